@@ -0,0 +1,266 @@
+#ifndef GPUINTEGRATION_COMMON_CAPTURE_HH
+#define GPUINTEGRATION_COMMON_CAPTURE_HH
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Streaming capture of integrand evaluations and final regions. Kernels
+// write the evaluations and regions they keep into fixed-size buffers, the
+// host hands the filled buffers to a capture_writer which appends them to a
+// columnar file from a thread of its own while the next iteration runs.
+//
+// File layout, little endian as written by the host:
+//   header:  char magic[8] "NICAPT01", uint32 ndim, uint32 reserved
+//   blocks:  uint32 kind, uint32 iteration, uint64 count, uint64 dropped,
+//            then the columns of the kind, count items each
+//     evaluations: uint64 region, uint32 point, double value,
+//                  double x, one column per dimension
+//     regions:     double low, one column per dimension,
+//                  double high, one column per dimension,
+//                  double estimate, double errorest
+// dropped counts the items that were selected but did not fit the buffer.
+
+namespace numint {
+
+  enum class capture_kind : uint32_t { evaluations = 0, regions = 1 };
+
+  struct capture_options {
+    // evaluations and regions kept per iteration, the rest are dropped
+    size_t evaluations = size_t{1} << 16;
+    size_t regions = size_t{1} << 14;
+    // keeps one evaluation in sample_every, picked by a hash of its
+    // iteration, region and point so that reruns keep the same ones
+    unsigned sample_every = 64;
+    // evaluations below it in absolute value are skipped, non-finite ones
+    // are always kept
+    double min_abs_value = 0.;
+  };
+
+  struct capture_column {
+    const void* data = nullptr;
+    size_t item_size = 0;
+  };
+
+  // columns point into memory that must stay valid until the writer has
+  // called the block's done callback
+  struct capture_block {
+    capture_kind kind = capture_kind::evaluations;
+    uint32_t iteration = 0;
+    uint64_t count = 0;
+    uint64_t dropped = 0;
+    std::vector<capture_column> columns;
+  };
+
+  class capture_writer {
+  public:
+    capture_writer(const std::string& filename, uint32_t ndim)
+      : file(filename, std::ios::binary | std::ios::trunc)
+    {
+      if (!file)
+        throw std::runtime_error("cannot open capture file " + filename);
+      const uint32_t reserved = 0;
+      file.write(magic, sizeof(magic));
+      file.write(reinterpret_cast<const char*>(&ndim), sizeof(ndim));
+      file.write(reinterpret_cast<const char*>(&reserved), sizeof(reserved));
+      thread = std::thread([this]() { run(); });
+    }
+
+    capture_writer(const capture_writer&) = delete;
+    capture_writer& operator=(const capture_writer&) = delete;
+
+    // writes out the queued blocks before returning
+    ~capture_writer()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+      }
+      queued.notify_all();
+      thread.join();
+    }
+
+    // queues block; done runs on the writer thread once its columns are in
+    // the file, or were given up on after a write error
+    void
+    submit(capture_block block, std::function<void()> done = {})
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back({std::move(block), std::move(done)});
+      }
+      queued.notify_one();
+    }
+
+    // blocks until everything submitted so far is written and flushed
+    void
+    flush()
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      idle.wait(lock, [this]() { return queue.empty() && !writing; });
+    }
+
+    bool
+    good() const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      return !failed;
+    }
+
+    static constexpr char magic[8] = {'N', 'I', 'C', 'A', 'P', 'T', '0', '1'};
+
+  private:
+    struct Pending {
+      capture_block block;
+      std::function<void()> done;
+    };
+
+    void
+    run()
+    {
+      while (true) {
+        Pending next;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          queued.wait(lock, [this]() { return stopping || !queue.empty(); });
+          if (queue.empty())
+            return;
+          next = std::move(queue.front());
+          queue.pop_front();
+          writing = true;
+        }
+
+        write(next.block);
+        if (next.done)
+          next.done();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        writing = false;
+        failed = failed || !file;
+        if (queue.empty())
+          idle.notify_all();
+      }
+    }
+
+    void
+    write(const capture_block& block)
+    {
+      const uint32_t kind = static_cast<uint32_t>(block.kind);
+      file.write(reinterpret_cast<const char*>(&kind), sizeof(kind));
+      file.write(reinterpret_cast<const char*>(&block.iteration),
+                 sizeof(block.iteration));
+      file.write(reinterpret_cast<const char*>(&block.count),
+                 sizeof(block.count));
+      file.write(reinterpret_cast<const char*>(&block.dropped),
+                 sizeof(block.dropped));
+      for (const capture_column& column : block.columns)
+        file.write(static_cast<const char*>(column.data),
+                   static_cast<std::streamsize>(column.item_size * block.count));
+      file.flush();
+    }
+
+    std::ofstream file;
+    mutable std::mutex mutex;
+    std::condition_variable queued;
+    std::condition_variable idle;
+    std::deque<Pending> queue;
+    bool writing = false;
+    bool stopping = false;
+    bool failed = false;
+    std::thread thread;
+  };
+
+  // a capture file read back, the blocks of each kind concatenated
+  struct capture_data {
+    uint32_t ndim = 0;
+
+    std::vector<uint32_t> eval_iteration;
+    std::vector<uint64_t> eval_region;
+    std::vector<uint32_t> eval_point;
+    std::vector<double> eval_value;
+    std::vector<std::vector<double>> eval_x; // [dim][evaluation]
+    uint64_t dropped_evaluations = 0;
+
+    std::vector<uint32_t> region_iteration;
+    std::vector<std::vector<double>> region_lows;  // [dim][region]
+    std::vector<std::vector<double>> region_highs; // [dim][region]
+    std::vector<double> region_estimate;
+    std::vector<double> region_errorest;
+    uint64_t dropped_regions = 0;
+  };
+
+  namespace detail {
+    template <typename T>
+    void
+    read_column(std::ifstream& in, std::vector<T>& column, uint64_t count)
+    {
+      const size_t first = column.size();
+      column.resize(first + count);
+      in.read(reinterpret_cast<char*>(column.data() + first),
+              static_cast<std::streamsize>(sizeof(T) * count));
+    }
+  }
+
+  inline capture_data
+  read_capture(const std::string& filename)
+  {
+    std::ifstream in(filename, std::ios::binary);
+    char magic[sizeof(capture_writer::magic)] = {};
+    uint32_t reserved = 0;
+    capture_data data;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&data.ndim), sizeof(data.ndim));
+    in.read(reinterpret_cast<char*>(&reserved), sizeof(reserved));
+    if (!in || std::memcmp(magic, capture_writer::magic, sizeof(magic)) != 0)
+      throw std::runtime_error(filename + " is not a capture file");
+
+    data.eval_x.resize(data.ndim);
+    data.region_lows.resize(data.ndim);
+    data.region_highs.resize(data.ndim);
+    while (true) {
+      uint32_t kind = 0, iteration = 0;
+      uint64_t count = 0, dropped = 0;
+      in.read(reinterpret_cast<char*>(&kind), sizeof(kind));
+      if (in.eof())
+        break;
+      in.read(reinterpret_cast<char*>(&iteration), sizeof(iteration));
+      in.read(reinterpret_cast<char*>(&count), sizeof(count));
+      in.read(reinterpret_cast<char*>(&dropped), sizeof(dropped));
+
+      if (kind == static_cast<uint32_t>(capture_kind::evaluations)) {
+        data.eval_iteration.insert(data.eval_iteration.end(), count, iteration);
+        detail::read_column(in, data.eval_region, count);
+        detail::read_column(in, data.eval_point, count);
+        detail::read_column(in, data.eval_value, count);
+        for (auto& x : data.eval_x)
+          detail::read_column(in, x, count);
+        data.dropped_evaluations += dropped;
+      } else if (kind == static_cast<uint32_t>(capture_kind::regions)) {
+        data.region_iteration.insert(
+          data.region_iteration.end(), count, iteration);
+        for (auto& lows : data.region_lows)
+          detail::read_column(in, lows, count);
+        for (auto& highs : data.region_highs)
+          detail::read_column(in, highs, count);
+        detail::read_column(in, data.region_estimate, count);
+        detail::read_column(in, data.region_errorest, count);
+        data.dropped_regions += dropped;
+      } else {
+        throw std::runtime_error(filename + " has an unknown capture block");
+      }
+      if (!in)
+        throw std::runtime_error(filename + " is truncated");
+    }
+    return data;
+  }
+}
+
+#endif
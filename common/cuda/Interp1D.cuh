@@ -5,6 +5,7 @@
 #include "common/cuda/cudaArray.cuh"
 #include "common/cuda/cudaMemoryUtil.h"
 #include "common/cuda/cudaTimerUtil.h"
+#include "common/cuda/shared_table.cuh"
 #include "common/cuda/str_to_doubles.hh"
 #include <assert.h>
 #include <cstdlib>
@@ -29,10 +30,11 @@ namespace quad {
   class Interp1D {
 
     size_t _cols = 0;
-    double* _xs = nullptr;
-    double* _zs = nullptr;
+    // shared by the copies, which copy no values
+    numint::shared_table<double> _xs;
+    numint::shared_table<double> _zs;
 
-    // Copy the pointed-to arrays into managed memory.
+    // Copy the pointed-to arrays into device memory.
     // The class interface guarantees that the array lengths
     // match the memory allocation done.
     void _initialize(double const* x, double const* z);
@@ -49,9 +51,6 @@ namespace quad {
     }
 
     Interp1D();
-    Interp1D(const Interp1D& source);
-    Interp1D& operator=(Interp1D const& rhs);
-    ~Interp1D();
 
     template <size_t M>
     Interp1D(std::array<double, M> const& xs, std::array<double, M> const& zs);
@@ -101,36 +100,12 @@ quad::Interp1D::_initialize(double const* x, double const* z)
     std::cerr << "Interp1D::_initilize called when _cols=" << _cols << '\n';
     std::abort();
   }
-  _xs = cuda_malloc<double>(_cols);
-  cuda_memcpy_to_device<double>(_xs, x, _cols);
-  _zs = cuda_malloc<double>(_cols);
-  cuda_memcpy_to_device<double>(_zs, z, _cols);
+  _xs = make_device_table(x, _cols);
+  _zs = make_device_table(z, _cols);
 }
 
 inline quad::Interp1D::Interp1D() {}
 
-inline quad::Interp1D::Interp1D(const Interp1D& source) : _cols(source._cols)
-{
-  _initialize(source._xs, source._zs);
-}
-
-inline quad::Interp1D&
-quad::Interp1D::operator=(Interp1D const& rhs)
-{
-  Interp1D tmp(rhs);
-  swap(tmp);
-  return *this;
-}
-
-inline quad::Interp1D::~Interp1D()
-{
-  if (_zs) cudaFree(_zs);
-  if (_xs) cudaFree(_xs);
-  // zero out the pointers to try to help the leak sanitizer
-  _zs = nullptr;
-  _xs = nullptr;
-}
-
 template <size_t M>
 inline
 quad::Interp1D::Interp1D(std::array<double, M> const& xs,
@@ -150,8 +125,8 @@ inline void
 quad::Interp1D::swap(Interp1D& other)
 {
   std::swap(_cols, other._cols);
-  std::swap(_zs, other._zs);
-  std::swap(_xs, other._xs);
+  _zs.swap(other._zs);
+  _xs.swap(other._xs);
 }
 
 inline __device__ __host__ bool
@@ -172,7 +147,7 @@ quad::Interp1D::_find_smallest__index_range(double val) const
     if (_in_range(val, smaller_candidate_range)) {
       return smaller_candidate_range;
     }
-    current_range.adjust_edges(_xs, val, smaller_candidate_range);
+    current_range.adjust_edges(_xs.data(), val, smaller_candidate_range);
   }
   return current_range;
 }
@@ -232,18 +207,9 @@ namespace quad {
     std::getline(is, buffer);
     std::vector<double> zs = str_to_doubles(buffer);
 
-    cudaMallocManaged((void**)&(*&interp), sizeof(quad::Interp1D));
-    cudaDeviceSynchronize();
-
     interp._cols = xs.size();
-
-    cudaMallocManaged((void**)&interp._xs, sizeof(double) * xs.size());
-    cudaDeviceSynchronize();
-    cudaMallocManaged((void**)&interp._zs, sizeof(double) * zs.size());
-    cudaDeviceSynchronize();
-
-    memcpy(interp._xs, xs.data(), sizeof(double) * xs.size());
-    memcpy(interp._zs, zs.data(), sizeof(double) * zs.size());
+    interp._xs = make_managed_table(xs.data(), xs.size());
+    interp._zs = make_managed_table(zs.data(), zs.size());
 
     return is;
   }
@@ -5,44 +5,63 @@
 #include "common/cuda/cudaArray.cuh"
 #include "common/cuda/cudaMemoryUtil.h"
 #include "common/cuda/cudaTimerUtil.h"
+#include "common/cuda/shared_table.cuh"
 #include "common/cuda/str_to_doubles.hh"
+#include "common/interp_layout.hh"
 #include <assert.h>
 #include <cstdlib>
 #include <iostream>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace quad {
-  
-  class Interp2D {
+
+  // Layout is one of the storage orders of common/interp_layout.hh; the
+  // values are always given row by row, x fastest
+  template <typename Layout = numint::row_major_layout>
+  class basic_Interp2D {
     // change names to xs, ys, zs to fit with y3_cluster_cpp::Interp2D
     size_t _rows = 0;
     size_t _cols = 0;
+    size_t _storage = 0;
+
+    // made once by Upload, copies of the interpolator share them
+    numint::shared_table<double> interpT;
+    numint::shared_table<double> interpR;
+    numint::shared_table<double> interpC;
 
-    double* interpT = nullptr;
-    double* interpR = nullptr;
-    double* interpC = nullptr;
-    
+    // zs in row-major order, rearranged for Layout on the way
     void
-    Alloc(size_t cols, size_t rows)
+    Upload(double const* xs,
+           double const* ys,
+           double const* zs,
+           size_t cols,
+           size_t rows)
     {
       CudaCheckError();
       if ((cols > 100000) || (rows > 100000)) {
-        std::cerr << "InterpD::Alloc called with cols=" << cols
+        std::cerr << "InterpD::Upload called with cols=" << cols
                   << " and rows=" << rows << '\n';
         std::abort();
       }
       if (cols * rows > 1000000) {
-        std::cerr << "Interp2D::Alloc called with cols=" << cols
+        std::cerr << "Interp2D::Upload called with cols=" << cols
                   << " and rows=" << rows << '\n';
         std::abort();
       }
       _rows = rows;
       _cols = cols;
-      interpR = cuda_malloc<double>(_rows);
-      CudaCheckError();
-      interpC = cuda_malloc<double>(_cols);
-      CudaCheckError();
-      interpT = cuda_malloc<double>(_rows * _cols);
+      const size_t n[2] = {_cols, _rows};
+      _storage = Layout::template storage<2>(n);
+      interpR = make_device_table(ys, _rows);
+      interpC = make_device_table(xs, _cols);
+      if constexpr (std::is_same<Layout, numint::row_major_layout>::value) {
+        interpT = make_device_table(zs, _storage);
+      } else {
+        const std::vector<double> table = numint::lay_out<Layout, 2>(zs, n);
+        interpT = make_device_table(table.data(), _storage);
+      }
       CudaCheckError();
     }
 
@@ -50,104 +69,60 @@ namespace quad {
     size_t
     get_device_mem_footprint()
     {
-      return 8 * (_cols * _rows + _cols + _rows);
+      return 8 * (_storage + _cols + _rows);
     }
 
     size_t
     get_device_mem_footprint() const
     {
-      return 8 * (_cols * _rows + _cols + _rows);
+      return 8 * (_storage + _cols + _rows);
     }
 
     void
-    swap(Interp2D& other)
+    swap(basic_Interp2D& other)
     {
       std::swap(_rows, other._rows);
       std::swap(_cols, other._cols);
-      std::swap(interpT, other.interpT);
-      std::swap(interpR, other.interpR);
-      std::swap(interpC, other.interpC);
+      std::swap(_storage, other._storage);
+      interpT.swap(other.interpT);
+      interpR.swap(other.interpR);
+      interpC.swap(other.interpC);
     }
 
     __host__ __device__
-    Interp2D()
+    basic_Interp2D()
     {}
 
-    Interp2D(const Interp2D& source)
-    {
-      _cols = source._cols;
-      _rows = source._rows;
-      Alloc(_cols, _rows);
-      
-      cuda_memcpy_device_to_device<double>(interpT, source.interpT, _cols * _rows);
-      cuda_memcpy_device_to_device<double>(interpC, source.interpC, _cols);
-      cuda_memcpy_device_to_device<double>(interpR, source.interpR, _rows);
-      CudaCheckError();
-    }
-
-    Interp2D&
-    operator=(Interp2D const& rhs)
-    {
-      Interp2D tmp(rhs);
-      CudaCheckError();
-      swap(tmp);
-      return *this;
-    }
-    
-
-    ~Interp2D()
-    {
-      cudaFree(interpT);
-      cudaFree(interpR);
-      cudaFree(interpC);
-    }
-
     template <size_t M, size_t N>
-    Interp2D(std::array<double, M> const& xs,
-             std::array<double, N> const& ys,
-             std::array<double, (N) * (M)> const& zs)
+    basic_Interp2D(std::array<double, M> const& xs,
+                   std::array<double, N> const& ys,
+                   std::array<double, (N) * (M)> const& zs)
     {
-      CudaCheckError();
-      Alloc(M, N);
-      cuda_memcpy_to_device<double>(interpR, ys.data(), N);
-      cuda_memcpy_to_device<double>(interpC, xs.data(), M);
-      cuda_memcpy_to_device<double>(interpT, zs.data(), N * M);
-      CudaCheckError();
+      Upload(xs.data(), ys.data(), zs.data(), M, N);
     }
 
-    Interp2D(double const* xs,
-             double const* ys,
-             double const* zs,
-             size_t cols,
-             size_t rows)
+    basic_Interp2D(double const* xs,
+                   double const* ys,
+                   double const* zs,
+                   size_t cols,
+                   size_t rows)
     {
-      CudaCheckError();
-      Alloc(cols, rows);
-      cuda_memcpy_to_device<double>(interpR, ys, rows);
-      cuda_memcpy_to_device<double>(interpC, xs, cols);
-      cuda_memcpy_to_device<double>(interpT, zs, rows * cols);
-      CudaCheckError();
+      Upload(xs, ys, zs, cols, rows);
     }
 
-    Interp2D(std::vector<double> const& xs,
-             std::vector<double> const& ys,
-             std::vector<double> const& zs)
-      : Interp2D(xs.data(), ys.data(), zs.data(), xs.size(), ys.size())
+    basic_Interp2D(std::vector<double> const& xs,
+                   std::vector<double> const& ys,
+                   std::vector<double> const& zs)
+      : basic_Interp2D(xs.data(), ys.data(), zs.data(), xs.size(), ys.size())
     {
       CudaCheckError();
     }
 
     template <size_t M, size_t N>
-    Interp2D(std::array<double, M> xs,
-             std::array<double, N> ys,
-             std::array<std::array<double, N>, M> zs)
+    basic_Interp2D(std::array<double, M> xs,
+                   std::array<double, N> ys,
+                   std::array<std::array<double, N>, M> zs)
     {
-
-      CudaCheckError();
-      Alloc(M, N);
-      cuda_memcpy_to_device<double>(interpR, ys.data(), N);
-      cuda_memcpy_to_device<double>(interpC, xs.data(), M);
-
       std::vector<double> buffer(N*M);
       for (std::size_t i = 0; i < M; ++i) {
         std::array<double, N> const& row = zs[i];
@@ -155,14 +130,13 @@ namespace quad {
           buffer[i + j * M] = row[j];
         }
       }
-	  
-      cuda_memcpy_to_device<double>(interpT, buffer.data(), N*M);
-      CudaCheckError();
+
+      Upload(xs.data(), ys.data(), buffer.data(), M, N);
     }
 
     __host__ __device__ bool
     AreNeighbors(const double val,
-                 double* arr,
+                 const double* arr,
                  const size_t leftIndex,
                  const size_t RightIndex) const
     {
@@ -170,7 +144,7 @@ namespace quad {
     }
 
     friend std::istream&
-    operator>>(std::istream& is, Interp2D& interp)
+    operator>>(std::istream& is, basic_Interp2D& interp)
     {
       assert(is.good());
       std::string buffer;
@@ -183,21 +157,21 @@ namespace quad {
 
       interp._cols = xs.size();
       interp._rows = ys.size();
+      const size_t n[2] = {interp._cols, interp._rows};
+      const std::vector<double> table =
+        numint::lay_out<Layout, 2>(zs.data(), n);
+      interp._storage = table.size();
 
-      cudaMallocManaged((void**)&interp.interpR, sizeof(double) * ys.size());
-      cudaMallocManaged((void**)&interp.interpC, sizeof(double) * xs.size());
-      cudaMallocManaged((void**)&interp.interpT, sizeof(double) * zs.size());
-
-      memcpy(interp.interpR, ys.data(), sizeof(double) * ys.size());
-      memcpy(interp.interpC, xs.data(), sizeof(double) * xs.size());
-      memcpy(interp.interpT, zs.data(), sizeof(double) * zs.size());
+      interp.interpR = make_managed_table(ys.data(), ys.size());
+      interp.interpC = make_managed_table(xs.data(), xs.size());
+      interp.interpT = make_managed_table(table.data(), table.size());
 
       return is;
     }
 
     __device__ __host__ void
     FindNeighbourIndices(const double val,
-                         double* arr,
+                         const double* arr,
                          const size_t size,
                          size_t& leftI,
                          size_t& rightI) const
@@ -229,29 +203,17 @@ namespace quad {
       // points in the z-table
       size_t y1 = 0, y2 = 0;
       size_t x1 = 0, x2 = 0;
-      FindNeighbourIndices(y, interpR, _rows, y1, y2);
-      FindNeighbourIndices(x, interpC, _cols, x1, x2);
+      FindNeighbourIndices(y, interpR.data(), _rows, y1, y2);
+      FindNeighbourIndices(x, interpC.data(), _cols, x1, x2);
       // this is how  zij is accessed by gsl2.6 Interp2D i.e. zij =
-      // z[j*xsize+i], where i=0,...,xsize-1, j=0, ..., ysize-1
-      const double q11 = interpT[y1 * _cols + x1];
-      const double q12 = interpT[y2 * _cols + x1];
-      const double q21 = interpT[y1 * _cols + x2];
-      const double q22 = interpT[y2 * _cols + x2];
-
-      const double x1_val = interpC[x1];
-      const double x2_val = interpC[x2];
-      const double y1_val = interpR[y1];
-      const double y2_val = interpR[y2];
-
-      const double f_x_y1 = q11 * (x2_val - x) / (x2_val - x1_val) +
-                            q21 * (x - x1_val) / (x2_val - x1_val);
-      const double f_x_y2 = q12 * (x2_val - x) / (x2_val - x1_val) +
-                            q22 * (x - x1_val) / (x2_val - x1_val);
-
-      double f_x_y = 0.;
-      f_x_y = f_x_y1 * (y2_val - y) / (y2_val - y1_val) +
-              f_x_y2 * (y - y1_val) / (y2_val - y1_val);
-      return f_x_y;
+      // z[j*xsize+i], where i=0,...,xsize-1, j=0, ..., ysize-1, before
+      // Layout rearranges it; q = {q11, q21, q12, q22}
+      const size_t n[2] = {_cols, _rows};
+      const size_t cell[2] = {x1, y1};
+      double q[4];
+      Layout::template corners<2>(interpT.data(), n, cell, q);
+      return numint::bilinear(
+        q, x, interpC[x1], interpC[x2], y, interpR[y1], interpR[y2]);
     }
 
     __device__ __host__ double
@@ -297,6 +259,8 @@ namespace quad {
       return eval(do_clamp(x, min_x(), max_x()), do_clamp(y, min_y(), max_y()));
     }
   };
+
+  using Interp2D = basic_Interp2D<>;
 }
 
 #endif
@@ -5,35 +5,50 @@
 #include "common/cuda/cudaArray.cuh"
 #include "common/cuda/cudaMemoryUtil.h"
 #include "common/cuda/cudaTimerUtil.h"
+#include "common/cuda/shared_table.cuh"
 #include "common/cuda/str_to_doubles.hh"
+#include "common/interp_layout.hh"
 #include <assert.h>
 #include <cstdlib>
 #include <iostream>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace quad {
 
-  class Interp3D {
+  // as basic_Interp2D, vals row-major with x fastest then y
+  template <typename Layout = numint::row_major_layout>
+  class basic_Interp3D {
     // change names to xs, ys, zs to fit with y3_cluster_cpp::Interp3D
     size_t size_x = 0;
     size_t size_y = 0;
     size_t size_z = 0;
+    size_t storage = 0;
 
-    double* interpT = nullptr;
-    double* _zs = nullptr;
-    double* _ys = nullptr; // y -> interpR
-    double* _xs = nullptr; // x -> interpC
+    // shared with every copy, see Upload
+    numint::shared_table<double> interpT;
+    numint::shared_table<double> _zs;
+    numint::shared_table<double> _ys; // y -> interpR
+    numint::shared_table<double> _xs; // x -> interpC
 
     void
-    Alloc(size_t x, size_t y, size_t z)
+    Upload(double const* xs,
+           double const* ys,
+           double const* zs,
+           double const* vs,
+           size_t x,
+           size_t y,
+           size_t z)
     {
+      CudaCheckError();
       if (x > 100000 || y > 100000 || z > 100000) {
-        std::cerr << "InterpD::Alloc called with x=" << x << " and y=" << y
+        std::cerr << "InterpD::Upload called with x=" << x << " and y=" << y
                   << " and z=" << z << '\n';
         std::abort();
       }
       if (x * y * z > 1000000) {
-        std::cerr << "Interp3D::Alloc called with x=" << x << " and y=" << y
+        std::cerr << "Interp3D::Upload called with x=" << x << " and y=" << y
                   << " and z=" << z << '\n';
         std::abort();
       }
@@ -41,11 +56,18 @@ namespace quad {
       size_x = x;
       size_y = y;
       size_z = z;
-
-      _xs = cuda_malloc<double>(x);
-      _ys = cuda_malloc<double>(y);
-      _zs = cuda_malloc<double>(z);
-      interpT = cuda_malloc<double>(x * y * z);
+      const size_t n[3] = {x, y, z};
+      storage = Layout::template storage<3>(n);
+
+      _xs = make_device_table(xs, x);
+      _ys = make_device_table(ys, y);
+      _zs = make_device_table(zs, z);
+      if constexpr (std::is_same<Layout, numint::row_major_layout>::value) {
+        interpT = make_device_table(vs, storage);
+      } else {
+        const std::vector<double> table = numint::lay_out<Layout, 3>(vs, n);
+        interpT = make_device_table(table.data(), storage);
+      }
       CudaCheckError();
     }
 
@@ -53,115 +75,71 @@ namespace quad {
     size_t
     get_device_mem_footprint()
     {
-      return 8 * (size_x * size_y * size_z + size_x + size_y + size_z);
+      return 8 * (storage + size_x + size_y + size_z);
     }
 
     size_t
     get_device_mem_footprint() const
     {
-      return 8 * (size_x * size_y * size_z + size_x + size_y + size_z);
+      return 8 * (storage + size_x + size_y + size_z);
     }
 
     void
-    swap(Interp3D& other)
+    swap(basic_Interp3D& other)
     {
       std::swap(size_x, other.size_x);
       std::swap(size_y, other.size_y);
       std::swap(size_z, other.size_z);
+      std::swap(storage, other.storage);
 
-      std::swap(interpT, other.interpT);
-      std::swap(_xs, other._xs);
-      std::swap(_ys, other._ys);
-      std::swap(_zs, other._zs);
+      interpT.swap(other.interpT);
+      _xs.swap(other._xs);
+      _ys.swap(other._ys);
+      _zs.swap(other._zs);
     }
 
     __host__ __device__
-    Interp3D()
+    basic_Interp3D()
     {}
 
-    Interp3D(const Interp3D& source)
-    {
-      size_x = source.size_x;
-      size_y = source.size_y;
-      size_z = source.size_z;
-      Alloc(size_x, size_y, size_z);
-
-      cuda_memcpy_device_to_device<double>(
-        interpT, source.interpT, size_x * size_y * size_z);
-      cuda_memcpy_device_to_device<double>(_xs, source._xs, size_x);
-      cuda_memcpy_device_to_device<double>(_ys, source._ys, size_y);
-      cuda_memcpy_device_to_device<double>(_zs, source._zs, size_z);
-      CudaCheckError();
-    }
-
-    Interp3D&
-    operator=(Interp3D const& rhs)
-    {
-      Interp3D tmp(rhs);
-      CudaCheckError();
-      swap(tmp);
-      return *this;
-    }
-
-
-    ~Interp3D()
-    {
-      cudaFree(_xs);
-      cudaFree(_ys);
-      cudaFree(_zs);
-      cudaFree(interpT);
-    }
-
     template <size_t M, size_t N, size_t S>
-    Interp3D(std::array<double, M> const& xs,
-             std::array<double, N> const& ys,
-             std::array<double, S> const& zs,
-             std::array<double, N * M * S> const& vals)
+    basic_Interp3D(std::array<double, M> const& xs,
+                   std::array<double, N> const& ys,
+                   std::array<double, S> const& zs,
+                   std::array<double, N * M * S> const& vals)
     {
-      CudaCheckError();
-      Alloc(M, N, S);
-      cuda_memcpy_to_device<double>(_xs, xs.data(), M);
-      cuda_memcpy_to_device<double>(_ys, ys.data(), N);
-      cuda_memcpy_to_device<double>(_zs, zs.data(), S);
-      cuda_memcpy_to_device<double>(interpT, vals.data(), N * M * S);
-      CudaCheckError();
+      Upload(xs.data(), ys.data(), zs.data(), vals.data(), M, N, S);
     }
 
-    Interp3D(double const* xs,
-             double const* ys,
-             double const* zs,
-             double const* vs,
-             size_t x_size,
-             size_t y_size,
-             size_t z_size)
+    basic_Interp3D(double const* xs,
+                   double const* ys,
+                   double const* zs,
+                   double const* vs,
+                   size_t x_size,
+                   size_t y_size,
+                   size_t z_size)
     {
-      CudaCheckError();
-      Alloc(x_size, y_size, z_size);
-      cuda_memcpy_to_device<double>(_xs, xs, x_size);
-      cuda_memcpy_to_device<double>(_ys, ys, y_size);
-      cuda_memcpy_to_device<double>(_zs, zs, z_size);
-      cuda_memcpy_to_device<double>(interpT, vs, x_size * y_size * z_size);
-      CudaCheckError();
+      Upload(xs, ys, zs, vs, x_size, y_size, z_size);
     }
 
-    Interp3D(std::vector<double> const& xs,
-             std::vector<double> const& ys,
-             std::vector<double> const& zs,
-             std::vector<double> const& vs)
-      : Interp3D(xs.data(),
-                 ys.data(),
-                 zs.data(),
-                 vs.data(),
-                 xs.size(),
-                 ys.size(),
-                 zs.size())
+    basic_Interp3D(std::vector<double> const& xs,
+                   std::vector<double> const& ys,
+                   std::vector<double> const& zs,
+                   std::vector<double> const& vs)
+      : basic_Interp3D(xs.data(),
+                       ys.data(),
+                       zs.data(),
+                       vs.data(),
+                       xs.size(),
+                       ys.size(),
+                       zs.size())
     {
       CudaCheckError();
     }
 
     __device__ bool
     AreNeighbors(const double val,
-                 double* arr,
+                 const double* arr,
                  const size_t leftIndex,
                  const size_t RightIndex) const
     {
@@ -170,7 +148,7 @@ namespace quad {
 
     __device__ void
     FindNeighbourIndices(const double val,
-                         double* arr,
+                         const double* arr,
                          const size_t size,
                          size_t& leftI,
                          size_t& rightI) const
@@ -195,6 +173,7 @@ namespace quad {
       }
     }
 
+    // of a point of the row-major input
     __device__ size_t
     index(size_t x, size_t y, size_t z) const
     {
@@ -211,31 +190,19 @@ namespace quad {
       size_t z0 = 0, z1 = 0;
 
       // separately find two nearest values to each of x, y, z
-      FindNeighbourIndices(y, _ys, size_y, y0, y1);
-      FindNeighbourIndices(x, _xs, size_x, x0, x1);
-      FindNeighbourIndices(z, _zs, size_z, z0, z1);
+      FindNeighbourIndices(y, _ys.data(), size_y, y0, y1);
+      FindNeighbourIndices(x, _xs.data(), size_x, x0, x1);
+      FindNeighbourIndices(z, _zs.data(), size_z, z0, z1);
 
       const double x_d = (x - _xs[x0]) / (_xs[x1] - _xs[x0]);
       const double y_d = (y - _ys[y0]) / (_ys[y1] - _ys[y0]);
       const double z_d = (z - _zs[z0]) / (_zs[z1] - _zs[z0]);
 
-      // interpolate along x
-      const double c00 = interpT[index(x0, y0, z0)] * (1 - x_d) +
-                         interpT[index(x1, y0, z0)] * x_d;
-      const double c01 = interpT[index(x0, y0, z1)] * (1 - x_d) +
-                         interpT[index(x1, y0, z1)] * x_d;
-      const double c10 = interpT[index(x0, y1, z0)] * (1 - x_d) +
-                         interpT[index(x1, y1, z0)] * x_d;
-      const double c11 = interpT[index(x0, y1, z1)] * (1 - x_d) +
-                         interpT[index(x1, y1, z1)] * x_d;
-
-      // interpolate values along y
-      const double c0 = c00 * (1 - y_d) + c10 * y_d;
-      const double c1 = c01 * (1 - y_d) + c11 * y_d;
-
-      // interpolate along z
-      const double f_xyz = c0 * (1 - z_d) + c1 * z_d;
-      return f_xyz;
+      const size_t n[3] = {size_x, size_y, size_z};
+      const size_t cell[3] = {x0, y0, z0};
+      double q[8];
+      Layout::template corners<3>(interpT.data(), n, cell, q);
+      return numint::trilinear(q, x_d, y_d, z_d);
     }
 
     __device__ double
@@ -295,6 +262,8 @@ namespace quad {
                   do_clamp(z, min_z(), max_z()));
     }
   };
+
+  using Interp3D = basic_Interp3D<>;
 }
 
 #endif
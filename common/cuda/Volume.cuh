@@ -5,6 +5,17 @@
 #include <cstring>
 #include <vector>
 
+// lets host-only translation units, like the host VEGAS in
+// cuda/mcubes/mcubesDist.hh, use the volume without nvcc
+#if !defined(__CUDACC__) && !defined(__HIPCC__)
+#ifndef __host__
+#define __host__
+#endif
+#ifndef __device__
+#define __device__
+#endif
+#endif
+
 // user must make sure to call cudaMalloc and cudaMemcpy regarding d_highs and
 // d_lows
 
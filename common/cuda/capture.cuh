@@ -0,0 +1,349 @@
+#ifndef CUDA_COMMON_CAPTURE_CUH
+#define CUDA_COMMON_CAPTURE_CUH
+
+#include "common/capture.hh"
+#include "common/cuda/Volume.cuh"
+#include "common/cuda/cudaMemoryUtil.h"
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <new>
+
+// Device side of common/capture.hh. The buffers are mapped host memory,
+// kernels write the few items they keep straight to the host and nothing
+// is copied back. There are two sets of buffers: the kernels of an
+// iteration fill one while the writer thread streams the other to disk.
+
+namespace quad {
+
+  __host__ __device__ inline unsigned long long
+  capture_mix(unsigned long long key)
+  {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ull;
+    key ^= key >> 33;
+    return key;
+  }
+
+  // what the kernels get, by value; disabled when default constructed.
+  // Coordinates are stored one column per dimension, capacity apart.
+  template <typename T>
+  struct Capture_log {
+    unsigned long long* eval_count = nullptr;
+    unsigned long long* eval_region = nullptr;
+    unsigned* eval_point = nullptr;
+    double* eval_value = nullptr;
+    double* eval_x = nullptr;
+    unsigned eval_capacity = 0;
+
+    unsigned long long* region_count = nullptr;
+    double* region_lows = nullptr;
+    double* region_highs = nullptr;
+    double* region_estimate = nullptr;
+    double* region_errorest = nullptr;
+    unsigned region_capacity = 0;
+
+    unsigned iteration = 0;
+    unsigned sample_every = 1;
+    double min_abs_value = 0.;
+
+    __device__ bool
+    enabled() const
+    {
+      return eval_count != nullptr;
+    }
+
+    __device__ bool
+    keeps(size_t region, int point, T value) const
+    {
+      if (!isfinite(value))
+        return true;
+      if (fabs(value) < min_abs_value)
+        return false;
+      const unsigned long long key =
+        capture_mix(region ^ (static_cast<unsigned long long>(iteration) << 40));
+      return sample_every <= 1 || capture_mix(key + point) % sample_every == 0;
+    }
+
+    // the slot the coordinates of the evaluation go to, -1 once full
+    __device__ int
+    record_evaluation(size_t region, int point, T value) const
+    {
+      const unsigned long long slot = atomicAdd(eval_count, 1ull);
+      if (slot >= eval_capacity)
+        return -1;
+      eval_region[slot] = region;
+      eval_point[slot] = point;
+      eval_value[slot] = value;
+      return static_cast<int>(slot);
+    }
+
+    __device__ void
+    store_x(int slot, int dim, T x) const
+    {
+      if (slot >= 0)
+        eval_x[static_cast<size_t>(dim) * eval_capacity + slot] = x;
+    }
+
+    __device__ int
+    record_region(T estimate, T errorest) const
+    {
+      const unsigned long long slot = atomicAdd(region_count, 1ull);
+      if (slot >= region_capacity)
+        return -1;
+      region_estimate[slot] = estimate;
+      region_errorest[slot] = errorest;
+      return static_cast<int>(slot);
+    }
+
+    __device__ void
+    store_bounds(int slot, int dim, T low, T high) const
+    {
+      if (slot < 0)
+        return;
+      const size_t i = static_cast<size_t>(dim) * region_capacity + slot;
+      region_lows[i] = low;
+      region_highs[i] = high;
+    }
+  };
+
+  // records the regions whose active flag is 0, all of them when active is
+  // null; left and length are in the unit cube, dimension-major
+  template <typename T, int NDIM>
+  __global__ void
+  capture_regions(Capture_log<T> log,
+                  const T* left,
+                  const T* length,
+                  size_t num_regions,
+                  const double* active,
+                  const T* estimates,
+                  const T* errorests,
+                  Volume<T, NDIM> vol)
+  {
+    const size_t region = blockIdx.x * blockDim.x + threadIdx.x;
+    if (region >= num_regions || (active != nullptr && active[region] != 0.))
+      return;
+    const int slot = log.record_region(estimates[region], errorests[region]);
+    for (int dim = 0; dim < NDIM; ++dim) {
+      const T range = vol.highs[dim] - vol.lows[dim];
+      const T low = left[dim * num_regions + region];
+      log.store_bounds(slot,
+                       dim,
+                       vol.lows[dim] + low * range,
+                       vol.lows[dim] +
+                         (low + length[dim * num_regions + region]) * range);
+    }
+  }
+
+  // owns the buffers behind the logs and the writer of the capture file
+  template <typename T>
+  class Capture_stream {
+  public:
+    Capture_stream(const std::string& filename,
+                   int ndim,
+                   const numint::capture_options& options = {})
+      : ndim(ndim)
+      , eval_capacity(static_cast<unsigned>(options.evaluations))
+      , region_capacity(static_cast<unsigned>(options.regions))
+      , writer(filename, static_cast<uint32_t>(ndim))
+    {
+      const size_t doubles =
+        eval_capacity * (1 + static_cast<size_t>(ndim)) +
+        region_capacity * (2 + 2 * static_cast<size_t>(ndim));
+      const size_t bytes = sizeof(unsigned long long) * (2 + eval_capacity) +
+                           sizeof(double) * doubles +
+                           sizeof(unsigned) * eval_capacity;
+      for (Buffers& half : halves) {
+        if (cudaHostAlloc(&half.host, bytes, cudaHostAllocMapped) !=
+            cudaSuccess) {
+          release();
+          throw std::bad_alloc();
+        }
+        char* device = nullptr;
+        cudaHostGetDevicePointer((void**)&device, half.host, 0);
+        half.host_log = layout(static_cast<char*>(half.host), options);
+        half.device_log = layout(device, options);
+      }
+    }
+
+    Capture_stream(const Capture_stream&) = delete;
+    Capture_stream& operator=(const Capture_stream&) = delete;
+
+    ~Capture_stream()
+    {
+      writer.flush();
+      release();
+    }
+
+    // the log the kernels of iteration write to, once the writer is done
+    // with what was last captured in it
+    Capture_log<T>
+    begin(unsigned iteration)
+    {
+      Buffers& half = halves[current];
+      if (half.released.valid())
+        half.released.wait();
+      *half.host_log.eval_count = 0;
+      *half.host_log.region_count = 0;
+      half.host_log.iteration = iteration;
+      half.device_log.iteration = iteration;
+      return half.device_log;
+    }
+
+    // regions are read from the device, see capture_regions
+    template <int NDIM>
+    void
+    record_regions(const T* left,
+                   const T* length,
+                   size_t num_regions,
+                   const double* active,
+                   const T* estimates,
+                   const T* errorests,
+                   Volume<T, NDIM> const& vol)
+    {
+      if (num_regions == 0)
+        return;
+      constexpr size_t block_size = 256;
+      const size_t num_blocks = (num_regions + block_size - 1) / block_size;
+      capture_regions<T, NDIM>
+        <<<num_blocks, block_size>>>(halves[current].device_log,
+                                     left,
+                                     length,
+                                     num_regions,
+                                     active,
+                                     estimates,
+                                     errorests,
+                                     vol);
+    }
+
+    // waits for the kernels of the iteration and queues what they captured;
+    // the next begin moves to the other buffers
+    void
+    drain()
+    {
+      cudaDeviceSynchronize();
+      Buffers& half = halves[current];
+      const Capture_log<T>& log = half.host_log;
+      const uint64_t evaluations = volatile_read(log.eval_count);
+      const uint64_t regions = volatile_read(log.region_count);
+
+      std::vector<numint::capture_block> blocks;
+      if (evaluations != 0) {
+        numint::capture_block block;
+        block.kind = numint::capture_kind::evaluations;
+        block.iteration = log.iteration;
+        block.count = std::min<uint64_t>(evaluations, eval_capacity);
+        block.dropped = evaluations - block.count;
+        block.columns = {{log.eval_region, sizeof(unsigned long long)},
+                         {log.eval_point, sizeof(unsigned)},
+                         {log.eval_value, sizeof(double)}};
+        for (int dim = 0; dim < ndim; ++dim)
+          block.columns.push_back(
+            {log.eval_x + static_cast<size_t>(dim) * eval_capacity,
+             sizeof(double)});
+        blocks.push_back(std::move(block));
+      }
+      if (regions != 0) {
+        numint::capture_block block;
+        block.kind = numint::capture_kind::regions;
+        block.iteration = log.iteration;
+        block.count = std::min<uint64_t>(regions, region_capacity);
+        block.dropped = regions - block.count;
+        for (const double* bounds : {log.region_lows, log.region_highs})
+          for (int dim = 0; dim < ndim; ++dim)
+            block.columns.push_back(
+              {bounds + static_cast<size_t>(dim) * region_capacity,
+               sizeof(double)});
+        block.columns.push_back({log.region_estimate, sizeof(double)});
+        block.columns.push_back({log.region_errorest, sizeof(double)});
+        blocks.push_back(std::move(block));
+      }
+
+      auto released = std::make_shared<std::promise<void>>();
+      half.released = released->get_future();
+      if (blocks.empty())
+        released->set_value();
+      for (size_t i = 0; i < blocks.size(); ++i) {
+        std::function<void()> done;
+        if (i + 1 == blocks.size())
+          done = [released]() { released->set_value(); };
+        writer.submit(std::move(blocks[i]), std::move(done));
+      }
+      current ^= 1;
+    }
+
+    // blocks until the file holds everything drained so far
+    void
+    flush()
+    {
+      writer.flush();
+    }
+
+    bool
+    good() const
+    {
+      return writer.good();
+    }
+
+  private:
+    struct Buffers {
+      void* host = nullptr;
+      Capture_log<T> host_log;
+      Capture_log<T> device_log;
+      std::future<void> released;
+    };
+
+    static uint64_t
+    volatile_read(const unsigned long long* count)
+    {
+      return *static_cast<const volatile unsigned long long*>(count);
+    }
+
+    // the 8 byte columns first, the 4 byte point indices last
+    Capture_log<T>
+    layout(char* base, const numint::capture_options& options) const
+    {
+      Capture_log<T> log;
+      auto* counters = reinterpret_cast<unsigned long long*>(base);
+      log.eval_count = counters;
+      log.region_count = counters + 1;
+      log.eval_region = counters + 2;
+      auto* doubles = reinterpret_cast<double*>(log.eval_region + eval_capacity);
+      log.eval_value = doubles;
+      log.eval_x = log.eval_value + eval_capacity;
+      log.region_lows = log.eval_x + static_cast<size_t>(ndim) * eval_capacity;
+      log.region_highs =
+        log.region_lows + static_cast<size_t>(ndim) * region_capacity;
+      log.region_estimate =
+        log.region_highs + static_cast<size_t>(ndim) * region_capacity;
+      log.region_errorest = log.region_estimate + region_capacity;
+      log.eval_point =
+        reinterpret_cast<unsigned*>(log.region_errorest + region_capacity);
+      log.eval_capacity = eval_capacity;
+      log.region_capacity = region_capacity;
+      log.sample_every = std::max(options.sample_every, 1u);
+      log.min_abs_value = options.min_abs_value;
+      return log;
+    }
+
+    void
+    release()
+    {
+      for (Buffers& half : halves) {
+        cudaFreeHost(half.host);
+        half.host = nullptr;
+      }
+    }
+
+    int ndim;
+    unsigned eval_capacity;
+    unsigned region_capacity;
+    Buffers halves[2];
+    int current = 0;
+    numint::capture_writer writer;
+  };
+}
+
+#endif
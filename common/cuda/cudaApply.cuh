@@ -6,7 +6,7 @@ namespace gpu {
 
   namespace detail {
     template <class F, typename T, size_t N, std::size_t... I>
-    __device__ T
+    __device__ auto
     apply_impl(F&& f,
                gpu::cudaArray<T, N> const& data,
                std::index_sequence<I...>)
@@ -15,8 +15,10 @@ namespace gpu {
     };
   }
 
+  // returns whatever f returns, T for scalar integrands and
+  // gpu::cudaArray<T, ncomp> for integrands with several components
   template <class F, typename T, size_t N>
-  __device__ T
+  __device__ auto
   // Unsure if we need to pass 'f' by value, for GPU execution
   apply(F&& f, gpu::cudaArray<T, N> const& data)
   {
@@ -393,12 +393,12 @@ set_device_array_range(T* arr,
 
 template <typename T>
 void
-set_device_array(T* arr, size_t size, T val)
+set_device_array(T* arr, size_t size, T val, cudaStream_t stream = 0)
 {
   size_t num_threads = 64;
   size_t num_blocks = size / num_threads + ((size % num_threads) ? 1 : 0);
-  set_array_to_value<T><<<num_blocks, num_threads>>>(arr, size, val);
-  cudaDeviceSynchronize();
+  set_array_to_value<T><<<num_blocks, num_threads, 0, stream>>>(arr, size, val);
+  cudaStreamSynchronize(stream);
 }
 
 template <typename T, typename C = T>
@@ -68,7 +68,7 @@ device_custom_reduce_atomics(T* arr, size_t size, T* out)
 
 template <typename T>
 T
-custom_reduce_atomics(T* arr, size_t size)
+custom_reduce_atomics(T* arr, size_t size, cudaStream_t stream = 0)
 {
   T res = 0.;
   size_t num_threads = 512;
@@ -79,7 +79,9 @@ custom_reduce_atomics(T* arr, size_t size)
   quad::cuda_memcpy_to_device<T>(out, &res, 1);
 
   quad::cuda_memcpy_to_device<T>(out, &res, 1);
-  device_custom_reduce_atomics<<<num_blocks, num_threads>>>(arr, size, out);
+  device_custom_reduce_atomics<<<num_blocks, num_threads, 0, stream>>>(
+    arr, size, out);
+  cudaStreamSynchronize(stream);
 
   quad::cuda_memcpy_to_host<T>(&res, out, 1);
   cudaFree(out);
@@ -109,7 +111,10 @@ device_custom_inner_product_atomics(T1* arr1, T2* arr2, size_t size, T2* out)
 
 template <typename T1, typename T2>
 T2
-custom_inner_product_atomics(T1* arr1, T2* arr2, size_t size)
+custom_inner_product_atomics(T1* arr1,
+                             T2* arr2,
+                             size_t size,
+                             cudaStream_t stream = 0)
 {
   T2 res = 0.;
   size_t num_threads = 512;
@@ -119,7 +124,8 @@ custom_inner_product_atomics(T1* arr1, T2* arr2, size_t size)
   T2* out = quad::cuda_malloc<T2>(1);
   quad::cuda_memcpy_to_device<T2>(out, &res, 1);
   device_custom_inner_product_atomics<T1, T2>
-    <<<num_blocks, num_threads>>>(arr1, arr2, size, out);
+    <<<num_blocks, num_threads, 0, stream>>>(arr1, arr2, size, out);
+  cudaStreamSynchronize(stream);
   quad::cuda_memcpy_to_host<T2>(&res, out, 1);
   cudaFree(out);
   return res;
@@ -236,7 +242,7 @@ block0_min_max(T* mins, T* maxs, const int size, T* min, T* max)
 
 template <typename T>
 std::pair<T, T>
-min_max(T* input, const int size)
+min_max(T* input, const int size, cudaStream_t stream = 0)
 {
   size_t num_threads = 1024;
   size_t max_num_blocks = 1024;
@@ -248,12 +254,12 @@ min_max(T* input, const int size)
   T* d_min = quad::cuda_malloc<T>(1);
   T* d_max = quad::cuda_malloc<T>(1);
 
-  blocks_min_max<T>
-    <<<num_blocks, num_threads>>>(input, size, block_mins, block_maxs);
-  block0_min_max<T><<<1, std::max(num_blocks, (size_t)32)>>>(
+  blocks_min_max<T><<<num_blocks, num_threads, 0, stream>>>(
+    input, size, block_mins, block_maxs);
+  block0_min_max<T><<<1, std::max(num_blocks, (size_t)32), 0, stream>>>(
     block_mins, block_maxs, num_blocks, d_min, d_max);
 
-  cudaDeviceSynchronize();
+  cudaStreamSynchronize(stream);
 
   T min = 0.;
   T max = 0.;
@@ -2,6 +2,7 @@
 #define CUDA_INTEGRANDS_CUH
 
 #include "cuda/pagani/demos/compute_genz_integrals.cuh"
+#include "common/separable.hh"
 
 // We have no analytic solution for F3 integrands with mathematica or the Genz
 // testpack (corner-peak integrand seems slighlty different there) same thing
@@ -1001,6 +1002,66 @@ public:
   double true_value;
 };
 
+// The cosine products as products of their factors, cos(x) for the fully
+// separable ones and cos(x + y) for the semi separable ones, so that
+// common/separable.hh backends integrate them one factor at a time.
+template <int num_groups, int group_ndim, typename Factor>
+struct Cos_product_traits {
+  static constexpr bool value = true;
+  static constexpr numint::separable_kind kind =
+    numint::separable_kind::product;
+  using groups = numint::uniform_separable_groups<group_ndim, num_groups>;
+
+  template <int g, typename IntegT>
+  __device__ __host__ static Factor
+  factor(IntegT const&)
+  {
+    return Factor();
+  }
+};
+
+template <int ndim>
+using Cos_fully_sep_traits =
+  Cos_product_traits<ndim, 1, Cos_fully_sep_product_1D>;
+template <int ndim>
+using Cos_semi_sep_traits = Cos_product_traits<ndim / 2, 2, Oscillatory_2D>;
+
+namespace numint {
+  template <>
+  struct separable_traits<Cos_fully_sep_product_2D>
+    : Cos_fully_sep_traits<2> {};
+  template <>
+  struct separable_traits<Cos_fully_sep_product_4D>
+    : Cos_fully_sep_traits<4> {};
+  template <>
+  struct separable_traits<Cos_fully_sep_product_5D>
+    : Cos_fully_sep_traits<5> {};
+  template <>
+  struct separable_traits<Cos_fully_sep_product_6D>
+    : Cos_fully_sep_traits<6> {};
+  template <>
+  struct separable_traits<Cos_fully_sep_product_7D>
+    : Cos_fully_sep_traits<7> {};
+  template <>
+  struct separable_traits<Cos_fully_sep_product_8D>
+    : Cos_fully_sep_traits<8> {};
+  template <>
+  struct separable_traits<Cos_fully_sep_product_9D>
+    : Cos_fully_sep_traits<9> {};
+  template <>
+  struct separable_traits<Cos_fully_sep_product_10D>
+    : Cos_fully_sep_traits<10> {};
+  template <>
+  struct separable_traits<Cos_semi_sep_product_4D>
+    : Cos_semi_sep_traits<4> {};
+  template <>
+  struct separable_traits<Cos_semi_sep_product_6D>
+    : Cos_semi_sep_traits<6> {};
+  template <>
+  struct separable_traits<Cos_semi_sep_product_8D>
+    : Cos_semi_sep_traits<8> {};
+}
+
 class Oscillatory_3D {
 public:
   __device__ __host__ double
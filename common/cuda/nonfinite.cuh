@@ -0,0 +1,186 @@
+#ifndef CUDA_COMMON_NONFINITE_CUH
+#define CUDA_COMMON_NONFINITE_CUH
+
+#include "common/cuda/cudaMemoryUtil.h"
+#include "common/nonfinite.hh"
+#include <algorithm>
+#include <new>
+
+// Detection of NaN and infinite integrand values. Kernels test every value
+// with isfinite, which costs a compare on the path that is taken; only a
+// non-finite value takes the atomic on the counter and writes its point and
+// region. The counter doubles as the per-launch flag: it lives in mapped
+// host memory, so the host reads it after the launch without a copy.
+
+namespace quad {
+
+  // what the kernels get, by value. A default constructed log is disabled
+  // and non-finite values go through untouched, as before.
+  template <typename T>
+  struct Nonfinite_log {
+    unsigned long long* count = nullptr;
+    T* values = nullptr;       // capacity
+    T* points = nullptr;       // capacity * ndim
+    T* region_lows = nullptr;  // capacity * ndim
+    T* region_highs = nullptr; // capacity * ndim
+    unsigned capacity = 0;
+    int ndim = 0;
+    numint::nonfinite_policy policy = numint::nonfinite_policy::fail;
+
+    __device__ bool
+    enabled() const
+    {
+      return count != nullptr;
+    }
+
+    // counts value and returns the slot its point goes to, -1 once the
+    // first capacity points are taken
+    __device__ int
+    record(T value) const
+    {
+      const unsigned long long slot = atomicAdd(count, 1ull);
+      if (slot >= capacity)
+        return -1;
+      values[slot] = value;
+      return static_cast<int>(slot);
+    }
+
+    __device__ void
+    store(int slot, int dim, T x, T low, T high) const
+    {
+      if (slot < 0)
+        return;
+      points[slot * ndim + dim] = x;
+      region_lows[slot * ndim + dim] = low;
+      region_highs[slot * ndim + dim] = high;
+    }
+
+    // the value the kernel carries on with; exclude keeps it non-finite so
+    // that it reaches the region sums, where it is detected once per region
+    __device__ T
+    replacement(T value) const
+    {
+      return policy == numint::nonfinite_policy::exclude ||
+                 policy == numint::nonfinite_policy::propagate ?
+               value :
+               T(0);
+    }
+
+    // the same for a VEGAS sample, which is all VEGAS can drop, so exclude
+    // is zero there
+    __device__ T
+    sample_replacement(T value) const
+    {
+      return policy == numint::nonfinite_policy::propagate ? value : T(0);
+    }
+  };
+
+  // owns the mapped buffers behind a Nonfinite_log
+  template <typename T>
+  class Nonfinite_monitor {
+  public:
+    explicit Nonfinite_monitor(int ndim, unsigned capacity = 16)
+      : ndim(ndim), capacity(capacity)
+    {
+      const size_t num_values = capacity * (1 + 3 * static_cast<size_t>(ndim));
+      if (cudaHostAlloc((void**)&host_count,
+                        sizeof(unsigned long long),
+                        cudaHostAllocMapped) != cudaSuccess ||
+          cudaHostAlloc((void**)&host_values,
+                        sizeof(T) * num_values,
+                        cudaHostAllocMapped) != cudaSuccess) {
+        cudaFreeHost(host_count);
+        throw std::bad_alloc();
+      }
+      *host_count = 0;
+
+      unsigned long long* device_count = nullptr;
+      T* device_values = nullptr;
+      cudaHostGetDevicePointer((void**)&device_count, host_count, 0);
+      cudaHostGetDevicePointer((void**)&device_values, host_values, 0);
+      log.count = device_count;
+      log.values = device_values;
+      log.points = device_values + capacity;
+      log.region_lows = log.points + capacity * ndim;
+      log.region_highs = log.region_lows + capacity * ndim;
+      log.capacity = capacity;
+      log.ndim = ndim;
+    }
+
+    Nonfinite_monitor(const Nonfinite_monitor&) = delete;
+    Nonfinite_monitor& operator=(const Nonfinite_monitor&) = delete;
+
+    ~Nonfinite_monitor()
+    {
+      cudaFreeHost(host_values);
+      cudaFreeHost(host_count);
+    }
+
+    Nonfinite_log<T>
+    device_log() const
+    {
+      return log;
+    }
+
+    numint::nonfinite_policy
+    policy() const
+    {
+      return log.policy;
+    }
+
+    void
+    set_policy(numint::nonfinite_policy policy)
+    {
+      log.policy = policy;
+    }
+
+    // to be called while no kernel using the log runs
+    void
+    reset()
+    {
+      *static_cast<volatile unsigned long long*>(host_count) = 0;
+    }
+
+    // valid once the kernels that got the log have completed
+    size_t
+    count() const
+    {
+      return *static_cast<volatile unsigned long long*>(host_count);
+    }
+
+    bool
+    must_stop() const
+    {
+      return log.policy == numint::nonfinite_policy::fail && count() != 0;
+    }
+
+    numint::nonfinite_report
+    report() const
+    {
+      numint::nonfinite_report report;
+      report.count = count();
+      const size_t recorded = std::min<size_t>(report.count, capacity);
+      const T* points = host_values + capacity;
+      const T* lows = points + capacity * ndim;
+      const T* highs = lows + capacity * ndim;
+      for (size_t i = 0; i < recorded; ++i) {
+        numint::nonfinite_point p;
+        p.value = host_values[i];
+        p.x.assign(points + i * ndim, points + (i + 1) * ndim);
+        p.region_lows.assign(lows + i * ndim, lows + (i + 1) * ndim);
+        p.region_highs.assign(highs + i * ndim, highs + (i + 1) * ndim);
+        report.points.push_back(p);
+      }
+      return report;
+    }
+
+  private:
+    int ndim;
+    unsigned capacity;
+    unsigned long long* host_count = nullptr;
+    T* host_values = nullptr;
+    Nonfinite_log<T> log;
+  };
+}
+
+#endif
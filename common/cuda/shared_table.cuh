@@ -0,0 +1,71 @@
+#ifndef GPUINTEGRATION_COMMON_CUDA_SHARED_TABLE_CUH
+#define GPUINTEGRATION_COMMON_CUDA_SHARED_TABLE_CUH
+
+#include "common/cuda/cudaMemoryUtil.h"
+#include "common/shared_table.hh"
+#include <cstring>
+
+// Memory policies of numint::shared_table for the CUDA interpolators.
+
+namespace quad {
+
+  // device memory, the tables of the constructors
+  struct device_table_memory {
+    template <typename T>
+    static T*
+    allocate(const T* values, size_t n)
+    {
+      T* data = cuda_malloc<T>(n);
+      try {
+        cuda_memcpy_to_device<T>(data, values, n);
+      }
+      catch (...) {
+        cudaFree(data);
+        throw;
+      }
+      return data;
+    }
+
+    template <typename T>
+    static void
+    release(T* data)
+    {
+      cudaFree(data);
+    }
+  };
+
+  // managed memory, for tables the host evaluates as well (operator>>)
+  struct managed_table_memory {
+    template <typename T>
+    static T*
+    allocate(const T* values, size_t n)
+    {
+      T* data = cuda_malloc_managed<T>(n);
+      std::memcpy(data, values, sizeof(T) * n);
+      return data;
+    }
+
+    template <typename T>
+    static void
+    release(T* data)
+    {
+      cudaFree(data);
+    }
+  };
+
+  template <typename T>
+  numint::shared_table<T>
+  make_device_table(const T* values, size_t n)
+  {
+    return numint::make_shared_table<device_table_memory>(values, n);
+  }
+
+  template <typename T>
+  numint::shared_table<T>
+  make_managed_table(const T* values, size_t n)
+  {
+    return numint::make_shared_table<managed_table_memory>(values, n);
+  }
+}
+
+#endif
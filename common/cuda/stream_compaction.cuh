@@ -0,0 +1,146 @@
+#ifndef CUDA_COMMON_STREAM_COMPACTION_CUH
+#define CUDA_COMMON_STREAM_COMPACTION_CUH
+
+#include "common/cuda/cudaMemoryUtil.h"
+#include <cstddef>
+#include <new>
+
+// Single pass stream compaction. Every i < n with flag(i) true is handed to
+// scatter(i, position), position being the number of flagged indices before
+// i; the number of flagged indices is returned. One kernel evaluates the
+// flags, scans them with a decoupled look-back (Merrill & Garland,
+// "Single-pass Parallel Prefix Scan with Decoupled Look-back") and
+// scatters, replacing the multi-kernel scan, the readback of its last
+// element and the separate scatter kernel.
+//
+// Blocks take tiles in the order they start, through an atomic counter, so
+// the look-back only waits on blocks that are running. The count is written
+// by the last tile to mapped host memory and read there after the kernel.
+// Tiles finish in any order, scatter must not overwrite what other indices
+// read. compact runs on the stream it is given and waits for that stream
+// only.
+
+namespace quad {
+
+  namespace detail {
+    constexpr unsigned long long tile_aggregate = 1ull << 62;
+    constexpr unsigned long long tile_prefix = 2ull << 62;
+    constexpr unsigned long long tile_value_mask = (1ull << 62) - 1;
+
+    template <int block_size, typename Flag, typename Scatter>
+    __global__ void
+    lookback_compaction(size_t n,
+                        Flag flag,
+                        Scatter scatter,
+                        unsigned long long* status,
+                        size_t num_tiles,
+                        size_t* count)
+    {
+      static_assert(block_size % 32 == 0, "tiles are made of whole warps");
+      constexpr int num_warps = block_size / 32;
+      __shared__ unsigned long long tile;
+      __shared__ unsigned long long exclusive_prefix;
+      __shared__ int warp_offsets[num_warps];
+
+      if (threadIdx.x == 0)
+        tile = atomicAdd(status + num_tiles, 1ull);
+      __syncthreads();
+
+      const size_t i = tile * block_size + threadIdx.x;
+      const bool flagged = i < n && flag(i);
+      const int lane = threadIdx.x % 32;
+      const int warp = threadIdx.x / 32;
+      const unsigned ballot = __ballot_sync(0xffffffff, flagged);
+      const int lane_offset = __popc(ballot & ((1u << lane) - 1));
+      if (lane == 0)
+        warp_offsets[warp] = __popc(ballot);
+      __syncthreads();
+
+      if (threadIdx.x == 0) {
+        unsigned long long aggregate = 0;
+        for (int w = 0; w < num_warps; ++w) {
+          const int warp_count = warp_offsets[w];
+          warp_offsets[w] = aggregate;
+          aggregate += warp_count;
+        }
+
+        unsigned long long exclusive = 0;
+        if (tile != 0) {
+          atomicExch(status + tile, tile_aggregate | aggregate);
+          for (unsigned long long pred = tile - 1;; --pred) {
+            unsigned long long word = 0;
+            while (word == 0)
+              word = atomicAdd(status + pred, 0ull);
+            exclusive += word & tile_value_mask;
+            if ((word & ~tile_value_mask) == tile_prefix)
+              break;
+          }
+        }
+        atomicExch(status + tile, tile_prefix | (exclusive + aggregate));
+        if ((tile + 1) * block_size >= n)
+          *count = exclusive + aggregate;
+        exclusive_prefix = exclusive;
+      }
+      __syncthreads();
+
+      if (flagged)
+        scatter(i, exclusive_prefix + warp_offsets[warp] + lane_offset);
+    }
+  }
+
+  // owns the look-back state and the mapped count, reused between calls
+  class Stream_compaction {
+  public:
+    Stream_compaction()
+    {
+      if (cudaHostAlloc((void**)&host_count,
+                        sizeof(size_t),
+                        cudaHostAllocMapped) != cudaSuccess)
+        throw std::bad_alloc();
+      cudaHostGetDevicePointer((void**)&device_count, host_count, 0);
+    }
+
+    Stream_compaction(const Stream_compaction&) = delete;
+    Stream_compaction& operator=(const Stream_compaction&) = delete;
+
+    ~Stream_compaction()
+    {
+      cudaFree(status);
+      cudaFreeHost(host_count);
+    }
+
+    template <typename Flag, typename Scatter>
+    size_t
+    compact(size_t n, Flag flag, Scatter scatter, cudaStream_t stream = 0)
+    {
+      if (n == 0)
+        return 0;
+
+      const size_t num_tiles = (n + block_size - 1) / block_size;
+      if (capacity < num_tiles + 1) {
+        cudaFree(status);
+        status = cuda_malloc<unsigned long long>(num_tiles + 1);
+        capacity = num_tiles + 1;
+      }
+      // tile words and the tile counter start at zero
+      cudaMemsetAsync(
+        status, 0, sizeof(unsigned long long) * (num_tiles + 1), stream);
+      detail::lookback_compaction<block_size>
+        <<<num_tiles, block_size, 0, stream>>>(
+          n, flag, scatter, status, num_tiles, device_count);
+      cudaStreamSynchronize(stream);
+      CudaCheckError();
+      return *static_cast<volatile size_t*>(host_count);
+    }
+
+  private:
+    static constexpr int block_size = 256;
+
+    unsigned long long* status = nullptr;
+    size_t capacity = 0;
+    size_t* host_count = nullptr;
+    size_t* device_count = nullptr;
+  };
+}
+
+#endif
@@ -7,21 +7,25 @@
 #include <thrust/host_vector.h>
 #include <thrust/inner_product.h>
 #include <thrust/pair.h>
+#include <thrust/system/cuda/execution_policy.h>
 #include <thrust/transform_reduce.h>
 #include "common/cuda/custom_functions.cuh"
 #include "common/cuda/cudaMemoryUtil.h"
 
 // https://www.apriorit.com/dev-blog/614-cpp-cuda-accelerate-algorithm-cpu-gpu
 
+// dot_product, reduction and device_array_min_max run on stream and return
+// once it has reached them, the default stream unless told otherwise
+
 template <typename T1, typename T2, bool use_custom = false>
 double
-dot_product(T1* arr1, T2* arr2, const size_t size)
+dot_product(T1* arr1, T2* arr2, const size_t size, cudaStream_t stream = 0)
 {
 
   if constexpr (use_custom == false) {
     thrust::device_ptr<T1> wrapped_mask_1 = thrust::device_pointer_cast(arr1);
     thrust::device_ptr<T2> wrapped_mask_2 = thrust::device_pointer_cast(arr2);
-    double res = thrust::inner_product(thrust::device,
+    double res = thrust::inner_product(thrust::cuda::par.on(stream),
                                        wrapped_mask_2,
                                        wrapped_mask_2 + size,
                                        wrapped_mask_1,
@@ -30,20 +34,22 @@ dot_product(T1* arr1, T2* arr2, const size_t size)
     return res;
   }
 
-  double res = custom_inner_product_atomics<T1, T2>(arr1, arr2, size);
+  double res =
+    custom_inner_product_atomics<T1, T2>(arr1, arr2, size, stream);
   return res;
 }
 
 template <typename T, bool use_custom = false>
 T
-reduction(T* arr, size_t size)
+reduction(T* arr, size_t size, cudaStream_t stream = 0)
 {
   if constexpr (use_custom == false) {
     thrust::device_ptr<T> wrapped_ptr = thrust::device_pointer_cast(arr);
-    return thrust::reduce(wrapped_ptr, wrapped_ptr + size);
+    return thrust::reduce(
+      thrust::cuda::par.on(stream), wrapped_ptr, wrapped_ptr + size);
   }
 
-  return custom_reduce_atomics(arr, size);
+  return custom_reduce_atomics(arr, size, stream);
 }
 
 template <typename T, bool use_custom = false>
@@ -70,18 +76,19 @@ thrust_exclusive_scan(T* arr, size_t size, T* out)
 
 template <typename T, bool use_custom = false>
 quad::Range<T>
-device_array_min_max(T* arr, size_t size)
+device_array_min_max(T* arr, size_t size, cudaStream_t stream = 0)
 {
   quad::Range<T> range;
   if (use_custom == false) {
     thrust::device_ptr<T> d_ptrE = thrust::device_pointer_cast(arr);
-    auto __tuple = thrust::minmax_element(d_ptrE, d_ptrE + size);
+    auto __tuple = thrust::minmax_element(
+      thrust::cuda::par.on(stream), d_ptrE, d_ptrE + size);
     range.low = *__tuple.first;
     range.high = *__tuple.second;
     return range;
   }
 
-  auto res = min_max<T>(arr, size);
+  auto res = min_max<T>(arr, size, stream);
   range.low = res.first;
   range.high = res.second;
   return range;
@@ -0,0 +1,508 @@
+#ifndef GPUINTEGRATION_COMMON_INTEGRATION_CACHE_H
+#define GPUINTEGRATION_COMMON_INTEGRATION_CACHE_H
+
+#include "common/integration_result.hh"
+#include "common/vegas_grid.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace numint {
+
+  // integration_key identifies an integration problem up to its tolerances:
+  // a user chosen name of the integrand and its parameters, the algorithm
+  // with whatever settings change its answer (ncall for vegas, the rule for
+  // cubacpp, ...), the bounds and any extra values added with add. Values
+  // enter bit for bit.
+  class integration_key {
+  public:
+    integration_key(std::string const& integrand, std::string const& algorithm)
+    {
+      add(integrand);
+      add(algorithm);
+    }
+
+    template <typename Volume>
+    integration_key(std::string const& integrand,
+                    std::string const& algorithm,
+                    Volume const& vol)
+      : integration_key(integrand, algorithm)
+    {
+      const size_t ndim = std::size(vol.lows);
+      add(static_cast<double>(ndim));
+      for (size_t dim = 0; dim < ndim; ++dim) {
+        add(static_cast<double>(vol.lows[dim]));
+        add(static_cast<double>(vol.highs[dim]));
+      }
+    }
+
+    integration_key&
+    add(double value)
+    {
+      canonical.append(reinterpret_cast<char const*>(&value), sizeof(value));
+      return *this;
+    }
+
+    integration_key&
+    add(std::string const& value)
+    {
+      const uint64_t size = value.size();
+      canonical.append(reinterpret_cast<char const*>(&size), sizeof(size));
+      canonical.append(value);
+      return *this;
+    }
+
+    std::string const&
+    bytes() const
+    {
+      return canonical;
+    }
+
+    uint64_t
+    hash() const
+    {
+      return fnv1a(canonical.data(), canonical.size());
+    }
+
+    static uint64_t
+    fnv1a(void const* data, size_t size, uint64_t h = 14695981039346656037ull)
+    {
+      auto bytes = static_cast<unsigned char const*>(data);
+      for (size_t i = 0; i < size; ++i) {
+        h ^= bytes[i];
+        h *= 1099511628211ull;
+      }
+      return h;
+    }
+
+  private:
+    std::string canonical;
+  };
+
+  // a cached run: the tolerances it was asked for, its result and, for
+  // VEGAS, the adapted grid
+  struct cache_entry {
+    double epsrel = 0.;
+    double epsabs = 0.;
+    integration_result result;
+    vegas_grid grid;
+  };
+
+  // cubacpp results carry the same information under other names
+  template <typename Cubacpp_result>
+  integration_result
+  from_cubacpp(Cubacpp_result const& r)
+  {
+    integration_result res;
+    res.estimate = r.value;
+    res.errorest = r.error;
+    res.neval = r.neval;
+    res.nregions = r.nregions;
+    res.status = r.status;
+    return res;
+  }
+
+  // integration_cache keeps integration results in an append-only file,
+  // indexed by the hash of their integration_key. The file is memory mapped
+  // for reading; appends hold an exclusive flock on it and index scans a
+  // shared one, so several processes (and the threads of one) can share a
+  // cache. Every record is checksummed; a torn record left by a crashed
+  // writer is cut off by the next append.
+  //
+  // A stored run answers a request when it converged to within the requested
+  // tolerances, or when it was made with exactly those tolerances. Otherwise
+  // the most accurate stored run of the problem is offered as a warm start,
+  // which for VEGAS means starting from its adapted grid. Pagani runs get
+  // no warm start from the cache, the grid handed to them stays empty; the
+  // CUDA Workspace can warm-start from a Partition_checkpoint file instead.
+  //
+  //   numint::integration_cache cache("results.cache");
+  //   numint::integration_key key("gauss(a=2)", "pagani", vol);
+  //   auto res = cache.integrate(key, epsrel, epsabs, [&](auto*) {
+  //     return workspace.integrate(integrand, epsrel, epsabs, vol);
+  //   });
+  //   numint::integration_key vkey("gauss(a=2)", "mcubes ncall=1e6", vol);
+  //   res = cache.integrate(vkey, epsrel, epsabs, [&](vegas_grid* grid) {
+  //     return mcubes::integrate<F, ndim>(f, epsrel, epsabs, 1e6, &vol,
+  //                                       15, 15, 5, grid);
+  //   });
+
+  class integration_cache {
+  public:
+    explicit integration_cache(std::string const& filename);
+    ~integration_cache();
+
+    integration_cache(integration_cache const&) = delete;
+    integration_cache& operator=(integration_cache const&) = delete;
+
+    bool lookup(integration_key const& key,
+                double epsrel,
+                double epsabs,
+                cache_entry& entry);
+
+    bool warm_start(integration_key const& key, cache_entry& entry);
+
+    void store(integration_key const& key, cache_entry const& entry);
+
+    // returns the cached result if one answers the request, otherwise calls
+    // run(vegas_grid*) with the warm start grid (empty without one) and
+    // stores what it returns along with the grid it leaves behind
+    template <typename Run>
+    integration_result
+    integrate(integration_key const& key,
+              double epsrel,
+              double epsabs,
+              Run run)
+    {
+      cache_entry entry;
+      if (lookup(key, epsrel, epsabs, entry))
+        return entry.result;
+      if (!warm_start(key, entry))
+        entry = cache_entry();
+      entry.epsrel = epsrel;
+      entry.epsabs = epsabs;
+      entry.result = run(&entry.grid);
+      store(key, entry);
+      return entry.result;
+    }
+
+    size_t size();
+
+  private:
+    struct file_header {
+      char magic[8];
+      uint64_t version;
+    };
+
+    struct record_header {
+      uint64_t record_size;
+      uint64_t checksum; // of the record past this field
+      uint64_t hash;
+      uint64_t key_size;
+      double epsrel;
+      double epsabs;
+      double estimate;
+      double errorest;
+      double chi_sq;
+      uint64_t neval;
+      uint64_t nregions;
+      uint64_t nFinishedRegions;
+      uint64_t iters;
+      int64_t status;
+      int64_t lastPhase;
+      int64_t grid_ndim;
+      int64_t grid_nbins;
+      double grid_si;
+      double grid_swgt;
+      double grid_schi;
+      uint64_t grid_iters;
+    };
+
+    static constexpr char file_magic[8] = {
+      'N', 'U', 'M', 'I', 'C', 'A', 'C', 'H'};
+    static constexpr uint64_t file_version = 1;
+
+    static size_t
+    padded(size_t bytes)
+    {
+      return (bytes + 7) / 8 * 8;
+    }
+
+    void refresh();
+    size_t scan();
+    bool valid_record(size_t offset) const;
+    void read(size_t offset, cache_entry& entry) const;
+    bool same_key(size_t offset, integration_key const& key) const;
+    void remap(size_t bytes);
+    template <typename Select>
+    bool find(integration_key const& key, cache_entry& entry, Select select);
+
+    std::string filename;
+    int fd = -1;
+    char const* mapping = nullptr;
+    size_t mapped_bytes = 0;
+    size_t indexed_bytes = sizeof(file_header);
+    std::unordered_multimap<uint64_t, size_t> index; // hash -> offset
+    std::mutex mutex;
+  };
+}
+
+inline numint::integration_cache::integration_cache(std::string const& filename)
+  : filename(filename)
+{
+  fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (fd < 0)
+    throw std::runtime_error("cannot open integration cache " + filename);
+
+  ::flock(fd, LOCK_EX);
+  struct stat st;
+  ::fstat(fd, &st);
+  file_header header;
+  bool ok = true;
+  if (st.st_size == 0) {
+    std::memcpy(header.magic, file_magic, sizeof(header.magic));
+    header.version = file_version;
+    ok = ::write(fd, &header, sizeof(header)) == sizeof(header);
+  } else {
+    ok = ::pread(fd, &header, sizeof(header), 0) == sizeof(header) &&
+         std::memcmp(header.magic, file_magic, sizeof(header.magic)) == 0 &&
+         header.version == file_version;
+  }
+  ::flock(fd, LOCK_UN);
+  if (!ok) {
+    ::close(fd);
+    throw std::runtime_error(filename + " is not an integration cache");
+  }
+}
+
+inline numint::integration_cache::~integration_cache()
+{
+  if (mapping != nullptr)
+    ::munmap(const_cast<char*>(mapping), mapped_bytes);
+  ::close(fd);
+}
+
+inline void
+numint::integration_cache::remap(size_t bytes)
+{
+  // another process may have cut off a torn record, so the file can shrink
+  if (bytes == mapped_bytes)
+    return;
+  if (mapping != nullptr)
+    ::munmap(const_cast<char*>(mapping), mapped_bytes);
+  void* map = ::mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED) {
+    mapping = nullptr;
+    mapped_bytes = 0;
+    throw std::runtime_error("cannot map integration cache " + filename);
+  }
+  mapping = static_cast<char const*>(map);
+  mapped_bytes = bytes;
+}
+
+inline bool
+numint::integration_cache::valid_record(size_t offset) const
+{
+  if (offset + sizeof(record_header) > mapped_bytes)
+    return false;
+  record_header header;
+  std::memcpy(&header, mapping + offset, sizeof(header));
+  if (header.record_size < sizeof(header) || header.record_size % 8 != 0 ||
+      header.record_size > mapped_bytes - offset)
+    return false;
+  constexpr size_t skip = 2 * sizeof(uint64_t);
+  return header.checksum ==
+         integration_key::fnv1a(mapping + offset + skip,
+                                header.record_size - skip);
+}
+
+// indexes the records appended since the last scan, returns the end of the
+// last valid one; the caller holds a lock on the file
+inline size_t
+numint::integration_cache::scan()
+{
+  struct stat st;
+  ::fstat(fd, &st);
+  remap(static_cast<size_t>(st.st_size));
+  while (valid_record(indexed_bytes)) {
+    record_header header;
+    std::memcpy(&header, mapping + indexed_bytes, sizeof(header));
+    index.emplace(header.hash, indexed_bytes);
+    indexed_bytes += header.record_size;
+  }
+  return indexed_bytes;
+}
+
+inline void
+numint::integration_cache::refresh()
+{
+  ::flock(fd, LOCK_SH);
+  scan();
+  ::flock(fd, LOCK_UN);
+}
+
+inline bool
+numint::integration_cache::same_key(size_t offset,
+                                    integration_key const& key) const
+{
+  record_header header;
+  std::memcpy(&header, mapping + offset, sizeof(header));
+  return header.key_size == key.bytes().size() &&
+         std::memcmp(mapping + offset + sizeof(header),
+                     key.bytes().data(),
+                     header.key_size) == 0;
+}
+
+inline void
+numint::integration_cache::read(size_t offset, cache_entry& entry) const
+{
+  record_header header;
+  std::memcpy(&header, mapping + offset, sizeof(header));
+  entry.epsrel = header.epsrel;
+  entry.epsabs = header.epsabs;
+  entry.result.estimate = header.estimate;
+  entry.result.errorest = header.errorest;
+  entry.result.chi_sq = header.chi_sq;
+  entry.result.neval = header.neval;
+  entry.result.nregions = header.nregions;
+  entry.result.nFinishedRegions = header.nFinishedRegions;
+  entry.result.iters = header.iters;
+  entry.result.status = static_cast<int>(header.status);
+  entry.result.lastPhase = static_cast<int>(header.lastPhase);
+
+  entry.grid = vegas_grid();
+  if (header.grid_ndim > 0 && header.grid_nbins > 0) {
+    entry.grid.resize(static_cast<int>(header.grid_ndim),
+                      static_cast<int>(header.grid_nbins));
+    std::memcpy(entry.grid.xi.data(),
+                mapping + offset + sizeof(header) + padded(header.key_size),
+                entry.grid.xi.size() * sizeof(double));
+    entry.grid.si = header.grid_si;
+    entry.grid.swgt = header.grid_swgt;
+    entry.grid.schi = header.grid_schi;
+    entry.grid.iters = header.grid_iters;
+  }
+}
+
+template <typename Select>
+bool
+numint::integration_cache::find(integration_key const& key,
+                                cache_entry& entry,
+                                Select select)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  refresh();
+  bool found = false;
+  auto [first, last] = index.equal_range(key.hash());
+  for (auto it = first; it != last; ++it) {
+    if (!same_key(it->second, key))
+      continue;
+    cache_entry candidate;
+    read(it->second, candidate);
+    if (select(candidate, found ? &entry : nullptr)) {
+      entry = std::move(candidate);
+      found = true;
+    }
+  }
+  return found;
+}
+
+inline bool
+numint::integration_cache::lookup(integration_key const& key,
+                                  double epsrel,
+                                  double epsabs,
+                                  cache_entry& entry)
+{
+  return find(key, entry, [=](cache_entry const& c, cache_entry const* best) {
+    const bool converged =
+      c.result.status == 0 &&
+      c.result.errorest <=
+        std::max(epsabs, epsrel * std::fabs(c.result.estimate));
+    const bool same_request = c.epsrel == epsrel && c.epsabs == epsabs;
+    if (!converged && !same_request)
+      return false;
+    return best == nullptr || c.result.errorest < best->result.errorest;
+  });
+}
+
+inline bool
+numint::integration_cache::warm_start(integration_key const& key,
+                                      cache_entry& entry)
+{
+  return find(key, entry, [](cache_entry const& c, cache_entry const* best) {
+    return best == nullptr || c.result.errorest < best->result.errorest;
+  });
+}
+
+inline void
+numint::integration_cache::store(integration_key const& key,
+                                 cache_entry const& entry)
+{
+  record_header header{};
+  header.hash = key.hash();
+  header.key_size = key.bytes().size();
+  header.epsrel = entry.epsrel;
+  header.epsabs = entry.epsabs;
+  header.estimate = entry.result.estimate;
+  header.errorest = entry.result.errorest;
+  header.chi_sq = entry.result.chi_sq;
+  header.neval = entry.result.neval;
+  header.nregions = entry.result.nregions;
+  header.nFinishedRegions = entry.result.nFinishedRegions;
+  header.iters = entry.result.iters;
+  header.status = entry.result.status;
+  header.lastPhase = entry.result.lastPhase;
+  if (!entry.grid.empty()) {
+    header.grid_ndim = entry.grid.ndim;
+    header.grid_nbins = entry.grid.nbins;
+    header.grid_si = entry.grid.si;
+    header.grid_swgt = entry.grid.swgt;
+    header.grid_schi = entry.grid.schi;
+    header.grid_iters = entry.grid.iters;
+  }
+  const size_t grid_bytes = entry.grid.xi.size() * sizeof(double);
+  header.record_size = sizeof(header) + padded(header.key_size) + grid_bytes;
+
+  std::vector<char> record(header.record_size, 0);
+  std::memcpy(record.data() + sizeof(header),
+              key.bytes().data(),
+              header.key_size);
+  if (!entry.grid.empty())
+    std::memcpy(record.data() + sizeof(header) + padded(header.key_size),
+                entry.grid.xi.data(),
+                grid_bytes);
+  std::memcpy(record.data(), &header, sizeof(header));
+  // the checksum covers the record past the size and checksum fields
+  constexpr size_t skip = 2 * sizeof(uint64_t);
+  header.checksum =
+    integration_key::fnv1a(record.data() + skip, record.size() - skip);
+  std::memcpy(record.data(), &header, sizeof(header));
+
+  std::lock_guard<std::mutex> lock(mutex);
+  ::flock(fd, LOCK_EX);
+  const size_t end = scan();
+  if (end < mapped_bytes && ::ftruncate(fd, static_cast<off_t>(end)) != 0) {
+    ::flock(fd, LOCK_UN);
+    throw std::runtime_error("cannot repair integration cache " + filename);
+  }
+
+  size_t written = 0;
+  while (written < record.size()) {
+    const ssize_t n =
+      ::write(fd, record.data() + written, record.size() - written);
+    if (n <= 0) {
+      // leave no partial record behind
+      (void)::ftruncate(fd, static_cast<off_t>(end));
+      ::flock(fd, LOCK_UN);
+      throw std::runtime_error("failed to write integration cache " +
+                               filename);
+    }
+    written += static_cast<size_t>(n);
+  }
+  scan();
+  ::flock(fd, LOCK_UN);
+}
+
+inline size_t
+numint::integration_cache::size()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  refresh();
+  return index.size();
+}
+
+#endif
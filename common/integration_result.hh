@@ -1,6 +1,8 @@
 #ifndef GPUINTEGRATION_COMMON_INTEGRATION_RESULT_H
 #define GPUINTEGRATION_COMMON_INTEGRATION_RESULT_H
 
+#include <array>
+#include <cstddef>
 #include <ostream>
 
 namespace numint {
@@ -21,6 +23,42 @@ namespace numint {
   };
 
   std::ostream& operator<<(std::ostream& os, integration_result const& res);
+
+  // integration_results<N> is the return type when integrating an integrand
+  // with N components. Estimates, error estimates and chi_sq are per
+  // component, the rest is shared by all components.
+
+  template <std::size_t N>
+  struct integration_results {
+    std::array<double, N> estimate{};
+    std::array<double, N> errorest{};
+    std::array<double, N> chi_sq{};
+    size_t neval = 0;
+    size_t nregions = 0;
+    size_t nFinishedRegions = 0;
+    int status = -1;
+    int lastPhase = -1;
+    size_t iters = 0;
+
+    integration_result component(std::size_t i) const;
+  };
+}
+
+template <std::size_t N>
+numint::integration_result
+numint::integration_results<N>::component(std::size_t i) const
+{
+  integration_result res;
+  res.estimate = estimate[i];
+  res.errorest = errorest[i];
+  res.chi_sq = chi_sq[i];
+  res.neval = neval;
+  res.nregions = nregions;
+  res.nFinishedRegions = nFinishedRegions;
+  res.status = status;
+  res.lastPhase = lastPhase;
+  res.iters = iters;
+  return res;
 }
 
 inline std::ostream&
@@ -0,0 +1,147 @@
+#ifndef GPUINTEGRATION_COMMON_INTEGRATION_SCHEDULER_H
+#define GPUINTEGRATION_COMMON_INTEGRATION_SCHEDULER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace numint {
+
+  // integration_scheduler runs integration jobs on a fixed pool of workers,
+  // so that at most max_in_flight integrations are running while the caller
+  // keeps queueing more. Jobs start in submission order. Every worker owns a
+  // slot in [0, max_in_flight) which it hands to the jobs it runs; drivers
+  // use it to give each in-flight integration its own resources, e.g. a
+  // workspace bound to its own execution space instance.
+  //
+  // submit returns a future for the result of the job. The optional
+  // completion callback runs on the worker with the result before the future
+  // becomes ready, so results can be consumed in completion order. An
+  // exception thrown by the job or the callback is stored in the future.
+
+  class integration_scheduler {
+  public:
+    explicit integration_scheduler(
+      size_t max_in_flight = std::thread::hardware_concurrency())
+    {
+      if (max_in_flight == 0)
+        max_in_flight = 1;
+      for (size_t slot = 0; slot < max_in_flight; ++slot)
+        workers.emplace_back([this, slot]() { run(slot); });
+    }
+
+    integration_scheduler(integration_scheduler const&) = delete;
+    integration_scheduler& operator=(integration_scheduler const&) = delete;
+
+    // finishes the queued jobs before returning
+    ~integration_scheduler()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+      }
+      work_ready.notify_all();
+      for (auto& worker : workers)
+        worker.join();
+    }
+
+    size_t
+    max_in_flight() const
+    {
+      return workers.size();
+    }
+
+    template <typename Job>
+    auto
+    submit(Job job)
+    {
+      return submit(std::move(job), [](auto const&) {});
+    }
+
+    template <typename Job, typename Callback>
+    auto
+    submit(Job job, Callback on_done)
+      -> std::future<std::invoke_result_t<Job&, size_t>>
+    {
+      using Result = std::invoke_result_t<Job&, size_t>;
+      auto task = std::make_shared<std::packaged_task<Result(size_t)>>(
+        [job = std::move(job),
+         on_done = std::move(on_done)](size_t slot) mutable {
+          Result result = job(slot);
+          on_done(static_cast<Result const&>(result));
+          return result;
+        });
+      auto result = task->get_future();
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.emplace_back([task](size_t slot) { (*task)(slot); });
+        ++pending;
+      }
+      work_ready.notify_one();
+      return result;
+    }
+
+    // blocks until every job submitted so far has finished
+    void
+    wait()
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      all_done.wait(lock, [this]() { return pending == 0; });
+    }
+
+  private:
+    void
+    run(size_t slot)
+    {
+      while (true) {
+        std::function<void(size_t)> job;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          work_ready.wait(lock,
+                          [this]() { return stopping || !queue.empty(); });
+          if (queue.empty())
+            return;
+          job = std::move(queue.front());
+          queue.pop_front();
+        }
+
+        job(slot);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pending == 0)
+          all_done.notify_all();
+      }
+    }
+
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable all_done;
+    std::deque<std::function<void(size_t)>> queue;
+    size_t pending = 0; // queued or running
+    bool stopping = false;
+    std::vector<std::thread> workers;
+  };
+
+  // Runs integrator.integrate(args...) on a thread of its own. The arguments
+  // are copied; the integrator is not, it must outlive the future and must
+  // not be used for anything else until the future is ready. Works for any
+  // of the integrators with an integrate member, e.g. the cubacpp ones.
+  template <typename Integrator, typename... Args>
+  auto
+  integrate_async(Integrator& integrator, Args... args)
+  {
+    return std::async(std::launch::async, [&integrator, args...]() {
+      return integrator.integrate(args...);
+    });
+  }
+}
+
+#endif
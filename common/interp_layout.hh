@@ -0,0 +1,255 @@
+#ifndef GPUINTEGRATION_COMMON_INTERP_LAYOUT_HH
+#define GPUINTEGRATION_COMMON_INTERP_LAYOUT_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Storage orders for the value tables of the interpolators. A table of
+// extents n[0] x ... x n[ndim - 1] is always given in row-major order, the
+// first dimension (x) fastest, and rearranged once when it is copied to the
+// device. A lookup reads the 2^ndim corners of one cell; corner c is the
+// point cell + (bit d of c) along each dimension d.
+//
+//   row_major_layout:    the input order, what the interpolators always used
+//   tiled_layout<L>:     tiles of 2^L points along each dimension, row-major
+//                        inside, the tiles themselves in row-major order
+//   morton_layout<L>:    the same tiles, Morton (Z) order inside
+//   packed_cell_layout:  the corners of each cell stored together, one
+//                        contiguous read of 2^ndim values per lookup at the
+//                        price of 2^ndim times the memory
+//
+// Tiles at the upper edges are padded, so the tiled layouts use up to
+// (2^L - 1) extra points per dimension.
+
+#if defined(__CUDACC__) || defined(__HIPCC__)
+#define INTERP_LAYOUT_FUNCTION __host__ __device__ inline
+#else
+#define INTERP_LAYOUT_FUNCTION inline
+#endif
+
+namespace numint {
+
+  namespace detail {
+    template <int ndim>
+    INTERP_LAYOUT_FUNCTION size_t
+    row_major_index(const size_t* n, const size_t* i)
+    {
+      size_t index = i[ndim - 1];
+      for (int d = ndim - 2; d >= 0; --d)
+        index = index * n[d] + i[d];
+      return index;
+    }
+
+    // loads the corners through the index of each of them
+    template <typename Layout, int ndim>
+    INTERP_LAYOUT_FUNCTION void
+    indexed_corners(const double* table,
+                    const size_t* n,
+                    const size_t* cell,
+                    double* q)
+    {
+      for (int c = 0; c < (1 << ndim); ++c) {
+        size_t i[ndim];
+        for (int d = 0; d < ndim; ++d)
+          i[d] = cell[d] + ((c >> d) & 1);
+        q[c] = table[Layout::template index<ndim>(n, i)];
+      }
+    }
+  }
+
+  struct row_major_layout {
+    static constexpr bool packs_cells = false;
+
+    template <int ndim>
+    static size_t
+    storage(const size_t* n)
+    {
+      size_t size = 1;
+      for (int d = 0; d < ndim; ++d)
+        size *= n[d];
+      return size;
+    }
+
+    template <int ndim>
+    INTERP_LAYOUT_FUNCTION static size_t
+    index(const size_t* n, const size_t* i)
+    {
+      return detail::row_major_index<ndim>(n, i);
+    }
+
+    template <int ndim>
+    INTERP_LAYOUT_FUNCTION static void
+    corners(const double* table, const size_t* n, const size_t* cell, double* q)
+    {
+      detail::indexed_corners<row_major_layout, ndim>(table, n, cell, q);
+    }
+  };
+
+  // the tiled layouts, Local gives the order within a tile
+  template <unsigned L, typename Local>
+  struct tile_grid_layout {
+    static_assert(L >= 1 && L <= 8, "tile edges go from 2 to 256 points");
+    static constexpr bool packs_cells = false;
+    static constexpr size_t edge = size_t{1} << L;
+
+    template <int ndim>
+    static size_t
+    storage(const size_t* n)
+    {
+      size_t tiles = 1;
+      for (int d = 0; d < ndim; ++d)
+        tiles *= (n[d] + edge - 1) >> L;
+      return tiles << (ndim * L);
+    }
+
+    template <int ndim>
+    INTERP_LAYOUT_FUNCTION static size_t
+    index(const size_t* n, const size_t* i)
+    {
+      size_t tiles[ndim], tile[ndim], local[ndim];
+      for (int d = 0; d < ndim; ++d) {
+        tiles[d] = (n[d] + edge - 1) >> L;
+        tile[d] = i[d] >> L;
+        local[d] = i[d] & (edge - 1);
+      }
+      return (detail::row_major_index<ndim>(tiles, tile) << (ndim * L)) |
+             Local::template index<ndim, L>(local);
+    }
+
+    template <int ndim>
+    INTERP_LAYOUT_FUNCTION static void
+    corners(const double* table, const size_t* n, const size_t* cell, double* q)
+    {
+      detail::indexed_corners<tile_grid_layout, ndim>(table, n, cell, q);
+    }
+  };
+
+  namespace detail {
+    struct row_major_tile {
+      template <int ndim, unsigned L>
+      INTERP_LAYOUT_FUNCTION static size_t
+      index(const size_t* local)
+      {
+        size_t index = 0;
+        for (int d = ndim - 1; d >= 0; --d)
+          index = (index << L) | local[d];
+        return index;
+      }
+    };
+
+    // bit b of coordinate d goes to bit b * ndim + d
+    struct morton_tile {
+      template <int ndim, unsigned L>
+      INTERP_LAYOUT_FUNCTION static size_t
+      index(const size_t* local)
+      {
+        size_t index = 0;
+        for (unsigned b = 0; b < L; ++b)
+          for (int d = 0; d < ndim; ++d)
+            index |= ((local[d] >> b) & 1u) << (b * ndim + d);
+        return index;
+      }
+    };
+  }
+
+  template <unsigned L = 3>
+  using tiled_layout = tile_grid_layout<L, detail::row_major_tile>;
+
+  template <unsigned L = 4>
+  using morton_layout = tile_grid_layout<L, detail::morton_tile>;
+
+  // cells in row-major order over their lower corners, 2^ndim values each;
+  // there is no index of a single point
+  struct packed_cell_layout {
+    static constexpr bool packs_cells = true;
+
+    template <int ndim>
+    static size_t
+    storage(const size_t* n)
+    {
+      size_t cells = 1;
+      for (int d = 0; d < ndim; ++d)
+        cells *= n[d] - 1;
+      return cells << ndim;
+    }
+
+    template <int ndim>
+    INTERP_LAYOUT_FUNCTION static void
+    corners(const double* table, const size_t* n, const size_t* cell, double* q)
+    {
+      size_t cells[ndim];
+      for (int d = 0; d < ndim; ++d)
+        cells[d] = n[d] - 1;
+      const double* block =
+        table + (detail::row_major_index<ndim>(cells, cell) << ndim);
+      for (int c = 0; c < (1 << ndim); ++c)
+        q[c] = block[c];
+    }
+  };
+
+  // values, in row-major order, rearranged into the storage of Layout
+  template <typename Layout, int ndim>
+  std::vector<double>
+  lay_out(const double* values, const size_t* n)
+  {
+    std::vector<double> table(Layout::template storage<ndim>(n), 0.);
+    if constexpr (Layout::packs_cells) {
+      for (size_t k = 0; k < table.size(); ++k) {
+        size_t rest = k >> ndim;
+        size_t corner[ndim];
+        for (int d = 0; d < ndim; ++d) {
+          corner[d] = rest % (n[d] - 1) + ((k >> d) & 1);
+          rest /= n[d] - 1;
+        }
+        table[k] = values[detail::row_major_index<ndim>(n, corner)];
+      }
+    } else {
+      const size_t points = row_major_layout::storage<ndim>(n);
+      for (size_t k = 0; k < points; ++k) {
+        size_t rest = k;
+        size_t i[ndim];
+        for (int d = 0; d < ndim; ++d) {
+          i[d] = rest % n[d];
+          rest /= n[d];
+        }
+        table[Layout::template index<ndim>(n, i)] = values[k];
+      }
+    }
+    return table;
+  }
+
+  // the blends of quad::Interp2D and quad::Interp3D, corners as above
+  INTERP_LAYOUT_FUNCTION double
+  bilinear(const double* q,
+           double x,
+           double x1_val,
+           double x2_val,
+           double y,
+           double y1_val,
+           double y2_val)
+  {
+    const double f_x_y1 = q[0] * (x2_val - x) / (x2_val - x1_val) +
+                          q[1] * (x - x1_val) / (x2_val - x1_val);
+    const double f_x_y2 = q[2] * (x2_val - x) / (x2_val - x1_val) +
+                          q[3] * (x - x1_val) / (x2_val - x1_val);
+    return f_x_y1 * (y2_val - y) / (y2_val - y1_val) +
+           f_x_y2 * (y - y1_val) / (y2_val - y1_val);
+  }
+
+  INTERP_LAYOUT_FUNCTION double
+  trilinear(const double* q, double x_d, double y_d, double z_d)
+  {
+    // interpolate along x
+    const double c00 = q[0] * (1 - x_d) + q[1] * x_d;
+    const double c01 = q[4] * (1 - x_d) + q[5] * x_d;
+    const double c10 = q[2] * (1 - x_d) + q[3] * x_d;
+    const double c11 = q[6] * (1 - x_d) + q[7] * x_d;
+    // then y and z
+    const double c0 = c00 * (1 - y_d) + c10 * y_d;
+    const double c1 = c01 * (1 - y_d) + c11 * y_d;
+    return c0 * (1 - z_d) + c1 * z_d;
+  }
+}
+
+#endif
@@ -33,10 +33,7 @@ namespace quad {
       _cols = xs.extent(0);
       _rows = ys.extent(0);
 
-      interpT = ViewDouble("interpT", _cols * _rows);
-      interpC = ViewDouble("interpC", _cols);
-      interpR = ViewDouble("interpR", _rows);
-
+      // the views are shared, not copied
       interpC = xs;
       interpR = ys;
       interpT = zs;
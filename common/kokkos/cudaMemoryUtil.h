@@ -19,6 +19,8 @@ typedef Kokkos::View<const size_t*, Kokkos::CudaSpace> constViewVectorSize_t;
 // policies
 typedef Kokkos::TeamPolicy<> team_policy;
 typedef Kokkos::TeamPolicy<>::member_type member_type;
+// instance kernels are queued on, each one a stream on GPU backends
+typedef Kokkos::DefaultExecutionSpace ExecSpace;
 //-------------------------------------------------------------------------------
 // Shared Memory
 typedef Kokkos::View<double*,
@@ -122,6 +124,16 @@ namespace quad {
     return temp;
   }
 
+  // zero-initializes on space instead of the default instance
+  template <class T>
+  Kokkos::View<T*, Kokkos::CudaSpace>
+  cuda_malloc(size_t size, const ExecSpace& space)
+  {
+    Kokkos::View<T*, Kokkos::CudaSpace> temp(Kokkos::view_alloc(space, "temp"),
+                                             size);
+    return temp;
+  }
+
   template <typename T>
   void
   cuda_memcpy_to_device(T* dest, T* src, size_t size)
@@ -262,10 +274,15 @@ namespace quad {
 
   template <typename T>
   void
-  set_array_to_value(T* array, size_t size, T val)
+  set_array_to_value(T* array,
+                     size_t size,
+                     T val,
+                     const ExecSpace& space = ExecSpace())
   {
     Kokkos::parallel_for(
-      "Loop1", size, KOKKOS_LAMBDA(const int& i) { array[i] = val; });
+      "Loop1",
+      Kokkos::RangePolicy<ExecSpace>(space, 0, size),
+      KOKKOS_LAMBDA(const int& i) { array[i] = val; });
   }
 
   template <typename T>
@@ -286,10 +303,15 @@ namespace quad {
 
   template <typename T>
   void
-  set_device_array(T* arr, size_t size, T val)
+  set_device_array(T* arr,
+                   size_t size,
+                   T val,
+                   const ExecSpace& space = ExecSpace())
   {
     Kokkos::parallel_for(
-      "Loop1", size, KOKKOS_LAMBDA(const int& i) { arr[i] = val; });
+      "Loop1",
+      Kokkos::RangePolicy<ExecSpace>(space, 0, size),
+      KOKKOS_LAMBDA(const int& i) { arr[i] = val; });
   }
 
   template <typename T, typename C = T>
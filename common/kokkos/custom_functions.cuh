@@ -12,12 +12,14 @@
 
 template <typename T>
 T
-custom_reduce(Kokkos::View<T*, Kokkos::CudaSpace> arr, size_t size)
+custom_reduce(Kokkos::View<T*, Kokkos::CudaSpace> arr,
+              size_t size,
+              const ExecSpace& space = ExecSpace())
 {
   T res = 0.;
   Kokkos::parallel_reduce(
     "Estimate computation",
-    size,
+    Kokkos::RangePolicy<ExecSpace>(space, 0, size),
     KOKKOS_LAMBDA(const int64_t index, T& valueToUpdate) {
       valueToUpdate += arr(index);
     },
@@ -29,13 +31,14 @@ custom_reduce(Kokkos::View<T*, Kokkos::CudaSpace> arr, size_t size)
 template <typename T1, typename T2>
 T2
 custom_inner_product(Kokkos::View<T1*, Kokkos::CudaSpace> arr1,
-                     Kokkos::View<T2*, Kokkos::CudaSpace> arr2)
+                     Kokkos::View<T2*, Kokkos::CudaSpace> arr2,
+                     const ExecSpace& space = ExecSpace())
 {
   size_t size = std::min(arr1.extent(0), arr2.extent(0));
   T2 res;
   Kokkos::parallel_reduce(
     "ProParRed1",
-    size,
+    Kokkos::RangePolicy<ExecSpace>(space, 0, size),
     KOKKOS_LAMBDA(const int64_t index, T2& valueToUpdate) {
       valueToUpdate += static_cast<T2>(arr1(index)) * arr2(index);
     },
@@ -45,11 +48,12 @@ custom_inner_product(Kokkos::View<T1*, Kokkos::CudaSpace> arr1,
 
 template <typename T>
 double
-ComputeMax(Kokkos::View<T*, Kokkos::CudaSpace> list)
+ComputeMax(Kokkos::View<T*, Kokkos::CudaSpace> list,
+           const ExecSpace& space = ExecSpace())
 {
   T max;
   Kokkos::parallel_reduce(
-    list.extent(0),
+    Kokkos::RangePolicy<ExecSpace>(space, 0, list.extent(0)),
     KOKKOS_LAMBDA(const int& index, T& lmax) {
       if (lmax < list(index))
         lmax = list(index);
@@ -60,11 +64,12 @@ ComputeMax(Kokkos::View<T*, Kokkos::CudaSpace> list)
 
 template <typename T>
 T
-ComputeMin(Kokkos::View<T*, Kokkos::CudaSpace> list)
+ComputeMin(Kokkos::View<T*, Kokkos::CudaSpace> list,
+           const ExecSpace& space = ExecSpace())
 {
   T min;
   Kokkos::parallel_reduce(
-    list.extent(0),
+    Kokkos::RangePolicy<ExecSpace>(space, 0, list.extent(0)),
     KOKKOS_LAMBDA(const int& index, T& lmin) {
       if (lmin > list(index))
         lmin = list(index);
@@ -75,9 +80,10 @@ ComputeMin(Kokkos::View<T*, Kokkos::CudaSpace> list)
 
 template <typename T>
 std::pair<T, T>
-min_max(Kokkos::View<T*, Kokkos::CudaSpace> input)
+min_max(Kokkos::View<T*, Kokkos::CudaSpace> input,
+        const ExecSpace& space = ExecSpace())
 {
-  return {ComputeMin<T>(input), ComputeMax<T>(input)};
+  return {ComputeMin<T>(input, space), ComputeMax<T>(input, space)};
 }
 
 #endif
@@ -0,0 +1,204 @@
+#ifndef KOKKOS_COMMON_STREAM_COMPACTION_CUH
+#define KOKKOS_COMMON_STREAM_COMPACTION_CUH
+
+#include "common/kokkos/cudaMemoryUtil.h"
+
+// Single pass stream compaction: every i in [0, n) with flag(i) true is
+// handed to scatter(i, position), position being the number of flagged
+// indices before i, and the number of flagged indices is returned. Flags,
+// scan and scatter happen in the same kernel.
+//
+// On devices the scan is a decoupled look-back (Merrill & Garland): each
+// team takes the next tile, scans its flags in scratch, publishes the tile
+// total and walks back over the published totals of the tiles before it
+// until it finds an inclusive prefix. Tiles are numbered in the order teams
+// start, so a team only ever waits on teams that are already running. On
+// host spaces a parallel_scan, chunked over the threads, does the same.
+//
+// scatter must not write to what flag or scatter of another index read:
+// tiles are not ordered, so compacting in place has to go through a buffer.
+
+namespace quad {
+
+  namespace detail {
+    constexpr unsigned long long tile_aggregate = 1ull << 62;
+    constexpr unsigned long long tile_prefix = 2ull << 62;
+    constexpr unsigned long long tile_value_mask = (1ull << 62) - 1;
+
+#ifdef KOKKOS_HAS_SHARED_HOST_PINNED_SPACE
+    // the last tile writes the count where the host reads it directly
+    using Compaction_count_space = Kokkos::SharedHostPinnedSpace;
+#else
+    using Compaction_count_space = ExecSpace::memory_space;
+#endif
+
+    template <typename Flag, typename Scatter>
+    struct Lookback_compaction {
+      using State = Kokkos::View<unsigned long long*, ExecSpace::memory_space>;
+      using Count = Kokkos::View<size_t, Compaction_count_space>;
+
+      KOKKOS_INLINE_FUNCTION void
+      operator()(const member_type& team) const
+      {
+        ScratchViewInt flags(team.team_scratch(0), tile_size);
+        ScratchViewInt offsets(team.team_scratch(0), tile_size);
+
+        unsigned long long tile = 0;
+        Kokkos::single(
+          Kokkos::PerTeam(team),
+          [&](unsigned long long& claimed) {
+            claimed = Kokkos::atomic_fetch_add(&status(num_tiles), 1ull);
+          },
+          tile);
+        const size_t first = tile * tile_size;
+
+        Kokkos::parallel_for(Kokkos::TeamThreadRange(team, tile_size),
+                             [&](const int j) {
+                               const size_t i = first + j;
+                               flags(j) = i < n && flag(i) ? 1 : 0;
+                             });
+        team.team_barrier();
+        Kokkos::parallel_scan(
+          Kokkos::TeamThreadRange(team, tile_size),
+          [&](const int j, int& partial, const bool final) {
+            if (final)
+              offsets(j) = partial;
+            partial += flags(j);
+          });
+        team.team_barrier();
+
+        size_t prefix = 0;
+        Kokkos::single(
+          Kokkos::PerTeam(team),
+          [&](size_t& exclusive) {
+            const unsigned long long aggregate =
+              offsets(tile_size - 1) + flags(tile_size - 1);
+            exclusive = 0;
+            if (tile != 0) {
+              Kokkos::atomic_exchange(&status(tile),
+                                      tile_aggregate | aggregate);
+              for (unsigned long long pred = tile - 1;; --pred) {
+                unsigned long long word = 0;
+                while (word == 0)
+                  word = Kokkos::atomic_fetch_add(&status(pred), 0ull);
+                exclusive += word & tile_value_mask;
+                if ((word & ~tile_value_mask) == tile_prefix)
+                  break;
+              }
+            }
+            Kokkos::atomic_exchange(&status(tile),
+                                    tile_prefix | (exclusive + aggregate));
+            if (first + tile_size >= n)
+              count() = exclusive + aggregate;
+          },
+          prefix);
+
+        Kokkos::parallel_for(Kokkos::TeamThreadRange(team, tile_size),
+                             [&](const int j) {
+                               if (flags(j))
+                                 scatter(first + j, prefix + offsets(j));
+                             });
+      }
+
+      Flag flag;
+      Scatter scatter;
+      size_t n;
+      int tile_size;
+      size_t num_tiles;
+      State status; // one word per tile, then the tile counter
+      Count count;
+    };
+  }
+
+  // keeps the look-back state between calls
+  class Stream_compaction {
+  public:
+    explicit Stream_compaction(const ExecSpace& space = ExecSpace())
+      : space(space)
+    {}
+
+    template <typename Flag, typename Scatter>
+    size_t
+    compact(const char* label, size_t n, Flag flag, Scatter scatter)
+    {
+      if (n == 0)
+        return 0;
+
+      if constexpr (Kokkos::SpaceAccessibility<
+                      Kokkos::HostSpace,
+                      ExecSpace::memory_space>::accessible) {
+        size_t count = 0;
+        Kokkos::parallel_scan(
+          label,
+          Kokkos::RangePolicy<ExecSpace>(space, 0, n),
+          KOKKOS_LAMBDA(const size_t i, size_t& update, const bool final) {
+            if (flag(i)) {
+              if (final)
+                scatter(i, update);
+              ++update;
+            }
+          },
+          count);
+        return count;
+      } else {
+        using Kernel = detail::Lookback_compaction<Flag, Scatter>;
+        Kernel kernel{flag, scatter, n, 0, 0, status, count};
+        const int team_size = std::min(
+          max_team_size,
+          team_policy(space, 1, 1).team_size_max(kernel,
+                                                 Kokkos::ParallelForTag()));
+        const int tile_size = items_per_thread * team_size;
+        const size_t num_tiles = (n + tile_size - 1) / tile_size;
+
+        if (status.extent(0) < num_tiles + 1)
+          status = typename Kernel::State(
+            Kokkos::view_alloc(space, "compaction_tiles"), num_tiles + 1);
+        if (count.data() == nullptr)
+          count = typename Kernel::Count(
+            Kokkos::view_alloc(space, "compaction_count"));
+        Kokkos::deep_copy(
+          space,
+          Kokkos::subview(status, std::make_pair(size_t{0}, num_tiles + 1)),
+          0ull);
+
+        kernel.tile_size = tile_size;
+        kernel.num_tiles = num_tiles;
+        kernel.status = status;
+        kernel.count = count;
+        const size_t scratch = 2 * ScratchViewInt::shmem_size(tile_size);
+        Kokkos::parallel_for(
+          label,
+          team_policy(space, num_tiles, team_size)
+            .set_scratch_size(0, Kokkos::PerTeam(scratch)),
+          kernel);
+        space.fence();
+
+#ifdef KOKKOS_HAS_SHARED_HOST_PINNED_SPACE
+        return count();
+#else
+        size_t host_count = 0;
+        Kokkos::deep_copy(host_count, count);
+        return host_count;
+#endif
+      }
+    }
+
+    // flags only, positions are not needed
+    template <typename Flag>
+    size_t
+    count_flagged(const char* label, size_t n, Flag flag)
+    {
+      return compact(label, n, flag, KOKKOS_LAMBDA(size_t, size_t){});
+    }
+
+  private:
+    static constexpr int max_team_size = 256;
+    static constexpr int items_per_thread = 4;
+
+    ExecSpace space;
+    Kokkos::View<unsigned long long*, ExecSpace::memory_space> status;
+    Kokkos::View<size_t, detail::Compaction_count_space> count;
+  };
+}
+
+#endif
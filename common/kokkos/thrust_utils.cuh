@@ -9,34 +9,38 @@
 template <typename T, bool use_custom = false>
 T
 dot_product(Kokkos::View<T*, Kokkos::CudaSpace> arr1,
-            Kokkos::View<T*, Kokkos::CudaSpace> arr2)
+            Kokkos::View<T*, Kokkos::CudaSpace> arr2,
+            const ExecSpace& space = ExecSpace())
 {
   if constexpr (use_custom == false) {
-    return KokkosBlas::dot(arr1, arr2);
+    return KokkosBlas::dot(space, arr1, arr2);
   }
 
-  T res = custom_inner_product<T, T>(arr1, arr2);
+  T res = custom_inner_product<T, T>(arr1, arr2, space);
   return res;
 }
 
 template <typename T1, typename T2, bool use_custom = false>
 T2
 dot_product(Kokkos::View<T1*, Kokkos::CudaSpace> arr1,
-            Kokkos::View<T2*, Kokkos::CudaSpace> arr2)
+            Kokkos::View<T2*, Kokkos::CudaSpace> arr2,
+            const ExecSpace& space = ExecSpace())
 {
-  T2 res = custom_inner_product<T1, T2>(arr1, arr2);
+  T2 res = custom_inner_product<T1, T2>(arr1, arr2, space);
   return res;
 }
 
 template <typename T, bool use_custom = false>
 T
-reduction(Kokkos::View<T*, Kokkos::CudaSpace> arr, size_t size)
+reduction(Kokkos::View<T*, Kokkos::CudaSpace> arr,
+          size_t size,
+          const ExecSpace& space = ExecSpace())
 {
   /*if constexpr (use_custom == false) {
     std::cerr << "no library use for reduction in kokkos" << std::endl;
     exit(1);
   }*/
-  return custom_reduce(arr, size);
+  return custom_reduce(arr, size, space);
 }
 
 template <typename T, bool use_custom = false>
@@ -66,7 +70,8 @@ exclusive_scan(Kokkos::View<T*, Kokkos::CudaSpace> input,
 
 template <typename T, bool use_custom = false>
 quad::Range<T>
-device_array_min_max(Kokkos::View<T*, Kokkos::CudaSpace> arr)
+device_array_min_max(Kokkos::View<T*, Kokkos::CudaSpace> arr,
+                     const ExecSpace& space = ExecSpace())
 {
   quad::Range<T> range;
   /*if (use_custom == false) {
@@ -75,7 +80,7 @@ device_array_min_max(Kokkos::View<T*, Kokkos::CudaSpace> arr)
     return range;
   }*/
 
-  auto res = min_max<T>(arr);
+  auto res = min_max<T>(arr, space);
   range.low = res.first;
   range.high = res.second;
   return range;
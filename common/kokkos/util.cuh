@@ -190,11 +190,14 @@ ComputeMin(ViewVectorDouble list)
 
 inline
 double
-exclusive_prefix_scan(ViewVectorInt input, ViewVectorInt output)
+exclusive_prefix_scan(ViewVectorInt input,
+                      ViewVectorInt output,
+                      const ExecSpace& space = ExecSpace())
 {
   int update = 0.;
   Kokkos::parallel_scan(
-    input.extent(0), KOKKOS_LAMBDA(const int i, int& update, const bool final) {
+    Kokkos::RangePolicy<ExecSpace>(space, 0, input.extent(0)),
+    KOKKOS_LAMBDA(const int i, int& update, const bool final) {
       const int val_i = input(i);
       if (final) {
         output(i) = update;
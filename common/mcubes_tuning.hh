@@ -0,0 +1,131 @@
+#ifndef GPUINTEGRATION_COMMON_MCUBES_TUNING_H
+#define GPUINTEGRATION_COMMON_MCUBES_TUNING_H
+
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace numint {
+
+  // launch geometry of the mcubes sampling kernels: cubes per thread and
+  // threads per block (team)
+  struct mcubes_launch_config {
+    int chunk_size = 0;
+    int team_size = 0;
+
+    bool
+    valid() const
+    {
+      return chunk_size > 0 && team_size > 0;
+    }
+  };
+
+  // mcubes_tuning_cache keeps the fastest launch configuration found by the
+  // mcubes autotuner for each (integrand type, ndim, decade of ncall,
+  // backend, device) in a text file, one entry per line:
+  //   integrand ndim ncall_decade backend device chunk_size team_size
+  // The file is read on construction and rewritten whenever an entry is
+  // stored. When autotune is false the cache is only consulted, misses fall
+  // back to the built-in heuristics. The backend field is the Kokkos
+  // execution space name; only the CUDA backend produces entries so far.
+
+  class mcubes_tuning_cache {
+  public:
+    explicit mcubes_tuning_cache(std::string const& filename,
+                                 bool autotune = true)
+      : autotune(autotune), filename(filename)
+    {
+      load();
+    }
+
+    static std::string
+    key(std::string const& integrand,
+        int ndim,
+        double ncall,
+        std::string const& backend,
+        std::string const& device)
+    {
+      std::ostringstream out;
+      out << integrand << ' ' << ndim << ' '
+          << static_cast<int>(std::floor(std::log10(ncall))) << ' '
+          << backend << ' ' << device;
+      return out.str();
+    }
+
+    bool
+    lookup(std::string const& key, mcubes_launch_config& config) const
+    {
+      auto entry = entries.find(key);
+      if (entry == entries.end())
+        return false;
+      config = entry->second;
+      return true;
+    }
+
+    void
+    store(std::string const& key, mcubes_launch_config config)
+    {
+      entries[key] = config;
+      save();
+    }
+
+    size_t
+    size() const
+    {
+      return entries.size();
+    }
+
+    bool autotune;
+
+  private:
+    void load();
+    void save() const;
+
+    std::string filename;
+    std::map<std::string, mcubes_launch_config> entries;
+  };
+}
+
+inline void
+numint::mcubes_tuning_cache::load()
+{
+  // a missing file is an empty cache
+  std::ifstream in(filename);
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream fields(line);
+    std::string integrand, backend, device;
+    int ndim = 0, decade = 0;
+    mcubes_launch_config config;
+    if (fields >> integrand >> ndim >> decade >> backend >> device >>
+          config.chunk_size >> config.team_size &&
+        config.valid()) {
+      std::ostringstream key;
+      key << integrand << ' ' << ndim << ' ' << decade << ' ' << backend
+          << ' ' << device;
+      entries[key.str()] = config;
+    }
+  }
+}
+
+inline void
+numint::mcubes_tuning_cache::save() const
+{
+  std::ofstream out(filename, std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error("cannot open " + filename + " for writing");
+  }
+
+  for (auto const& [key, config] : entries)
+    out << key << ' ' << config.chunk_size << ' ' << config.team_size << '\n';
+
+  if (!out) {
+    throw std::runtime_error("failed to write mcubes tuning cache to " +
+                             filename);
+  }
+}
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef GPUINTEGRATION_COMMON_MPI_UTILS_H
+#define GPUINTEGRATION_COMMON_MPI_UTILS_H
+
+#include <mpi.h>
+#include <cstdint>
+#include <vector>
+
+namespace quad {
+
+  template <typename T>
+  MPI_Datatype mpi_datatype();
+
+  template <>
+  inline MPI_Datatype
+  mpi_datatype<double>()
+  {
+    return MPI_DOUBLE;
+  }
+
+  template <>
+  inline MPI_Datatype
+  mpi_datatype<float>()
+  {
+    return MPI_FLOAT;
+  }
+
+  template <>
+  inline MPI_Datatype
+  mpi_datatype<int>()
+  {
+    return MPI_INT;
+  }
+
+  template <>
+  inline MPI_Datatype
+  mpi_datatype<unsigned long>()
+  {
+    return MPI_UNSIGNED_LONG;
+  }
+
+  template <>
+  inline MPI_Datatype
+  mpi_datatype<unsigned long long>()
+  {
+    return MPI_UNSIGNED_LONG_LONG;
+  }
+
+  // Reduces scalars over all ranks of a communicator. Used wherever the
+  // integrators take a decision that must be identical on every rank.
+  class Mpi_reducer {
+  public:
+    explicit Mpi_reducer(MPI_Comm communicator = MPI_COMM_WORLD)
+      : comm(communicator)
+    {
+      MPI_Comm_rank(comm, &rank);
+      MPI_Comm_size(comm, &num_ranks);
+    }
+
+    template <typename T>
+    T
+    sum(T val) const
+    {
+      return allreduce(val, MPI_SUM);
+    }
+
+    template <typename T>
+    T
+    min(T val) const
+    {
+      return allreduce(val, MPI_MIN);
+    }
+
+    template <typename T>
+    T
+    max(T val) const
+    {
+      return allreduce(val, MPI_MAX);
+    }
+
+    template <typename T>
+    void
+    sum(T* vals, size_t size) const
+    {
+      MPI_Allreduce(MPI_IN_PLACE,
+                    vals,
+                    static_cast<int>(size),
+                    mpi_datatype<T>(),
+                    MPI_SUM,
+                    comm);
+    }
+
+    bool
+    any(bool val) const
+    {
+      int res = val;
+      MPI_Allreduce(MPI_IN_PLACE, &res, 1, MPI_INT, MPI_LOR, comm);
+      return res != 0;
+    }
+
+    template <typename T>
+    std::vector<T>
+    allgather(T val) const
+    {
+      std::vector<T> vals(num_ranks);
+      MPI_Allgather(
+        &val, 1, mpi_datatype<T>(), vals.data(), 1, mpi_datatype<T>(), comm);
+      return vals;
+    }
+
+    MPI_Comm comm;
+    int rank = 0;
+    int num_ranks = 1;
+
+  private:
+    template <typename T>
+    T
+    allreduce(T val, MPI_Op op) const
+    {
+      T res = val;
+      MPI_Allreduce(&val, &res, 1, mpi_datatype<T>(), op, comm);
+      return res;
+    }
+  };
+}
+
+#endif
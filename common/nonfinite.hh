@@ -0,0 +1,61 @@
+#ifndef GPUINTEGRATION_COMMON_NONFINITE_HH
+#define GPUINTEGRATION_COMMON_NONFINITE_HH
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+namespace numint {
+
+  // status of a run stopped because the integrand returned NaN or infinity;
+  // 0 and 1 keep their meaning of converged and not converged
+  constexpr int nonfinite_status = 2;
+
+  // what the kernels do with a non-finite integrand value
+  //   fail:      record it and stop the integration after the launch
+  //   zero:      record it and use 0 in its place
+  //   exclude:   record it and drop what it belongs to, the whole region for
+  //              the cubature rules, the sample for VEGAS
+  //   propagate: record it and carry on with it, so that it reaches the
+  //              estimate; what the integrators did before they checked
+  enum class nonfinite_policy { fail, zero, exclude, propagate };
+
+  struct nonfinite_point {
+    std::vector<double> x;
+    double value = 0.;
+    // the region (cubature) or the grid cell (VEGAS) being sampled
+    std::vector<double> region_lows;
+    std::vector<double> region_highs;
+  };
+
+  // count is the number of non-finite values seen, points holds the first
+  // ones in the order the device recorded them, at most the capacity the
+  // monitor was built with
+  struct nonfinite_report {
+    size_t count = 0;
+    std::vector<nonfinite_point> points;
+
+    bool
+    empty() const
+    {
+      return count == 0;
+    }
+  };
+
+  std::ostream& operator<<(std::ostream& os, nonfinite_point const& p);
+}
+
+inline std::ostream&
+numint::operator<<(std::ostream& os, numint::nonfinite_point const& p)
+{
+  os << p.value << " at (";
+  for (size_t i = 0; i < p.x.size(); ++i)
+    os << (i == 0 ? "" : ",") << p.x[i];
+  os << ") in [";
+  for (size_t i = 0; i < p.region_lows.size(); ++i)
+    os << (i == 0 ? "" : "x") << p.region_lows[i] << ":" << p.region_highs[i];
+  os << "]";
+  return os;
+}
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef ONEAPI_COMMON_STREAM_COMPACTION_DP_HPP
+#define ONEAPI_COMMON_STREAM_COMPACTION_DP_HPP
+
+#include <CL/sycl.hpp>
+#include <cstddef>
+#include <new>
+
+// Single pass stream compaction, the SYCL counterpart of
+// common/cuda/stream_compaction.cuh: every i < n with flag(i) true is handed
+// to scatter(i, position) and the number of flagged indices is returned.
+// Work-groups claim tiles through an atomic counter, scan their flags with
+// exclusive_scan_over_group and find their offset with a decoupled
+// look-back over the totals published by the earlier tiles. Those tiles
+// were claimed by groups that are already running, so the look-back waits
+// on nothing that has not started. The count goes to host USM, no copy is
+// needed to read it.
+
+namespace quad {
+
+  namespace detail {
+    constexpr unsigned long long tile_aggregate = 1ull << 62;
+    constexpr unsigned long long tile_prefix = 2ull << 62;
+    constexpr unsigned long long tile_value_mask = (1ull << 62) - 1;
+  }
+
+  class Stream_compaction {
+  public:
+    Stream_compaction()
+    {
+      auto q_ct1 = sycl::queue(sycl::gpu_selector());
+      count = sycl::malloc_host<size_t>(1, q_ct1);
+      if (count == nullptr)
+        throw std::bad_alloc();
+    }
+
+    Stream_compaction(const Stream_compaction&) = delete;
+    Stream_compaction& operator=(const Stream_compaction&) = delete;
+
+    ~Stream_compaction()
+    {
+      auto q_ct1 = sycl::queue(sycl::gpu_selector());
+      sycl::free(status, q_ct1);
+      sycl::free(count, q_ct1);
+    }
+
+    template <typename Flag, typename Scatter>
+    size_t
+    compact(size_t n, Flag flag, Scatter scatter)
+    {
+      if (n == 0)
+        return 0;
+
+      auto q_ct1 = sycl::queue(sycl::gpu_selector());
+      const size_t num_tiles = (n + group_size - 1) / group_size;
+      if (capacity < num_tiles + 1) {
+        sycl::free(status, q_ct1);
+        status = sycl::malloc_device<unsigned long long>(num_tiles + 1, q_ct1);
+        capacity = num_tiles + 1;
+      }
+      q_ct1.memset(status, 0, sizeof(unsigned long long) * (num_tiles + 1))
+        .wait();
+
+      unsigned long long* tile_status = status;
+      size_t* tile_count = count;
+      q_ct1
+        .submit([&](sycl::handler& cgh) {
+          sycl::accessor<unsigned long long,
+                         1,
+                         sycl::access_mode::read_write,
+                         sycl::access::target::local>
+            shared(sycl::range<1>(2), cgh);
+
+          cgh.parallel_for(
+            sycl::nd_range<1>(num_tiles * group_size, group_size),
+            [=](sycl::nd_item<1> item) {
+              using Atomic =
+                sycl::atomic_ref<unsigned long long,
+                                 sycl::memory_order::relaxed,
+                                 sycl::memory_scope::device,
+                                 sycl::access::address_space::global_space>;
+              auto group = item.get_group();
+              const size_t local = item.get_local_id(0);
+
+              if (local == 0)
+                shared[0] = Atomic(tile_status[num_tiles]).fetch_add(1ull);
+              sycl::group_barrier(group);
+              const unsigned long long tile = shared[0];
+
+              const size_t i = tile * group_size + local;
+              const int flagged = i < n && flag(i) ? 1 : 0;
+              const int offset = sycl::exclusive_scan_over_group(
+                group, flagged, sycl::plus<int>());
+              const unsigned long long aggregate =
+                sycl::reduce_over_group(group, flagged, sycl::plus<int>());
+
+              if (local == 0) {
+                unsigned long long exclusive = 0;
+                if (tile != 0) {
+                  Atomic(tile_status[tile])
+                    .store(detail::tile_aggregate | aggregate);
+                  for (unsigned long long pred = tile - 1;; --pred) {
+                    unsigned long long word = 0;
+                    while (word == 0)
+                      word = Atomic(tile_status[pred]).load();
+                    exclusive += word & detail::tile_value_mask;
+                    if ((word & ~detail::tile_value_mask) ==
+                        detail::tile_prefix)
+                      break;
+                  }
+                }
+                Atomic(tile_status[tile])
+                  .store(detail::tile_prefix | (exclusive + aggregate));
+                if ((tile + 1) * group_size >= n)
+                  *tile_count = exclusive + aggregate;
+                shared[1] = exclusive;
+              }
+              sycl::group_barrier(group);
+
+              if (flagged)
+                scatter(i, shared[1] + offset);
+            });
+        })
+        .wait();
+      return *count;
+    }
+
+  private:
+    static constexpr size_t group_size = 256;
+
+    unsigned long long* status = nullptr;
+    size_t capacity = 0;
+    size_t* count = nullptr;
+  };
+}
+
+#endif
@@ -0,0 +1,312 @@
+#ifndef GPUINTEGRATION_COMMON_QMC_HH
+#define GPUINTEGRATION_COMMON_QMC_HH
+
+#include "common/integration_result.hh"
+#include "common/region_dispatch.hh"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Randomized quasi-Monte Carlo. The points are those of an extensible
+// base-2 rank-1 lattice or of a Sobol sequence, either one randomized by R
+// independent shifts (an additive one for the lattice, a digital one for
+// Sobol). Point i of randomization r is computed directly from i, r and the
+// seed, so any range of points is generated in parallel with no state, and
+// the point set is extended by doubling without re-evaluating what was
+// already summed. The R estimates give the error estimate.
+//
+// The backends only differ in how they sum a range of points: the host
+// version here runs on region_dispatcher workers, kokkos/qmc/qmc.h and
+// oneAPI/qmc/qmc.dp.hpp run a reduction kernel. All use qmc_iterate.
+
+#if defined(__CUDACC__) || defined(__HIPCC__)
+#define QMC_FUNCTION __host__ __device__ inline
+#else
+#define QMC_FUNCTION inline
+#endif
+
+namespace numint {
+
+  enum class qmc_rule { lattice, sobol };
+
+  // Periodizing transforms, for integrands that are not periodic on the
+  // unit cube, which lattice rules converge slowly on
+  //   baker:      u -> 1 - |2u - 1|, weight 1
+  //   polynomial: u -> u^2 (3 - 2u), weight 6u(1 - u)
+  enum class qmc_periodization { none, baker, polynomial };
+
+  struct qmc_options {
+    qmc_rule rule = qmc_rule::lattice;
+    qmc_periodization periodization = qmc_periodization::none;
+    // independent randomizations, at least 2
+    unsigned randomizations = 16;
+    // points per randomization go from 2^min_log2_points, doubling up to
+    // 2^max_log2_points until the error estimate is small enough
+    unsigned min_log2_points = 10;
+    unsigned max_log2_points = 24;
+    uint64_t seed = 0x5eed;
+  };
+
+  constexpr int qmc_max_lattice_dim = 20;
+  constexpr int qmc_max_sobol_dim = 16;
+
+  namespace detail {
+    // first components of the generating vector
+    // lattice-39102-1024-1048576.3600 of Cools, Kuo and Nuyens
+    constexpr uint32_t lattice_generator[qmc_max_lattice_dim] = {
+      1,      182667, 469891, 498753, 110745, 446247, 250185,
+      118627, 245333, 283199, 408519, 391023, 246327, 126539,
+      399185, 461527, 300343, 69681,  516695, 436179};
+
+    // degree s, inner coefficients a and initial m of the primitive
+    // polynomials of Joe and Kuo (new-joe-kuo-6.21201), from dimension 2
+    struct sobol_polynomial {
+      unsigned s;
+      unsigned a;
+      uint32_t m[6];
+    };
+
+    constexpr sobol_polynomial sobol_polynomials[qmc_max_sobol_dim - 1] = {
+      {1, 0, {1}},
+      {2, 1, {1, 3}},
+      {3, 1, {1, 3, 1}},
+      {3, 2, {1, 1, 1}},
+      {4, 1, {1, 1, 3, 3}},
+      {4, 4, {1, 3, 5, 13}},
+      {5, 2, {1, 1, 5, 5, 17}},
+      {5, 4, {1, 1, 5, 5, 5}},
+      {5, 7, {1, 1, 7, 11, 19}},
+      {5, 11, {1, 1, 5, 1, 1}},
+      {5, 13, {1, 1, 1, 3, 11}},
+      {5, 14, {1, 3, 5, 5, 31}},
+      {6, 1, {1, 3, 3, 9, 7, 49}},
+      {6, 13, {1, 1, 1, 15, 21, 21}},
+      {6, 16, {1, 3, 1, 13, 27, 49}}};
+
+    QMC_FUNCTION uint64_t
+    splitmix64(uint64_t x)
+    {
+      x += 0x9e3779b97f4a7c15ull;
+      x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+      x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+      return x ^ (x >> 31);
+    }
+
+    QMC_FUNCTION uint32_t
+    reverse_bits(uint32_t x)
+    {
+      x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+      x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+      x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+      x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+      return (x >> 16) | (x << 16);
+    }
+
+    template <typename F, typename T, size_t... I>
+    QMC_FUNCTION double
+    qmc_call(F& f, const T* x, std::index_sequence<I...>)
+    {
+      return f(x[I]...);
+    }
+  }
+
+  // calls f(x[0], ..., x[ndim - 1]), the convention of the integrands
+  template <int ndim, typename F, typename T>
+  QMC_FUNCTION double
+  qmc_call(F& f, const T* x)
+  {
+    return detail::qmc_call(f, x, std::make_index_sequence<ndim>());
+  }
+
+  // Everything needed to compute a point, trivially copyable so that it can
+  // be captured by kernels.
+  template <int ndim>
+  struct qmc_sequence {
+    static_assert(ndim >= 1 && ndim <= qmc_max_lattice_dim,
+                  "no generating vector for that many dimensions");
+
+    qmc_rule rule = qmc_rule::lattice;
+    qmc_periodization periodization = qmc_periodization::none;
+    uint64_t seed = 0;
+    uint32_t generator[ndim] = {};
+    uint32_t directions[ndim][32] = {};
+    double lows[ndim] = {};
+    double ranges[ndim] = {};
+    double jacobian = 1.;
+
+    // 32 random bits, the shift of dimension dim in randomization r
+    QMC_FUNCTION uint32_t
+    shift(unsigned r, int dim) const
+    {
+      const uint64_t key = seed ^ (static_cast<uint64_t>(r) << 32) ^
+                           static_cast<uint64_t>(dim);
+      return static_cast<uint32_t>(detail::splitmix64(key) >> 32);
+    }
+
+    // fills x with point i of randomization r, mapped to the volume, and
+    // returns the weight of the point, jacobian included
+    template <typename T>
+    QMC_FUNCTION double
+    point(uint64_t i, unsigned r, T* x) const
+    {
+      const uint32_t index = static_cast<uint32_t>(i);
+      const uint32_t radical_inverse = detail::reverse_bits(index);
+      double weight = jacobian;
+      for (int dim = 0; dim < ndim; ++dim) {
+        uint32_t bits = 0;
+        if (rule == qmc_rule::lattice) {
+          bits = radical_inverse * generator[dim] + shift(r, dim);
+        } else {
+          for (uint32_t rest = index, k = 0; rest != 0; rest >>= 1, ++k)
+            if (rest & 1u)
+              bits ^= directions[dim][k];
+          bits ^= shift(r, dim);
+        }
+        double u = (static_cast<double>(bits) + .5) * 0x1p-32;
+        if (periodization == qmc_periodization::baker) {
+          u = 1. - fabs(2. * u - 1.);
+        } else if (periodization == qmc_periodization::polynomial) {
+          weight *= 6. * u * (1. - u);
+          u = u * u * (3. - 2. * u);
+        }
+        x[dim] = static_cast<T>(lows[dim] + u * ranges[dim]);
+      }
+      return weight;
+    }
+  };
+
+  template <int ndim, typename T>
+  qmc_sequence<ndim>
+  make_qmc_sequence(const qmc_options& options, const T* lows, const T* highs)
+  {
+    if (options.rule == qmc_rule::sobol && ndim > qmc_max_sobol_dim)
+      throw std::invalid_argument("Sobol points are limited to " +
+                                  std::to_string(qmc_max_sobol_dim) +
+                                  " dimensions");
+    if (options.max_log2_points > 32)
+      throw std::invalid_argument("QMC point sets are limited to 2^32 points");
+
+    qmc_sequence<ndim> sequence;
+    sequence.rule = options.rule;
+    sequence.periodization = options.periodization;
+    sequence.seed = detail::splitmix64(options.seed);
+    for (int dim = 0; dim < ndim; ++dim) {
+      sequence.generator[dim] = detail::lattice_generator[dim];
+      sequence.lows[dim] = lows[dim];
+      sequence.ranges[dim] = highs[dim] - lows[dim];
+      sequence.jacobian *= sequence.ranges[dim];
+    }
+
+    if (options.rule != qmc_rule::sobol)
+      return sequence;
+    for (int k = 0; k < 32; ++k)
+      sequence.directions[0][k] = 1u << (31 - k);
+    for (int dim = 1; dim < ndim; ++dim) {
+      const detail::sobol_polynomial& p = detail::sobol_polynomials[dim - 1];
+      uint32_t* v = sequence.directions[dim];
+      for (unsigned k = 0; k < p.s; ++k)
+        v[k] = p.m[k] << (31 - k);
+      for (unsigned k = p.s; k < 32; ++k) {
+        v[k] = v[k - p.s] ^ (v[k - p.s] >> p.s);
+        for (unsigned j = 1; j < p.s; ++j)
+          if ((p.a >> (p.s - 1 - j)) & 1u)
+            v[k] ^= v[k - j];
+      }
+    }
+    return sequence;
+  }
+
+  // The driver shared by the backends. accumulate(first, last, sums) adds,
+  // for every randomization r, the weighted integrand values of points
+  // [first, last) to sums[r]. The point set doubles until the standard
+  // error of the R estimates meets the tolerance.
+  template <typename Accumulate>
+  integration_result
+  qmc_iterate(double epsrel,
+              double epsabs,
+              const qmc_options& options,
+              Accumulate&& accumulate)
+  {
+    if (options.randomizations < 2)
+      throw std::invalid_argument("QMC error estimates need at least two "
+                                  "randomizations");
+
+    const unsigned num_random = options.randomizations;
+    std::vector<double> sums(num_random, 0.);
+    integration_result res;
+    res.status = 1;
+    uint64_t done = 0;
+    for (unsigned m = options.min_log2_points; m <= options.max_log2_points;
+         ++m) {
+      const uint64_t n = uint64_t{1} << m;
+      accumulate(done, n, sums.data());
+      done = n;
+
+      double mean = 0.;
+      for (double sum : sums)
+        mean += sum / n;
+      mean /= num_random;
+      double variance = 0.;
+      for (double sum : sums)
+        variance += (sum / n - mean) * (sum / n - mean);
+      variance /= num_random - 1;
+
+      res.estimate = mean;
+      res.errorest = std::sqrt(variance / num_random);
+      res.neval = n * num_random;
+      ++res.iters;
+      if (res.errorest <= std::max(epsabs, epsrel * std::abs(mean))) {
+        res.status = 0;
+        break;
+      }
+    }
+    return res;
+  }
+
+  // Host backend: ranges of points are summed by region_dispatcher
+  // workers, block by block, and the block sums are added in order so that
+  // the result does not depend on the number of threads.
+  template <int ndim, typename IntegT, typename Volume>
+  integration_result
+  qmc_integrate(IntegT integrand,
+                double epsrel,
+                double epsabs,
+                const Volume& vol,
+                const qmc_options& options = {},
+                size_t num_threads = std::thread::hardware_concurrency())
+  {
+    constexpr uint64_t block_size = 4096;
+    const qmc_sequence<ndim> sequence =
+      make_qmc_sequence<ndim>(options, vol.lows, vol.highs);
+    const region_dispatcher dispatcher(num_threads);
+    const unsigned num_random = options.randomizations;
+
+    auto accumulate = [&](uint64_t first, uint64_t last, double* sums) {
+      const uint64_t num_blocks = (last - first + block_size - 1) / block_size;
+      std::vector<double> block_sums(num_blocks * num_random, 0.);
+      dispatcher.run(num_blocks, [&](size_t block) {
+        IntegT f = integrand;
+        double x[ndim];
+        double* partial = block_sums.data() + block * num_random;
+        const uint64_t begin = first + block * block_size;
+        const uint64_t end = std::min(last, begin + block_size);
+        for (uint64_t i = begin; i < end; ++i)
+          for (unsigned r = 0; r < num_random; ++r) {
+            const double weight = sequence.point(i, r, x);
+            partial[r] += weight * qmc_call<ndim>(f, x);
+          }
+      });
+      for (uint64_t block = 0; block < num_blocks; ++block)
+        for (unsigned r = 0; r < num_random; ++r)
+          sums[r] += block_sums[block * num_random + r];
+    };
+    return qmc_iterate(epsrel, epsabs, options, accumulate);
+  }
+}
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef GPUINTEGRATION_COMMON_REGION_DISPATCH_H
+#define GPUINTEGRATION_COMMON_REGION_DISPATCH_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace numint {
+
+  // How the work items (regions, blocks of points) are handed to host
+  // workers; the host QMC backend in common/qmc.hh runs on this.
+  //   static_blocks:  every worker takes one contiguous block, fixed upfront
+  //   self_scheduled: workers claim chunks as they go, the chunks shrinking
+  //                   with the work left (guided self-scheduling)
+  //   cost_ordered:   self-scheduled, the regions expected to be the most
+  //                   expensive going first so that the tail is made of
+  //                   cheap ones
+  enum class region_schedule { static_blocks, self_scheduled, cost_ordered };
+
+  // the chunk a worker claims when remaining regions are left, about half an
+  // even share so that the last claims are short
+  inline size_t
+  guided_chunk(size_t remaining, size_t num_workers, size_t min_chunk = 1)
+  {
+    const size_t chunk = remaining / (2 * std::max<size_t>(num_workers, 1));
+    return std::min(remaining, std::max({chunk, min_chunk, size_t{1}}));
+  }
+
+  // indices of costs, most expensive first (longest processing time first)
+  template <typename Index = size_t>
+  std::vector<Index>
+  cost_order(const double* costs, size_t n)
+  {
+    std::vector<Index> order(n);
+    std::iota(order.begin(), order.end(), Index{0});
+    std::stable_sort(order.begin(), order.end(), [costs](Index a, Index b) {
+      return costs[a] > costs[b];
+    });
+    return order;
+  }
+
+  // Runs work(region) once for every region in [0, n) on a group of host
+  // threads, the calling thread being one of them. With cost_ordered, the
+  // predicted costs set the order; without them the regions go in index
+  // order. When measured is given, the wall time of every call is written to
+  // measured[region], in seconds, ready to predict the next run. The first
+  // exception thrown by work is rethrown once all workers have stopped.
+  class region_dispatcher {
+  public:
+    explicit region_dispatcher(
+      size_t num_workers = std::thread::hardware_concurrency(),
+      size_t min_chunk = 1)
+      : workers(std::max<size_t>(num_workers, 1))
+      , min_chunk(std::max<size_t>(min_chunk, 1))
+    {}
+
+    size_t
+    num_workers() const
+    {
+      return workers;
+    }
+
+    template <typename Work>
+    void
+    run(size_t n,
+        Work&& work,
+        region_schedule schedule = region_schedule::self_scheduled,
+        const double* predicted = nullptr,
+        double* measured = nullptr) const
+    {
+      if (n == 0)
+        return;
+
+      std::vector<size_t> order;
+      if (schedule == region_schedule::cost_ordered && predicted != nullptr)
+        order = cost_order(predicted, n);
+
+      auto process = [&](size_t i) {
+        const size_t region = order.empty() ? i : order[i];
+        if (measured == nullptr) {
+          work(region);
+          return;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        work(region);
+        measured[region] = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+      };
+
+      const size_t num_threads = std::min(workers, n);
+      std::atomic<size_t> next{0};
+      std::atomic<bool> failed{false};
+      std::exception_ptr error;
+      std::mutex error_mutex;
+
+      auto worker = [&](size_t id) {
+        try {
+          if (schedule == region_schedule::static_blocks) {
+            const size_t first = n * id / num_threads;
+            const size_t last = n * (id + 1) / num_threads;
+            for (size_t i = first; i < last && !failed; ++i)
+              process(i);
+            return;
+          }
+          while (!failed) {
+            size_t first = next.load();
+            size_t count = 0;
+            do {
+              if (first >= n)
+                return;
+              count = guided_chunk(n - first, workers, min_chunk);
+            } while (!next.compare_exchange_weak(first, first + count));
+            for (size_t i = first; i < first + count; ++i)
+              process(i);
+          }
+        }
+        catch (...) {
+          std::lock_guard<std::mutex> lock(error_mutex);
+          if (!error)
+            error = std::current_exception();
+          failed = true;
+        }
+      };
+
+      std::vector<std::thread> threads;
+      for (size_t id = 1; id < num_threads; ++id)
+        threads.emplace_back(worker, id);
+      worker(0);
+      for (auto& thread : threads)
+        thread.join();
+      if (error)
+        std::rethrow_exception(error);
+    }
+
+  private:
+    size_t workers;
+    size_t min_chunk;
+  };
+}
+
+#endif
@@ -0,0 +1,233 @@
+#ifndef GPUINTEGRATION_COMMON_SEPARABLE_HH
+#define GPUINTEGRATION_COMMON_SEPARABLE_HH
+
+#include "common/integration_result.hh"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Integrands that split over consecutive groups of dimensions,
+//
+//   f(x) = f_0(x_0) * f_1(x_1) * ...   or   f(x) = f_0(x_0) + f_1(x_1) + ...
+//
+// are integrated factor by factor with low-dimensional rules instead of as
+// one coupled ndim-dimensional function. An integrand opts in by
+// specializing separable_traits:
+//
+//   template <>
+//   struct numint::separable_traits<My_integrand> {
+//     static constexpr bool value = true;
+//     static constexpr separable_kind kind = separable_kind::product;
+//     using groups = std::integer_sequence<int, 1, 2, 1>;
+//     template <int g>
+//     static auto factor(My_integrand const&);
+//   };
+//
+// groups lists the number of dimensions of each factor, in the argument
+// order of the integrand, and factor<g> returns an integrand of that many
+// arguments. Device backends call factor<g> in their kernels, so it is
+// declared the same way as the operator() of the integrand.
+//
+// The backends only provide evaluate(tolerances), which integrates every
+// factor; separable_iterate picks the tolerances and combines the results.
+
+namespace numint {
+
+  enum class separable_kind { product, sum };
+
+  // How the error estimates of the factors add up: bound for rules whose
+  // estimate bounds the error (Pagani, Gauss-Kronrod), statistical for the
+  // standard errors of Monte Carlo.
+  enum class separable_errors { bound, statistical };
+
+  template <typename IntegT>
+  struct separable_traits {
+    static constexpr bool value = false;
+  };
+
+  namespace detail {
+    template <int... n>
+    constexpr std::array<int, sizeof...(n)>
+    group_sizes(std::integer_sequence<int, n...>)
+    {
+      return {n...};
+    }
+
+    template <int size, int... i>
+    std::integer_sequence<int, (0 * i + size)...>
+    uniform_groups(std::integer_sequence<int, i...>);
+  }
+
+  // count groups of size dimensions each
+  template <int size, int count>
+  using uniform_separable_groups = decltype(detail::uniform_groups<size>(
+    std::make_integer_sequence<int, count>()));
+
+  template <typename IntegT>
+  constexpr auto separable_groups =
+    detail::group_sizes(typename separable_traits<IntegT>::groups());
+
+  template <typename IntegT>
+  constexpr int num_separable_groups =
+    static_cast<int>(separable_groups<IntegT>.size());
+
+  template <typename IntegT, int g>
+  constexpr int separable_group_size = separable_groups<IntegT>[g];
+
+  // first dimension of group g
+  template <typename IntegT>
+  constexpr int
+  separable_offset(int g)
+  {
+    int offset = 0;
+    for (int h = 0; h < g; ++h)
+      offset += separable_groups<IntegT>[h];
+    return offset;
+  }
+
+  template <typename IntegT>
+  constexpr int
+  separable_ndim()
+  {
+    return separable_offset<IntegT>(num_separable_groups<IntegT>);
+  }
+
+  struct separable_tolerance {
+    double epsrel = 0.;
+    double epsabs = 0.;
+  };
+
+  // Estimate and error of the whole integral from those of the factors.
+  // volumes[g] is the volume of the box of group g: a term of a sum is
+  // integrated over the other groups by multiplying with their volume.
+  inline integration_result
+  combine_separable(separable_kind kind,
+                    separable_errors errors,
+                    std::vector<integration_result> const& factors,
+                    std::vector<double> const& volumes)
+  {
+    const size_t num_groups = factors.size();
+    double total_volume = 1.;
+    for (double volume : volumes)
+      total_volume *= volume;
+
+    integration_result res;
+    res.status = 0;
+    double variance = 0.;
+    if (kind == separable_kind::product) {
+      double estimate = 1.;
+      double upper = 1.;
+      for (integration_result const& factor : factors) {
+        estimate *= factor.estimate;
+        upper *= std::abs(factor.estimate) + factor.errorest;
+      }
+      res.estimate = estimate;
+      res.errorest = upper - std::abs(estimate);
+      // first order in the errors, with the other factors held fixed
+      for (size_t g = 0; g < num_groups; ++g) {
+        double others = factors[g].errorest;
+        for (size_t h = 0; h < num_groups; ++h)
+          if (h != g)
+            others *= factors[h].estimate;
+        variance += others * others;
+      }
+    } else {
+      res.estimate = 0.;
+      res.errorest = 0.;
+      for (size_t g = 0; g < num_groups; ++g) {
+        const double complement = total_volume / volumes[g];
+        const double errorest = factors[g].errorest * complement;
+        res.estimate += factors[g].estimate * complement;
+        res.errorest += errorest;
+        variance += errorest * errorest;
+      }
+    }
+    if (errors == separable_errors::statistical)
+      res.errorest = std::sqrt(variance);
+
+    for (integration_result const& factor : factors) {
+      res.neval += factor.neval;
+      res.nregions += factor.nregions;
+      res.nFinishedRegions += factor.nFinishedRegions;
+      res.chi_sq = std::max(res.chi_sq, factor.chi_sq);
+      if (factor.status != 0)
+        res.status = factor.status;
+    }
+    return res;
+  }
+
+  // The driver shared by the backends. evaluate(tolerances) integrates
+  // factor g to tolerances[g] and returns the results in group order.
+  //
+  // The first round gives every factor an equal share of epsrel, the
+  // relative errors of a product adding up like the absolute ones of a sum.
+  // When the combined error still misses the tolerance (the second order
+  // terms of a product, a factor close to 0, epsabs of a sum), the next
+  // round scales the tolerance of every factor by the missing ratio. The
+  // result fails when a factor does, since no later round can do better.
+  template <typename Evaluate>
+  integration_result
+  separable_iterate(separable_kind kind,
+                    separable_errors errors,
+                    std::vector<double> const& volumes,
+                    double epsrel,
+                    double epsabs,
+                    Evaluate&& evaluate,
+                    int max_rounds = 4)
+  {
+    if (max_rounds < 1)
+      throw std::invalid_argument("separable_iterate needs at least a round");
+
+    const size_t num_groups = volumes.size();
+    const double shares = errors == separable_errors::bound ?
+                            static_cast<double>(num_groups) :
+                            std::sqrt(static_cast<double>(num_groups));
+    double total_volume = 1.;
+    for (double volume : volumes)
+      total_volume *= volume;
+
+    std::vector<separable_tolerance> tolerances(num_groups);
+    for (size_t g = 0; g < num_groups; ++g) {
+      tolerances[g].epsrel = epsrel / shares;
+      if (kind == separable_kind::sum)
+        tolerances[g].epsabs = epsabs / shares * volumes[g] / total_volume;
+    }
+
+    integration_result res;
+    size_t neval = 0;
+    for (int round = 1; round <= max_rounds; ++round) {
+      std::vector<integration_result> const factors = evaluate(tolerances);
+      if (factors.size() != num_groups)
+        throw std::logic_error("separable_iterate: one result per factor");
+
+      res = combine_separable(kind, errors, factors, volumes);
+      neval += res.neval;
+      res.neval = neval;
+      res.iters = round;
+
+      const double target = std::max(epsabs, epsrel * std::abs(res.estimate));
+      if (res.status != 0)
+        return res;
+      if (res.errorest <= target)
+        break;
+      if (round == max_rounds) {
+        res.status = 1;
+        break;
+      }
+
+      // every factor error is within its tolerance, so the tolerances
+      // shrink by at least the ratio the combined error is off by
+      const double ratio = .5 * target / res.errorest;
+      for (size_t g = 0; g < num_groups; ++g) {
+        tolerances[g].epsrel *= ratio;
+        tolerances[g].epsabs = factors[g].errorest * ratio;
+      }
+    }
+    return res;
+  }
+}
+
+#endif
@@ -0,0 +1,175 @@
+#ifndef GPUINTEGRATION_COMMON_SHARED_TABLE_HH
+#define GPUINTEGRATION_COMMON_SHARED_TABLE_HH
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+// An immutable table of values shared by every copy of the object holding
+// it. Copying a shared_table bumps a count kept on the host instead of
+// copying the values; the last copy to go releases them. The values are
+// placed once, when the table is made, by a Memory policy providing
+//
+//   template <typename T> static T* allocate(const T* values, size_t n);
+//   template <typename T> static void release(T* data);
+//
+// host_table_memory is the policy of the host backends, the CUDA ones are
+// in common/cuda/shared_table.cuh.
+//
+// Only host code touches the count. A table copied bit by bit to the
+// device, inside an integrand passed to a kernel or make_gpu_integrand,
+// reads the values there but is not counted: it must not outlive the host
+// object it was copied from.
+
+#if defined(__CUDACC__) || defined(__HIPCC__)
+#define SHARED_TABLE_FUNCTION __host__ __device__ inline
+#else
+#define SHARED_TABLE_FUNCTION inline
+#endif
+
+namespace numint {
+
+  namespace detail {
+    struct table_owner {
+      std::atomic<long> count{1};
+      void* data = nullptr;
+      void (*release)(void*) = nullptr;
+    };
+  }
+
+  struct host_table_memory {
+    template <typename T>
+    static T*
+    allocate(const T* values, size_t n)
+    {
+      T* data = new T[n];
+      std::copy(values, values + n, data);
+      return data;
+    }
+
+    template <typename T>
+    static void
+    release(T* data)
+    {
+      delete[] data;
+    }
+  };
+
+  template <typename T>
+  class shared_table;
+
+  template <typename Memory, typename T>
+  shared_table<T> make_shared_table(const T* values, size_t n);
+
+  template <typename T>
+  class shared_table {
+    const T* _data = nullptr;
+    size_t _size = 0;
+    detail::table_owner* _owner = nullptr;
+
+    void
+    drop()
+    {
+      if (_owner &&
+          _owner->count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        _owner->release(_owner->data);
+        delete _owner;
+      }
+      _data = nullptr;
+      _size = 0;
+      _owner = nullptr;
+    }
+
+    template <typename Memory, typename U>
+    friend shared_table<U> make_shared_table(const U* values, size_t n);
+
+  public:
+    shared_table() = default;
+
+    shared_table(shared_table const& other)
+      : _data(other._data), _size(other._size), _owner(other._owner)
+    {
+      if (_owner)
+        _owner->count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    shared_table(shared_table&& other) noexcept
+      : _data(other._data), _size(other._size), _owner(other._owner)
+    {
+      other._data = nullptr;
+      other._size = 0;
+      other._owner = nullptr;
+    }
+
+    shared_table&
+    operator=(shared_table other) noexcept
+    {
+      swap(other);
+      return *this;
+    }
+
+    ~shared_table() { drop(); }
+
+    void
+    swap(shared_table& other) noexcept
+    {
+      std::swap(_data, other._data);
+      std::swap(_size, other._size);
+      std::swap(_owner, other._owner);
+    }
+
+    // the number of host copies sharing the values, 0 for an empty table
+    long
+    use_count() const
+    {
+      return _owner ? _owner->count.load(std::memory_order_relaxed) : 0;
+    }
+
+    SHARED_TABLE_FUNCTION const T*
+    data() const
+    {
+      return _data;
+    }
+
+    SHARED_TABLE_FUNCTION size_t
+    size() const
+    {
+      return _size;
+    }
+
+    SHARED_TABLE_FUNCTION const T&
+    operator[](size_t i) const
+    {
+      return _data[i];
+    }
+  };
+
+  // the only way to fill a table: copies n values through Memory
+  template <typename Memory, typename T>
+  shared_table<T>
+  make_shared_table(const T* values, size_t n)
+  {
+    shared_table<T> table;
+    if (n == 0)
+      return table;
+    T* data = Memory::template allocate<T>(values, n);
+    try {
+      table._owner = new detail::table_owner;
+    }
+    catch (...) {
+      Memory::template release<T>(data);
+      throw;
+    }
+    table._owner->data = data;
+    table._owner->release = [](void* p) {
+      Memory::template release<T>(static_cast<T*>(p));
+    };
+    table._data = data;
+    table._size = n;
+    return table;
+  }
+}
+
+#endif
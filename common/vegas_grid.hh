@@ -0,0 +1,133 @@
+#ifndef GPUINTEGRATION_COMMON_VEGAS_GRID_H
+#define GPUINTEGRATION_COMMON_VEGAS_GRID_H
+
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace numint {
+
+  // vegas_grid holds the bin boundaries adapted by a VEGAS run, along with
+  // the statistics accumulated over its iterations. It is filled by the mcubes
+  // integrators and can be handed to a later call, possibly in another
+  // process, to start from the adapted grid instead of a uniform one.
+  // Boundaries are stored in unit coordinates, bins of dimension j occupy
+  // xi[j * nbins, (j + 1) * nbins) and the last one of each dimension is 1.
+
+  struct vegas_grid {
+    int ndim = 0;
+    int nbins = 0;
+    std::vector<double> xi;
+
+    // weighted sums of the iteration estimates, as in the vegas loop
+    double si = 0.;
+    double swgt = 0.;
+    double schi = 0.;
+    size_t iters = 0;
+
+    vegas_grid() = default;
+
+    explicit vegas_grid(std::string const& filename) { load(filename); }
+
+    bool
+    empty() const
+    {
+      return xi.empty();
+    }
+
+    double&
+    operator()(int dim, int bin)
+    {
+      return xi[static_cast<size_t>(dim) * nbins + bin];
+    }
+
+    double
+    operator()(int dim, int bin) const
+    {
+      return xi[static_cast<size_t>(dim) * nbins + bin];
+    }
+
+    void
+    resize(int dims, int bins)
+    {
+      ndim = dims;
+      nbins = bins;
+      xi.assign(static_cast<size_t>(dims) * bins, 0.);
+    }
+
+    // conversions from and to the 1-based layout used inside vegas, where
+    // bin i of dimension j is at vegas_xi[j * stride + i]
+    void
+    import_from(double const* vegas_xi, int dims, int bins, int stride)
+    {
+      resize(dims, bins);
+      for (int j = 0; j < ndim; j++)
+        for (int i = 0; i < nbins; i++)
+          (*this)(j, i) = vegas_xi[(j + 1) * stride + i + 1];
+    }
+
+    void
+    export_to(double* vegas_xi, int stride) const
+    {
+      for (int j = 0; j < ndim; j++)
+        for (int i = 0; i < nbins; i++)
+          vegas_xi[(j + 1) * stride + i + 1] = (*this)(j, i);
+    }
+
+    void save(std::string const& filename) const;
+    void load(std::string const& filename);
+  };
+}
+
+inline void
+numint::vegas_grid::save(std::string const& filename) const
+{
+  std::ofstream out(filename, std::ios::binary);
+  if (!out) {
+    throw std::runtime_error("cannot open " + filename + " for writing");
+  }
+
+  const int64_t header[3] = {ndim, nbins, static_cast<int64_t>(iters)};
+  const double stats[3] = {si, swgt, schi};
+  out.write(reinterpret_cast<const char*>(header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(stats), sizeof(stats));
+  out.write(reinterpret_cast<const char*>(xi.data()),
+            sizeof(double) * xi.size());
+
+  if (!out) {
+    throw std::runtime_error("failed to write vegas grid to " + filename);
+  }
+}
+
+inline void
+numint::vegas_grid::load(std::string const& filename)
+{
+  std::ifstream in(filename, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("cannot open " + filename);
+  }
+
+  int64_t header[3];
+  double stats[3];
+  in.read(reinterpret_cast<char*>(header), sizeof(header));
+  in.read(reinterpret_cast<char*>(stats), sizeof(stats));
+  if (!in || header[0] <= 0 || header[1] <= 0) {
+    throw std::runtime_error(filename + " does not hold a vegas grid");
+  }
+
+  resize(static_cast<int>(header[0]), static_cast<int>(header[1]));
+  in.read(reinterpret_cast<char*>(xi.data()), sizeof(double) * xi.size());
+  if (!in) {
+    xi.clear();
+    throw std::runtime_error("failed to read vegas grid from " + filename);
+  }
+
+  iters = static_cast<size_t>(header[2]);
+  si = stats[0];
+  swgt = stats[1];
+  schi = stats[2];
+}
+
+#endif
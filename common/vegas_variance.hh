@@ -0,0 +1,84 @@
+#ifndef GPUINTEGRATION_COMMON_VEGAS_VARIANCE_HH
+#define GPUINTEGRATION_COMMON_VEGAS_VARIANCE_HH
+
+#include <type_traits>
+
+namespace numint {
+
+  // placeholder control type, when only antithetic sampling is wanted
+  struct no_control_variate {};
+
+  // Variance reduction on top of the importance sampling and stratification
+  // of VEGAS, applied within each hypercube.
+  //
+  // antithetic: samples come in pairs, the second one drawn at 1 - u for
+  //   the uniform variates u of the first, and each pair counts as one
+  //   sample in the variance estimate. Pays off for integrands that are
+  //   close to monotonic over the extent of a hypercube.
+  // control: a cheap functor called like the integrand, whose integral over
+  //   the volume is control_integral. Every iteration estimates the
+  //   coefficient b minimizing the variance of f - b (g - G) from its own
+  //   samples, which biases the estimate by O(1 / ncall).
+  template <typename ControlT = no_control_variate>
+  struct vegas_variance_reduction {
+    bool antithetic = false;
+    ControlT control = {};
+    double control_integral = 0.;
+
+    static constexpr bool
+    has_control()
+    {
+      return !std::is_same<ControlT, no_control_variate>::value;
+    }
+
+    bool
+    active() const
+    {
+      return antithetic || has_control();
+    }
+  };
+
+  template <typename ControlT>
+  vegas_variance_reduction<ControlT>
+  control_variate(ControlT const& control,
+                  double control_integral,
+                  bool antithetic = false)
+  {
+    vegas_variance_reduction<ControlT> reduction;
+    reduction.antithetic = antithetic;
+    reduction.control = control;
+    reduction.control_integral = control_integral;
+    return reduction;
+  }
+
+  // the iteration sums of the variance-reduced VEGAS kernels: estimate and
+  // variance of the integrand, the same for the control and their
+  // covariance, all over the stratified samples
+  struct vegas_reduced_sums {
+    double f = 0.;
+    double ff = 0.;
+    double c = 0.;
+    double cc = 0.;
+    double fc = 0.;
+  };
+
+  // estimate and variance of f - b (g - G) with the optimal b
+  inline void
+  apply_control_variate(vegas_reduced_sums const& sums,
+                        double control_integral,
+                        double& estimate,
+                        double& variance)
+  {
+    estimate = sums.f;
+    variance = sums.ff;
+    if (!(sums.cc > 0.))
+      return;
+    const double b = sums.fc / sums.cc;
+    estimate -= b * (sums.c - control_integral);
+    variance -= b * sums.fc;
+    if (variance < sums.ff * 1.e-30)
+      variance = sums.ff * 1.e-30;
+  }
+}
+
+#endif
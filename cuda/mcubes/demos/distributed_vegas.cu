@@ -0,0 +1,86 @@
+#include "cuda/mcubes/mcubesDist.hh"
+#include <chrono>
+#include <iostream>
+
+// Runs the distributed host VEGAS on all ranks, then repeats the integration
+// on rank 0 alone with the same streams. Every rank must return the same
+// result, identical to the single-rank one; the exit status is non-zero
+// otherwise. Run with e.g. mpirun -np 4 ./mcubes_distributed_vegas
+
+class GENZ_4_5D {
+public:
+  __device__ __host__ double
+  operator()(double x, double y, double z, double w, double v)
+  {
+    double beta = .5;
+    return exp(-1.0 *
+               (pow(25, 2) * pow(x - beta, 2) + pow(25, 2) * pow(y - beta, 2) +
+                pow(25, 2) * pow(z - beta, 2) + pow(25, 2) * pow(w - beta, 2) +
+                pow(25, 2) * pow(v - beta, 2)));
+  }
+};
+
+int
+main(int argc, char** argv)
+{
+  MPI_Init(&argc, &argv);
+  using MilliSeconds =
+    std::chrono::duration<double, std::chrono::milliseconds::period>;
+  constexpr int ndim = 5;
+  double constexpr epsrel = 1.e-3;
+  double constexpr epsabs = 1.e-20;
+  double const true_value = 1.79132603674879e-06;
+  unsigned long const ncall = 1.e6;
+  int const itmx = 10;
+  int const num_streams = 16;
+  quad::Volume<double, ndim> vol;
+  GENZ_4_5D integrand;
+
+  int rank = 0, num_ranks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &num_ranks);
+
+  auto t0 = std::chrono::high_resolution_clock::now();
+  numint::integration_result res = dist_mcubes_integrate<GENZ_4_5D, ndim>(
+    integrand, epsrel, epsabs, ncall, &vol, itmx, num_streams);
+  MilliSeconds dt = std::chrono::high_resolution_clock::now() - t0;
+
+  // every rank must hold rank 0's result
+  double local[3] = {res.estimate, res.errorest, res.chi_sq};
+  double lowest[3], highest[3];
+  MPI_Allreduce(local, lowest, 3, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+  MPI_Allreduce(local, highest, 3, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  const bool same_on_all_ranks = lowest[0] == highest[0] &&
+                                 lowest[1] == highest[1] &&
+                                 lowest[2] == highest[2];
+
+  int status = 0;
+  if (rank == 0) {
+    numint::integration_result single =
+      dist_mcubes_integrate<GENZ_4_5D, ndim>(integrand,
+                                             epsrel,
+                                             epsabs,
+                                             ncall,
+                                             &vol,
+                                             itmx,
+                                             num_streams,
+                                             1,
+                                             MPI_COMM_SELF);
+    const bool identical = single.estimate == res.estimate &&
+                           single.errorest == res.errorest &&
+                           single.chi_sq == res.chi_sq;
+    status = identical && same_on_all_ranks ? 0 : 1;
+
+    std::cout.precision(17);
+    std::cout << "id, ranks, streams, true_value, estimate, errorest, chi_sq, "
+                 "time, same_on_all_ranks, identical_to_single_rank\n";
+    std::cout << "f4_5D," << num_ranks << "," << num_streams << ","
+              << std::scientific << true_value << "," << res.estimate << ","
+              << res.errorest << "," << res.chi_sq << "," << dt.count() << ","
+              << same_on_all_ranks << "," << identical << "\n";
+  }
+
+  MPI_Bcast(&status, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  MPI_Finalize();
+  return status;
+}
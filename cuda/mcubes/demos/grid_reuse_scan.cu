@@ -0,0 +1,64 @@
+#include <iostream>
+#include "cuda/mcubes/demos/demo_utils.cuh"
+#include "common/cuda/integrands.cuh"
+#include "common/vegas_grid.hh"
+
+// Parameter scan over the location of a gaussian peak. The first scan point
+// adapts the grid from scratch and saves it; every later point loads the grid
+// of the previous one and runs fewer adjustment iterations without skipping.
+int
+main()
+{
+  using MilliSeconds =
+    std::chrono::duration<double, std::chrono::milliseconds::period>;
+  constexpr int ndim = 6;
+  constexpr bool MCUBES_DEBUG = false;
+  double constexpr epsabs = 1.0e-20;
+  double constexpr epsrel = 1.0e-3;
+  const std::string grid_file = "mcubes_scan_grid.bin";
+
+  VegasParams cold(1.e7, 70, 40, 5);
+  VegasParams warm(1.e7, 70, 5, 0);
+  std::vector<double> peak_locs = {
+    .45, .46, .47, .48, .49, .50, .51, .52, .53, .54, .55};
+  quad::Volume<double, ndim> vol(0., 1.);
+
+  std::cout << "id, start, peak_loc, true_value, epsrel, estimate, errorest, "
+               "chi_sq, ncall, iters, time, status"
+            << std::endl;
+
+  for (size_t i = 0; i < peak_locs.size(); i++) {
+    F_4_6D_alt integrand;
+    integrand.sharpness = 10.;
+    integrand.peak_loc = peak_locs[i];
+    integrand.set_true_value();
+
+    numint::vegas_grid grid;
+    if (i != 0)
+      grid.load(grid_file);
+    VegasParams const& params = (i == 0) ? cold : warm;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    auto res = cuda_mcubes::integrate<F_4_6D_alt, ndim, MCUBES_DEBUG>(
+      integrand,
+      epsrel,
+      epsabs,
+      params.ncall,
+      &vol,
+      params.t_iter,
+      params.num_adjust_iters,
+      params.num_skip_iters,
+      &grid);
+    MilliSeconds dt = std::chrono::high_resolution_clock::now() - t0;
+    grid.save(grid_file);
+
+    std::cout.precision(17);
+    std::cout << "f_4_alt," << (i == 0 ? "cold" : "warm") << ","
+              << integrand.peak_loc << "," << std::scientific
+              << integrand.true_value << "," << epsrel << "," << res.estimate
+              << "," << res.errorest << "," << res.chi_sq << ","
+              << params.ncall << "," << res.iters << "," << dt.count() << ","
+              << res.status << "\n";
+  }
+  return 0;
+}
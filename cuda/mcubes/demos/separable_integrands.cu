@@ -0,0 +1,87 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include "cuda/mcubes/demos/demo_utils.cuh"
+#include "cuda/mcubes/separable.cuh"
+#include "common/cuda/integrands.cuh"
+
+// The cosine products of common/cuda/integrands.cuh integrated as coupled
+// ndim-dimensional functions and factor by factor, for the same epsrel and
+// calls per iteration. The factor runs need a handful of 1D or 2D VEGAS
+// iterations where the coupled runs need more and more with ndim.
+
+namespace {
+  using MilliSeconds =
+    std::chrono::duration<double, std::chrono::milliseconds::period>;
+
+  template <typename F, int ndim>
+  void
+  report(const char* id,
+         const char* method,
+         F const& integrand,
+         numint::integration_result const& res,
+         MilliSeconds dt)
+  {
+    std::cout << id << "," << method << "," << ndim << ","
+              << integrand.true_value << "," << res.estimate << ","
+              << res.errorest << ","
+              << std::abs(res.estimate - integrand.true_value) /
+                   std::abs(integrand.true_value)
+              << "," << res.iters << "," << dt.count() << "," << res.status
+              << "\n";
+  }
+
+  template <typename F, int ndim>
+  void
+  run(const char* id, double epsrel, VegasParams const& params)
+  {
+    constexpr double epsabs = 1.e-20;
+    quad::Volume<double, ndim> vol;
+    F integrand;
+    integrand.set_true_value(vol.lows[0], vol.highs[0]);
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    auto coupled = cuda_mcubes::integrate<F, ndim>(integrand,
+                                                   epsrel,
+                                                   epsabs,
+                                                   params.ncall,
+                                                   &vol,
+                                                   params.t_iter,
+                                                   params.num_adjust_iters,
+                                                   params.num_skip_iters);
+    MilliSeconds dt = std::chrono::high_resolution_clock::now() - t0;
+    report<F, ndim>(id, "coupled", integrand, coupled, dt);
+
+    t0 = std::chrono::high_resolution_clock::now();
+    auto separable =
+      cuda_mcubes::integrate_separable<F, ndim>(integrand,
+                                                epsrel,
+                                                epsabs,
+                                                params.ncall,
+                                                &vol,
+                                                params.t_iter,
+                                                params.num_adjust_iters,
+                                                params.num_skip_iters);
+    dt = std::chrono::high_resolution_clock::now() - t0;
+    report<F, ndim>(id, "separable", integrand, separable, dt);
+  }
+}
+
+int
+main()
+{
+  constexpr double epsrel = 1.e-4;
+  VegasParams params(1.e6, 70, 50, 5);
+  std::cout.precision(10);
+  std::cout << "id, method, ndim, true value, estimate, errorest, true relerr, "
+               "iters, time, status\n";
+
+  run<Cos_fully_sep_product_4D, 4>("Cos_fully_sep_product", epsrel, params);
+  run<Cos_fully_sep_product_6D, 6>("Cos_fully_sep_product", epsrel, params);
+  run<Cos_fully_sep_product_8D, 8>("Cos_fully_sep_product", epsrel, params);
+  run<Cos_fully_sep_product_10D, 10>("Cos_fully_sep_product", epsrel, params);
+  run<Cos_semi_sep_product_4D, 4>("Cos_semi_sep_product", epsrel, params);
+  run<Cos_semi_sep_product_6D, 6>("Cos_semi_sep_product", epsrel, params);
+  run<Cos_semi_sep_product_8D, 8>("Cos_semi_sep_product", epsrel, params);
+  return 0;
+}
@@ -0,0 +1,111 @@
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <iostream>
+#include "cuda/mcubes/demos/demo_utils.cuh"
+#include "common/vegas_variance.hh"
+
+// A smooth integrand with a cheap companion that captures most of its
+// shape. Runs VEGAS plain, with antithetic pairs, with the companion as a
+// control variate and with both, for the same number of calls per
+// iteration, and compares how many iterations each needs for epsrel.
+
+namespace {
+  constexpr int ndim = 5;
+  constexpr double rates[ndim] = {1., 1.5, 2., 2.5, 3.};
+
+  class Damped_exponential {
+  public:
+    __device__ __host__ double
+    operator()(double x, double y, double z, double w, double v)
+    {
+      return exp(-(x + 1.5 * y + 2. * z + 2.5 * w + 3. * v));
+    }
+  };
+
+  class Modulated_exponential {
+  public:
+    __device__ __host__ double
+    operator()(double x, double y, double z, double w, double v)
+    {
+      Damped_exponential g;
+      return g(x, y, z, w, v) * (1. + .2 * cos(x + y + z + w + v));
+    }
+  };
+
+  // integral of exp(-a.x) (1 + c cos(sum x)) over the unit cube
+  double
+  exact(double c)
+  {
+    double product = 1.;
+    std::complex<double> modulated = 1.;
+    for (double a : rates) {
+      product *= (1. - std::exp(-a)) / a;
+      const std::complex<double> s(-a, 1.);
+      modulated *= (std::exp(s) - 1.) / s;
+    }
+    return product + c * modulated.real();
+  }
+
+  template <typename ControlT>
+  void
+  run(const char* id,
+      numint::vegas_variance_reduction<ControlT> const& reduction,
+      double true_value)
+  {
+    using MilliSeconds =
+      std::chrono::duration<double, std::chrono::milliseconds::period>;
+    constexpr double epsrel = 1.e-5;
+    VegasParams params(1.e6, 100, 10, 5);
+    quad::Volume<double, ndim> vol;
+    Modulated_exponential integrand;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    auto res = cuda_mcubes::integrate<Modulated_exponential,
+                                      ndim,
+                                      false,
+                                      Curand_generator,
+                                      ControlT>(integrand,
+                                                epsrel,
+                                                1.e-20,
+                                                params.ncall,
+                                                &vol,
+                                                params.t_iter,
+                                                params.num_adjust_iters,
+                                                params.num_skip_iters,
+                                                nullptr,
+                                                false,
+                                                numint::nonfinite_policy::fail,
+                                                nullptr,
+                                                reduction);
+    MilliSeconds dt = std::chrono::high_resolution_clock::now() - t0;
+    std::cout << id << "," << res.estimate << "," << res.errorest << ","
+              << std::abs(res.estimate - true_value) / true_value << ","
+              << res.chi_sq << "," << res.iters << "," << dt.count() << ","
+              << res.status << "\n";
+  }
+}
+
+int
+main()
+{
+  const double true_value = exact(.2);
+  std::cout.precision(10);
+  std::cout << "id, estimate, errorest, true relerr, chi_sq, iters, time, "
+               "status\n";
+
+  numint::vegas_variance_reduction<> plain;
+  run("plain", plain, true_value);
+
+  numint::vegas_variance_reduction<> antithetic;
+  antithetic.antithetic = true;
+  run("antithetic", antithetic, true_value);
+
+  run("control",
+      numint::control_variate(Damped_exponential(), exact(0.)),
+      true_value);
+  run("both",
+      numint::control_variate(Damped_exponential(), exact(0.), true),
+      true_value);
+  return 0;
+}
@@ -0,0 +1,59 @@
+#include <iostream>
+#include "cuda/mcubes/vegasT_vector.cuh"
+
+// Integrates a gaussian together with its first and second moments along x
+// from one set of samples, adapting the grid to the gaussian only and then to
+// all three components.
+class Gaussian_moments {
+public:
+  __device__ __host__ gpu::cudaArray<double, 3>
+  operator()(double x, double y, double z, double w, double v)
+  {
+    const double g =
+      exp(-10. * ((x - .5) * (x - .5) + (y - .5) * (y - .5) +
+                  (z - .5) * (z - .5) + (w - .5) * (w - .5) +
+                  (v - .5) * (v - .5)));
+    return {{g, x * g, x * x * g}};
+  }
+};
+
+int
+main()
+{
+  constexpr int ndim = 5;
+  constexpr int ncomp = 3;
+  double constexpr epsrel = 1.e-3;
+  double constexpr epsabs = 1.e-20;
+  double const ncall = 1.e7;
+  quad::Volume<double, ndim> vol;
+  Gaussian_moments integrand;
+
+  std::cout << "id, adapt, comp, estimate, errorest, chi_sq, iters, status"
+            << std::endl;
+  std::cout.precision(15);
+
+  auto print = [&](std::string const& adapt,
+                   numint::integration_results<ncomp> const& res) {
+    for (int comp = 0; comp < ncomp; ++comp)
+      std::cout << "gaussian_moments," << adapt << "," << comp << ","
+                << std::scientific << res.estimate[comp] << ","
+                << res.errorest[comp] << "," << res.chi_sq[comp] << ","
+                << res.iters << "," << res.status << std::endl;
+  };
+
+  print("comp0",
+        cuda_mcubes::integrate_v<Gaussian_moments, ndim, ncomp>(
+          integrand,
+          epsrel,
+          epsabs,
+          ncall,
+          &vol,
+          15,
+          15,
+          5,
+          cuda_mcubes::adapt_to_component<ncomp>(0)));
+  print("all",
+        cuda_mcubes::integrate_v<Gaussian_moments, ndim, ncomp>(
+          integrand, epsrel, epsabs, ncall, &vol));
+  return 0;
+}
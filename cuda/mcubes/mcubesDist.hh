@@ -0,0 +1,221 @@
+#ifndef MCUBES_DIST_HH
+#define MCUBES_DIST_HH
+
+// Host VEGAS distributed over the ranks of an MPI communicator. The ncubes
+// sub-cubes are split into num_streams contiguous chunks, each sampled with
+// its own random number stream, and the chunks are dealt out to the ranks.
+// The per-chunk sums of f and of the bin contributions d are all-reduced
+// and added up in chunk order on every rank before the shared rebin, so the
+// grid, the estimates and chi_sq depend on the number of streams but not on
+// the number of ranks: a single process run with the same num_streams and
+// seed returns the same result bit for bit.
+
+#include "common/cuda/Volume.cuh"
+#include "common/integration_result.hh"
+#include "common/mpi_utils.hh"
+#include "cuda/mcubes/mcubesSeq.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace mcubes_dist {
+
+  // independent generator for each chunk of sub-cubes
+  inline std::mt19937_64
+  make_stream(unsigned long seed, int stream)
+  {
+    std::seed_seq seq{seed, static_cast<unsigned long>(stream)};
+    return std::mt19937_64(seq);
+  }
+}
+
+template <typename IntegT, int NDIM>
+numint::integration_result
+dist_mcubes_integrate(IntegT integrand,
+                      double epsrel,
+                      double epsabs,
+                      unsigned long ncall,
+                      quad::Volume<double, NDIM> const* volume,
+                      int itmx,
+                      int num_streams = 0,
+                      unsigned long seed = 1,
+                      MPI_Comm comm = MPI_COMM_WORLD)
+{
+  quad::Mpi_reducer reducer(comm);
+  if (num_streams <= 0)
+    num_streams = reducer.num_ranks;
+
+  constexpr int ndim = NDIM;
+  const int nd = NDMX;
+  const double xnd = nd;
+  int ng = (int)pow(ncall / 2.0 + 0.25, 1.0 / ndim);
+  size_t ncubes = 1;
+  for (int i = 1; i <= ndim; i++)
+    ncubes *= ng;
+  const int npg = IMAX(ncall / ncubes, 2);
+  const double calls = (double)npg * (double)ncubes;
+  double dxg = 1.0 / ng;
+  double dv2g = 1.;
+  for (int i = 1; i <= ndim; i++)
+    dv2g *= dxg;
+  dv2g = SQR(calls * dv2g) / npg / npg / (npg - 1.0);
+  dxg *= xnd;
+
+  double regn[NDIM + 1], dx[NDIM + 1];
+  double xjac = 1.0 / calls;
+  for (int j = 1; j <= ndim; j++) {
+    regn[j] = volume->lows[j - 1];
+    dx[j] = volume->highs[j - 1] - volume->lows[j - 1];
+    xjac *= dx[j];
+  }
+
+  // xi[j][i] is the right edge of bin i in dimension j, both 1-based
+  std::vector<std::vector<double>> xi(ndim + 1,
+                                      std::vector<double>(nd + 1, 0.));
+  std::vector<double> r(nd + 1, 1.0), xin(nd + 1);
+  for (int j = 1; j <= ndim; j++) {
+    xi[j][1] = 1.0;
+    rebin(1 / xnd, nd, r.data(), xin.data(), xi[j].data());
+  }
+
+  // chunks owned by this rank and their generators, which persist over the
+  // iterations
+  const int first_stream = reducer.rank * num_streams / reducer.num_ranks;
+  const int last_stream = (reducer.rank + 1) * num_streams / reducer.num_ranks;
+  std::vector<std::mt19937_64> streams;
+  for (int s = first_stream; s < last_stream; s++)
+    streams.push_back(mcubes_dist::make_stream(seed, s));
+  std::uniform_real_distribution<double> uniform(0., 1.);
+
+  // per chunk: ti, tsi and d[i][j] at 2 + (j - 1) * nd + i - 1
+  const size_t stride = 2 + static_cast<size_t>(nd) * ndim;
+  std::vector<double> partials(num_streams * stride);
+  std::vector<double> d((nd + 1) * (ndim + 1)), dt(ndim + 1);
+  auto d_at = [&](int i, int j) -> double& { return d[j * (nd + 1) + i]; };
+
+  double si = 0., swgt = 0., schi = 0.;
+  double tgral = 0., sd = 0., chi2a = 0.;
+  int kg[MXDIM + 1], ia[MXDIM + 1];
+  double x[NDIM + 1];
+
+  for (int it = 1; it <= itmx; it++) {
+    std::fill(partials.begin(), partials.end(), 0.);
+
+    for (int s = first_stream; s < last_stream; s++) {
+      std::mt19937_64& gen = streams[s - first_stream];
+      double* part = &partials[s * stride];
+      double* part_d = part + 2;
+      const size_t first_cube = s * ncubes / num_streams;
+      const size_t last_cube = (s + 1) * ncubes / num_streams;
+
+      for (size_t m = first_cube; m < last_cube; m++) {
+        get_indx(m, &kg[1], ndim, ng);
+        double fb = 0., f2b = 0.;
+
+        for (int k = 1; k <= npg; k++) {
+          double wgt = xjac;
+          for (int j = 1; j <= ndim; j++) {
+            const double xn = (kg[j] - uniform(gen)) * dxg + 1.0;
+            ia[j] = IMAX(IMIN((int)(xn), NDMX), 1);
+            double xo, rc;
+            if (ia[j] > 1) {
+              xo = xi[j][ia[j]] - xi[j][ia[j] - 1];
+              rc = xi[j][ia[j] - 1] + (xn - ia[j]) * xo;
+            } else {
+              xo = xi[j][ia[j]];
+              rc = (xn - ia[j]) * xo;
+            }
+            x[j] = regn[j] + rc * dx[j];
+            wgt *= xo * xnd;
+          }
+
+          std::array<double, NDIM> xx;
+          for (int dim = 0; dim < NDIM; ++dim)
+            xx[dim] = x[dim + 1];
+          const double f = wgt * std::apply(integrand, xx);
+          const double f2 = f * f;
+          fb += f;
+          f2b += f2;
+          for (int j = 1; j <= ndim; j++)
+            part_d[(j - 1) * nd + ia[j] - 1] += f2;
+        }
+
+        f2b = sqrt(f2b * npg);
+        f2b = (f2b - fb) * (f2b + fb);
+        if (f2b <= 0.0)
+          f2b = TINY;
+        part[0] += fb;
+        part[1] += f2b;
+      }
+    }
+
+    // every slot is non-zero on one rank at most, so the sum is exact
+    reducer.sum(partials.data(), partials.size());
+
+    double ti = 0., tsi = 0.;
+    std::fill(d.begin(), d.end(), 0.);
+    for (int s = 0; s < num_streams; s++) {
+      const double* part = &partials[s * stride];
+      ti += part[0];
+      tsi += part[1];
+      for (int j = 1; j <= ndim; j++)
+        for (int i = 1; i <= nd; i++)
+          d_at(i, j) += part[2 + (j - 1) * nd + i - 1];
+    }
+
+    tsi *= dv2g;
+    const double wgt = 1.0 / tsi;
+    si += wgt * ti;
+    schi += wgt * ti * ti;
+    swgt += wgt;
+    tgral = si / swgt;
+    chi2a = (schi - si * tgral) / (it - 0.9999);
+    if (chi2a < 0.0)
+      chi2a = 0.0;
+    sd = sqrt(1.0 / swgt);
+
+    // smooth the contributions and adjust the intervals
+    for (int j = 1; j <= ndim; j++) {
+      double xo = d_at(1, j);
+      double xn = d_at(2, j);
+      d_at(1, j) = (xo + xn) / 2.0;
+      dt[j] = d_at(1, j);
+      for (int i = 2; i < nd; i++) {
+        const double rc = xo + xn;
+        xo = xn;
+        xn = d_at(i + 1, j);
+        d_at(i, j) = (rc + xn) / 3.0;
+        dt[j] += d_at(i, j);
+      }
+      d_at(nd, j) = (xo + xn) / 2.0;
+      dt[j] += d_at(nd, j);
+    }
+
+    for (int j = 1; j <= ndim; j++) {
+      double rc = 0.0;
+      for (int i = 1; i <= nd; i++) {
+        if (d_at(i, j) < TINY)
+          d_at(i, j) = TINY;
+        r[i] = pow((1.0 - d_at(i, j) / dt[j]) / (log(dt[j]) - log(d_at(i, j))),
+                   ALPH);
+        rc += r[i];
+      }
+      rebin(rc / xnd, nd, r.data(), xin.data(), xi[j].data());
+    }
+  }
+
+  numint::integration_result result;
+  result.estimate = tgral;
+  result.errorest = sd;
+  result.chi_sq = chi2a;
+  result.neval = static_cast<size_t>(calls) * itmx;
+  result.iters = itmx;
+  result.status = sd / abs(tgral) <= epsrel || sd <= epsabs ? 0 : 1;
+  return result;
+}
+
+#endif
@@ -228,11 +228,12 @@ rebin(double rc, int nd, double r[], double xin[], double xi[])
   (int)pow(ncall / 2.0 + 0.25, 1.0 / ndim)) and the number of intervals in each
   dimension calculates the indexes for that subcube*/
 void
-get_indx(int ms, int* da, int ND, int NINTV)
+get_indx(size_t ms, int* da, int ND, int NINTV)
 {
-  int dp[MXDIM];
-  int j, t0, t1;
-  int m = ms;
+  size_t dp[MXDIM];
+  size_t t0, t1;
+  int j;
+  size_t m = ms;
   dp[0] = 1;
   dp[1] = NINTV;
   // avoid use of pow() function
@@ -333,7 +334,9 @@ vegas_mcubes(IntegT integrand,
   // printf("ng, npg, dv2g, xjac, %d, %d, %e, %e\n", ng, npg, dv2g, xjac);
 
   double ran00;
-  int ncubes = pow(ng, ndim);
+  size_t ncubes = 1;
+  for (j = 1; j <= ndim; j++)
+    ncubes *= ng;
 
   /*std::cout<<"ndim:"<<ndim<<"\n";
   std::cout<<"calls:"<<calls<<"\n";
@@ -358,7 +361,7 @@ vegas_mcubes(IntegT integrand,
 
     // std::cout<<"finished resetting contributions for new iteration\n";
 
-    for (int m = 0; m < ncubes; m++) {
+    for (size_t m = 0; m < ncubes; m++) {
       get_indx(m,
                &kg[1],
                ndim,
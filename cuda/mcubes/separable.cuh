@@ -0,0 +1,118 @@
+#ifndef GPUINTEGRATION_MCUBES_SEPARABLE_CUH
+#define GPUINTEGRATION_MCUBES_SEPARABLE_CUH
+
+#include "cuda/mcubes/vegasT.cuh"
+#include "common/cuda/Volume.cuh"
+#include "common/integration_result.hh"
+#include "common/separable.hh"
+#include <utility>
+#include <vector>
+
+// mcubes backend of the separable integrands of common/separable.hh: every
+// factor gets a VEGAS run of its own dimension, with the same calls per
+// iteration as the whole integrand would. The errors are standard errors
+// and combine as such.
+
+namespace cuda_mcubes {
+
+  namespace detail {
+    using Tolerances = std::vector<numint::separable_tolerance>;
+
+    template <typename IntegT,
+              int g,
+              int ndim,
+              typename GeneratorType = typename ::Curand_generator>
+    numint::integration_result
+    integrate_factor(IntegT const& integrand,
+                     numint::separable_tolerance const& tolerance,
+                     double ncall,
+                     quad::Volume<double, ndim> const* volume,
+                     int totalIters,
+                     int adjustIters,
+                     int skipIters)
+    {
+      constexpr int group_ndim = numint::separable_group_size<IntegT, g>;
+      constexpr int offset = numint::separable_offset<IntegT>(g);
+      quad::Volume<double, group_ndim> group_volume(volume->lows + offset,
+                                                    volume->highs + offset);
+      auto factor =
+        numint::separable_traits<IntegT>::template factor<g>(integrand);
+      return integrate<decltype(factor), group_ndim, false, GeneratorType>(
+        factor,
+        tolerance.epsrel,
+        tolerance.epsabs,
+        ncall,
+        &group_volume,
+        totalIters,
+        adjustIters,
+        skipIters);
+    }
+
+    template <typename IntegT, int ndim, typename GeneratorType, int... g>
+    std::vector<numint::integration_result>
+    integrate_factors(IntegT const& integrand,
+                      Tolerances const& tolerances,
+                      double ncall,
+                      quad::Volume<double, ndim> const* volume,
+                      int totalIters,
+                      int adjustIters,
+                      int skipIters,
+                      std::integer_sequence<int, g...>)
+    {
+      return {integrate_factor<IntegT, g, ndim, GeneratorType>(integrand,
+                                                               tolerances[g],
+                                                               ncall,
+                                                               volume,
+                                                               totalIters,
+                                                               adjustIters,
+                                                               skipIters)...};
+    }
+  }
+
+  template <typename IntegT,
+            int NDIM,
+            typename GeneratorType = typename ::Curand_generator>
+  numint::integration_result
+  integrate_separable(IntegT const& integrand,
+                      double epsrel,
+                      double epsabs,
+                      double ncall,
+                      quad::Volume<double, NDIM> const* volume,
+                      int totalIters = 15,
+                      int adjustIters = 15,
+                      int skipIters = 5,
+                      int max_rounds = 4)
+  {
+    using Traits = numint::separable_traits<IntegT>;
+    static_assert(Traits::value, "the integrand is not declared separable");
+    static_assert(numint::separable_ndim<IntegT>() == NDIM,
+                  "the groups do not cover the dimensions of the integrand");
+    constexpr int num_groups = numint::num_separable_groups<IntegT>;
+
+    std::vector<double> volumes(num_groups, 1.);
+    for (int g = 0, d = 0; g < num_groups; ++g)
+      for (int k = 0; k < numint::separable_groups<IntegT>[g]; ++k, ++d)
+        volumes[g] *= volume->highs[d] - volume->lows[d];
+
+    auto evaluate = [&](detail::Tolerances const& tolerances) {
+      return detail::integrate_factors<IntegT, NDIM, GeneratorType>(
+        integrand,
+        tolerances,
+        ncall,
+        volume,
+        totalIters,
+        adjustIters,
+        skipIters,
+        std::make_integer_sequence<int, num_groups>());
+    };
+    return numint::separable_iterate(Traits::kind,
+                                     numint::separable_errors::statistical,
+                                     volumes,
+                                     epsrel,
+                                     epsabs,
+                                     evaluate,
+                                     max_rounds);
+  }
+}
+
+#endif
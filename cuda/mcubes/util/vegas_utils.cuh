@@ -201,8 +201,8 @@ struct Kernel_Params {
   int npg = 0;
   uint32_t nBlocks = 0;
   uint32_t nThreads = 0;
-  uint32_t totalNumThreads = 0;
-  uint32_t totalCubes = 0;
+  size_t totalNumThreads = 0;
+  size_t totalCubes = 0;
   int extra = 0;
   int LastChunk = 0; // how many chunks for the last thread
 
@@ -211,7 +211,7 @@ struct Kernel_Params {
     ncubes = ComputeNcubes(ncall, ndim);
     npg = Compute_samples_per_cube(ncall, ncubes);
 
-    totalNumThreads = (uint32_t)((ncubes) / chunkSize);
+    totalNumThreads = (size_t)((ncubes) / chunkSize);
     totalCubes = totalNumThreads * chunkSize;
     extra = totalCubes - ncubes;
     LastChunk = chunkSize - extra;
@@ -30,7 +30,7 @@ class IterDataLogger {
 public:
   FuncEval<NDIM>* funcevals = nullptr;
   double* randoms = nullptr;
-  IterDataLogger(uint32_t totalNumThreads,
+  IterDataLogger(size_t totalNumThreads,
                  int chunkSize,
                  int extra,
                  int npg,
@@ -113,13 +113,13 @@ public:
   }
 
   void
-  PrintRandomNums(int it, int ncubes, int npg, int ndim)
+  PrintRandomNums(int it, size_t ncubes, int npg, int ndim)
   {
 
     size_t nums_per_cube = npg * ndim;
     size_t nums_per_sample = ndim;
 
-    for (int cube = 0; cube < ncubes; cube++)
+    for (size_t cube = 0; cube < ncubes; cube++)
       for (int sample = 1; sample <= npg; sample++){
         size_t index = cube * nums_per_cube * npg + sample ;
         myfile_randoms << it << "," 
@@ -139,12 +139,12 @@ public:
   }
 
   void
-  PrintFuncEvals(int it, int ncubes, int npg, int ndim)
+  PrintFuncEvals(int it, size_t ncubes, int npg, int ndim)
   {
     size_t num_fevals = ncubes * npg;
-    for (int cube = 0; cube < ncubes; cube++)
+    for (size_t cube = 0; cube < ncubes; cube++)
       for (int sample = 0; sample < npg; sample++) {
-        int index = npg * cube + sample;
+        size_t index = npg * cube + sample;
         myfile_funcevals << it << "," 
                         << cube << "," 
                         << sample << ","
@@ -159,7 +159,7 @@ public:
   void
   PrintIntervals(int ndim,
                  int ng,
-                 uint32_t totalNumThreads,
+                 size_t totalNumThreads,
                  int chunkSize,
                  int it)
   {
@@ -35,6 +35,7 @@ Last three arguments are: total iterations, iteration
 #include "common/cuda/Volume.cuh"
 #include "common/cuda/cudaApply.cuh"
 #include "common/cuda/cudaArray.cuh"
+#include "common/cuda/nonfinite.cuh"
 #include "cuda/mcubes/seqCodesDefs.hh"
 #include "cuda/mcubes/util/vegas_utils.cuh"
 #include "cuda/mcubes/util/verbose_utils.cuh"
@@ -43,8 +44,10 @@ Last three arguments are: total iterations, iteration
 #include <ctime>
 #include <curand_kernel.h>
 #include <fstream>
+#include <future>
 #include <inttypes.h>
 #include <iostream>
+#include <limits>
 #include <math.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -53,6 +56,9 @@ Last three arguments are: total iterations, iteration
 #include <cuda_profiler_api.h>
 
 #include "common/integration_result.hh"
+#include "common/nonfinite.hh"
+#include "common/vegas_grid.hh"
+#include "common/vegas_variance.hh"
 
 #define WARP_SIZE 32
 #define BLOCK_DIM_X 128
@@ -138,14 +144,15 @@ namespace cuda_mcubes {
     return val;
   }
 
+  // decodes the 64-bit cube index ms into its 1-based per-axis intervals
   __inline__ __device__ __host__ void
-  get_indx(uint32_t ms, uint32_t* da, int ND, int NINTV)
+  get_indx(size_t ms, uint32_t* da, int ND, int NINTV)
   {
     // called like :    get_indx(m * chunkSize, &kg[1], ndim, ng);
-    uint32_t dp[Internal_Vegas_Params::get_MXDIM()];
-    uint32_t t0, t1;
+    size_t dp[Internal_Vegas_Params::get_MXDIM()];
+    size_t t0, t1;
     int j;
-    uint32_t m = ms;
+    size_t m = ms;
     dp[0] = 1;
     dp[1] = NINTV;
 
@@ -164,7 +171,7 @@ namespace cuda_mcubes {
   void
   Test_get_indx(int ndim,
                 int ng,
-                uint32_t totalNumThreads,
+                size_t totalNumThreads,
                 int chunkSize,
                 int it,
                 std::ofstream& interval_myfile)
@@ -174,7 +181,7 @@ namespace cuda_mcubes {
     if (it == 1)
       interval_myfile << "m, kg[1], kg[2], kg[3], it\n";
 
-    for (uint32_t m = 0; m < totalNumThreads; m++) {
+    for (size_t m = 0; m < totalNumThreads; m++) {
       uint32_t kg[mxdim_p1];
       get_indx(m, &kg[1], ndim, ng);
 
@@ -201,7 +208,7 @@ namespace cuda_mcubes {
                        double& wgt,
                        int npg,
                        int sampleID,
-                       uint32_t cube_id,
+                       size_t cube_id,
                        int iter,
                        double* randoms = nullptr)
   {
@@ -234,6 +241,35 @@ namespace cuda_mcubes {
     }
   }
 
+  // logs a non-finite sample with the grid cell it was drawn from. Only
+  // taken for non-finite values, so the bins are searched again instead of
+  // being kept for every sample.
+  template <int ndim>
+  __device__ void
+  Record_nonfinite(quad::Nonfinite_log<double> const& nonfinite,
+                   double value,
+                   const double* const x,
+                   const double* const regn,
+                   const double* const dx,
+                   const double* const xi)
+  {
+    constexpr int ndmx = Internal_Vegas_Params::get_NDMX();
+    constexpr int ndmx1 = Internal_Vegas_Params::get_NDMX_p1();
+    const int slot = nonfinite.record(value);
+    for (int j = 1; j <= ndim; j++) {
+      const double rc = (x[j] - regn[j]) / dx[j];
+      int bin = 1;
+      while (bin < ndmx && xi[j * ndmx1 + bin] < rc)
+        ++bin;
+      const double low = bin > 1 ? xi[j * ndmx1 + bin - 1] : 0.;
+      nonfinite.store(slot,
+                      j - 1,
+                      x[j],
+                      regn[j] + low * dx[j],
+                      regn[j] + xi[j * ndmx1 + bin] * dx[j]);
+    }
+  }
+
   template <typename IntegT,
             int ndim,
             bool DEBUG_MCUBES = false,
@@ -255,10 +291,11 @@ namespace cuda_mcubes {
                       double* d,
                       double& fb,
                       double& f2b,
-                      uint32_t cube_id,
+                      size_t cube_id,
                       int iter,
                       double* randoms = nullptr,
-                      FuncEval<ndim>* funcevals = nullptr)
+                      FuncEval<ndim>* funcevals = nullptr,
+                      quad::Nonfinite_log<double> nonfinite = {})
   {
     constexpr int mxdim_p1 = Internal_Vegas_Params::get_MXDIM_p1();
     for (int k = 1; k <= npg; k++) {
@@ -291,7 +328,11 @@ namespace cuda_mcubes {
         }
       }
 
-      const double tmp = gpu::apply(*d_integrand, xx);
+      double tmp = gpu::apply(*d_integrand, xx);
+      if (!isfinite(tmp) && nonfinite.enabled()) {
+        Record_nonfinite<ndim>(nonfinite, tmp, x, regn, dx, xi);
+        tmp = nonfinite.sample_replacement(tmp);
+      }
       const double f = wgt * tmp;
 
       if constexpr(DEBUG_MCUBES){
@@ -340,13 +381,14 @@ namespace cuda_mcubes {
                  size_t cube_id_offset,
                  int iter,
                  double* randoms = nullptr,
-                 FuncEval<ndim>* funcevals = nullptr)
+                 FuncEval<ndim>* funcevals = nullptr,
+                 quad::Nonfinite_log<double> nonfinite = {})
   {
 
     for (int t = 0; t < chunkSize; t++) {
       double fb = 0.,
              f2b = 0.0; // init to zero for each interval processed by thread
-      uint32_t cube_id = cube_id_offset + t;
+      size_t cube_id = cube_id_offset + t;
 
       // can't use if(is_same<GeneratorType, Custom_generator>) in device code
       // can't do if statement checking whether typename GeneratorType ==
@@ -377,7 +419,8 @@ namespace cuda_mcubes {
         cube_id,
         iter,
         randoms,
-        funcevals);
+        funcevals,
+        nonfinite);
 
       f2b = sqrt(f2b * npg);
       f2b = (f2b - fb) * (f2b + fb);
@@ -414,20 +457,21 @@ namespace cuda_mcubes {
                double* d,
                double* dx,
                double* regn,
-               int ncubes,
+               size_t ncubes,
                int iter,
                double sc,
                double sci,
                double ing,
                int chunkSize,
-               uint32_t totalNumThreads,
+               size_t totalNumThreads,
                int LastChunk,
                unsigned int seed_init,
                double* randoms = nullptr,
-               FuncEval<ndim>* funcevals = nullptr)
+               FuncEval<ndim>* funcevals = nullptr,
+               quad::Nonfinite_log<double> nonfinite = {})
   {
     constexpr int mxdim_p1 = Internal_Vegas_Params::get_MXDIM_p1();
-    uint32_t m = blockIdx.x * blockDim.x + threadIdx.x;
+    const size_t m = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
     uint32_t tx = threadIdx.x;
     double wgt;
     uint32_t kg[mxdim_p1];
@@ -437,8 +481,7 @@ namespace cuda_mcubes {
 
     if (m < totalNumThreads) {
 
-      size_t cube_id_offset =
-        (blockIdx.x * blockDim.x + threadIdx.x) * chunkSize;
+      size_t cube_id_offset = m * chunkSize;
 
       if (m == totalNumThreads - 1)
         chunkSize = LastChunk;
@@ -469,7 +512,8 @@ namespace cuda_mcubes {
         cube_id_offset,
         iter,
         randoms,
-        funcevals);
+        funcevals,
+        nonfinite);
     }
 
     // testing if synch is needed
@@ -504,24 +548,25 @@ namespace cuda_mcubes {
                 double* d,
                 double* dx,
                 double* regn,
-                int ncubes,
+                size_t ncubes,
                 int iter,
                 double sc,
                 double sci,
                 double ing, // not needed?
                 int chunkSize,
-                uint32_t totalNumThreads,
+                size_t totalNumThreads,
                 int LastChunk,
-                unsigned int seed_init)
+                unsigned int seed_init,
+                quad::Nonfinite_log<double> nonfinite = {})
   {
 
     constexpr int ndmx = Internal_Vegas_Params::get_NDMX();
     constexpr int ndmx_p1 = Internal_Vegas_Params::get_NDMX_p1();
     constexpr int mxdim_p1 = Internal_Vegas_Params::get_MXDIM_p1();
 
-    uint32_t m = blockIdx.x * blockDim.x + threadIdx.x;
+    const size_t m = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
     int tx = threadIdx.x;
-    size_t cube_id_offset = (blockIdx.x * blockDim.x + threadIdx.x) * chunkSize;
+    size_t cube_id_offset = m * chunkSize;
 
     double fb, f2b, wgt, xn, xo, rc, f, f2, ran00;
     uint32_t kg[mxdim_p1];
@@ -575,6 +620,10 @@ namespace cuda_mcubes {
           }
 
           tmp = gpu::apply(*d_integrand, xx);
+          if (!isfinite(tmp) && nonfinite.enabled()) {
+            Record_nonfinite<ndim>(nonfinite, tmp, x, regn, dx, xi);
+            tmp = nonfinite.sample_replacement(tmp);
+          }
 
           f = wgt * tmp;
           f2 = f * f;
@@ -618,6 +667,161 @@ namespace cuda_mcubes {
     // end of subcube if
   }
 
+  // maps the uniform variates u[1..ndim] of a sample of hypercube kg to the
+  // grid, as Setup_Integrand_Eval does with the variates it draws
+  template <int ndim>
+  __device__ void
+  Map_to_grid(const double* const u,
+              double xnd,
+              double dxg,
+              const double* const xi,
+              const double* const regn,
+              const double* const dx,
+              const uint32_t* const kg,
+              int* const ia,
+              double* const x,
+              double& wgt)
+  {
+    constexpr int ndmx = Internal_Vegas_Params::get_NDMX();
+    constexpr int ndmx1 = Internal_Vegas_Params::get_NDMX_p1();
+    for (int j = 1; j <= ndim; j++) {
+      const double xn = (kg[j] - u[j]) * dxg + 1.0;
+      ia[j] = IMAX(IMIN((int)(xn), ndmx), 1);
+      double xo, rc;
+      if (ia[j] > 1) {
+        xo = xi[j * ndmx1 + ia[j]] - xi[j * ndmx1 + ia[j] - 1];
+        rc = xi[j * ndmx1 + ia[j] - 1] + (xn - ia[j]) * xo;
+      } else {
+        xo = xi[j * ndmx1 + ia[j]];
+        rc = (xn - ia[j]) * xo;
+      }
+      x[j] = regn[j] + rc * dx[j];
+      wgt *= xo * xnd;
+    }
+  }
+
+  // Both phases of vegas with antithetic pairs and/or a control variate,
+  // see numint::vegas_variance_reduction. A pair counts as one sample, so a
+  // hypercube has npg / 2 of them. result_dev gets the fields of
+  // numint::vegas_reduced_sums, variances scaled like those of vegas_kernel
+  // so that dv2g applies unchanged. The bin contributions in d are only
+  // accumulated when adjust is set.
+  template <typename IntegT,
+            typename ControlT,
+            int ndim,
+            typename GeneratorType = Curand_generator>
+  __global__ void
+  vegas_kernel_reduced(IntegT* d_integrand,
+                       ControlT* d_control,
+                       bool antithetic,
+                       bool adjust,
+                       int ng,
+                       int npg,
+                       double xjac,
+                       double dxg,
+                       double* result_dev,
+                       double xnd,
+                       double* xi,
+                       double* d,
+                       double* dx,
+                       double* regn,
+                       int chunkSize,
+                       size_t totalNumThreads,
+                       int LastChunk,
+                       unsigned int seed_init,
+                       quad::Nonfinite_log<double> nonfinite = {})
+  {
+    constexpr int mxdim_p1 = Internal_Vegas_Params::get_MXDIM_p1();
+    constexpr bool has_control =
+      numint::vegas_variance_reduction<ControlT>::has_control();
+    const size_t m = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+    const int units = antithetic ? npg / 2 : npg;
+    const double scale = (npg - 1.0) / (units - 1.0);
+    double sums[5] = {0., 0., 0., 0., 0.};
+
+    if (m < totalNumThreads) {
+      const size_t cube_id_offset = m * chunkSize;
+      if (m == totalNumThreads - 1)
+        chunkSize = LastChunk;
+
+      Random_num_generator<GeneratorType> rand_num_generator(seed_init);
+      uint32_t kg[mxdim_p1];
+      int ia[mxdim_p1];
+      double x[mxdim_p1];
+      double u[mxdim_p1];
+      get_indx(cube_id_offset, &kg[1], ndim, ng);
+
+      for (int t = 0; t < chunkSize; t++) {
+        if constexpr (mcubes::TypeChecker<GeneratorType, Custom_generator>::
+                        is_custom_generator()) {
+          rand_num_generator.SetSeed(cube_id_offset + t);
+        }
+
+        double sf = 0., sff = 0., sc = 0., scc = 0., sfc = 0.;
+        for (int k = 0; k < units; k++) {
+          for (int j = 1; j <= ndim; j++)
+            u[j] = rand_num_generator();
+
+          double uf = 0., uc = 0.;
+          for (int side = 0; side <= (antithetic ? 1 : 0); side++) {
+            if (side == 1)
+              for (int j = 1; j <= ndim; j++)
+                u[j] = 1.0 - u[j];
+
+            double wgt = xjac;
+            Map_to_grid<ndim>(u, xnd, dxg, xi, regn, dx, kg, ia, x, wgt);
+            gpu::cudaArray<double, ndim> xx;
+            for (int i = 0; i < ndim; i++)
+              xx[i] = x[i + 1];
+
+            double tmp = gpu::apply(*d_integrand, xx);
+            if (!isfinite(tmp) && nonfinite.enabled()) {
+              Record_nonfinite<ndim>(nonfinite, tmp, x, regn, dx, xi);
+              tmp = nonfinite.sample_replacement(tmp);
+            }
+            const double f = wgt * tmp;
+            uf += f;
+            if (adjust)
+              for (int j = 1; j <= ndim; j++)
+                atomicAdd(&d[ia[j] * mxdim_p1 + j], f * f);
+            if constexpr (has_control)
+              uc += wgt * gpu::apply(*d_control, xx);
+          }
+
+          sf += uf;
+          sff += uf * uf;
+          if constexpr (has_control) {
+            sc += uc;
+            scc += uc * uc;
+            sfc += uf * uc;
+          }
+        }
+
+        const double vff = (units * sff - sf * sf) * scale;
+        sums[0] += sf;
+        sums[1] += vff <= 0.0 ? TINY : vff;
+        if constexpr (has_control) {
+          sums[2] += sc;
+          sums[3] += (units * scc - sc * sc) * scale;
+          sums[4] += (units * sfc - sf * sc) * scale;
+        }
+
+        for (int k = ndim; k >= 1; k--) {
+          kg[k] %= ng;
+          if (++kg[k] != 1)
+            break;
+        }
+      }
+    }
+
+    __syncthreads();
+    for (int i = 0; i < (has_control ? 5 : 2); i++) {
+      const double sum = blockReduceSum(sums[i]);
+      if (threadIdx.x == 0)
+        atomicAdd(&result_dev[i], sum);
+    }
+  }
+
   __inline__ void
   rebin(double rc, int nd, double r[], double xin[], double xi[])
   {
@@ -644,7 +848,8 @@ namespace cuda_mcubes {
   template <typename IntegT,
             int ndim,
             bool DEBUG_MCUBES = false,
-            typename GeneratorType = typename ::Curand_generator>
+            typename GeneratorType = typename ::Curand_generator,
+            typename ControlT = numint::no_control_variate>
   void
   vegas(IntegT const& integrand,
         double epsrel,
@@ -658,7 +863,13 @@ namespace cuda_mcubes {
         int titer,
         int itmax,
         int skip,
-        quad::Volume<double, ndim> const* vol)
+        quad::Volume<double, ndim> const* vol,
+        numint::vegas_grid* grid = nullptr,
+        bool reuse_statistics = false,
+        numint::nonfinite_policy nonfinite_policy =
+          numint::nonfinite_policy::propagate,
+        numint::nonfinite_report* nonfinite = nullptr,
+        numint::vegas_variance_reduction<ControlT> const& reduction = {})
   {
     auto t0 = std::chrono::high_resolution_clock::now();
 
@@ -666,7 +877,13 @@ namespace cuda_mcubes {
     constexpr int ndmx_p1 = Internal_Vegas_Params::get_NDMX_p1();
     constexpr int mxdim_p1 = Internal_Vegas_Params::get_MXDIM_p1();
 
+    constexpr bool has_control =
+      numint::vegas_variance_reduction<ControlT>::has_control();
+
     IntegT* d_integrand = quad::cuda_copy_to_managed(integrand);
+    ControlT* d_control = nullptr;
+    if constexpr (has_control)
+      d_control = quad::cuda_copy_to_managed(reduction.control);
     double regn[2 * mxdim_p1];
 
     for (int j = 1; j <= ndim; j++) {
@@ -679,7 +896,7 @@ namespace cuda_mcubes {
     double calls, dv2g, dxg, rc, ti, tsi, wgt, xjac, xn, xnd, xo;
     double k, ncubes;
     double schi, si, swgt;
-    double result[2];
+    double result[5];
     double *d, *dt, *dx, *r, *x, *xi, *xin;
     int* ia;
 
@@ -720,6 +937,9 @@ namespace cuda_mcubes {
     ncubes = k;
 
     npg = IMAX(ncall / k, 2);
+    // whole pairs, at least two of them for the variance
+    if (reduction.antithetic)
+      npg = IMAX(npg + (npg & 1), 4);
     // assert(npg == Compute_samples_per_cube(ncall, ncubes)); //to replace line
     // directly above assert(ncubes == ComputeNcubes(ncall, ndim)); //to replace
     // line directly above
@@ -745,12 +965,29 @@ namespace cuda_mcubes {
       rebin(ndo / xnd, nd, r, xin, &xi[j * ndmx_p1]);
     }
 
+    // start from a previously adapted grid instead of the uniform one
+    size_t prior_iters = 0;
+    const size_t iters_at_start = *iters;
+    if (grid != nullptr && !grid->empty()) {
+      if (grid->ndim != ndim || grid->nbins != nd) {
+        throw std::invalid_argument(
+          "vegas grid does not match the number of dimensions or bins");
+      }
+      grid->export_to(xi, ndmx_p1);
+      if (reuse_statistics) {
+        si = grid->si;
+        swgt = grid->swgt;
+        schi = grid->schi;
+        prior_iters = grid->iters;
+      }
+    }
+
     ndo = nd;
 
     double *d_dev, *dx_dev, *x_dev, *xi_dev, *regn_dev, *result_dev;
     int* ia_dev;
 
-    cudaMalloc((void**)&result_dev, sizeof(double) * 2);
+    cudaMalloc((void**)&result_dev, sizeof(double) * 5);
     cudaCheckError();
     cudaMalloc((void**)&d_dev, sizeof(double) * (ndmx_p1) * (mxdim_p1));
     cudaCheckError();
@@ -777,14 +1014,60 @@ namespace cuda_mcubes {
     cudaMemset(ia_dev, 0, sizeof(int) * (mxdim_p1));
 
     int chunkSize = GetChunkSize(ncall);
-    uint32_t totalNumThreads = (uint32_t)((ncubes) / chunkSize);
+    size_t totalNumThreads = (size_t)((ncubes) / chunkSize);
 
-    uint32_t totalCubes = totalNumThreads * chunkSize; // even-split cubes
+    size_t totalCubes = totalNumThreads * chunkSize; // even-split cubes
     int extra = ncubes - totalCubes;                   // left-over cubes
     int LastChunk = extra + chunkSize; // last chunk of last thread
     Kernel_Params params(ncall, chunkSize, ndim);
     IterDataLogger<DEBUG_MCUBES, ndim> data_collector(
       totalNumThreads, chunkSize, extra, npg, ndim);
+    quad::Nonfinite_monitor<double> monitor(ndim);
+    monitor.set_policy(nonfinite_policy);
+    // with fail, the first iteration meeting a non-finite value is the last
+    auto launch_reduced = [&](bool adjust, unsigned int seed) {
+      vegas_kernel_reduced<IntegT, ControlT, ndim, GeneratorType>
+        <<<params.nBlocks, params.nThreads>>>(d_integrand,
+                                              d_control,
+                                              reduction.antithetic,
+                                              adjust,
+                                              ng,
+                                              npg,
+                                              xjac,
+                                              dxg,
+                                              result_dev,
+                                              xnd,
+                                              xi_dev,
+                                              d_dev,
+                                              dx_dev,
+                                              regn_dev,
+                                              chunkSize,
+                                              totalNumThreads,
+                                              LastChunk,
+                                              seed,
+                                              monitor.device_log());
+    };
+    // the iteration estimate and variance, before the dv2g scaling
+    auto read_iteration = [&]() {
+      cudaMemcpy(
+        result, result_dev, sizeof(double) * 5, cudaMemcpyDeviceToHost);
+      ti = result[0];
+      tsi = result[1];
+      if constexpr (has_control) {
+        const numint::vegas_reduced_sums sums{
+          result[0], result[1], result[2], result[3], result[4]};
+        numint::apply_control_variate(
+          sums, reduction.control_integral, ti, tsi);
+      }
+    };
+    auto stop_on_nonfinite = [&]() {
+      if (!monitor.must_stop())
+        return false;
+      *tgral = std::numeric_limits<double>::quiet_NaN();
+      *sd = std::numeric_limits<double>::quiet_NaN();
+      *status = numint::nonfinite_status;
+      return true;
+    };
     LOG(true, "starting iterations with adjustement");
     for (it = 1; it <= itmax && (*status) == 1; (*iters)++, it++) {
 
@@ -801,36 +1084,43 @@ namespace cuda_mcubes {
       cudaCheckError(); // bin bounds
       cudaMemset(
         d_dev, 0, sizeof(double) * (ndmx_p1) * (mxdim_p1)); // bin contributions
-      cudaMemset(result_dev, 0, 2 * sizeof(double));
+      cudaMemset(result_dev, 0, 5 * sizeof(double));
 
       MilliSeconds time_diff = std::chrono::high_resolution_clock::now() - t0;
       unsigned int seed = static_cast<unsigned int>(time_diff.count()) +
                           static_cast<unsigned int>(it);
-      vegas_kernel<IntegT, ndim, DEBUG_MCUBES, GeneratorType>
-        <<<params.nBlocks, params.nThreads>>>(d_integrand,
-                                              ng,
-                                              npg,
-                                              xjac,
-                                              dxg,
-                                              result_dev,
-                                              xnd,
-                                              xi_dev,
-                                              d_dev,
-                                              dx_dev,
-                                              regn_dev,
-                                              ncubes,
-                                              it,
-                                              sc,
-                                              sci,
-                                              ing,
-                                              chunkSize,
-                                              totalNumThreads,
-                                              LastChunk,
-                                              seed + it,
-                                              data_collector.randoms,
-                                              data_collector.funcevals);
+      if (reduction.active()) {
+        launch_reduced(true, seed + it);
+      } else {
+        vegas_kernel<IntegT, ndim, DEBUG_MCUBES, GeneratorType>
+          <<<params.nBlocks, params.nThreads>>>(d_integrand,
+                                                ng,
+                                                npg,
+                                                xjac,
+                                                dxg,
+                                                result_dev,
+                                                xnd,
+                                                xi_dev,
+                                                d_dev,
+                                                dx_dev,
+                                                regn_dev,
+                                                ncubes,
+                                                it,
+                                                sc,
+                                                sci,
+                                                ing,
+                                                chunkSize,
+                                                totalNumThreads,
+                                                LastChunk,
+                                                seed + it,
+                                                data_collector.randoms,
+                                                data_collector.funcevals,
+                                                monitor.device_log());
+      }
 
       cudaDeviceSynchronize();
+      if (stop_on_nonfinite())
+        break;
       cudaMemcpy(xi,
                  xi_dev,
                  sizeof(double) * (mxdim_p1) * (ndmx_p1),
@@ -843,11 +1133,7 @@ namespace cuda_mcubes {
                  cudaMemcpyDeviceToHost);
 
       cudaCheckError(); // we do need to the contributions for the rebinning
-      cudaMemcpy(
-        result, result_dev, sizeof(double) * 2, cudaMemcpyDeviceToHost);
-
-      ti = result[0];
-      tsi = result[1];
+      read_iteration();
       tsi *= dv2g;
 
       if (it > skip) {
@@ -856,7 +1142,8 @@ namespace cuda_mcubes {
         schi += wgt * ti * ti;
         swgt += wgt;
         *tgral = si / swgt;
-        *chi2a = (schi - si * (*tgral)) / (static_cast<double>(it) - 0.9999);
+        *chi2a = (schi - si * (*tgral)) /
+                 (static_cast<double>(it + prior_iters) - 0.9999);
         if (*chi2a < 0.0)
           *chi2a = 0.0;
         *sd = sqrt(1.0 / swgt);
@@ -936,41 +1223,46 @@ namespace cuda_mcubes {
                cudaMemcpyHostToDevice);
     cudaCheckError();
 
-    for (it = itmax + 1; it <= titer && (*status); (*iters)++, it++) {
+    for (it = itmax + 1; it <= titer && (*status) && !monitor.must_stop();
+         (*iters)++, it++) {
       ti = tsi = 0.0;
-      cudaMemset(result_dev, 0, 2 * sizeof(double));
+      cudaMemset(result_dev, 0, 5 * sizeof(double));
 
       using MilliSeconds =
         std::chrono::duration<double, std::chrono::milliseconds::period>;
       MilliSeconds time_diff = std::chrono::high_resolution_clock::now() - t0;
       unsigned int seed = static_cast<unsigned int>(time_diff.count()) +
                           static_cast<unsigned int>(it);
-      vegas_kernelF<IntegT, ndim, GeneratorType>
-        <<<params.nBlocks, params.nThreads>>>(d_integrand,
-                                              ng,
-                                              npg,
-                                              xjac,
-                                              dxg,
-                                              result_dev,
-                                              xnd,
-                                              xi_dev,
-                                              d_dev,
-                                              dx_dev,
-                                              regn_dev,
-                                              ncubes,
-                                              it,
-                                              sc,
-                                              sci,
-                                              ing,
-                                              chunkSize,
-                                              totalNumThreads,
-                                              LastChunk,
-                                              seed + it);
+      if (reduction.active()) {
+        launch_reduced(false, seed + it);
+      } else {
+        vegas_kernelF<IntegT, ndim, GeneratorType>
+          <<<params.nBlocks, params.nThreads>>>(d_integrand,
+                                                ng,
+                                                npg,
+                                                xjac,
+                                                dxg,
+                                                result_dev,
+                                                xnd,
+                                                xi_dev,
+                                                d_dev,
+                                                dx_dev,
+                                                regn_dev,
+                                                ncubes,
+                                                it,
+                                                sc,
+                                                sci,
+                                                ing,
+                                                chunkSize,
+                                                totalNumThreads,
+                                                LastChunk,
+                                                seed + it,
+                                                monitor.device_log());
+      }
       cudaDeviceSynchronize();
-      cudaMemcpy(
-        result, result_dev, sizeof(double) * 2, cudaMemcpyDeviceToHost);
-      ti = result[0];
-      tsi = result[1];
+      if (stop_on_nonfinite())
+        break;
+      read_iteration();
       tsi *= dv2g;
 
       wgt = 1.0 / tsi;
@@ -979,7 +1271,7 @@ namespace cuda_mcubes {
       swgt += wgt;
       *tgral = si / swgt;
 
-      *chi2a = (schi - si * (*tgral)) / (it - 0.9999);
+      *chi2a = (schi - si * (*tgral)) / (it + prior_iters - 0.9999);
       if (*chi2a < 0.0)
         *chi2a = 0.0;
       *sd = sqrt(1.0 / swgt);
@@ -1000,6 +1292,16 @@ namespace cuda_mcubes {
       }
     } // end of iterations
 
+    if (grid != nullptr) {
+      grid->import_from(xi, ndim, nd, ndmx_p1);
+      grid->si = si;
+      grid->swgt = swgt;
+      grid->schi = schi;
+      grid->iters = prior_iters + (*iters - iters_at_start);
+    }
+    if (nonfinite != nullptr)
+      *nonfinite = monitor.report();
+
     free(d);
     free(dt);
     free(dx);
@@ -1010,6 +1312,10 @@ namespace cuda_mcubes {
     free(r);
 
     d_integrand->~IntegT();
+    if (d_control != nullptr) {
+      d_control->~ControlT();
+      cudaFree(d_control);
+    }
     cudaFree(d_dev);
     cudaFree(dx_dev);
     cudaFree(ia_dev);
@@ -1023,7 +1329,8 @@ namespace cuda_mcubes {
   template <typename IntegT,
             int NDIM,
             bool DEBUG_MCUBES = false,
-            typename GeneratorType = typename ::Curand_generator>
+            typename GeneratorType = typename ::Curand_generator,
+            typename ControlT = numint::no_control_variate>
   numint::integration_result
   integrate(IntegT& ig,
             double epsrel,
@@ -1032,24 +1339,35 @@ namespace cuda_mcubes {
             quad::Volume<double, NDIM> const* volume,
             int totalIters = 15,
             int adjustIters = 15,
-            int skipIters = 5)
+            int skipIters = 5,
+            numint::vegas_grid* grid = nullptr,
+            bool reuse_statistics = false,
+            numint::nonfinite_policy nonfinite_policy =
+              numint::nonfinite_policy::propagate,
+            numint::nonfinite_report* nonfinite = nullptr,
+            numint::vegas_variance_reduction<ControlT> const& reduction = {})
   {
 
     numint::integration_result result;
     result.status = 1;
-    vegas<IntegT, NDIM, DEBUG_MCUBES, GeneratorType>(ig,
-                                                     epsrel,
-                                                     epsabs,
-                                                     ncall,
-                                                     &result.estimate,
-                                                     &result.errorest,
-                                                     &result.chi_sq,
-                                                     &result.status,
-                                                     &result.iters,
-                                                     totalIters,
-                                                     adjustIters,
-                                                     skipIters,
-                                                     volume);
+    vegas<IntegT, NDIM, DEBUG_MCUBES, GeneratorType, ControlT>(ig,
+                                                               epsrel,
+                                                               epsabs,
+                                                               ncall,
+                                                               &result.estimate,
+                                                               &result.errorest,
+                                                               &result.chi_sq,
+                                                               &result.status,
+                                                               &result.iters,
+                                                               totalIters,
+                                                               adjustIters,
+                                                               skipIters,
+                                                               volume,
+                                                               grid,
+                                                               reuse_statistics,
+                                                               nonfinite_policy,
+                                                               nonfinite,
+                                                               reduction);
     return result;
   }
 
@@ -1100,7 +1418,8 @@ namespace cuda_mcubes {
   template <typename IntegT,
             int NDIM,
             bool DEBUG_MCUBES = false,
-            typename GeneratorType = typename ::Curand_generator>
+            typename GeneratorType = typename ::Curand_generator,
+            typename ControlT = numint::no_control_variate>
   numint::integration_result
   simple_integrate(IntegT const& integrand,
                    double epsrel,
@@ -1109,30 +1428,79 @@ namespace cuda_mcubes {
                    quad::Volume<double, NDIM> const* volume,
                    int totalIters = 15,
                    int adjustIters = 15,
-                   int skipIters = 5)
+                   int skipIters = 5,
+                   numint::vegas_grid* grid = nullptr,
+                   bool reuse_statistics = false,
+                   numint::nonfinite_policy nonfinite_policy =
+                     numint::nonfinite_policy::propagate,
+                   numint::nonfinite_report* nonfinite = nullptr,
+                   numint::vegas_variance_reduction<ControlT> const&
+                     reduction = {})
   {
 
     numint::integration_result result;
     result.status = 1;
 
     do {
-      vegas<IntegT, NDIM, DEBUG_MCUBES, GeneratorType>(integrand,
-                                                       epsrel,
-                                                       epsabs,
-                                                       ncall,
-                                                       &result.estimate,
-                                                       &result.errorest,
-                                                       &result.chi_sq,
-                                                       &result.status,
-                                                       &result.iters,
-                                                       totalIters,
-                                                       adjustIters,
-                                                       skipIters,
-                                                       volume);
+      vegas<IntegT, NDIM, DEBUG_MCUBES, GeneratorType, ControlT>(
+        integrand,
+        epsrel,
+        epsabs,
+        ncall,
+        &result.estimate,
+        &result.errorest,
+        &result.chi_sq,
+        &result.status,
+        &result.iters,
+        totalIters,
+        adjustIters,
+        skipIters,
+        volume,
+        grid,
+        reuse_statistics,
+        nonfinite_policy,
+        nonfinite,
+        reduction);
     } while (result.status == 1 && AdjustParams(ncall, totalIters) == true);
 
     return result;
   }
 
+  // integrate on a host thread of its own. The integrand is copied, the
+  // volume and grid are not and must outlive the future. The kernels go to
+  // the default stream, so concurrent calls only overlap on the device when
+  // built with --default-stream per-thread; otherwise the gain is limited to
+  // the host side work.
+  template <typename IntegT,
+            int NDIM,
+            bool DEBUG_MCUBES = false,
+            typename GeneratorType = typename ::Curand_generator>
+  std::future<numint::integration_result>
+  integrate_async(IntegT const& integrand,
+                  double epsrel,
+                  double epsabs,
+                  double ncall,
+                  quad::Volume<double, NDIM> const* volume,
+                  int totalIters = 15,
+                  int adjustIters = 15,
+                  int skipIters = 5,
+                  numint::vegas_grid* grid = nullptr,
+                  bool reuse_statistics = false)
+  {
+    return std::async(std::launch::async, [=]() mutable {
+      return integrate<IntegT, NDIM, DEBUG_MCUBES, GeneratorType>(
+        integrand,
+        epsrel,
+        epsabs,
+        ncall,
+        volume,
+        totalIters,
+        adjustIters,
+        skipIters,
+        grid,
+        reuse_statistics);
+    });
+  }
+
 }
 #endif
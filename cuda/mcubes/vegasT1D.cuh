@@ -78,12 +78,14 @@ namespace mcubes1D {
     return val;
   }
 
+  // decodes the 64-bit cube index ms into its 1-based per-axis intervals
   __inline__ __device__ void
-  get_indx(int ms, uint32_t* da, int ND, int NINTV)
+  get_indx(size_t ms, size_t* da, int ND, size_t NINTV)
   {
-    int dp[/*Internal_Vegas_Params::get_MXDIM()*/ 21];
-    int j, t0, t1;
-    int m = ms;
+    size_t dp[/*Internal_Vegas_Params::get_MXDIM()*/ 21];
+    size_t t0, t1;
+    int j;
+    size_t m = ms;
     dp[0] = 1;
     dp[1] = NINTV;
 
@@ -105,7 +107,7 @@ namespace mcubes1D {
             typename GeneratorType = Curand_generator>
   __global__ void
   vegas_kernel(IntegT* d_integrand,
-               int ng,
+               size_t ng,
                int npg,
                double xjac,
                double dxg,
@@ -121,7 +123,7 @@ namespace mcubes1D {
                double sci,
                double ing,
                int chunkSize,
-               uint32_t totalNumThreads,
+               size_t totalNumThreads,
                int LastChunk,
                unsigned int seed_init,
                double* randoms = nullptr,
@@ -132,11 +134,11 @@ namespace mcubes1D {
     constexpr int mxdim_p1 = Internal_Vegas_Params::get_MXDIM_p1();
     constexpr int ndmx = Internal_Vegas_Params::get_NDMX();
 
-    uint32_t m = blockIdx.x * blockDim.x + threadIdx.x;
+    const size_t m = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
     int tx = threadIdx.x;
 
     double fb, f2b /*, wgt, xn, xo, rc, f, f2*/;
-    uint32_t kg[mxdim_p1];
+    size_t kg[mxdim_p1];
     int ia[mxdim_p1];
     double x[mxdim_p1];
     int k, j;
@@ -158,7 +160,7 @@ namespace mcubes1D {
         if constexpr (mcubes::TypeChecker<GeneratorType, Custom_generator>::
                         is_custom_generator()) {
           // size_t cube_id_offset = m*chunkSize;
-          uint32_t cube_id = cube_id_offset + t;
+          size_t cube_id = cube_id_offset + t;
           rand_num_generator.SetSeed(cube_id);
         }
 
@@ -171,7 +173,7 @@ namespace mcubes1D {
             if constexpr (DEBUG_MCUBES) {
               if (randoms != nullptr) {
                 // size_t cube_id_offset = m*chunkSize;
-                uint32_t cube_id = cube_id_offset + t;
+                size_t cube_id = cube_id_offset + t;
                 size_t nums_per_cube = npg * ndim;
                 size_t nums_per_sample = ndim;
                 size_t index =
@@ -205,7 +207,7 @@ namespace mcubes1D {
           if constexpr (DEBUG_MCUBES) {
             if (funcevals != nullptr) {
               // size_t cube_id_offset = m*chunkSize;
-              uint32_t cube_id = cube_id_offset + t;
+              size_t cube_id = cube_id_offset + t;
               size_t nums_evals_per_cube = npg;
               size_t index = cube_id * nums_evals_per_cube + (k - 1);
               funcevals[index] = f;
@@ -253,7 +255,7 @@ namespace mcubes1D {
             typename GeneratorType = Curand_generator>
   __global__ void
   vegas_kernelF(IntegT* d_integrand,
-                int ng,
+                size_t ng,
                 int npg,
                 double xjac,
                 double dxg,
@@ -269,7 +271,7 @@ namespace mcubes1D {
                 double sci,
                 double ing,
                 int chunkSize,
-                uint32_t totalNumThreads,
+                size_t totalNumThreads,
                 int LastChunk,
                 unsigned int seed_init)
   {
@@ -278,11 +280,11 @@ namespace mcubes1D {
     constexpr int ndmx = Internal_Vegas_Params::get_NDMX();
     constexpr int mxdim_p1 = Internal_Vegas_Params::get_MXDIM_p1();
 
-    uint32_t m = blockIdx.x * blockDim.x + threadIdx.x;
+    const size_t m = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
     int tx = threadIdx.x;
 
     double fb, f2b, wgt, xn, xo, rc, f, f2, ran00;
-    uint32_t kg[mxdim_p1];
+    size_t kg[mxdim_p1];
     int iaj;
     double x[mxdim_p1];
     int k, j;
@@ -407,7 +409,8 @@ namespace mcubes1D {
     constexpr int ndmx_p1 = Internal_Vegas_Params::get_NDMX_p1();
 
     double regn[2 * mxdim_p1];
-    int i, it, j /*, k*/, nd, ndo, ng, npg /*, ncubes*/;
+    int i, it, j /*, k*/, nd, ndo, npg /*, ncubes*/;
+    size_t ng;
     double k, ncubes;
     double calls, dv2g, dxg, rc, ti, tsi, wgt, xjac, xn, xnd, xo;
 
@@ -439,7 +442,7 @@ namespace mcubes1D {
     si = swgt = schi = 0.0;
     nd = ndmx;
     ng = 1;
-    ng = (int)pow(ncall / 2.0 + 0.25, 1.0 / ndim);
+    ng = (size_t)pow(ncall / 2.0 + 0.25, 1.0 / ndim);
     for (k = 1, i = 1; i < ndim; i++)
       k *= ng;
 
@@ -504,8 +507,8 @@ namespace mcubes1D {
 
     int chunkSize = GetChunkSize(ncall);
 
-    uint32_t totalNumThreads = (uint32_t)((ncubes) / chunkSize);
-    uint32_t totalCubes = totalNumThreads * chunkSize;
+    size_t totalNumThreads = (size_t)((ncubes) / chunkSize);
+    size_t totalCubes = totalNumThreads * chunkSize;
     int extra = ncubes - totalCubes;
     int LastChunk = extra + chunkSize;
     uint32_t nBlocks =
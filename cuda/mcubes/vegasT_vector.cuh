@@ -0,0 +1,375 @@
+#ifndef VEGAS_VEGAS_T_VECTOR_CUH
+#define VEGAS_VEGAS_T_VECTOR_CUH
+
+// VEGAS for integrands returning gpu::cudaArray<double, ncomp>. Every sample
+// is shared by all components, each of which gets its own weighted average
+// and chi_sq. The grid is adapted to the weighted norm sum_c w_c f_c^2 of the
+// components; a unit weight vector adapts it to a single component.
+
+#include "cuda/mcubes/vegasT.cuh"
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace cuda_mcubes {
+
+  template <size_t ncomp>
+  std::array<double, ncomp>
+  adapt_to_component(size_t comp)
+  {
+    if (comp >= ncomp)
+      throw std::out_of_range("adapt_to_component: component " +
+                              std::to_string(comp) + " of " +
+                              std::to_string(ncomp));
+    std::array<double, ncomp> weights{};
+    weights[comp] = 1.;
+    return weights;
+  }
+
+  template <size_t ncomp>
+  std::array<double, ncomp>
+  adapt_to_all_components()
+  {
+    std::array<double, ncomp> weights;
+    weights.fill(1.);
+    return weights;
+  }
+
+  // result_dev holds the sums of f and of the per-cube variance of each
+  // component, interleaved; d is only filled when adjust is set
+  template <typename IntegT,
+            int ndim,
+            int ncomp,
+            typename GeneratorType = Curand_generator>
+  __global__ void
+  vegas_kernel_v(IntegT* d_integrand,
+                 int ng,
+                 int npg,
+                 double xjac,
+                 double dxg,
+                 double* result_dev,
+                 double xnd,
+                 double* xi,
+                 double* d,
+                 double* dx,
+                 double* regn,
+                 gpu::cudaArray<double, ncomp> weights,
+                 int chunkSize,
+                 size_t totalNumThreads,
+                 int LastChunk,
+                 unsigned int seed_init,
+                 bool adjust)
+  {
+    constexpr int mxdim_p1 = Internal_Vegas_Params::get_MXDIM_p1();
+    const size_t m = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+    uint32_t kg[mxdim_p1];
+    int ia[mxdim_p1];
+    double x[mxdim_p1];
+    double wgt;
+    double fbg[ncomp], f2bg[ncomp];
+    for (int comp = 0; comp < ncomp; ++comp)
+      fbg[comp] = f2bg[comp] = 0.;
+
+    if (m < totalNumThreads) {
+      size_t cube_id_offset = m * chunkSize;
+      if (m == totalNumThreads - 1)
+        chunkSize = LastChunk;
+
+      Random_num_generator<GeneratorType> rand_num_generator(seed_init);
+      get_indx(cube_id_offset, &kg[1], ndim, ng);
+
+      for (int t = 0; t < chunkSize; t++) {
+        double fb[ncomp], f2b[ncomp];
+        for (int comp = 0; comp < ncomp; ++comp)
+          fb[comp] = f2b[comp] = 0.;
+        size_t cube_id = cube_id_offset + t;
+
+        if constexpr (mcubes::TypeChecker<GeneratorType, Custom_generator>::
+                        is_custom_generator()) {
+          rand_num_generator.SetSeed(cube_id);
+        }
+
+        for (int k = 1; k <= npg; k++) {
+          wgt = xjac;
+          Setup_Integrand_Eval<ndim, false, GeneratorType>(&rand_num_generator,
+                                                           xnd,
+                                                           dxg,
+                                                           xi,
+                                                           regn,
+                                                           dx,
+                                                           kg,
+                                                           ia,
+                                                           x,
+                                                           wgt,
+                                                           npg,
+                                                           k,
+                                                           cube_id,
+                                                           0);
+
+          gpu::cudaArray<double, ndim> xx;
+          for (int i = 0; i < ndim; i++)
+            xx[i] = x[i + 1];
+
+          const gpu::cudaArray<double, ncomp> vals =
+            gpu::apply(*d_integrand, xx);
+          double norm = 0.;
+          for (int comp = 0; comp < ncomp; ++comp) {
+            const double f = wgt * vals[comp];
+            fb[comp] += f;
+            f2b[comp] += f * f;
+            norm += weights[comp] * f * f;
+          }
+
+          if (adjust) {
+            for (int j = 1; j <= ndim; j++)
+              atomicAdd(&d[ia[j] * mxdim_p1 + j], norm);
+          }
+        }
+
+        for (int comp = 0; comp < ncomp; ++comp) {
+          double var = sqrt(f2b[comp] * npg);
+          var = (var - fb[comp]) * (var + fb[comp]);
+          if (var <= 0.0)
+            var = TINY;
+          fbg[comp] += fb[comp];
+          f2bg[comp] += var;
+        }
+
+        for (int k = ndim; k >= 1; k--) {
+          kg[k] %= ng;
+          if (++kg[k] != 1)
+            break;
+        }
+      }
+    }
+
+    for (int comp = 0; comp < ncomp; ++comp) {
+      fbg[comp] = blockReduceSum(fbg[comp]);
+      f2bg[comp] = blockReduceSum(f2bg[comp]);
+    }
+
+    if (threadIdx.x == 0) {
+      for (int comp = 0; comp < ncomp; ++comp) {
+        atomicAdd(&result_dev[2 * comp], fbg[comp]);
+        atomicAdd(&result_dev[2 * comp + 1], f2bg[comp]);
+      }
+    }
+  }
+
+  template <typename IntegT,
+            int ndim,
+            int ncomp,
+            typename GeneratorType = typename ::Curand_generator>
+  void
+  vegas_v(IntegT const& integrand,
+          double epsrel,
+          double epsabs,
+          double ncall,
+          std::array<double, ncomp> const& adapt_weights,
+          numint::integration_results<ncomp>& res,
+          int titer,
+          int itmax,
+          int skip,
+          quad::Volume<double, ndim> const* vol)
+  {
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    constexpr int ndmx = Internal_Vegas_Params::get_NDMX();
+    constexpr int ndmx_p1 = Internal_Vegas_Params::get_NDMX_p1();
+    constexpr int mxdim_p1 = Internal_Vegas_Params::get_MXDIM_p1();
+
+    IntegT* d_integrand = quad::cuda_copy_to_managed(integrand);
+    double regn[2 * mxdim_p1];
+    for (int j = 1; j <= ndim; j++) {
+      regn[j] = vol->lows[j - 1];
+      regn[j + ndim] = vol->highs[j - 1];
+    }
+
+    std::vector<double> d(ndmx_p1 * mxdim_p1), dt(mxdim_p1), dx(mxdim_p1),
+      r(ndmx_p1), xi(mxdim_p1 * ndmx_p1), xin(ndmx_p1);
+    std::array<double, ncomp> si{}, swgt{}, schi{};
+    double result[2 * ncomp];
+
+    const int nd = ndmx;
+    const size_t ng = (size_t)pow(ncall / 2.0 + 0.25, 1.0 / ndim);
+    double ncubes = 1.;
+    for (int i = 1; i <= ndim; i++)
+      ncubes *= ng;
+    const int npg = IMAX(ncall / ncubes, 2);
+    const double calls = (double)npg * ncubes;
+    double dxg = 1.0 / ng;
+    double dv2g = 1.;
+    for (int i = 1; i <= ndim; i++)
+      dv2g *= dxg;
+    dv2g = (calls * dv2g * calls * dv2g) / npg / npg / (npg - 1.0);
+    const double xnd = nd;
+    dxg *= xnd;
+    double xjac = 1.0 / calls;
+    for (int j = 1; j <= ndim; j++) {
+      dx[j] = regn[j + ndim] - regn[j];
+      xjac *= dx[j];
+    }
+
+    for (int j = 1; j <= ndim; j++)
+      xi[j * ndmx_p1 + 1] = 1.0;
+    for (int i = 1; i <= nd; i++)
+      r[i] = 1.0;
+    for (int j = 1; j <= ndim; j++)
+      rebin(1 / xnd, nd, r.data(), xin.data(), &xi[j * ndmx_p1]);
+
+    gpu::cudaArray<double, ncomp> weights;
+    for (int comp = 0; comp < ncomp; ++comp)
+      weights[comp] = adapt_weights[comp];
+
+    double* result_dev = quad::cuda_malloc<double>(2 * ncomp);
+    double* d_dev = quad::cuda_malloc<double>(ndmx_p1 * mxdim_p1);
+    double* dx_dev = quad::cuda_malloc<double>(mxdim_p1);
+    double* xi_dev = quad::cuda_malloc<double>(mxdim_p1 * ndmx_p1);
+    double* regn_dev = quad::cuda_malloc<double>(2 * ndim + 1);
+    quad::cuda_memcpy_to_device<double>(dx_dev, dx.data(), mxdim_p1);
+    quad::cuda_memcpy_to_device<double>(regn_dev, regn, 2 * ndim + 1);
+
+    int chunkSize = GetChunkSize(ncall);
+    size_t totalNumThreads = (size_t)(ncubes / chunkSize);
+    size_t totalCubes = totalNumThreads * chunkSize;
+    int extra = ncubes - totalCubes;
+    int LastChunk = extra + chunkSize;
+    Kernel_Params params(ncall, chunkSize, ndim);
+
+    res.status = 1;
+    for (int it = 1; it <= titer && res.status == 1; res.iters++, it++) {
+      const bool adjust = it <= itmax;
+      quad::cuda_memcpy_to_device<double>(
+        xi_dev, xi.data(), mxdim_p1 * ndmx_p1);
+      cudaMemset(d_dev, 0, sizeof(double) * ndmx_p1 * mxdim_p1);
+      cudaMemset(result_dev, 0, sizeof(double) * 2 * ncomp);
+
+      MilliSeconds time_diff = std::chrono::high_resolution_clock::now() - t0;
+      unsigned int seed = static_cast<unsigned int>(time_diff.count()) +
+                          static_cast<unsigned int>(it);
+      vegas_kernel_v<IntegT, ndim, ncomp, GeneratorType>
+        <<<params.nBlocks, params.nThreads>>>(d_integrand,
+                                              ng,
+                                              npg,
+                                              xjac,
+                                              dxg,
+                                              result_dev,
+                                              xnd,
+                                              xi_dev,
+                                              d_dev,
+                                              dx_dev,
+                                              regn_dev,
+                                              weights,
+                                              chunkSize,
+                                              totalNumThreads,
+                                              LastChunk,
+                                              seed + it,
+                                              adjust);
+      cudaDeviceSynchronize();
+      cudaCheckError();
+      quad::cuda_memcpy_to_host<double>(result, result_dev, 2 * ncomp);
+
+      if (it > skip) {
+        int status = 0;
+        for (int comp = 0; comp < ncomp; ++comp) {
+          const double ti = result[2 * comp];
+          const double tsi = result[2 * comp + 1] * dv2g;
+          const double wgt = 1.0 / tsi;
+          si[comp] += wgt * ti;
+          schi[comp] += wgt * ti * ti;
+          swgt[comp] += wgt;
+          res.estimate[comp] = si[comp] / swgt[comp];
+          res.chi_sq[comp] = (schi[comp] - si[comp] * res.estimate[comp]) /
+                             (static_cast<double>(it) - 0.9999);
+          if (res.chi_sq[comp] < 0.0)
+            res.chi_sq[comp] = 0.0;
+          res.errorest[comp] = sqrt(1.0 / swgt[comp]);
+          status |= GetStatus(
+            res.estimate[comp], res.errorest[comp], it, epsrel, epsabs);
+        }
+        res.status = status;
+      }
+
+      if (!adjust)
+        continue;
+
+      quad::cuda_memcpy_to_host<double>(d.data(), d_dev, ndmx_p1 * mxdim_p1);
+      for (int j = 1; j <= ndim; j++) {
+        double xo = d[1 * mxdim_p1 + j];
+        double xn = d[2 * mxdim_p1 + j];
+        d[1 * mxdim_p1 + j] = (xo + xn) / 2.0;
+        dt[j] = d[1 * mxdim_p1 + j];
+        for (int i = 2; i < nd; i++) {
+          const double rc = xo + xn;
+          xo = xn;
+          xn = d[(i + 1) * mxdim_p1 + j];
+          d[i * mxdim_p1 + j] = (rc + xn) / 3.0;
+          dt[j] += d[i * mxdim_p1 + j];
+        }
+        d[nd * mxdim_p1 + j] = (xo + xn) / 2.0;
+        dt[j] += d[nd * mxdim_p1 + j];
+      }
+
+      for (int j = 1; j <= ndim; j++) {
+        if (dt[j] > 0.0) {
+          double rc = 0.0;
+          for (int i = 1; i <= nd; i++) {
+            // a bin nothing was sampled in would make log(d) infinite
+            if (d[i * mxdim_p1 + j] < TINY)
+              d[i * mxdim_p1 + j] = TINY;
+            r[i] = pow((1.0 - d[i * mxdim_p1 + j] / dt[j]) /
+                         (log(dt[j]) - log(d[i * mxdim_p1 + j])),
+                       Internal_Vegas_Params::get_ALPH());
+            rc += r[i];
+          }
+          rebin(rc / xnd, nd, r.data(), xin.data(), &xi[j * ndmx_p1]);
+        }
+      }
+    }
+
+    res.neval = static_cast<size_t>(calls) * res.iters;
+    d_integrand->~IntegT();
+    cudaFree(d_integrand);
+    cudaFree(result_dev);
+    cudaFree(d_dev);
+    cudaFree(dx_dev);
+    cudaFree(xi_dev);
+    cudaFree(regn_dev);
+  }
+
+  // integrates all ncomp components of ig with one set of samples; the grid
+  // follows adapt_weights, see adapt_to_component
+  template <typename IntegT,
+            int NDIM,
+            int NCOMP,
+            typename GeneratorType = typename ::Curand_generator>
+  numint::integration_results<NCOMP>
+  integrate_v(IntegT const& ig,
+              double epsrel,
+              double epsabs,
+              double ncall,
+              quad::Volume<double, NDIM> const* volume,
+              int totalIters = 15,
+              int adjustIters = 15,
+              int skipIters = 5,
+              std::array<double, NCOMP> const& adapt_weights =
+                adapt_to_all_components<NCOMP>())
+  {
+    numint::integration_results<NCOMP> result;
+    result.iters = 0;
+    vegas_v<IntegT, NDIM, NCOMP, GeneratorType>(ig,
+                                                epsrel,
+                                                epsabs,
+                                                ncall,
+                                                adapt_weights,
+                                                result,
+                                                totalIters,
+                                                adjustIters,
+                                                skipIters,
+                                                volume);
+    return result;
+  }
+}
+
+#endif
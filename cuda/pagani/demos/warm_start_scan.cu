@@ -0,0 +1,86 @@
+#include <iostream>
+#include <string>
+#include "cuda/pagani/demos/new_time_and_call.cuh"
+#include "cuda/pagani/quad/GPUquad/Partition_checkpoint.cuh"
+#include "common/cuda/integrands.cuh"
+
+// Parameter scan over the location of a gaussian peak. Every scan point is
+// integrated twice: once from the uniform split and once starting from the
+// partition that the previous scan point saved to file.
+template <typename F, int ndim, bool use_custom = false, int debug = 0>
+void
+scan_time_and_call(std::string id,
+                   double epsrel,
+                   double sharpness,
+                   const std::vector<double>& peak_locs,
+                   const std::string& partition_file,
+                   std::ostream& outfile,
+                   quad::Volume<double, ndim>& vol)
+{
+  using MilliSeconds =
+    std::chrono::duration<double, std::chrono::milliseconds::period>;
+  double constexpr epsabs = 1.0e-40;
+  bool relerr_classification = true;
+  Workspace<double, ndim, debug, use_custom> workspace;
+
+  for (size_t i = 0; i < peak_locs.size(); i++) {
+    F integrand;
+    integrand.peak_loc = peak_locs[i];
+    integrand.sharpness = sharpness;
+    integrand.set_true_value();
+
+    for (bool warm : {false, true}) {
+      if (warm && i == 0)
+        continue;
+
+      auto const t0 = std::chrono::high_resolution_clock::now();
+      Partition_checkpoint<double, ndim> checkpoint;
+      if (warm)
+        checkpoint.load(partition_file);
+      const size_t skipped_iters = checkpoint.iterations;
+
+      numint::integration_result result =
+        workspace.template integrate<F>(
+          integrand, checkpoint, epsrel, epsabs, vol, relerr_classification);
+
+      if (!warm)
+        checkpoint.save(partition_file);
+      MilliSeconds dt = std::chrono::high_resolution_clock::now() - t0;
+
+      outfile.precision(17);
+      outfile << id << "," << ndim << "," << (warm ? "warm" : "cold") << ","
+              << integrand.peak_loc << "," << integrand.sharpness << ","
+              << std::fixed << std::scientific << integrand.true_value << ","
+              << epsrel << "," << epsabs << "," << result.estimate << ","
+              << result.errorest << "," << result.nregions << ","
+              << skipped_iters << "," << result.iters << "," << result.status
+              << "," << dt.count() << std::endl;
+    }
+  }
+}
+
+int
+main()
+{
+  constexpr int ndim = 6;
+  std::vector<double> epsrels = {1.e-3, 1.e-4, 1.e-5, 1.e-6};
+  std::vector<double> peak_locs = {
+    .45, .46, .47, .48, .49, .50, .51, .52, .53, .54, .55};
+  quad::Volume<double, ndim> vol(0., 1.);
+
+  std::cout << "id, ndim, start, peak_loc, sharpness, true_value, epsrel, "
+               "epsabs, estimate, errorest, nregions, skipped_iters, "
+               "completed_iters, status, time"
+            << std::endl;
+
+  for (double epsrel : epsrels) {
+    scan_time_and_call<F_4_6D_alt, ndim>("f_4_alt",
+                                         epsrel,
+                                         20.,
+                                         peak_locs,
+                                         "pagani_scan_partition.bin",
+                                         std::cout,
+                                         vol);
+  }
+  return 0;
+}
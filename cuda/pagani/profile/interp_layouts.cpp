@@ -0,0 +1,182 @@
+#include "common/interp_layout.hh"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Host-thread benchmark of the storage layouts of common/interp_layout.hh,
+// on tables the size of the largest ones Interp2D and Interp3D accept.
+// Lookups come either in clusters, the way the cubature points of a small
+// region or the samples of a VEGAS hypercube fall into a few neighbouring
+// cells, or scattered over the whole table. Every layout sees the same
+// points; the checksum tells that they also return the same values.
+//
+//   ./profile_interp_layouts [threads] [lookups per thread]
+
+namespace {
+  using MilliSeconds =
+    std::chrono::duration<double, std::chrono::milliseconds::period>;
+
+  constexpr int cluster_size = 64;
+  constexpr double cluster_cells = 4.;
+
+  struct Random {
+    uint64_t state;
+
+    double
+    operator()()
+    {
+      uint64_t x = (state += 0x9e3779b97f4a7c15ull);
+      x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+      x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+      return ((x ^ (x >> 31)) >> 11) * 0x1p-53;
+    }
+  };
+
+  template <int ndim>
+  struct Table {
+    size_t n[ndim];
+    std::vector<double> axes[ndim];
+    std::vector<double> values;
+  };
+
+  // a smooth function on slightly uneven knots
+  template <int ndim>
+  Table<ndim>
+  make_table(size_t points)
+  {
+    Table<ndim> table;
+    size_t total = 1;
+    for (int d = 0; d < ndim; ++d) {
+      table.n[d] = points;
+      total *= points;
+      for (size_t i = 0; i < points; ++i)
+        table.axes[d].push_back(i + .25 * std::sin(.1 * i));
+    }
+    table.values.resize(total);
+    for (size_t k = 0; k < total; ++k) {
+      double value = 0.;
+      size_t rest = k;
+      for (int d = 0; d < ndim; ++d) {
+        value += std::cos(.01 * (d + 1) * table.axes[d][rest % points]);
+        rest /= points;
+      }
+      table.values[k] = value;
+    }
+    return table;
+  }
+
+  template <typename Layout, int ndim>
+  double
+  lookup(Table<ndim> const& table, const double* stored, const double* x)
+  {
+    size_t cell[ndim];
+    double lo[ndim], hi[ndim];
+    for (int d = 0; d < ndim; ++d) {
+      std::vector<double> const& axis = table.axes[d];
+      const size_t i =
+        std::upper_bound(axis.begin(), axis.end() - 1, x[d]) - axis.begin();
+      cell[d] = std::max<size_t>(i, 1) - 1;
+      lo[d] = axis[cell[d]];
+      hi[d] = axis[cell[d] + 1];
+    }
+    double q[1 << ndim];
+    Layout::template corners<ndim>(stored, table.n, cell, q);
+    if constexpr (ndim == 2)
+      return numint::bilinear(q, x[0], lo[0], hi[0], x[1], lo[1], hi[1]);
+    else
+      return numint::trilinear(q,
+                               (x[0] - lo[0]) / (hi[0] - lo[0]),
+                               (x[1] - lo[1]) / (hi[1] - lo[1]),
+                               (x[2] - lo[2]) / (hi[2] - lo[2]));
+  }
+
+  template <typename Layout, int ndim>
+  void
+  run(const char* name,
+      Table<ndim> const& table,
+      bool clustered,
+      size_t num_threads,
+      size_t lookups)
+  {
+    const std::vector<double> stored =
+      numint::lay_out<Layout, ndim>(table.values.data(), table.n);
+    std::vector<double> sums(num_threads, 0.);
+
+    auto work = [&](size_t t) {
+      Random random{t + 1};
+      double x[ndim], center[ndim] = {};
+      double sum = 0.;
+      for (size_t k = 0; k < lookups; ++k) {
+        const bool new_cluster = !clustered || k % cluster_size == 0;
+        for (int d = 0; d < ndim; ++d) {
+          const double low = table.axes[d].front();
+          const double high = table.axes[d].back();
+          if (new_cluster)
+            center[d] = low + (high - low) * random();
+          x[d] = clustered ? center[d] + cluster_cells * (random() - .5) :
+                             center[d];
+          x[d] = std::min(std::max(x[d], low), high);
+        }
+        sum += lookup<Layout, ndim>(table, stored.data(), x);
+      }
+      sums[t] = sum;
+    };
+
+    auto const t0 = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < num_threads; ++t)
+      threads.emplace_back(work, t);
+    work(0);
+    for (std::thread& thread : threads)
+      thread.join();
+    MilliSeconds const dt = std::chrono::high_resolution_clock::now() - t0;
+
+    double checksum = 0.;
+    for (double sum : sums)
+      checksum += sum;
+    std::cout << ndim << "D, " << name << ", "
+              << (clustered ? "clustered" : "scattered") << ", "
+              << stored.size() * sizeof(double) / (1 << 20) << ", "
+              << 1.e6 * dt.count() / (lookups * num_threads) << ", "
+              << checksum << "\n";
+  }
+
+  template <int ndim>
+  void
+  run_all(Table<ndim> const& table, size_t num_threads, size_t lookups)
+  {
+    for (bool clustered : {true, false}) {
+      run<numint::row_major_layout, ndim>(
+        "row_major", table, clustered, num_threads, lookups);
+      run<numint::tiled_layout<>, ndim>(
+        "tiled<3>", table, clustered, num_threads, lookups);
+      run<numint::morton_layout<>, ndim>(
+        "morton<4>", table, clustered, num_threads, lookups);
+      run<numint::packed_cell_layout, ndim>(
+        "packed_cell", table, clustered, num_threads, lookups);
+    }
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  const size_t num_threads =
+    argc > 1 ? std::atol(argv[1]) :
+               std::max(1u, std::thread::hardware_concurrency());
+  const size_t lookups = argc > 2 ? std::atol(argv[2]) : 1 << 22;
+
+  std::cout << std::setprecision(12);
+  std::cout << "ndim, layout, pattern, table (MiB), wall ns per lookup, "
+               "checksum\n";
+  run_all(make_table<2>(1000), num_threads, lookups);
+  run_all(make_table<3>(100), num_threads, lookups);
+  return 0;
+}
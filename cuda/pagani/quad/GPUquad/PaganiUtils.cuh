@@ -20,6 +20,7 @@
 #include "cuda/pagani/quad/GPUquad/Sub_region_splitter.cuh"
 // #include "cuda/pagani/quad/GPUquad/heuristic_classifier.cuh"
 #include "common/cuda/custom_functions.cuh"
+#include "common/cuda/nonfinite.cuh"
 #include "cuda/pagani/quad/GPUquad/Func_Eval.cuh"
 #include <stdlib.h>
 #include <fstream>
@@ -45,7 +46,6 @@ public:
   using Reg_estimates = Region_estimates<T, ndim>;
   using Sub_regs = Sub_regions<T, ndim>;
   using Regs_characteristics = Region_characteristics<ndim>;
-  Recorder<true> rfevals;
   Recorder<true> rregions;
   Recorder<true> rgenerators;
 
@@ -53,31 +53,10 @@ public:
   {
 
     if constexpr (debug > 0) {
-      rfevals.outfile.open("cuda_fevals.csv");
       rgenerators.outfile.open("cuda_generators.csv");
       rregions.outfile.open("cuda_regions.csv");
     }
 
-    auto print_header = [=]() {
-      rfevals.outfile << "reg, fid,";
-      for (size_t dim = 0; dim < ndim; ++dim)
-        rfevals.outfile << "dim" + std::to_string(dim) << +"low"
-                        << ","
-                        << "dim" + std::to_string(dim) + "high,";
-
-      for (size_t dim = 0; dim < ndim; ++dim)
-        rfevals.outfile << "gdim" + std::to_string(dim) << +"low"
-                        << ","
-                        << "gdim" + std::to_string(dim) + "high"
-                        << ",";
-
-      for (size_t dim = 0; dim < ndim; ++dim)
-        rfevals.outfile << "dim" + std::to_string(dim) << ",";
-
-      rfevals.outfile << std::scientific << "feval, estimate, errorest"
-                      << std::endl;
-    };
-    print_header();
     constexpr size_t fEvalPerRegion = pagani::CuhreFuncEvalsPerRegion<ndim>();
     quad::Rule<T> rule;
     const int key = 0;
@@ -127,51 +106,6 @@ public:
     cudaFree(constMem.cGeneratorCount);
   }
 
-  void
-  Print_func_evals(quad::Func_Evals<ndim> fevals,
-                   T* ests,
-                   T* errs,
-                   const size_t num_regions)
-  {
-    if (num_regions >= 1024)
-      return;
-
-    auto print_reg = [=](const Bounds* sub_region) {
-      for (size_t dim = 0; dim < ndim; ++dim) {
-        rfevals.outfile << std::scientific << sub_region[dim].lower << ","
-                        << sub_region[dim].upper << ",";
-      }
-    };
-
-    auto print_global_bounds = [=](const GlobalBounds* sub_region) {
-      for (size_t dim = 0; dim < ndim; ++dim) {
-        rfevals.outfile << std::scientific << sub_region[dim].unScaledLower
-                        << "," << sub_region[dim].unScaledUpper << ",";
-      }
-    };
-
-    auto print_feval_point = [=](T* x) {
-      for (size_t dim = 0; dim < ndim; ++dim) {
-        rfevals.outfile << std::scientific << x[dim] << ",";
-      }
-    };
-
-    for (size_t reg = 0; reg < num_regions; ++reg) {
-      for (int feval = 0; feval < fevals.num_fevals; ++feval) {
-        size_t index = reg * fevals.num_fevals + feval;
-        rfevals.outfile << reg << "," << fevals[index].feval_index << ",";
-
-        print_reg(fevals[index].region_bounds);
-        print_global_bounds(fevals[index].global_bounds);
-        print_feval_point(fevals[index].point);
-
-        rfevals.outfile << std::scientific << fevals[index].feval << ",";
-        rfevals.outfile << std::scientific << ests[reg] << "," << errs[reg];
-        rfevals.outfile << std::endl;
-      }
-    }
-  }
-
   void
   Print_region_evals(int iter, T* ests, T* errs, const size_t num_regions)
   {
@@ -201,10 +135,7 @@ public:
   }
 
   void
-  print_verbose(int iter,
-                T* d_generators,
-                quad::Func_Evals<ndim>& dfevals,
-                const Reg_estimates& estimates)
+  print_verbose(int iter, T* d_generators, const Reg_estimates& estimates)
   {
 
     if constexpr (debug >= 2) {
@@ -222,18 +153,9 @@ public:
 
       Print_region_evals(iter, ests, errs, num_regions);
 
-      if constexpr (debug > 2) {
+      // the evaluations themselves go to the capture the Workspace opens
+      if constexpr (debug > 2)
         print_generators(d_generators);
-        constexpr size_t num_fevals = pagani::CuhreFuncEvalsPerRegion<ndim>();
-        quad::Func_Evals<ndim>* hfevals = new quad::Func_Evals<ndim>;
-        hfevals->fevals_list = new quad::Feval<ndim>[num_regions * num_fevals];
-        quad::cuda_memcpy_to_host<quad::Feval<ndim>>(
-          hfevals->fevals_list, dfevals.fevals_list, num_regions * num_fevals);
-        Print_func_evals(*hfevals, ests, errs, num_regions);
-        delete[] hfevals->fevals_list;
-        delete hfevals;
-        cudaFree(dfevals.fevals_list);
-      }
 
       delete[] ests;
       delete[] errs;
@@ -254,36 +176,38 @@ public:
     Region_estimates<T, ndim> subregion_estimates(num_regions);
 
     quad::set_device_array<T>(
-      region_characteristics.active_regions, num_regions, 1);
+      region_characteristics.active_regions, num_regions, 1, stream);
 
     size_t num_blocks = num_regions;
     constexpr size_t block_size = 64;
 
     T epsrel = 1.e-3, epsabs = 1.e-12;
     quad::INTEGRATE_GPU_PHASE1<IntegT, T, ndim, block_size>
-      <<<num_blocks, block_size>>>(d_integrand,
-                                   subregions.dLeftCoord,
-                                   subregions.dLength,
-                                   num_regions,
-                                   subregion_estimates.integral_estimates,
-                                   subregion_estimates.error_estimates,
-                                   region_characteristics.sub_dividing_dim,
-                                   epsrel,
-                                   epsabs,
-                                   constMem,
-                                   integ_space_lows,
-                                   integ_space_highs,
-                                   0,
-                                   generators);
-    cudaDeviceSynchronize();
+      <<<num_blocks, block_size, 0, stream>>>(
+        d_integrand,
+        subregions.dLeftCoord,
+        subregions.dLength,
+        num_regions,
+        subregion_estimates.integral_estimates,
+        subregion_estimates.error_estimates,
+        region_characteristics.sub_dividing_dim,
+        epsrel,
+        epsabs,
+        constMem,
+        integ_space_lows,
+        integ_space_highs,
+        0,
+        generators);
+    cudaStreamSynchronize(stream);
 
     numint::integration_result res;
     res.estimate = reduction<T, use_custom>(
-      subregion_estimates.integral_estimates, num_regions);
-    res.errorest = compute_error ?
-                     reduction<T, use_custom>(
-                       subregion_estimates.error_estimates, num_regions) :
-                     std::numeric_limits<T>::infinity();
+      subregion_estimates.integral_estimates, num_regions, stream);
+    res.errorest =
+      compute_error ?
+        reduction<T, use_custom>(
+          subregion_estimates.error_estimates, num_regions, stream) :
+        std::numeric_limits<T>::infinity();
 
     return res;
   }
@@ -296,49 +220,103 @@ public:
     const Sub_regs& subregions,
     const Reg_estimates& subregion_estimates,
     const Regs_characteristics& region_characteristics,
-    bool compute_error = false)
+    bool compute_error = false,
+    quad::Capture_log<T> capture = {})
   {
 
     size_t num_regions = subregions.size;
+    // never allocated, evaluations are recorded through capture
     quad::Func_Evals<ndim> dfevals;
-    if constexpr (debug >= 2) {
-      constexpr size_t num_fevals = pagani::CuhreFuncEvalsPerRegion<ndim>();
-      dfevals.fevals_list =
-        quad::cuda_malloc<quad::Feval<ndim>>(num_regions * num_fevals);
-    }
 
     quad::set_device_array<T>(
-      region_characteristics.active_regions, num_regions, 1.);
+      region_characteristics.active_regions, num_regions, 1., stream);
    
     size_t num_blocks = num_regions;
     constexpr size_t block_size = 64;
 
     T epsrel = 1.e-3, epsabs = 1.e-12;
     quad::INTEGRATE_GPU_PHASE1<IntegT, T, ndim, block_size, debug>
-      <<<num_blocks, block_size>>>(d_integrand,
-                                   subregions.dLeftCoord,
-                                   subregions.dLength,
-                                   num_regions,
-                                   subregion_estimates.integral_estimates,
-                                   subregion_estimates.error_estimates,
-                                   region_characteristics.sub_dividing_dim,
-                                   epsrel,
-                                   epsabs,
-                                   constMem,
-                                   integ_space_lows,
-                                   integ_space_highs,
-                                   generators,
-                                   dfevals);
-    cudaDeviceSynchronize();
-
-    print_verbose(it, generators, dfevals, subregion_estimates);
+      <<<num_blocks, block_size, 0, stream>>>(
+        d_integrand,
+        subregions.dLeftCoord,
+        subregions.dLength,
+        num_regions,
+        subregion_estimates.integral_estimates,
+        subregion_estimates.error_estimates,
+        region_characteristics.sub_dividing_dim,
+        epsrel,
+        epsabs,
+        constMem,
+        integ_space_lows,
+        integ_space_highs,
+        generators,
+        dfevals,
+        nonfinite.device_log(),
+        capture);
+    cudaStreamSynchronize(stream);
+
+    print_verbose(it, generators, subregion_estimates);
     numint::integration_result res;
     res.estimate = reduction<T, use_custom>(
-      subregion_estimates.integral_estimates, num_regions);
-    res.errorest = compute_error ?
-                     reduction<T, use_custom>(
-                       subregion_estimates.error_estimates, num_regions) :
-                     std::numeric_limits<T>::infinity();
+      subregion_estimates.integral_estimates, num_regions, stream);
+    res.errorest =
+      compute_error ?
+        reduction<T, use_custom>(
+          subregion_estimates.error_estimates, num_regions, stream) :
+        std::numeric_limits<T>::infinity();
+    return res;
+  }
+
+  // evaluates an integrand with ncomp components, writing the estimates of
+  // component comp to subregion_estimates[comp]
+  template <typename IntegT, size_t ncomp>
+  std::array<numint::integration_result, ncomp>
+  apply_cubature_integration_rules(
+    IntegT* d_integrand,
+    const Sub_regs& subregions,
+    std::array<Reg_estimates, ncomp>& subregion_estimates,
+    const Regs_characteristics& region_characteristics,
+    bool compute_error = false)
+  {
+    size_t num_regions = subregions.size;
+    quad::set_device_array<T>(
+      region_characteristics.active_regions, num_regions, 1., stream);
+
+    gpu::cudaArray<T*, ncomp> integrals;
+    gpu::cudaArray<T*, ncomp> errors;
+    for (size_t comp = 0; comp < ncomp; ++comp) {
+      integrals[comp] = subregion_estimates[comp].integral_estimates;
+      errors[comp] = subregion_estimates[comp].error_estimates;
+    }
+
+    size_t num_blocks = num_regions;
+    constexpr size_t block_size = 64;
+    quad::INTEGRATE_GPU_PHASE1_V<IntegT, T, ndim, ncomp, block_size>
+      <<<num_blocks, block_size, 0, stream>>>(
+        d_integrand,
+        subregions.dLeftCoord,
+        subregions.dLength,
+        num_regions,
+        integrals,
+        errors,
+        region_characteristics.sub_dividing_dim,
+        constMem,
+        integ_space_lows,
+        integ_space_highs,
+        generators);
+    cudaStreamSynchronize(stream);
+
+    std::array<numint::integration_result, ncomp> res;
+    for (size_t comp = 0; comp < ncomp; ++comp) {
+      res[comp].estimate = reduction<T, use_custom>(
+        subregion_estimates[comp].integral_estimates, num_regions, stream);
+      res[comp].errorest =
+        compute_error ?
+          reduction<T, use_custom>(subregion_estimates[comp].error_estimates,
+                                   num_regions,
+                                   stream) :
+          std::numeric_limits<T>::infinity();
+    }
     return res;
   }
 
@@ -363,24 +341,35 @@ public:
 
   T* integ_space_lows = nullptr;
   T* integ_space_highs = nullptr;
+
+  // NaN and infinite values met by apply_cubature_integration_rules since
+  // the last reset
+  quad::Nonfinite_monitor<T> nonfinite{static_cast<int>(ndim)};
+
+  // the rules are applied on this stream, set by the Workspace owning them
+  cudaStream_t stream = 0;
 };
 
 template <typename T, size_t ndim, bool use_custom = false>
 numint::integration_result
 compute_finished_estimates(const Region_estimates<T, ndim>& estimates,
                            const Region_characteristics<ndim>& classifiers,
-                           const numint::integration_result& iter)
+                           const numint::integration_result& iter,
+                           cudaStream_t stream = 0)
 {
   numint::integration_result finished;
   finished.estimate =
     iter.estimate -
-    dot_product<T, T, use_custom>(
-      classifiers.active_regions, estimates.integral_estimates, estimates.size);
+    dot_product<T, T, use_custom>(classifiers.active_regions,
+                                  estimates.integral_estimates,
+                                  estimates.size,
+                                  stream);
 
   finished.errorest =
     iter.errorest - dot_product<T, T, use_custom>(classifiers.active_regions,
                                                     estimates.error_estimates,
-                                                    estimates.size);
+                                                    estimates.size,
+                                                    stream);
   return finished;
 }
 
@@ -0,0 +1,221 @@
+#ifndef PARTITION_CHECKPOINT_CUH
+#define PARTITION_CHECKPOINT_CUH
+
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "common/cuda/cudaMemoryUtil.h"
+#include "cuda/pagani/quad/GPUquad/Sub_regions.cuh"
+#include "cuda/pagani/quad/GPUquad/Region_estimates.cuh"
+
+// Partition of the whole integration space, together with the two-level
+// parent estimates the next iteration expects. Workspace refreshes it while no
+// region has been finished yet; it can then be saved to a file and used to
+// warm-start the integration of a nearby integrand, e.g. the next point of a
+// parameter scan, skipping the early refinement iterations.
+template <typename T, size_t ndim>
+class Partition_checkpoint {
+public:
+  Partition_checkpoint() {}
+
+  Partition_checkpoint(const std::string& filename) { load(filename); }
+
+  Partition_checkpoint(const Partition_checkpoint<T, ndim>&) = delete;
+  Partition_checkpoint& operator=(const Partition_checkpoint<T, ndim>&) =
+    delete;
+
+  ~Partition_checkpoint() { release(); }
+
+  bool
+  empty() const
+  {
+    return size == 0;
+  }
+
+  // back to a default constructed checkpoint
+  void
+  clear()
+  {
+    release();
+    interval = default_interval;
+  }
+
+  // Workspace refreshes the partition at the first iteration and then every
+  // interval iterations only, each refresh copying the whole partition; the
+  // checkpoint can lag the last partition covering the space by up to
+  // interval - 1 iterations
+  void
+  set_interval(size_t iterations)
+  {
+    interval = iterations == 0 ? 1 : iterations;
+  }
+
+  bool
+  due(size_t iteration) const
+  {
+    return iteration % interval == 0;
+  }
+
+  // regions must be laid out as produced by Sub_region_splitter, with
+  // parent_ests holding the estimates of the regions they were split from
+  void
+  capture(const Sub_regions<T, ndim>& regions,
+          const Region_estimates<T, ndim>& parent_ests,
+          size_t iteration)
+  {
+    allocate(regions.size, parent_ests.size);
+    quad::cuda_memcpy_device_to_device<T>(
+      dLeftCoord, regions.dLeftCoord, size * ndim);
+    quad::cuda_memcpy_device_to_device<T>(
+      dLength, regions.dLength, size * ndim);
+    quad::cuda_memcpy_device_to_device<T>(
+      parent_integral_estimates, parent_ests.integral_estimates, num_parents);
+    quad::cuda_memcpy_device_to_device<T>(
+      parent_error_estimates, parent_ests.error_estimates, num_parents);
+    iterations = iteration;
+  }
+
+  void
+  restore(Sub_regions<T, ndim>& regions,
+          Region_estimates<T, ndim>& parent_ests) const
+  {
+    cudaFree(regions.dLeftCoord);
+    cudaFree(regions.dLength);
+    regions.device_init(size);
+    quad::cuda_memcpy_device_to_device<T>(
+      regions.dLeftCoord, dLeftCoord, size * ndim);
+    quad::cuda_memcpy_device_to_device<T>(
+      regions.dLength, dLength, size * ndim);
+
+    if (num_parents == 0) {
+      return;
+    }
+
+    parent_ests.reallocate(num_parents);
+    quad::cuda_memcpy_device_to_device<T>(
+      parent_ests.integral_estimates, parent_integral_estimates, num_parents);
+    quad::cuda_memcpy_device_to_device<T>(
+      parent_ests.error_estimates, parent_error_estimates, num_parents);
+  }
+
+  // binary layout: header (ndim, sizeof(T), size, num_parents, iterations)
+  // followed by left coordinates, lengths, parent integral and error estimates
+  void
+  save(const std::string& filename) const
+  {
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) {
+      throw std::runtime_error("cannot open " + filename + " for writing");
+    }
+
+    const uint64_t header[5] = {
+      ndim, sizeof(T), size, num_parents, iterations};
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    write_device_array(out, dLeftCoord, size * ndim);
+    write_device_array(out, dLength, size * ndim);
+    write_device_array(out, parent_integral_estimates, num_parents);
+    write_device_array(out, parent_error_estimates, num_parents);
+
+    if (!out) {
+      throw std::runtime_error("failed to write partition to " + filename);
+    }
+  }
+
+  void
+  load(const std::string& filename)
+  {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) {
+      throw std::runtime_error("cannot open " + filename);
+    }
+
+    uint64_t header[5];
+    in.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!in || header[0] != ndim || header[1] != sizeof(T)) {
+      throw std::runtime_error(filename + " does not hold a partition of "
+                                          "matching dimension and precision");
+    }
+
+    if (header[3] != 0 && 2 * header[3] != header[2]) {
+      throw std::runtime_error(filename +
+                               " holds inconsistent parent estimates");
+    }
+
+    allocate(header[2], header[3]);
+    read_device_array(in, dLeftCoord, size * ndim);
+    read_device_array(in, dLength, size * ndim);
+    read_device_array(in, parent_integral_estimates, num_parents);
+    read_device_array(in, parent_error_estimates, num_parents);
+    iterations = header[4];
+
+    if (!in) {
+      release();
+      throw std::runtime_error("failed to read partition from " + filename);
+    }
+  }
+
+  T* dLeftCoord = nullptr;
+  T* dLength = nullptr;
+  T* parent_integral_estimates = nullptr;
+  T* parent_error_estimates = nullptr;
+
+  size_t size = 0;
+  size_t num_parents = 0;
+  // iteration of the run that produced the partition
+  size_t iterations = 0;
+  size_t interval = default_interval;
+
+  static constexpr size_t default_interval = 4;
+
+private:
+  // frees the partition, keeping the settings
+  void
+  release()
+  {
+    cudaFree(dLeftCoord);
+    cudaFree(dLength);
+    cudaFree(parent_integral_estimates);
+    cudaFree(parent_error_estimates);
+    dLeftCoord = nullptr;
+    dLength = nullptr;
+    parent_integral_estimates = nullptr;
+    parent_error_estimates = nullptr;
+    size = 0;
+    num_parents = 0;
+    iterations = 0;
+  }
+
+  void
+  allocate(size_t num_regions, size_t num_parent_regions)
+  {
+    release();
+    size = num_regions;
+    num_parents = num_parent_regions;
+    dLeftCoord = quad::cuda_malloc<T>(size * ndim);
+    dLength = quad::cuda_malloc<T>(size * ndim);
+    if (num_parents > 0) {
+      parent_integral_estimates = quad::cuda_malloc<T>(num_parents);
+      parent_error_estimates = quad::cuda_malloc<T>(num_parents);
+    }
+  }
+
+  static void
+  write_device_array(std::ofstream& out, const T* src, size_t n)
+  {
+    std::vector<T> host(n);
+    quad::cuda_memcpy_to_host<T>(host.data(), src, n);
+    out.write(reinterpret_cast<const char*>(host.data()), sizeof(T) * n);
+  }
+
+  static void
+  read_device_array(std::ifstream& in, T* dest, size_t n)
+  {
+    std::vector<T> host(n);
+    in.read(reinterpret_cast<char*>(host.data()), sizeof(T) * n);
+    quad::cuda_memcpy_to_device<T>(dest, host.data(), n);
+  }
+};
+
+#endif
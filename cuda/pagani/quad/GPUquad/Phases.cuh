@@ -310,7 +310,9 @@ namespace quad {
                    T* lows,
                    T* highs,
                    T* generators,
-                   quad::Func_Evals<NDIM>& fevals)
+                   quad::Func_Evals<NDIM>& fevals,
+                   quad::Nonfinite_log<T> nonfinite = {},
+                   quad::Capture_log<T> capture = {})
   {
     const size_t index = blockIdx.x;
     // may not be worth pre-computing
@@ -358,7 +360,9 @@ namespace quad {
                                                         ranges,
                                                         &Jacobian,
                                                         generators,
-                                                        fevals);
+                                                        fevals,
+                                                        nonfinite,
+                                                        capture);
     __syncthreads();
   }
 
@@ -379,7 +383,9 @@ namespace quad {
     T* lows,
     T* highs,
     T* generators,
-    quad::Func_Evals<NDIM> fevals)
+    quad::Func_Evals<NDIM> fevals,
+    quad::Nonfinite_log<T> nonfinite = {},
+    quad::Capture_log<T> capture = {})
   {
     __shared__ Region<NDIM> sRegionPool[1];
     __shared__ GlobalBounds sBound[NDIM];
@@ -394,7 +400,9 @@ namespace quad {
                                                        lows,
                                                        highs,
                                                        generators,
-                                                       fevals);
+                                                       fevals,
+                                                       nonfinite,
+                                                       capture);
 
     if (threadIdx.x == 0) {
       subDividingDimension[blockIdx.x] = sRegionPool[0].result.bisectdim;
@@ -403,6 +411,82 @@ namespace quad {
     }
   }
 
+  // INTEGRATE_GPU_PHASE1 for integrands with NCOMP components, the estimates
+  // of component comp go to dRegionsIntegral[comp] and dRegionsError[comp]
+  template <typename IntegT, typename T, int NDIM, int NCOMP, int blockDim>
+  __global__ void
+  INTEGRATE_GPU_PHASE1_V(IntegT* d_integrand,
+                         T* dRegions,
+                         T* dRegionsLength,
+                         size_t numRegions,
+                         gpu::cudaArray<T*, NCOMP> dRegionsIntegral,
+                         gpu::cudaArray<T*, NCOMP> dRegionsError,
+                         int* subDividingDimension,
+                         Structures<T> constMem,
+                         T* lows,
+                         T* highs,
+                         T* generators)
+  {
+    __shared__ Region<NDIM> sRegionPool[1];
+    __shared__ GlobalBounds sBound[NDIM];
+    __shared__ T Jacobian;
+    __shared__ int maxDim;
+    __shared__ T vol;
+    __shared__ T ranges[NDIM];
+    __shared__ T avg[NCOMP];
+    __shared__ T err[NCOMP];
+    const size_t index = blockIdx.x;
+
+    if (threadIdx.x == 0) {
+      Jacobian = 1.;
+      vol = 1.;
+      T maxRange = 0;
+
+      #pragma unroll NDIM
+      for (int dim = 0; dim < NDIM; ++dim) {
+        T lower = dRegions[dim * numRegions + index];
+        sRegionPool[0].bounds[dim].lower = lower;
+        sRegionPool[0].bounds[dim].upper =
+          lower + dRegionsLength[dim * numRegions + index];
+        vol *=
+          sRegionPool[0].bounds[dim].upper - sRegionPool[0].bounds[dim].lower;
+
+        sBound[dim].unScaledLower = lows[dim];
+        sBound[dim].unScaledUpper = highs[dim];
+        ranges[dim] = sBound[dim].unScaledUpper - sBound[dim].unScaledLower;
+
+        T range = sRegionPool[0].bounds[dim].upper - lower;
+        Jacobian = Jacobian * ranges[dim];
+        if (range > maxRange) {
+          maxDim = dim;
+          maxRange = range;
+        }
+      }
+    }
+
+    __syncthreads();
+    SampleRegionBlock_v<IntegT, T, NDIM, NCOMP, blockDim>(d_integrand,
+                                                          constMem,
+                                                          sRegionPool,
+                                                          sBound,
+                                                          &vol,
+                                                          &maxDim,
+                                                          ranges,
+                                                          &Jacobian,
+                                                          generators,
+                                                          avg,
+                                                          err);
+    __syncthreads();
+
+    if (threadIdx.x == 0) {
+      subDividingDimension[index] = sRegionPool[0].result.bisectdim;
+      for (int comp = 0; comp < NCOMP; ++comp) {
+        dRegionsIntegral[comp][index] = avg[comp];
+        dRegionsError[comp][index] = err[comp];
+      }
+    }
+  }
+
   __device__ size_t
   GetSiblingIndex(size_t numRegions)
   {
@@ -7,6 +7,8 @@
 #include "common/cuda/cudaApply.cuh"
 #include "common/cuda/cudaArray.cuh"
 #include "common/cuda/cudaUtil.h"
+#include "common/cuda/capture.cuh"
+#include "common/cuda/nonfinite.cuh"
 #include "cuda/pagani/quad/GPUquad/Func_Eval.cuh"
 #include <cmath>
 #include <curand_kernel.h>
@@ -112,7 +114,9 @@ namespace quad {
                      T* jacobian,
                      T* generators,
                      T* sdata,
-                     quad::Func_Evals<NDIM>& fevals)
+                     quad::Func_Evals<NDIM>& fevals,
+                     quad::Nonfinite_log<T> nonfinite = {},
+                     quad::Capture_log<T> capture = {})
   {
 
     gpu::cudaArray<T, NDIM> x;
@@ -130,18 +134,28 @@ namespace quad {
                                              range[dim];
     }
 
-    const T fun = gpu::apply(*d_integrand, x) * (*jacobian);
+    T value = gpu::apply(*d_integrand, x);
+    if (capture.enabled() && capture.keeps(blockIdx.x, pIndex, value)) {
+      const int slot = capture.record_evaluation(blockIdx.x, pIndex, value);
+      for (int dim = 0; dim < NDIM; ++dim)
+        capture.store_x(slot, dim, x[dim]);
+    }
+    if (!isfinite(value) && nonfinite.enabled()) {
+      const int slot = nonfinite.record(value);
+      for (int dim = 0; dim < NDIM; ++dim) {
+        const T low = sBound[dim].unScaledLower;
+        nonfinite.store(slot,
+                        dim,
+                        x[dim],
+                        low + b[dim].lower * range[dim],
+                        low + b[dim].upper * range[dim]);
+      }
+      value = nonfinite.replacement(value);
+    }
+    const T fun = value * (*jacobian);
     sdata[threadIdx.x] = fun; // target for reduction
     const int gIndex = __ldg(&constMem.gpuGenPermGIndex[pIndex]);
 
-    if constexpr (debug >= 2) {
-      // assert(fevals != nullptr);
-      fevals[blockIdx.x * pagani::CuhreFuncEvalsPerRegion<NDIM>() + pIndex]
-        .store(x, sBound, b);
-      fevals[blockIdx.x * pagani::CuhreFuncEvalsPerRegion<NDIM>() + pIndex]
-        .store(gpu::apply(*d_integrand, x), pIndex);
-    }
-
     #pragma unroll 5
     for (int rul = 0; rul < NRULES; ++rul) {
       sum[rul] += fun * __ldg(&constMem.cRuleWt[gIndex * NRULES + rul]);
@@ -160,7 +174,9 @@ namespace quad {
                     T range[],
                     T* jacobian,
                     T* generators,
-                    quad::Func_Evals<NDIM>& fevals)
+                    quad::Func_Evals<NDIM>& fevals,
+                    quad::Nonfinite_log<T> nonfinite = {},
+                    quad::Capture_log<T> capture = {})
   {
     Region<NDIM>* const region = (Region<NDIM>*)&sRegionPool[0];
     __shared__ T sdata[blockdim];
@@ -186,7 +202,9 @@ namespace quad {
                                                  jacobian,
                                                  generators,
                                                  sdata,
-                                                 fevals);
+                                                 fevals,
+                                                 nonfinite,
+                                                 capture);
     }
 
     __syncthreads();
@@ -231,7 +249,9 @@ namespace quad {
                                                  jacobian,
                                                  generators,
                                                  sdata,
-                                                 fevals);
+                                                 fevals,
+                                                 nonfinite,
+                                                 capture);
     }
     //__syncthreads();
     // Balance permutations
@@ -248,7 +268,9 @@ namespace quad {
                                                  jacobian,
                                                  generators,
                                                  sdata,
-                                                 fevals);
+                                                 fevals,
+                                                 nonfinite,
+                                                 capture);
     }
 
     __syncthreads();
@@ -286,6 +308,193 @@ namespace quad {
                           errcoeff[0] * sum[2] <= sum[3]) ?
                            errcoeff[1] * sum[1] :
                            errcoeff[2] * max(max(sum[1], sum[2]), sum[3]));
+
+      // an excluded value left the rule sums non-finite: the region
+      // contributes nothing, and with a zero error it is classified as
+      // finished, so it is dropped instead of refined
+      if (nonfinite.enabled() &&
+          nonfinite.policy == numint::nonfinite_policy::exclude &&
+          !isfinite(sum[0])) {
+        r->avg = 0.;
+        r->err = 0.;
+      }
+    }
+  }
+
+  // evaluates an integrand returning ncomp components; every component is
+  // accumulated with all NRULES rules and sdata holds the values of each
+  // component for the fourth-difference test
+  template <typename IntegT, typename T, int NDIM, int NCOMP, int blockdim>
+  __device__ void
+  computePermutation_v(IntegT* d_integrand,
+                       int pIndex,
+                       Bounds* b,
+                       GlobalBounds sBound[],
+                       T sum[][NRULES],
+                       Structures<T>& constMem,
+                       T range[],
+                       T* jacobian,
+                       T* generators,
+                       T sdata[][blockdim])
+  {
+    gpu::cudaArray<T, NDIM> x;
+
+    #pragma unroll
+    for (int dim = 0; dim < NDIM; ++dim) {
+      const T generator = __ldg(
+        &generators[pagani::CuhreFuncEvalsPerRegion<NDIM>() * dim + pIndex]);
+      x[dim] = sBound[dim].unScaledLower + ((.5 + generator) * b[dim].lower +
+                                            (.5 - generator) * b[dim].upper) *
+                                             range[dim];
+    }
+
+    const gpu::cudaArray<T, NCOMP> vals = gpu::apply(*d_integrand, x);
+    const int gIndex = __ldg(&constMem.gpuGenPermGIndex[pIndex]);
+
+    #pragma unroll
+    for (int comp = 0; comp < NCOMP; ++comp) {
+      const T fun = vals[comp] * (*jacobian);
+      sdata[comp][threadIdx.x] = fun;
+
+      #pragma unroll 5
+      for (int rul = 0; rul < NRULES; ++rul) {
+        sum[comp][rul] += fun * __ldg(&constMem.cRuleWt[gIndex * NRULES + rul]);
+      }
+    }
+  }
+
+  // SampleRegionBlock for integrands with NCOMP components. The region is
+  // bisected along the dimension with the largest fourth difference summed
+  // over the components; the estimates of each component are left in
+  // avg[comp] and err[comp].
+  template <typename IntegT, typename T, int NDIM, int NCOMP, int blockdim>
+  __device__ void
+  SampleRegionBlock_v(IntegT* d_integrand,
+                      Structures<T>& constMem,
+                      Region<NDIM> sRegionPool[],
+                      GlobalBounds sBound[],
+                      T* vol,
+                      int* maxdim,
+                      T range[],
+                      T* jacobian,
+                      T* generators,
+                      T avg[],
+                      T err[])
+  {
+    Region<NDIM>* const region = (Region<NDIM>*)&sRegionPool[0];
+    __shared__ T sdata[NCOMP][blockdim];
+    int perm = 0;
+    constexpr int offset = 2 * NDIM;
+
+    T sum[NCOMP][NRULES];
+    Zap(sum);
+
+    int pIndex = perm * blockdim + threadIdx.x;
+    constexpr int FEVAL = pagani::CuhreFuncEvalsPerRegion<NDIM>();
+    if (pIndex < FEVAL) {
+      computePermutation_v<IntegT, T, NDIM, NCOMP, blockdim>(d_integrand,
+                                                             pIndex,
+                                                             region->bounds,
+                                                             sBound,
+                                                             sum,
+                                                             constMem,
+                                                             range,
+                                                             jacobian,
+                                                             generators,
+                                                             sdata);
+    }
+
+    __syncthreads();
+
+    if (threadIdx.x == 0) {
+      const T ratio =
+        Sq(__ldg(&constMem.gpuG[2 * NDIM]) / __ldg(&constMem.gpuG[1 * NDIM]));
+      T maxdiff = 0;
+      int bisectdim = *maxdim;
+      for (int dim = 0; dim < NDIM; ++dim) {
+        T fourthdiff = 0.;
+        for (int comp = 0; comp < NCOMP; ++comp) {
+          T* f1 = &sdata[comp][2 * dim];
+          T* fp = f1 + 1;
+          T* fm = fp + 1;
+          const T base = sdata[comp][0] * 2 * (1 - ratio);
+          fourthdiff +=
+            fabs(base + ratio * (fp[0] + fm[0]) - (fp[offset] + fm[offset]));
+        }
+
+        if (fourthdiff > maxdiff) {
+          maxdiff = fourthdiff;
+          bisectdim = dim;
+        }
+      }
+
+      region->result.bisectdim = bisectdim;
+    }
+    __syncthreads();
+
+    #pragma unroll 1
+    for (perm = 1; perm < FEVAL / blockdim; ++perm) {
+      int pIndex = perm * blockdim + threadIdx.x;
+      computePermutation_v<IntegT, T, NDIM, NCOMP, blockdim>(d_integrand,
+                                                             pIndex,
+                                                             region->bounds,
+                                                             sBound,
+                                                             sum,
+                                                             constMem,
+                                                             range,
+                                                             jacobian,
+                                                             generators,
+                                                             sdata);
+    }
+
+    pIndex = perm * blockdim + threadIdx.x;
+    if (pIndex < FEVAL) {
+      computePermutation_v<IntegT, T, NDIM, NCOMP, blockdim>(d_integrand,
+                                                             pIndex,
+                                                             region->bounds,
+                                                             sBound,
+                                                             sum,
+                                                             constMem,
+                                                             range,
+                                                             jacobian,
+                                                             generators,
+                                                             sdata);
+    }
+
+    __syncthreads();
+    for (int comp = 0; comp < NCOMP; ++comp) {
+      #pragma unroll 5
+      for (int i = 0; i < NRULES; ++i) {
+        sum[comp][i] = blockReduceSum(sum[comp][i]);
+      }
+    }
+
+    if (threadIdx.x == 0) {
+      for (int comp = 0; comp < NCOMP; ++comp) {
+        T* s = sum[comp];
+
+        #pragma unroll 3
+        for (int rul = 1; rul < NRULES - 1; ++rul) {
+          T maxerr = 0.;
+          constexpr int NSETS = 9;
+          #pragma unroll 9
+          for (int set = 0; set < NSETS; ++set) {
+            maxerr =
+              max(maxerr,
+                  fabs(s[rul + 1] +
+                       __ldg(&constMem.GPUScale[set * NRULES + rul]) * s[rul]) *
+                    __ldg(&constMem.GPUNorm[set * NRULES + rul]));
+          }
+          s[rul] = maxerr;
+        }
+
+        avg[comp] = (*vol) * s[0];
+        const T errcoeff[3] = {5., 1., 5.};
+        err[comp] = (*vol) * ((errcoeff[0] * s[1] <= s[2] &&
+                               errcoeff[0] * s[2] <= s[3]) ?
+                                errcoeff[1] * s[1] :
+                                errcoeff[2] * max(max(s[1], s[2]), s[3]));
+      }
     }
   }
 
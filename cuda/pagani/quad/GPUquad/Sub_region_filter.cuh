@@ -3,27 +3,22 @@
 
 #include "cuda/pagani/quad/GPUquad/Sub_regions.cuh"
 #include "common/cuda/cudaMemoryUtil.h"
+#include "common/cuda/stream_compaction.cuh"
 #include "cuda/pagani/quad/GPUquad/heuristic_classifier.cuh"
 
+// the scalars of the active regions move during the compaction pass, the
+// coordinates afterwards since their layout depends on the number of regions
 template <typename T, int NDIM>
 __global__ void
-alignRegions(T* dRegions,
-             T* dRegionsLength,
-             T* activeRegions,
-             T* dRegionsIntegral,
-             T* dRegionsError,
-             T* dRegionsParentIntegral,
-             T* dRegionsParentError,
-             int* subDividingDimension,
-             T* scannedArray,
-             T* newActiveRegions,
-             T* newActiveRegionsLength,
-             int* newActiveRegionsBisectDim,
-             size_t numRegions,
-             size_t newNumRegions,
-             int numOfDivisionOnDimension)
+alignCoordinates(T* dRegions,
+                 T* dRegionsLength,
+                 T* activeRegions,
+                 T* scannedArray,
+                 T* newActiveRegions,
+                 T* newActiveRegionsLength,
+                 size_t numRegions,
+                 size_t newNumRegions)
 {
-
   size_t tid = blockIdx.x * blockDim.x + threadIdx.x;
 
   if (tid < numRegions && activeRegions[tid] == 1) {
@@ -35,14 +30,68 @@ alignRegions(T* dRegions,
       newActiveRegionsLength[i * newNumRegions + interval_index] =
         dRegionsLength[i * numRegions + tid];
     }
+  }
+}
+
+template <typename T>
+struct Active_region {
+  __device__ bool
+  operator()(size_t reg) const
+  {
+    return active_regions[reg] == 1;
+  }
 
+  T* active_regions;
+};
+
+// records the position of each active region, used by filter_estimates
+template <typename T>
+struct Record_position {
+  __device__ void
+  operator()(size_t reg, size_t slot) const
+  {
+    scanned_array[reg] = slot;
+  }
+
+  T* scanned_array;
+};
+
+template <typename T>
+struct Align_parents {
+  __device__ void
+  operator()(size_t reg, size_t slot) const
+  {
+    scanned_array[reg] = slot;
+    parent_integrals[slot] = integrals[reg];
+    parent_errors[slot] = errors[reg];
+    bisect_dims[slot] = sub_dividing_dim[reg];
+  }
+
+  T* scanned_array;
+  const T* integrals;
+  const T* errors;
+  const int* sub_dividing_dim;
+  T* parent_integrals;
+  T* parent_errors;
+  int* bisect_dims;
+};
+
+template <typename T>
+__global__ void
+alignEstimates(T* activeRegions,
+               T* dRegionsIntegral,
+               T* dRegionsError,
+               T* dRegionsParentIntegral,
+               T* dRegionsParentError,
+               T* scannedArray,
+               size_t numRegions)
+{
+  size_t tid = blockIdx.x * blockDim.x + threadIdx.x;
+
+  if (tid < numRegions && activeRegions[tid] == 1) {
+    size_t interval_index = scannedArray[tid];
     dRegionsParentIntegral[interval_index] = dRegionsIntegral[tid];
     dRegionsParentError[interval_index] = dRegionsError[tid];
-
-    for (int i = 0; i < numOfDivisionOnDimension; ++i) {
-      newActiveRegionsBisectDim[i * newNumRegions + interval_index] =
-        subDividingDimension[tid];
-    }
   }
 }
 
@@ -53,32 +102,30 @@ public:
   using Region_char = Region_characteristics<ndim>;
   using Region_ests = Region_estimates<T, ndim>;
 
-  Sub_regions_filter(const size_t num_regions)
+  Sub_regions_filter() = default;
+
+  Sub_regions_filter(const size_t num_regions) { reserve(num_regions); }
+
+  // the scan array only grows, so that one filter, with its compaction
+  // state, serves every iteration of a Workspace
+  void
+  reserve(const size_t num_regions)
   {
+    if (num_regions <= capacity)
+      return;
+    cudaFree(scanned_array);
     scanned_array = quad::cuda_malloc<T>(num_regions);
+    capacity = num_regions;
   }
 
   size_t
   get_num_active_regions(T* active_regions, const size_t num_regions)
   {
-    exclusive_scan<T, use_custom>(active_regions, num_regions, scanned_array);
-    T last_element;
-    T num_active = 0;
-
-    cudaMemcpy(&last_element,
-               active_regions + num_regions - 1,
-               sizeof(T),
-               cudaMemcpyDeviceToHost);
-
-    cudaMemcpy(&num_active,
-               scanned_array + num_regions - 1,
-               sizeof(T),
-               cudaMemcpyDeviceToHost);
-
-    if (last_element == 1.)
-      num_active++;
-
-    return static_cast<size_t>(num_active);
+    reserve(num_regions);
+    return compaction.compact(num_regions,
+                              Active_region<T>{active_regions},
+                              Record_position<T>{scanned_array},
+                              stream);
   }
 
   // filter out finished regions
@@ -90,10 +137,32 @@ public:
   {
 
     const size_t current_num_regions = sub_regions.size;
-    const size_t num_active_regions = get_num_active_regions(
-      region_characteristics.active_regions, current_num_regions);
+    if (current_num_regions == 0) {
+      return 0;
+    }
+
+    // parents and bisection dimensions are written during the compaction
+    // pass, before the number of active regions is known, so they are sized
+    // for the worst case
+    reserve(current_num_regions);
+    int* filtered_sub_dividing_dim =
+      quad::cuda_malloc<int>(current_num_regions);
+    parent_ests.reallocate(current_num_regions);
+    const size_t num_active_regions = compaction.compact(
+      current_num_regions,
+      Active_region<T>{region_characteristics.active_regions},
+      Align_parents<T>{scanned_array,
+                       region_ests.integral_estimates,
+                       region_ests.error_estimates,
+                       region_characteristics.sub_dividing_dim,
+                       parent_ests.integral_estimates,
+                       parent_ests.error_estimates,
+                       filtered_sub_dividing_dim},
+      stream);
+    parent_ests.size = num_active_regions;
 
     if (num_active_regions == 0) {
+      cudaFree(filtered_sub_dividing_dim);
       return 0;
     }
 
@@ -102,30 +171,20 @@ public:
     // occur here
     T* filtered_leftCoord = quad::cuda_malloc<T>(num_active_regions * ndim);
     T* filtered_length = quad::cuda_malloc<T>(num_active_regions * ndim);
-    int* filtered_sub_dividing_dim = quad::cuda_malloc<int>(num_active_regions);
-
-    parent_ests.reallocate(num_active_regions);
-    const int numOfDivisionOnDimension = 1;
     const size_t num_blocks = compute_num_blocks(current_num_regions);
 
-    alignRegions<T, static_cast<int>(ndim)>
-      <<<num_blocks, BLOCK_SIZE>>>(sub_regions.dLeftCoord,
-                                   sub_regions.dLength,
-                                   region_characteristics.active_regions,
-                                   region_ests.integral_estimates,
-                                   region_ests.error_estimates,
-                                   parent_ests.integral_estimates,
-                                   parent_ests.error_estimates,
-                                   region_characteristics.sub_dividing_dim,
-                                   scanned_array,
-                                   filtered_leftCoord,
-                                   filtered_length,
-                                   filtered_sub_dividing_dim,
-                                   current_num_regions,
-                                   num_active_regions,
-                                   numOfDivisionOnDimension);
-
-    cudaDeviceSynchronize();
+    alignCoordinates<T, static_cast<int>(ndim)>
+      <<<num_blocks, BLOCK_SIZE, 0, stream>>>(
+        sub_regions.dLeftCoord,
+        sub_regions.dLength,
+        region_characteristics.active_regions,
+        scanned_array,
+        filtered_leftCoord,
+        filtered_length,
+        current_num_regions,
+        num_active_regions);
+
+    cudaStreamSynchronize(stream);
     cudaFree(sub_regions.dLeftCoord);
     cudaFree(sub_regions.dLength);
     cudaFree(region_characteristics.sub_dividing_dim);
@@ -138,6 +197,33 @@ public:
     return num_active_regions;
   }
 
+  // compacts the estimates of one more integrand component into parent_ests,
+  // using the scan of the last call to get_num_active_regions
+  void
+  filter_estimates(const Region_char& region_characteristics,
+                   const Region_ests& region_ests,
+                   Region_ests& parent_ests,
+                   const size_t num_regions,
+                   const size_t num_active_regions)
+  {
+    if (num_active_regions == 0) {
+      return;
+    }
+
+    parent_ests.reallocate(num_active_regions);
+    const size_t num_blocks = compute_num_blocks(num_regions);
+    alignEstimates<T><<<num_blocks, BLOCK_SIZE, 0, stream>>>(
+      region_characteristics.active_regions,
+      region_ests.integral_estimates,
+      region_ests.error_estimates,
+      parent_ests.integral_estimates,
+      parent_ests.error_estimates,
+      scanned_array,
+      num_regions);
+    cudaStreamSynchronize(stream);
+    quad::CudaCheckError();
+  }
+
   size_t
   compute_num_blocks(const size_t num_regions) const
   {
@@ -148,6 +234,10 @@ public:
   ~Sub_regions_filter() { cudaFree(scanned_array); }
 
   T* scanned_array = nullptr;
+  size_t capacity = 0;
+  quad::Stream_compaction compaction;
+  // every kernel of the filter is queued on it
+  cudaStream_t stream = 0;
 };
 
 #endif
\ No newline at end of file
@@ -50,7 +50,10 @@ class Sub_region_splitter {
 
 public:
   size_t num_regions;
-  Sub_region_splitter(size_t size) : num_regions(size) {}
+  cudaStream_t stream = 0;
+  Sub_region_splitter(size_t size, cudaStream_t s = 0)
+    : num_regions(size), stream(s)
+  {}
 
   void
   split(Sub_regions<T, ndim>& sub_regions,
@@ -70,14 +73,14 @@ public:
       quad::cuda_malloc<T>(num_regions * ndim * children_per_region);
 
     divideIntervalsGPU<T, ndim>
-      <<<num_blocks, num_threads>>>(children_left_coord,
-                                    children_length,
-                                    sub_regions.dLeftCoord,
-                                    sub_regions.dLength,
-                                    classifiers.sub_dividing_dim,
-                                    num_regions,
-                                    children_per_region);
-    cudaDeviceSynchronize();
+      <<<num_blocks, num_threads, 0, stream>>>(children_left_coord,
+                                               children_length,
+                                               sub_regions.dLeftCoord,
+                                               sub_regions.dLength,
+                                               classifiers.sub_dividing_dim,
+                                               num_regions,
+                                               children_per_region);
+    cudaStreamSynchronize(stream);
     cudaFree(sub_regions.dLeftCoord);
     cudaFree(sub_regions.dLength);
     sub_regions.size = num_regions * children_per_region;
@@ -51,11 +51,33 @@ struct Sub_regions {
 
   Sub_regions(const Sub_regions<T, ndim>& other)
   {
-    size = other.size;
-    device_init(size);
-    quad::cuda_memcpy_device_to_device<double>(
-      dLeftCoord, other.dLeftCoord, size);
-    quad::cuda_memcpy_device_to_device<double>(dLength, other.dLength, size);
+    device_init(other.size);
+    quad::cuda_memcpy_device_to_device<T>(
+      dLeftCoord, other.dLeftCoord, size * ndim);
+    quad::cuda_memcpy_device_to_device<T>(
+      dLength, other.dLength, size * ndim);
+  }
+
+  // deep, like the copy constructor; the host arrays are dropped and the
+  // snapshot is kept
+  Sub_regions&
+  operator=(const Sub_regions<T, ndim>& other)
+  {
+    if (this == &other)
+      return *this;
+    delete[] LeftCoord;
+    delete[] Length;
+    LeftCoord = nullptr;
+    Length = nullptr;
+    host_data_size = 0;
+    cudaFree(dLeftCoord);
+    cudaFree(dLength);
+    device_init(other.size);
+    quad::cuda_memcpy_device_to_device<T>(
+      dLeftCoord, other.dLeftCoord, size * ndim);
+    quad::cuda_memcpy_device_to_device<T>(
+      dLength, other.dLength, size * ndim);
+    return *this;
   }
 
   ~Sub_regions()
@@ -64,6 +86,8 @@ struct Sub_regions {
     delete[] Length;
     cudaFree(dLeftCoord);
     cudaFree(dLength);
+    cudaFree(snapshot_dLeftCoord);
+    cudaFree(snapshot_dLength);
   }
 
   void
@@ -162,7 +186,8 @@ struct Sub_regions {
   }
 
   void
-  uniform_split(size_t numOfDivisionPerRegionPerDimension)
+  uniform_split(size_t numOfDivisionPerRegionPerDimension,
+                cudaStream_t stream = 0)
   {
     size_t num_starting_regions =
       pow((T)numOfDivisionPerRegionPerDimension, (T)ndim);
@@ -173,14 +198,14 @@ struct Sub_regions {
     size_t numThreads = 512;
     size_t numBlocks = (size_t)ceil((T)num_starting_regions / (T)numThreads);
 
-    create_uniform_split<<<numBlocks, numThreads>>>(
+    create_uniform_split<<<numBlocks, numThreads, 0, stream>>>(
       starting_axis_length,
       dLeftCoord,
       dLength,
       num_starting_regions,
       numOfDivisionPerRegionPerDimension,
       ndim);
-    cudaDeviceSynchronize();
+    cudaStreamSynchronize(stream);
     size = num_starting_regions;
   }
 
@@ -219,6 +244,8 @@ struct Sub_regions {
   void
   take_snapshot()
   {
+    cudaFree(snapshot_dLeftCoord);
+    cudaFree(snapshot_dLength);
     snapshot_size = size;
     snapshot_dLeftCoord = quad::cuda_malloc<T>(size * ndim);
     snapshot_dLength = quad::cuda_malloc<T>(size * ndim);
@@ -228,14 +255,17 @@ struct Sub_regions {
       snapshot_dLength, dLength, size * ndim);
   }
 
+  // copies the snapshot back, which stays valid for further loads
   void
   load_snapshot()
   {
     cudaFree(dLeftCoord);
     cudaFree(dLength);
-    dLeftCoord = snapshot_dLeftCoord;
-    dLength = snapshot_dLength;
-    size = snapshot_size;
+    device_init(snapshot_size);
+    quad::cuda_memcpy_device_to_device<T>(
+      dLeftCoord, snapshot_dLeftCoord, size * ndim);
+    quad::cuda_memcpy_device_to_device<T>(
+      dLength, snapshot_dLength, size * ndim);
   }
 
   // for accessing on the host side, may need to invoke refresh_host_device() to
@@ -0,0 +1,267 @@
+#ifndef VECTOR_WORKSPACE_CUH
+#define VECTOR_WORKSPACE_CUH
+
+#include <array>
+#include "cuda/pagani/quad/GPUquad/Region_estimates.cuh"
+#include "cuda/pagani/quad/GPUquad/Sub_regions.cuh"
+#include "cuda/pagani/quad/GPUquad/Region_characteristics.cuh"
+#include "cuda/pagani/quad/GPUquad/hybrid.cuh"
+#include "cuda/pagani/quad/GPUquad/PaganiUtils.cuh"
+#include "cuda/pagani/quad/GPUquad/Sub_region_splitter.cuh"
+#include "cuda/pagani/quad/GPUquad/Sub_region_filter.cuh"
+#include "cuda/pagani/quad/GPUquad/heuristic_classifier.cuh"
+#include "common/integration_result.hh"
+#include "common/cuda/Volume.cuh"
+
+template <typename T>
+__global__ void
+mark_active_if_any(T* active_regions,
+                   const T* component_active_regions,
+                   size_t num_regions)
+{
+  size_t tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid < num_regions && component_active_regions[tid] == 1.)
+    active_regions[tid] = 1.;
+}
+
+// Pagani for integrands returning gpu::cudaArray<T, ncomp>. All components
+// share one partition: the integrand is evaluated once per cubature point,
+// every component gets its own two-level error estimate and a region stays
+// active as long as one of the components needs it to be split. The
+// threshold classification of Workspace is not applied, the iterations stop
+// once a full split does not fit in device memory.
+template <typename T, size_t ndim, size_t ncomp, bool use_custom = false>
+class Vector_workspace {
+  using Estimates = Region_estimates<T, ndim>;
+  using Component_estimates = std::array<Estimates, ncomp>;
+  using Sub_regs = Sub_regions<T, ndim>;
+  using Regs_characteristics = Region_characteristics<ndim>;
+  using Filter = Sub_regions_filter<T, ndim, use_custom>;
+  using Splitter = Sub_region_splitter<T, ndim>;
+  using Results = std::array<numint::integration_result, ncomp>;
+
+private:
+  void relerr_classify(Regs_characteristics& characteristics,
+                       Component_estimates& estimates,
+                       const Component_estimates& prev_iter_estimates,
+                       T epsrel,
+                       bool relerr_classification);
+  void fix_error_budget_overflow(
+    Regs_characteristics& characteristics,
+    const numint::integration_results<ncomp>& finished,
+    const Results& iter,
+    Results& iter_finished,
+    const T epsrel);
+  bool enough_mem_for_next_split(size_t num_regions) const;
+
+  Cubature_rules<T, ndim, 0, use_custom> rules;
+  // one filter for the whole run, its buffers outlive the iterations
+  Filter filter;
+
+public:
+  Vector_workspace() = default;
+
+  template <typename IntegT>
+  numint::integration_results<ncomp> integrate(
+    const IntegT& integrand,
+    T epsrel,
+    T epsabs,
+    quad::Volume<T, ndim> const& vol,
+    bool relerr_classification = true);
+};
+
+template <typename T, size_t ndim, size_t ncomp, bool use_custom>
+void
+Vector_workspace<T, ndim, ncomp, use_custom>::relerr_classify(
+  Regs_characteristics& characteristics,
+  Component_estimates& estimates,
+  const Component_estimates& prev_iter_estimates,
+  T epsrel,
+  bool relerr_classification)
+{
+  const size_t num_regions = characteristics.size;
+  if (prev_iter_estimates[0].size == 0) {
+    return;
+  }
+
+  // each component classifies into its own flags, a region stays active if
+  // any of them is
+  Regs_characteristics component_characteristics(num_regions);
+  quad::set_device_array<T>(characteristics.active_regions, num_regions, 0.);
+  size_t block_size = 64;
+  size_t num_blocks =
+    num_regions / block_size + ((num_regions % block_size) ? 1 : 0);
+
+  for (size_t comp = 0; comp < ncomp; ++comp) {
+    two_level_errorest_and_relerr_classify<T, ndim>(estimates[comp],
+                                                    prev_iter_estimates[comp],
+                                                    component_characteristics,
+                                                    epsrel,
+                                                    relerr_classification);
+    mark_active_if_any<T><<<num_blocks, block_size>>>(
+      characteristics.active_regions,
+      component_characteristics.active_regions,
+      num_regions);
+  }
+  cudaDeviceSynchronize();
+}
+
+template <typename T, size_t ndim, size_t ncomp, bool use_custom>
+void
+Vector_workspace<T, ndim, ncomp, use_custom>::fix_error_budget_overflow(
+  Regs_characteristics& characteristics,
+  const numint::integration_results<ncomp>& cummulative_finished,
+  const Results& iter,
+  Results& iter_finished,
+  const T epsrel)
+{
+  // the active flags are shared, so all components keep their finished
+  // regions or none does
+  bool overflow = false;
+  for (size_t comp = 0; comp < ncomp; ++comp) {
+    T leaves_estimate =
+      cummulative_finished.estimate[comp] + iter[comp].estimate;
+    T leaves_finished_errorest =
+      cummulative_finished.errorest[comp] + iter_finished[comp].errorest;
+    overflow |= leaves_finished_errorest > abs(leaves_estimate) * epsrel;
+  }
+
+  if (overflow) {
+    size_t num_threads = 256;
+    size_t num_blocks = characteristics.size / num_threads +
+                        (characteristics.size % num_threads == 0 ? 0 : 1);
+    quad::set_array_to_value<T><<<num_blocks, num_threads>>>(
+      characteristics.active_regions, characteristics.size, 1);
+    cudaDeviceSynchronize();
+
+    for (size_t comp = 0; comp < ncomp; ++comp) {
+      iter_finished[comp].errorest = 0.;
+      iter_finished[comp].estimate = 0.;
+    }
+  }
+}
+
+template <typename T, size_t ndim, size_t ncomp, bool use_custom>
+bool
+Vector_workspace<T, ndim, ncomp, use_custom>::enough_mem_for_next_split(
+  size_t num_regions) const
+{
+  // the estimates, two-level errors and parents of the other components
+  const size_t per_component = 8 * 5 * 2 * num_regions;
+  const size_t required =
+    device_mem_required_for_full_split(num_regions, ndim) +
+    (ncomp - 1) * per_component;
+  return free_device_mem(num_regions, ndim) > required;
+}
+
+template <typename T, size_t ndim, size_t ncomp, bool use_custom>
+template <typename IntegT>
+numint::integration_results<ncomp>
+Vector_workspace<T, ndim, ncomp, use_custom>::integrate(
+  const IntegT& integrand,
+  T epsrel,
+  T epsabs,
+  quad::Volume<T, ndim> const& vol,
+  bool relerr_classification)
+{
+  rules.set_device_volume(vol.lows, vol.highs);
+  Component_estimates prev_iter_estimates;
+  numint::integration_results<ncomp> cummulative;
+
+  size_t partitions_per_axis = 2;
+  if (ndim < 5)
+    partitions_per_axis = 4;
+  else if (ndim <= 10)
+    partitions_per_axis = 2;
+  else
+    partitions_per_axis = 1;
+
+  Sub_regs subregions(partitions_per_axis);
+  cummulative.status = 1;
+  bool compute_relerr_error_reduction = false;
+  IntegT* d_integrand = quad::cuda_copy_to_managed(integrand);
+
+  for (size_t it = 0; it < 700 && subregions.size > 0; it++) {
+    size_t num_regions = subregions.size;
+    Regs_characteristics characteristics(subregions.size);
+    Component_estimates estimates;
+    for (size_t comp = 0; comp < ncomp; ++comp)
+      estimates[comp].reallocate(num_regions);
+
+    Results iter =
+      rules.template apply_cubature_integration_rules<IntegT, ncomp>(
+        d_integrand,
+        subregions,
+        estimates,
+        characteristics,
+        compute_relerr_error_reduction);
+
+    relerr_classify(characteristics,
+                    estimates,
+                    prev_iter_estimates,
+                    epsrel,
+                    relerr_classification);
+
+    bool all_converged = true;
+    for (size_t comp = 0; comp < ncomp; ++comp) {
+      iter[comp].errorest = reduction<T, use_custom>(
+        estimates[comp].error_estimates, num_regions);
+      all_converged &= accuracy_reached(
+        epsrel,
+        epsabs,
+        std::abs(cummulative.estimate[comp] + iter[comp].estimate),
+        cummulative.errorest[comp] + iter[comp].errorest);
+    }
+
+    cummulative.iters++;
+    if (all_converged || !enough_mem_for_next_split(num_regions)) {
+      for (size_t comp = 0; comp < ncomp; ++comp) {
+        cummulative.estimate[comp] += iter[comp].estimate;
+        cummulative.errorest[comp] += iter[comp].errorest;
+      }
+      cummulative.status = all_converged ? 0 : 1;
+      cummulative.nregions += num_regions;
+      d_integrand->~IntegT();
+      cudaFree(d_integrand);
+      return cummulative;
+    }
+
+    Results finished;
+    for (size_t comp = 0; comp < ncomp; ++comp)
+      finished[comp] = compute_finished_estimates<T, ndim, use_custom>(
+        estimates[comp], characteristics, iter[comp]);
+
+    fix_error_budget_overflow(
+      characteristics, cummulative, iter, finished, epsrel);
+
+    for (size_t comp = 0; comp < ncomp; ++comp) {
+      cummulative.estimate[comp] += finished[comp].estimate;
+      cummulative.errorest[comp] += finished[comp].errorest;
+    }
+
+    const size_t num_active_regions = filter.get_num_active_regions(
+      characteristics.active_regions, num_regions);
+    for (size_t comp = 1; comp < ncomp; ++comp)
+      filter.filter_estimates(characteristics,
+                              estimates[comp],
+                              prev_iter_estimates[comp],
+                              num_regions,
+                              num_active_regions);
+    filter.filter(
+      subregions, characteristics, estimates[0], prev_iter_estimates[0]);
+
+    cummulative.nregions += num_regions - num_active_regions;
+    subregions.size = num_active_regions;
+    quad::CudaCheckError();
+
+    Splitter splitter(subregions.size);
+    splitter.split(subregions, characteristics);
+  }
+
+  cummulative.nregions += subregions.size;
+  d_integrand->~IntegT();
+  cudaFree(d_integrand);
+  return cummulative;
+}
+
+#endif
@@ -3,6 +3,7 @@
 
 #include "cuda/pagani/quad/GPUquad/Region_estimates.cuh"
 #include "cuda/pagani/quad/GPUquad/Sub_regions.cuh"
+#include "cuda/pagani/quad/GPUquad/Partition_checkpoint.cuh"
 #include "cuda/pagani/quad/GPUquad/Region_characteristics.cuh"
 #include "cuda/pagani/quad/GPUquad/hybrid.cuh"
 #include "cuda/pagani/quad/GPUquad/PaganiUtils.cuh"
@@ -10,7 +11,12 @@
 #include "cuda/pagani/quad/GPUquad/Sub_region_filter.cuh"
 #include "cuda/pagani/quad/GPUquad/heuristic_classifier.cuh"
 #include "common/integration_result.hh"
+#include "common/nonfinite.hh"
+#include "common/capture.hh"
+#include "common/cuda/capture.cuh"
 #include "common/cuda/Volume.cuh"
+#include <limits>
+#include <memory>
 
 template <bool debug_ters = false>
 void
@@ -42,12 +48,73 @@ private:
                           numint::integration_result& finished,
                           const numint::integration_result& iter,
                           const numint::integration_result& cummulative);
-
+  template <typename IntegT>
+  numint::integration_result stop_on_nonfinite(
+    numint::integration_result cummulative,
+    size_t num_regions,
+    IntegT* d_integrand);
+  quad::Capture_log<T> capture_log(size_t it);
+  static size_t initial_partitions_per_axis();
+  void capture_regions(const Sub_regs& subregions,
+                       const Estimates& estimates,
+                       const double* active,
+                       quad::Volume<T, ndim> const& vol);
+
+  struct no_hook {
+    void
+    operator()(size_t,
+               const numint::integration_result&,
+               const Sub_regs&,
+               const Estimates&) const
+    {}
+  };
+
+  // the main loop of every integrate overload; after_split is called with
+  // the iteration, the running result, the regions just split and their
+  // parent estimates. With count_final_iteration the iteration that ends
+  // the run is part of iters, as the overload taking subregions has always
+  // reported it; the others count the iterations that split regions.
+  template <typename IntegT, bool predict_split, typename Hook>
+  numint::integration_result refine(const IntegT& integrand,
+                                    Sub_regs& subregions,
+                                    Estimates& prev_iter_estimates,
+                                    T epsrel,
+                                    T epsabs,
+                                    quad::Volume<T, ndim> const& vol,
+                                    bool relerr_classification,
+                                    const std::string& optional,
+                                    bool count_final_iteration,
+                                    Hook after_split);
+
+  // every kernel, reduction and copy of integrate is queued on it, so that
+  // Workspaces used from different host threads run concurrently
+  cudaStream_t stream = 0;
   Cubature_rules<T, ndim, debug> rules;
+  // reused by every iteration, with its scan array and compaction state
+  Filter filter;
   Recorder<true, collect_mult_runs> time_breakdown;
+  std::unique_ptr<quad::Capture_stream<T>> capture;
 
 public:
-  Workspace() = default;
+  Workspace()
+  {
+    cudaStreamCreate(&stream);
+    rules.stream = stream;
+    filter.stream = stream;
+    // every evaluation, up to the buffer size of each iteration; this used
+    // to be a full copy of them, which ran out of memory on real runs
+    if constexpr (debug >= 2) {
+      numint::capture_options options;
+      options.sample_every = 1;
+      capture_to("cuda_fevals.capture", options);
+    }
+  }
+
+  Workspace(const Workspace&) = delete;
+  Workspace& operator=(const Workspace&) = delete;
+
+  ~Workspace() { cudaStreamDestroy(stream); }
+
   //Workspace(T* lows, T* highs) : Cubature_rules<T, ndim>(lows, highs) {} //probably undeeded
   template <typename IntegT,
             bool predict_split = false,
@@ -68,8 +135,118 @@ public:
                                        T epsabs,
                                        quad::Volume<T, ndim> const& vol,
                                        bool relerr_classification = true);
+
+  // starts from the partition held by checkpoint if it is not empty and
+  // keeps it updated, every checkpoint.interval iterations, with the
+  // partition of the whole space, so that it can warm-start the next
+  // integrand
+  template <typename IntegT,
+            bool predict_split = false,
+            bool collect_iters = false>
+  numint::integration_result integrate(const IntegT& integrand,
+                                       Partition_checkpoint<T, ndim>& checkpoint,
+                                       T epsrel,
+                                       T epsabs,
+                                       quad::Volume<T, ndim> const& vol,
+                                       bool relerr_classification = true);
+
+  // fail (the default) ends integrate at the first iteration producing a
+  // NaN or infinite integrand value, with status numint::nonfinite_status
+  // and a NaN estimate; zero and exclude let it carry on
+  void
+  set_nonfinite_policy(numint::nonfinite_policy policy)
+  {
+    rules.nonfinite.set_policy(policy);
+  }
+
+  // the non-finite values met by the last call to integrate
+  numint::nonfinite_report
+  nonfinite_report() const
+  {
+    return rules.nonfinite.report();
+  }
+
+  // streams a sample of the integrand evaluations and the regions that are
+  // done with, as they are finished, of the following calls to integrate
+  // into filename; the format is described in common/capture.hh
+  void
+  capture_to(const std::string& filename,
+             const numint::capture_options& options = {})
+  {
+    capture.reset();
+    capture = std::make_unique<quad::Capture_stream<T>>(
+      filename, static_cast<int>(ndim), options);
+  }
+
+  // waits for the capture file to be complete and closes it
+  void
+  stop_capture()
+  {
+    capture.reset();
+  }
 };
 
+template <typename T, size_t ndim, int debug, bool use_custom, bool collect_mult_runs>
+template <typename IntegT>
+numint::integration_result
+Workspace<T, ndim, debug, use_custom, collect_mult_runs>::stop_on_nonfinite(
+  numint::integration_result cummulative,
+  size_t num_regions,
+  IntegT* d_integrand)
+{
+  if (capture)
+    capture->drain();
+  cummulative.estimate = std::numeric_limits<T>::quiet_NaN();
+  cummulative.errorest = std::numeric_limits<T>::quiet_NaN();
+  cummulative.status = numint::nonfinite_status;
+  cummulative.nregions += num_regions;
+  d_integrand->~IntegT();
+  cudaFree(d_integrand);
+  return cummulative;
+}
+
+template <typename T, size_t ndim, int debug, bool use_custom, bool collect_mult_runs>
+size_t
+Workspace<T, ndim, debug, use_custom, collect_mult_runs>::
+  initial_partitions_per_axis()
+{
+  if (ndim < 5)
+    return 4;
+  if (ndim <= 10)
+    return 2;
+  return 1;
+}
+
+template <typename T, size_t ndim, int debug, bool use_custom, bool collect_mult_runs>
+quad::Capture_log<T>
+Workspace<T, ndim, debug, use_custom, collect_mult_runs>::capture_log(size_t it)
+{
+  return capture ? capture->begin(static_cast<unsigned>(it)) :
+                   quad::Capture_log<T>{};
+}
+
+// active is null when the iteration ends the integration, all the regions
+// are final then
+template <typename T, size_t ndim, int debug, bool use_custom, bool collect_mult_runs>
+void
+Workspace<T, ndim, debug, use_custom, collect_mult_runs>::capture_regions(
+  const Sub_regs& subregions,
+  const Estimates& estimates,
+  const double* active,
+  quad::Volume<T, ndim> const& vol)
+{
+  if (!capture)
+    return;
+  capture->record_regions(subregions.dLeftCoord,
+                          subregions.dLength,
+                          subregions.size,
+                          active,
+                          estimates.integral_estimates,
+                          estimates.error_estimates,
+                          vol);
+  capture->drain();
+}
+
 
 template <typename T, size_t ndim, int debug, bool use_custom, bool collect_mult_runs>
 bool
@@ -107,7 +284,8 @@ Workspace<T, ndim, debug, use_custom, collect_mult_runs>::heuristic_classify(
     finished.estimate = iter.estimate - dot_product<T, T, use_custom>(
                                           characteristics.active_regions,
                                           estimates.integral_estimates,
-                                          characteristics.size);
+                                          characteristics.size,
+                                          stream);
     finished.errorest = hs_results.finished_errorest;
   }
 
@@ -136,9 +314,9 @@ Workspace<T, ndim, debug, use_custom, collect_mult_runs>::fix_error_budget_overf
     size_t num_threads = 256;
     size_t num_blocks = characteristics.size / num_threads +
                         (characteristics.size % num_threads == 0 ? 0 : 1);
-    quad::set_array_to_value<T><<<num_blocks, num_threads>>>(
+    quad::set_array_to_value<T><<<num_blocks, num_threads, 0, stream>>>(
       characteristics.active_regions, characteristics.size, 1);
-    cudaDeviceSynchronize();
+    cudaStreamSynchronize(stream);
 
     iter_finished.errorest = 0.;
     iter_finished.estimate = 0.;
@@ -146,15 +324,19 @@ Workspace<T, ndim, debug, use_custom, collect_mult_runs>::fix_error_budget_overf
 }
 
 template <typename T, size_t ndim, int debug, bool use_custom, bool collect_mult_runs>
-template <typename IntegT, bool predict_split, bool collect_iters>
+template <typename IntegT, bool predict_split, typename Hook>
 numint::integration_result
-Workspace<T, ndim, debug, use_custom, collect_mult_runs>::integrate(const IntegT& integrand,
-                                          Sub_regions<T, ndim>& subregions,
-                                          T epsrel,
-                                          T epsabs,
-                                          quad::Volume<T, ndim> const& vol,
-                                          bool relerr_classification,
-                                          const std::string& optional)
+Workspace<T, ndim, debug, use_custom, collect_mult_runs>::refine(
+  const IntegT& integrand,
+  Sub_regs& subregions,
+  Estimates& prev_iter_estimates,
+  T epsrel,
+  T epsabs,
+  quad::Volume<T, ndim> const& vol,
+  bool relerr_classification,
+  const std::string& optional,
+  bool count_final_iteration,
+  Hook after_split)
 {
   using CustomTimer = std::chrono::high_resolution_clock::time_point;
   using MilliSeconds =
@@ -162,16 +344,16 @@ Workspace<T, ndim, debug, use_custom, collect_mult_runs>::integrate(const IntegT
 
   CustomTimer timer;
   rules.set_device_volume(vol.lows, vol.highs);
-  Estimates prev_iter_estimates;
+  rules.nonfinite.reset();
   numint::integration_result cummulative;
 
-  Classifier classifier(epsrel, epsabs);
+  Classifier classifier(epsrel, epsabs, stream);
   cummulative.status = 1;
   bool compute_relerr_error_reduction = false;
   Recorder<debug, collect_mult_runs> iter_recorder("cuda_pagani_iters.csv");
   Recorder<debug, collect_mult_runs> time_breakdown("cuda_pagani_time_breakdown.csv");
 
-  IntegT* d_integrand = quad::make_gpu_integrand<IntegT>(integrand);
+  IntegT* d_integrand = quad::cuda_copy_to_managed(integrand);
 
 
   if(debug > 0 && collect_mult_runs == false){
@@ -194,7 +376,10 @@ Workspace<T, ndim, debug, use_custom, collect_mult_runs>::integrate(const IntegT
         subregions,
         estimates,
         characteristics,
-        compute_relerr_error_reduction);
+        compute_relerr_error_reduction,
+        capture_log(it));
+    if (rules.nonfinite.must_stop())
+      return stop_on_nonfinite(cummulative, subregions.size, d_integrand);
 
     if constexpr (debug > 0) {
       MilliSeconds dt = std::chrono::high_resolution_clock::now() - timer;
@@ -218,9 +403,10 @@ Workspace<T, ndim, debug, use_custom, collect_mult_runs>::integrate(const IntegT
                                                     prev_iter_estimates,
                                                     characteristics,
                                                     epsrel,
-                                                    relerr_classification);
-    iter.errorest =
-      reduction<T, use_custom>(estimates.error_estimates, subregions.size);
+                                                    relerr_classification,
+                                                    stream);
+    iter.errorest = reduction<T, use_custom>(
+      estimates.error_estimates, subregions.size, stream);
 
     if constexpr (debug > 0) {
       MilliSeconds dt = std::chrono::high_resolution_clock::now() - timer;
@@ -247,7 +433,8 @@ Workspace<T, ndim, debug, use_custom, collect_mult_runs>::integrate(const IntegT
       }
     }
 
-    cummulative.iters++;
+    if (count_final_iteration)
+      cummulative.iters++;
     if (accuracy_reached(epsrel,
                          epsabs,
                          std::abs(cummulative.estimate + iter.estimate),
@@ -256,6 +443,7 @@ Workspace<T, ndim, debug, use_custom, collect_mult_runs>::integrate(const IntegT
       cummulative.errorest += iter.errorest;
       cummulative.status = 0;
       cummulative.nregions += subregions.size;
+      capture_regions(subregions, estimates, nullptr, vol);
       d_integrand->~IntegT();
       cudaFree(d_integrand);
       return cummulative;
@@ -270,7 +458,7 @@ Workspace<T, ndim, debug, use_custom, collect_mult_runs>::integrate(const IntegT
     classifier.store_estimate(cummulative.estimate + iter.estimate);
     numint::integration_result finished =
       compute_finished_estimates<T, ndim, use_custom>(
-        estimates, characteristics, iter);
+        estimates, characteristics, iter, stream);
 
     if constexpr (debug > 0) {
       MilliSeconds dt = std::chrono::high_resolution_clock::now() - timer;
@@ -300,6 +488,7 @@ Workspace<T, ndim, debug, use_custom, collect_mult_runs>::integrate(const IntegT
       cummulative.estimate += iter.estimate;
       cummulative.errorest += iter.errorest;
       cummulative.nregions += subregions.size;
+      capture_regions(subregions, estimates, nullptr, vol);
       d_integrand->~IntegT();
       cudaFree(d_integrand);
 
@@ -325,8 +514,9 @@ Workspace<T, ndim, debug, use_custom, collect_mult_runs>::integrate(const IntegT
       timer = std::chrono::high_resolution_clock::now();
     }
 
-    Filter filter_obj(subregions.size);
-    size_t num_active_regions = filter_obj.filter(
+    capture_regions(
+      subregions, estimates, characteristics.active_regions, vol);
+    size_t num_active_regions = filter.filter(
       subregions, characteristics, estimates, prev_iter_estimates);
 
     cummulative.nregions += num_regions - num_active_regions;
@@ -341,7 +531,7 @@ Workspace<T, ndim, debug, use_custom, collect_mult_runs>::integrate(const IntegT
       timer = std::chrono::high_resolution_clock::now();
     }
 
-    Splitter splitter(subregions.size);
+    Splitter splitter(subregions.size, stream);
     splitter.split(subregions, characteristics);
 
     if constexpr (debug > 0) {
@@ -350,6 +540,9 @@ Workspace<T, ndim, debug, use_custom, collect_mult_runs>::integrate(const IntegT
                              << it << ","
                              << "region_splitting," << dt.count() << std::endl;
     }
+    if (!count_final_iteration)
+      cummulative.iters++;
+    after_split(it, cummulative, subregions, prev_iter_estimates);
   }
   cummulative.nregions += subregions.size;
   d_integrand->~IntegT();
@@ -357,6 +550,29 @@ Workspace<T, ndim, debug, use_custom, collect_mult_runs>::integrate(const IntegT
   return cummulative;
 }
 
+template <typename T, size_t ndim, int debug, bool use_custom, bool collect_mult_runs>
+template <typename IntegT, bool predict_split, bool collect_iters>
+numint::integration_result
+Workspace<T, ndim, debug, use_custom, collect_mult_runs>::integrate(const IntegT& integrand,
+                                          Sub_regions<T, ndim>& subregions,
+                                          T epsrel,
+                                          T epsabs,
+                                          quad::Volume<T, ndim> const& vol,
+                                          bool relerr_classification,
+                                          const std::string& optional)
+{
+  Estimates prev_iter_estimates;
+  return refine<IntegT, predict_split>(integrand,
+                                       subregions,
+                                       prev_iter_estimates,
+                                       epsrel,
+                                       epsabs,
+                                       vol,
+                                       relerr_classification,
+                                       optional,
+                                       true,
+                                       no_hook{});
+}
 
 template <typename T, size_t ndim, int debug, bool use_custom, bool collect_mult_runs>
 template <typename IntegT, bool predict_split, bool collect_iters>
@@ -367,130 +583,58 @@ Workspace<T, ndim, debug, use_custom, collect_mult_runs>::integrate(const IntegT
                                           quad::Volume<T, ndim> const& vol,
                                           bool relerr_classification)
 {
-  
-  using MilliSeconds =
-    std::chrono::duration<T, std::chrono::milliseconds::period>;
-  
-  rules.set_device_volume(vol.lows, vol.highs);
   Estimates prev_iter_estimates;
-  numint::integration_result cummulative;
-  Recorder<debug, collect_mult_runs> iter_recorder("cuda_iters.csv");
+  Sub_regions<T, ndim> subregions;
+  subregions.uniform_split(initial_partitions_per_axis(), stream);
+  return refine<IntegT, predict_split>(integrand,
+                                       subregions,
+                                       prev_iter_estimates,
+                                       epsrel,
+                                       epsabs,
+                                       vol,
+                                       relerr_classification,
+                                       "default",
+                                       false,
+                                       no_hook{});
+}
 
-  size_t partitions_per_axis = 2;
-  if (ndim < 5)
-    partitions_per_axis = 4;
-  else if (ndim <= 10)
-    partitions_per_axis = 2;
+template <typename T, size_t ndim, int debug, bool use_custom, bool collect_mult_runs>
+template <typename IntegT, bool predict_split, bool collect_iters>
+numint::integration_result
+Workspace<T, ndim, debug, use_custom, collect_mult_runs>::integrate(const IntegT& integrand,
+                                          Partition_checkpoint<T, ndim>& checkpoint,
+                                          T epsrel,
+                                          T epsabs,
+                                          quad::Volume<T, ndim> const& vol,
+                                          bool relerr_classification)
+{
+  Estimates prev_iter_estimates;
+  Sub_regions<T, ndim> subregions;
+  size_t const restored_iterations = checkpoint.iterations;
+  if (checkpoint.empty())
+    subregions.uniform_split(initial_partitions_per_axis(), stream);
   else
-    partitions_per_axis = 1;
-
-  Sub_regions<T, ndim> subregions(partitions_per_axis);
-
-  Classifier classifier(epsrel, epsabs);
-  cummulative.status = 1;
-  bool compute_relerr_error_reduction = false;
-  IntegT* d_integrand = quad::cuda_copy_to_managed(integrand);
-  
-  if constexpr (debug > 0 && collect_mult_runs == false) {
-
-    iter_recorder.outfile << "it, estimate, errorest, nregions" << std::endl;
-  }
-
-  for (size_t it = 0; it < 700 && subregions.size > 0; it++) {
-    size_t num_regions = subregions.size;
-    Regs_characteristics characteristics(subregions.size);
-    Estimates estimates(subregions.size);
-
-    auto const t0 = std::chrono::high_resolution_clock::now();
-    numint::integration_result iter =
-      rules.template apply_cubature_integration_rules<IntegT>(
-        d_integrand,
-        it,
-        subregions,
-        estimates,
-        characteristics,
-        compute_relerr_error_reduction);
-    MilliSeconds dt = std::chrono::high_resolution_clock::now() - t0;
-
-    if constexpr (predict_split) {
-      relerr_classification =
-        subregions.size <= 15000000 && it < 15 && cummulative.nregions == 0 ?
-          false :
-          true;
-    }
-    two_level_errorest_and_relerr_classify<T, ndim>(estimates,
-                                                    prev_iter_estimates,
-                                                    characteristics,
-                                                    epsrel,
-                                                    relerr_classification);
-    iter.errorest =
-      reduction<T, use_custom>(estimates.error_estimates, subregions.size);
-
-    if constexpr (debug > 0)
-      iter_recorder.outfile << it << "," << cummulative.estimate + iter.estimate
-                            << "," << cummulative.errorest + iter.errorest
-                            << "," << subregions.size << std::endl;
-    // std::cout << it << "," << cummulative.estimate + iter.estimate << ","
-    //           << cummulative.errorest + iter.errorest << "," << subregions.size
-    //           << std::endl;
-
-    if constexpr (predict_split) {
-      if (cummulative.nregions == 0 && it == 15) {
-        subregions.take_snapshot();
-      }
-    }
-
-    if (accuracy_reached(epsrel,
-                         epsabs,
-                         std::abs(cummulative.estimate + iter.estimate),
-                         cummulative.errorest + iter.errorest)) {
-      cummulative.estimate += iter.estimate;
-      cummulative.errorest += iter.errorest;
-      cummulative.status = 0;
-      cummulative.nregions += subregions.size;
-      d_integrand->~IntegT();
-      cudaFree(d_integrand);
-      return cummulative;
-    }
-
-    quad::CudaCheckError();
-    classifier.store_estimate(cummulative.estimate + iter.estimate);
-    numint::integration_result finished =
-      compute_finished_estimates<T, ndim, use_custom>(
-        estimates, characteristics, iter);
-    fix_error_budget_overflow(
-      characteristics, cummulative, iter, finished, epsrel);
-    if (heuristic_classify(classifier,
-                           characteristics,
-                           estimates,
-                           finished,
-                           iter,
-                           cummulative) == true) {
-      cummulative.estimate += iter.estimate;
-      cummulative.errorest += iter.errorest;
-      cummulative.nregions += subregions.size;
-      d_integrand->~IntegT();
-      cudaFree(d_integrand);
-      return cummulative;
-    }
-
-    cummulative.estimate += finished.estimate;
-    cummulative.errorest += finished.errorest;
-    quad::CudaCheckError();
-    Filter filter_obj(subregions.size);
-    size_t num_active_regions = filter_obj.filter(
-      subregions, characteristics, estimates, prev_iter_estimates);
-    cummulative.nregions += num_regions - num_active_regions;
-    subregions.size = num_active_regions;
-    quad::CudaCheckError();
-    Splitter splitter(subregions.size);
-    splitter.split(subregions, characteristics);
-    cummulative.iters++;
-  }
-  cummulative.nregions += subregions.size;
-  d_integrand->~IntegT();
-  cudaFree(d_integrand);
-  return cummulative;
+    checkpoint.restore(subregions, prev_iter_estimates);
+
+  // once a region is finished, the remaining ones no longer cover the
+  // integration space and can't be used to start another integrand
+  auto refresh = [&](size_t it,
+                     const numint::integration_result& cummulative,
+                     const Sub_regs& regions,
+                     const Estimates& parents) {
+    if (cummulative.nregions == 0 && checkpoint.due(it))
+      checkpoint.capture(regions, parents, restored_iterations + it + 1);
+  };
+  return refine<IntegT, predict_split>(integrand,
+                                       subregions,
+                                       prev_iter_estimates,
+                                       epsrel,
+                                       epsabs,
+                                       vol,
+                                       relerr_classification,
+                                       "default",
+                                       false,
+                                       refresh);
 }
 
 #endif
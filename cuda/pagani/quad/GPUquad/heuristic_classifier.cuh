@@ -76,13 +76,14 @@ void
 set_true_for_larger_than(const T* arr,
                          const T val,
                          const size_t size,
-                         T* output_flags)
+                         T* output_flags,
+                         cudaStream_t stream = 0)
 {
   size_t num_threads = 1024;
   size_t num_blocks = size / num_threads + (size % num_threads == 0 ? 0 : 1);
   device_set_true_for_larger_than<T>
-    <<<num_blocks, num_threads>>>(arr, val, size, output_flags);
-  cudaDeviceSynchronize();
+    <<<num_blocks, num_threads, 0, stream>>>(arr, val, size, output_flags);
+  cudaStreamSynchronize(stream);
   quad::CudaCheckError();
 }
 
@@ -155,13 +156,16 @@ class Heuristic_classifier {
   const size_t min_iters_for_convergence = 1;
   T max_percent_error_budget = .25;
   T max_active_regions_percentage = .5;
+  // the stream of the Workspace doing the classification
+  cudaStream_t stream = 0;
 
   friend class Classification_res<T>;
 
 public:
   Heuristic_classifier() = default;
 
-  Heuristic_classifier(T rel_tol, T abs_tol) : epsrel(rel_tol), epsabs(abs_tol)
+  Heuristic_classifier(T rel_tol, T abs_tol, cudaStream_t s = 0)
+    : epsrel(rel_tol), epsabs(abs_tol), stream(s)
   {
     required_digits = ceil(log10(1 / epsrel));
   }
@@ -290,9 +294,9 @@ public:
     };
 
     set_true_for_larger_than<T>(
-      errorests, res.threshold, num_regions, res.active_flags);
+      errorests, res.threshold, num_regions, res.active_flags, stream);
     res.num_active = static_cast<size_t>(
-      reduction<T, use_custom>(res.active_flags, num_regions));
+      reduction<T, use_custom>(res.active_flags, num_regions, stream));
     res.percent_mem_active = int_division(res.num_active, num_regions);
     // std::cout<<"res.num_active:"<< res.num_active << std::endl;
     // std::cout<<"res.percent_mem_active:"<<res.percent_mem_active<<std::endl;
@@ -315,8 +319,10 @@ public:
   {
 
     const T extra_f_errorest = active_errorest -
-                               dot_product<T, T, use_custom>(
-                                 error_estimates, active_flags, num_regions) -
+                               dot_product<T, T, use_custom>(error_estimates,
+                                                             active_flags,
+                                                             num_regions,
+                                                             stream) -
                                iter_finished_errorest;
     const T error_budget = target_error - total_f_errorest;
     res.pass_errorest_budget =
@@ -369,7 +375,7 @@ public:
   {
 
     Classification_res<T> thres_search =
-      (device_array_min_max<T, use_custom>(errorests, num_regions));
+      (device_array_min_max<T, use_custom>(errorests, num_regions, stream));
     thres_search.data_allocated = true;
 
     const T min_errorest = thres_search.threshold_range.low;
@@ -15,7 +15,8 @@ two_level_errorest_and_relerr_classify(
   const Region_estimates<T, ndim>& prev_iter_two_level_estimates,
   const Region_characteristics<ndim>& reg_classifiers,
   T epsrel,
-  bool relerr_classification = true)
+  bool relerr_classification = true,
+  cudaStream_t stream = 0)
 {
 
   size_t num_regions = current_iter_raw_estimates.size;
@@ -28,7 +29,7 @@ two_level_errorest_and_relerr_classify(
   }
 
   T* new_two_level_errorestimates = quad::cuda_malloc<T>(num_regions);
-  quad::RefineError<T><<<numBlocks, block_size>>>(
+  quad::RefineError<T><<<numBlocks, block_size, 0, stream>>>(
     current_iter_raw_estimates.integral_estimates,
     current_iter_raw_estimates.error_estimates,
     prev_iter_two_level_estimates.integral_estimates,
@@ -39,7 +40,7 @@ two_level_errorest_and_relerr_classify(
     epsrel,
     forbid_relerr_classification);
 
-  cudaDeviceSynchronize();
+  cudaStreamSynchronize(stream);
   cudaFree(current_iter_raw_estimates.error_estimates);
   current_iter_raw_estimates.error_estimates = new_two_level_errorestimates;
 }
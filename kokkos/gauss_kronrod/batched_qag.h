@@ -0,0 +1,512 @@
+#ifndef KOKKOS_GAUSS_KRONROD_BATCHED_QAG_H
+#define KOKKOS_GAUSS_KRONROD_BATCHED_QAG_H
+
+#include <Kokkos_Core.hpp>
+#include "common/integration_result.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+// Batched adaptive Gauss-Kronrod quadrature (QUADPACK's QAG) for many
+// independent 1D integrals. Every integral is handled by one thread of a
+// team, which keeps a max-heap of its subintervals ordered by error in
+// scratch memory and bisects the worst one until the summed error meets the
+// tolerance or the heap is full. The integrand evaluations of a rule are
+// spread over the vector lanes of the thread: SIMD lanes on host backends,
+// warp or sub-group lanes on GPUs.
+//
+// The integrand is a functor evaluated as f(i, x) for integral i, so one
+// launch can integrate a whole family of parametrized integrands.
+
+namespace gauss_kronrod {
+
+  enum class Rule { gk15, gk21 };
+
+  // abscissae and weights of the positive half of the rule, the centre last;
+  // gauss weights are 0 on the Kronrod-only nodes
+  template <Rule rule>
+  struct Rule_table;
+
+  template <>
+  struct Rule_table<Rule::gk15> {
+    static constexpr int num_nodes = 8;
+
+    KOKKOS_INLINE_FUNCTION static double
+    node(int j)
+    {
+      constexpr double x[num_nodes] = {0.991455371120812639206854697526329,
+                                       0.949107912342758524526189684047851,
+                                       0.864864423359769072789712788640926,
+                                       0.741531185599394439863864773280788,
+                                       0.586087235467691130294144845693013,
+                                       0.405845151377397166906606412076961,
+                                       0.207784955007898467600689403773245,
+                                       0.};
+      return x[j];
+    }
+
+    KOKKOS_INLINE_FUNCTION static double
+    kronrod_weight(int j)
+    {
+      constexpr double w[num_nodes] = {0.022935322010529224963732008058970,
+                                       0.063092092629978553290700663189204,
+                                       0.104790010322250183839876322541518,
+                                       0.140653259715525918745189590510238,
+                                       0.169004726639267902826583426598550,
+                                       0.190350578064785409913256402421014,
+                                       0.204432940075298892414161999234649,
+                                       0.209482141084727828012999174891714};
+      return w[j];
+    }
+
+    KOKKOS_INLINE_FUNCTION static double
+    gauss_weight(int j)
+    {
+      constexpr double w[num_nodes] = {0.,
+                                       0.129484966168869693270611432679082,
+                                       0.,
+                                       0.279705391489276667901467771423780,
+                                       0.,
+                                       0.381830050505118944950369775488975,
+                                       0.,
+                                       0.417959183673469387755102040816327};
+      return w[j];
+    }
+  };
+
+  template <>
+  struct Rule_table<Rule::gk21> {
+    static constexpr int num_nodes = 11;
+
+    KOKKOS_INLINE_FUNCTION static double
+    node(int j)
+    {
+      constexpr double x[num_nodes] = {0.995657163025808080735527280689003,
+                                       0.973906528517171720077964012084452,
+                                       0.930157491355708226001207180059508,
+                                       0.865063366688984510732096688423493,
+                                       0.780817726586416897063717578345042,
+                                       0.679409568299024406234327365114874,
+                                       0.562757134668604683339000099272694,
+                                       0.433395394129247190799265943165784,
+                                       0.294392862701460198131126603103866,
+                                       0.148874338981631210884826001129720,
+                                       0.};
+      return x[j];
+    }
+
+    KOKKOS_INLINE_FUNCTION static double
+    kronrod_weight(int j)
+    {
+      constexpr double w[num_nodes] = {0.011694638867371874278064396062192,
+                                       0.032558162307964727478818972459390,
+                                       0.054755896574351996031381300244580,
+                                       0.075039674810919952767043140916190,
+                                       0.093125454583697605535065465083366,
+                                       0.109387158802297641899210590325805,
+                                       0.123491976262065851077208245535000,
+                                       0.134709217311473325928054001771707,
+                                       0.142775938577060080797094273138717,
+                                       0.147739104901338491374841515972068,
+                                       0.149445554002916905664936468389821};
+      return w[j];
+    }
+
+    KOKKOS_INLINE_FUNCTION static double
+    gauss_weight(int j)
+    {
+      constexpr double w[num_nodes] = {0.,
+                                       0.066671344308688137593568809893332,
+                                       0.,
+                                       0.149451349150580593145776339657697,
+                                       0.,
+                                       0.219086362515982043995534934228163,
+                                       0.,
+                                       0.269266719309996355091226921569469,
+                                       0.,
+                                       0.295524224714752870173892994651338,
+                                       0.};
+      return w[j];
+    }
+  };
+
+  template <Rule rule>
+  constexpr int
+  evaluations_per_interval()
+  {
+    return 2 * Rule_table<rule>::num_nodes - 1;
+  }
+
+  struct Interval {
+    double low = 0.;
+    double high = 0.;
+    double estimate = 0.;
+    double errorest = 0.;
+  };
+
+  namespace detail {
+    using ExecSpace = Kokkos::DefaultExecutionSpace;
+    using member_type = Kokkos::TeamPolicy<ExecSpace>::member_type;
+    using Scratch_view =
+      Kokkos::View<double*,
+                   ExecSpace::scratch_memory_space,
+                   Kokkos::MemoryTraits<Kokkos::Unmanaged>>;
+
+    // max-heap on the error with interval k stored at data[4 * k]; the size
+    // is kept by the caller so that all vector lanes agree on it while only
+    // one of them writes
+    struct Interval_heap {
+      KOKKOS_INLINE_FUNCTION
+      Interval_heap(double* storage) : data(storage) {}
+
+      KOKKOS_INLINE_FUNCTION Interval
+      get(int k) const
+      {
+        Interval interval;
+        interval.low = data[4 * k];
+        interval.high = data[4 * k + 1];
+        interval.estimate = data[4 * k + 2];
+        interval.errorest = data[4 * k + 3];
+        return interval;
+      }
+
+      KOKKOS_INLINE_FUNCTION void
+      set(int k, const Interval& interval) const
+      {
+        data[4 * k] = interval.low;
+        data[4 * k + 1] = interval.high;
+        data[4 * k + 2] = interval.estimate;
+        data[4 * k + 3] = interval.errorest;
+      }
+
+      KOKKOS_INLINE_FUNCTION void
+      push(int size, const Interval& interval) const
+      {
+        int k = size;
+        while (k > 0) {
+          const int parent = (k - 1) / 2;
+          if (data[4 * parent + 3] >= interval.errorest)
+            break;
+          set(k, get(parent));
+          k = parent;
+        }
+        set(k, interval);
+      }
+
+      KOKKOS_INLINE_FUNCTION void
+      replace_top(int size, const Interval& interval) const
+      {
+        int k = 0;
+        while (true) {
+          int child = 2 * k + 1;
+          if (child >= size)
+            break;
+          if (child + 1 < size &&
+              data[4 * (child + 1) + 3] > data[4 * child + 3])
+            ++child;
+          if (data[4 * child + 3] <= interval.errorest)
+            break;
+          set(k, get(child));
+          k = child;
+        }
+        set(k, interval);
+      }
+
+      double* data;
+    };
+
+    // QUADPACK's qk15/qk21 on [low, high]. Each lane only reads back the
+    // function values it stored itself, and every lane gets the result.
+    template <Rule rule, typename F>
+    KOKKOS_INLINE_FUNCTION Interval
+    apply_rule(const member_type& team,
+               const F& f,
+               size_t integral,
+               double low,
+               double high,
+               double* fvals)
+    {
+      using Table = Rule_table<rule>;
+      constexpr int n = Table::num_nodes;
+      const double center = .5 * (low + high);
+      const double half_length = .5 * (high - low);
+      const double abs_half_length = fabs(half_length);
+
+      // f(center - h x_j) at j and f(center + h x_j) at n + j
+      double resk = 0.;
+      Kokkos::parallel_reduce(
+        Kokkos::ThreadVectorRange(team, n),
+        [&](const int j, double& sum) {
+          const double dx = half_length * Table::node(j);
+          const double fm = f(integral, center - dx);
+          const double fp = j == n - 1 ? 0. : f(integral, center + dx);
+          fvals[j] = fm;
+          fvals[n + j] = fp;
+          sum += Table::kronrod_weight(j) * (fm + fp);
+        },
+        resk);
+
+      double resg = 0.;
+      Kokkos::parallel_reduce(
+        Kokkos::ThreadVectorRange(team, n),
+        [&](const int j, double& sum) {
+          sum += Table::gauss_weight(j) * (fvals[j] + fvals[n + j]);
+        },
+        resg);
+
+      double resabs = 0.;
+      Kokkos::parallel_reduce(
+        Kokkos::ThreadVectorRange(team, n),
+        [&](const int j, double& sum) {
+          sum +=
+            Table::kronrod_weight(j) * (fabs(fvals[j]) + fabs(fvals[n + j]));
+        },
+        resabs);
+
+      const double mean = .5 * resk;
+      double resasc = 0.;
+      Kokkos::parallel_reduce(
+        Kokkos::ThreadVectorRange(team, n),
+        [&](const int j, double& sum) {
+          const double deviation = j == n - 1 ?
+                                     fabs(fvals[j] - mean) :
+                                     fabs(fvals[j] - mean) +
+                                       fabs(fvals[n + j] - mean);
+          sum += Table::kronrod_weight(j) * deviation;
+        },
+        resasc);
+
+      constexpr double epmach = std::numeric_limits<double>::epsilon();
+      constexpr double uflow = std::numeric_limits<double>::min();
+      resabs *= abs_half_length;
+      resasc *= abs_half_length;
+      double abserr = fabs((resk - resg) * half_length);
+      if (resasc != 0. && abserr != 0.)
+        abserr = resasc * fmin(1., pow(200. * abserr / resasc, 1.5));
+      if (resabs > uflow / (50. * epmach))
+        abserr = fmax(epmach * 50. * resabs, abserr);
+
+      Interval interval;
+      interval.low = low;
+      interval.high = high;
+      interval.estimate = resk * half_length;
+      interval.errorest = abserr;
+      return interval;
+    }
+
+    // one integral per team thread, the rule evaluations over its lanes
+    template <Rule rule, typename F>
+    struct Qag_kernel {
+      using Bounds =
+        Kokkos::View<const double*, typename ExecSpace::memory_space>;
+      using Results = Kokkos::View<numint::integration_result*,
+                                   typename ExecSpace::memory_space>;
+
+      KOKKOS_INLINE_FUNCTION void
+      operator()(const member_type& team) const
+      {
+        const size_t i =
+          static_cast<size_t>(team.league_rank()) * team.team_size() +
+          team.team_rank();
+        if (i >= lows.extent(0))
+          return;
+
+        Scratch_view storage(team.thread_scratch(scratch_level),
+                             4 * capacity + 2 * Rule_table<rule>::num_nodes);
+        Interval_heap heap(storage.data());
+        double* fvals = storage.data() + 4 * capacity;
+
+        const Interval whole =
+          apply_rule<rule>(team, f, i, lows(i), highs(i), fvals);
+        Kokkos::single(Kokkos::PerThread(team), [&]() { heap.push(0, whole); });
+        double area = whole.estimate;
+        double errsum = whole.errorest;
+        int size = 1;
+        size_t iters = 0;
+
+        while (errsum > fmax(epsabs, epsrel * fabs(area)) && size < capacity) {
+          Interval worst;
+          Kokkos::single(
+            Kokkos::PerThread(team),
+            [&](Interval& top) { top = heap.get(0); },
+            worst);
+
+          // no room left between the floating point endpoints
+          const double mid = .5 * (worst.low + worst.high);
+          if (!(worst.low < mid && mid < worst.high))
+            break;
+
+          const Interval left =
+            apply_rule<rule>(team, f, i, worst.low, mid, fvals);
+          const Interval right =
+            apply_rule<rule>(team, f, i, mid, worst.high, fvals);
+          area += left.estimate + right.estimate - worst.estimate;
+          errsum += left.errorest + right.errorest - worst.errorest;
+
+          Kokkos::single(Kokkos::PerThread(team), [&]() {
+            heap.replace_top(size, left);
+            heap.push(size, right);
+          });
+          ++size;
+          ++iters;
+        }
+
+        // the running sums drift, add the heap up again
+        Kokkos::single(Kokkos::PerThread(team), [&]() {
+          double estimate = 0.;
+          double errorest = 0.;
+          for (int k = 0; k < size; ++k) {
+            estimate += heap.data[4 * k + 2];
+            errorest += heap.data[4 * k + 3];
+          }
+          numint::integration_result result;
+          result.estimate = estimate;
+          result.errorest = errorest;
+          result.nregions = size;
+          result.iters = iters;
+          result.neval = (2 * iters + 1) * evaluations_per_interval<rule>();
+          result.status =
+            errorest <= fmax(epsabs, epsrel * fabs(estimate)) ? 0 : 1;
+          results(i) = result;
+        });
+      }
+
+      F f;
+      Bounds lows;
+      Bounds highs;
+      Results results;
+      double epsrel;
+      double epsabs;
+      int capacity;
+      int scratch_level;
+    };
+  }
+
+  // QAG for a batch of integrals on one execution space instance. limit
+  // bounds the number of subintervals of each integral; integrals_per_team
+  // is a hint, clamped to what the backend accepts. The integrand is called
+  // as f(i, x) for integral i.
+  template <Rule rule = Rule::gk21>
+  class Batched_qag {
+  public:
+    using ExecSpace = detail::ExecSpace;
+    using memory_space = ExecSpace::memory_space;
+    using Bounds = Kokkos::View<const double*, memory_space>;
+    using Results = Kokkos::View<numint::integration_result*, memory_space>;
+
+    explicit Batched_qag(int limit = 64,
+                         int integrals_per_team = 8,
+                         const ExecSpace& space = ExecSpace())
+      : limit(limit), integrals_per_team(integrals_per_team), space(space)
+    {
+      if (limit < 1 || integrals_per_team < 1)
+        throw std::invalid_argument(
+          "Batched_qag needs a positive limit and team size");
+    }
+
+    // asynchronous on the instance, fence it before reading the results
+    template <typename F>
+    void integrate(F const& f,
+                   Bounds lows,
+                   Bounds highs,
+                   double epsrel,
+                   double epsabs,
+                   Results results) const;
+
+    template <typename F>
+    std::vector<numint::integration_result> integrate(
+      F const& f,
+      std::vector<double> const& lows,
+      std::vector<double> const& highs,
+      double epsrel,
+      double epsabs) const;
+
+  private:
+    int limit;
+    int integrals_per_team;
+    ExecSpace space;
+  };
+}
+
+template <gauss_kronrod::Rule rule>
+template <typename F>
+void
+gauss_kronrod::Batched_qag<rule>::integrate(F const& f,
+                                            Bounds lows,
+                                            Bounds highs,
+                                            double epsrel,
+                                            double epsabs,
+                                            Results results) const
+{
+  using Policy = Kokkos::TeamPolicy<ExecSpace>;
+  const size_t num_integrals = lows.extent(0);
+  if (highs.extent(0) != num_integrals || results.extent(0) < num_integrals)
+    throw std::invalid_argument("Batched_qag: mismatched batch sizes");
+  if (num_integrals == 0)
+    return;
+
+  detail::Qag_kernel<rule, F> kernel{
+    f, lows, highs, results, epsrel, epsabs, limit, 0};
+  const size_t scratch_bytes = detail::Scratch_view::shmem_size(
+    4 * limit + 2 * Rule_table<rule>::num_nodes);
+  const int vector_length = std::min(16, Policy::vector_length_max());
+
+  Policy probe(space, 1, 1, vector_length);
+  const int max_team_size =
+    probe.set_scratch_size(0, Kokkos::PerThread(scratch_bytes))
+      .team_size_max(kernel, Kokkos::ParallelForTag());
+  const int team_size =
+    std::max(1, std::min(integrals_per_team, max_team_size));
+
+  // heaps that do not fit in team shared memory go to global scratch
+  if (team_size * scratch_bytes > Policy::scratch_size_max(0))
+    kernel.scratch_level = 1;
+
+  const size_t num_teams = (num_integrals + team_size - 1) / team_size;
+  Policy policy(space, num_teams, team_size, vector_length);
+  Kokkos::parallel_for(
+    "batched_qag",
+    policy.set_scratch_size(kernel.scratch_level,
+                            Kokkos::PerThread(scratch_bytes)),
+    kernel);
+}
+
+template <gauss_kronrod::Rule rule>
+template <typename F>
+std::vector<numint::integration_result>
+gauss_kronrod::Batched_qag<rule>::integrate(F const& f,
+                                            std::vector<double> const& lows,
+                                            std::vector<double> const& highs,
+                                            double epsrel,
+                                            double epsabs) const
+{
+  if (lows.size() != highs.size())
+    throw std::invalid_argument("Batched_qag: mismatched batch sizes");
+
+  using Host_bounds =
+    Kokkos::View<const double*, Kokkos::HostSpace, Kokkos::MemoryUnmanaged>;
+  const size_t num_integrals = lows.size();
+  Kokkos::View<double*, memory_space> d_lows(
+    Kokkos::view_alloc(space, "lows"), num_integrals);
+  Kokkos::View<double*, memory_space> d_highs(
+    Kokkos::view_alloc(space, "highs"), num_integrals);
+  Kokkos::deep_copy(space, d_lows, Host_bounds(lows.data(), num_integrals));
+  Kokkos::deep_copy(space, d_highs, Host_bounds(highs.data(), num_integrals));
+
+  Results d_results(Kokkos::view_alloc(space, "results"), num_integrals);
+  integrate(f, d_lows, d_highs, epsrel, epsabs, d_results);
+
+  std::vector<numint::integration_result> results(num_integrals);
+  Kokkos::View<numint::integration_result*,
+               Kokkos::HostSpace,
+               Kokkos::MemoryUnmanaged>
+    h_results(results.data(), num_integrals);
+  Kokkos::deep_copy(space, h_results, d_results);
+  space.fence();
+  return results;
+}
+
+#endif
@@ -3,8 +3,9 @@
 code works for gaussian and sin using switch statement. device pointerr/template
 slow down the code by 2x
 
-chunksize needs to be tuned based on the ncalls. For now hardwired using a
-switch statement
+chunksize needs to be tuned based on the ncalls. The default is hardwired
+using a switch statement, passing a numint::mcubes_tuning_cache to vegas()
+picks chunk and team sizes by calibration instead
 
 nvcc -O2 -DCUSTOM -o vegas vegas_mcubes.cu -arch=sm_70
 OR
@@ -39,11 +40,16 @@ Last three arguments are: total iterations, iteration
 #define CUSTOM
 #define BLOCK_DIM_X 128
 
+#include <algorithm>
 #include <chrono>
 #include "common/kokkos/cudaMemoryUtil.h"
 #include "common/kokkos/cudaApply.cuh"
 #include "common/kokkos/Volume.cuh"
 #include "common/integration_result.hh"
+#include "common/mcubes_tuning.hh"
+#include "common/vegas_grid.hh"
+#include <string>
+#include <typeinfo>
 
 namespace kokkos_mcubes {
 
@@ -118,7 +124,7 @@ public:
   Kokkos::View<FuncEval<NDIM>*, Kokkos::CudaUVMSpace> funcevals;
   Kokkos::View<double*, Kokkos::CudaUVMSpace> randoms;
 
-  IterDataLogger(uint32_t totalNumThreads,
+  IterDataLogger(size_t totalNumThreads,
                  int chunkSize,
                  int extra,
                  int npg,
@@ -205,14 +211,14 @@ public:
   }
 
   void
-  PrintRandomNums(int it, int ncubes, int npg, int ndim)
+  PrintRandomNums(int it, size_t ncubes, int npg, int ndim)
   {
 
     size_t nums_per_cube = npg * ndim;
     size_t nums_per_sample = ndim;
 
 
-    for (int cube = 0; cube < ncubes; cube++)
+    for (size_t cube = 0; cube < ncubes; cube++)
       for (int sample = 1; sample <= npg; sample++)
         for (int dim = 1; dim <= ndim; dim++) {
 
@@ -228,11 +234,11 @@ public:
   }
 
   void
-  PrintFuncEvals(int it, int ncubes, int npg, int ndim)
+  PrintFuncEvals(int it, size_t ncubes, int npg, int ndim)
   {
-    for (int cube = 0; cube < ncubes; cube++)
+    for (size_t cube = 0; cube < ncubes; cube++)
       for (int sample = 0; sample < npg; sample++) {
-        int index = npg * cube + sample;
+        size_t index = npg * cube + sample;
         myfile_funcevals << it << "," 
                         << cube << "," 
                         << sample << ","
@@ -247,7 +253,7 @@ public:
   void
   PrintIntervals(int ndim,
                  int ng,
-                 uint32_t totalNumThreads,
+                 size_t totalNumThreads,
                  int chunkSize,
                  int it)
   {
@@ -256,7 +262,7 @@ public:
     if(it == 1)
         interval_myfile<<"m, kg[1], kg[2], kg[3], it\n";
 
-    for(uint32_t m = 0; m < totalNumThreads; m++){
+    for(size_t m = 0; m < totalNumThreads; m++){
         uint32_t kg[mxdim_p1];
         get_indx(m , &kg[1], ndim, ng);
 
@@ -330,35 +336,39 @@ public:
   int npg = 0;
   uint32_t nBlocks = 0;
   uint32_t nThreads = 0;
-  uint32_t totalNumThreads = 0;
-  uint32_t totalCubes = 0;
+  size_t totalNumThreads = 0;
+  size_t totalCubes = 0;
   int extra = 0;
   int LastChunk = 0; // how many chunks for the last thread
 
-  Kernel_Params(double ncall, int chunkSize, int ndim)
+  Kernel_Params(double ncall,
+                int chunkSize,
+                int ndim,
+                int teamSize = BLOCK_DIM_X)
   {
     ncubes = ComputeNcubes(ncall, ndim);
     npg = Compute_samples_per_cube(ncall, ncubes);
 
-    totalNumThreads = (uint32_t)((ncubes) / chunkSize);
+    totalNumThreads = (size_t)((ncubes) / chunkSize);
     totalCubes = totalNumThreads * chunkSize;
     extra = totalCubes - ncubes;
     LastChunk = chunkSize - extra;
-    nBlocks = totalNumThreads % BLOCK_DIM_X == 0 ?
-                totalNumThreads / BLOCK_DIM_X :
-                totalNumThreads / BLOCK_DIM_X + 1;
-    nThreads = BLOCK_DIM_X;
+    nBlocks = totalNumThreads % teamSize == 0 ?
+                totalNumThreads / teamSize :
+                totalNumThreads / teamSize + 1;
+    nThreads = teamSize;
   }
 };
 
+  // decodes the 64-bit cube index ms into its 1-based per-axis intervals
   KOKKOS_INLINE_FUNCTION void
-  get_indx(uint32_t ms, uint32_t* da, int ND, int NINTV)
+  get_indx(size_t ms, uint32_t* da, int ND, int NINTV)
   {
     // called like :    get_indx(m * chunkSize, &kg[1], ndim, ng);
-    uint32_t dp[Internal_Vegas_Params::get_MXDIM()];
-    uint32_t t0, t1;
+    size_t dp[Internal_Vegas_Params::get_MXDIM()];
+    size_t t0, t1;
     int j;
-    uint32_t m = ms;
+    size_t m = ms;
     dp[0] = 1;
     dp[1] = NINTV;
 
@@ -597,7 +607,7 @@ GetChunkSize(const double ncall)
                       ViewVectorDouble d,
                       double& fb,
                       double& f2b,
-                      uint32_t cube_id,
+                      size_t cube_id,
                       FuncEval<ndim>* funcevals = nullptr)
   {
     constexpr int mxdim_p1 = Internal_Vegas_Params::get_MXDIM_p1();
@@ -666,7 +676,7 @@ GetChunkSize(const double ncall)
     for (int t = 0; t < chunkSize; t++) {
       double fb = 0.,
              f2b = 0.0; // init to zero for each interval processed by thread
-      uint32_t cube_id = cube_id_offset + t;
+      size_t cube_id = cube_id_offset + t;
 
       if constexpr (kokkos_mcubes::TypeChecker<
                       GeneratorType,
@@ -731,7 +741,7 @@ GetChunkSize(const double ncall)
                       ViewVectorDouble dx,
                       ViewVectorDouble regn,
                       int _chunkSize,
-                      uint32_t totalNumThreads,
+                      size_t totalNumThreads,
                       int LastChunk,
                       unsigned int seed_init,
                       FuncEval<ndim>* funcevals = nullptr)
@@ -744,8 +754,10 @@ GetChunkSize(const double ncall)
         //ScratchViewDouble sh_buff(team_member.team_scratch(0), 2 * nThreads);
         constexpr int mxdim_p1 = Internal_Vegas_Params::get_MXDIM_p1();
         uint32_t tx = team_member.team_rank(); // local id
-        uint32_t m = team_member.league_rank() * team_member.team_size() +
-                     tx; // global thread id
+        const size_t m =
+          static_cast<size_t>(team_member.league_rank()) *
+            team_member.team_size() +
+          tx; // global thread id
 
         uint32_t kg[mxdim_p1];
         int ia[mxdim_p1];
@@ -754,9 +766,7 @@ GetChunkSize(const double ncall)
 
         if (m < totalNumThreads) {
 
-          size_t cube_id_offset =
-            (team_member.league_rank() * team_member.team_size() + tx) *
-            chunkSize;
+          size_t cube_id_offset = m * chunkSize;
 
           if (m == totalNumThreads - 1)
             chunkSize = LastChunk;
@@ -816,7 +826,7 @@ GetChunkSize(const double ncall)
                        ViewVectorDouble dx,
                        ViewVectorDouble regn,
                        int _chunkSize,
-                       uint32_t totalNumThreads,
+                       size_t totalNumThreads,
                        int LastChunk,
                        unsigned int seed_init,
                        FuncEval<ndim>* funcevals)
@@ -834,8 +844,10 @@ GetChunkSize(const double ncall)
        // ScratchViewDouble sh_buff(team_member.team_scratch(0), 2 * nThreads);
 
         uint32_t tx = team_member.team_rank();
-        uint32_t m =
-          team_member.league_rank() * team_member.team_size() + tx; // global thread id
+        const size_t m =
+          static_cast<size_t>(team_member.league_rank()) *
+            team_member.team_size() +
+          tx; // global thread id
 
         double fb, f2b, wgt, xn, xo, rc, f, f2, ran00;
         uint32_t kg[mxdim_p1];
@@ -846,7 +858,7 @@ GetChunkSize(const double ncall)
 
         if (m < totalNumThreads) {
 
-          size_t cube_id_offset = (team_member.league_rank() * team_member.team_size() +  tx) * chunkSize;
+          size_t cube_id_offset = m * chunkSize;
 
           if (m == totalNumThreads - 1)
             chunkSize = LastChunk;
@@ -944,6 +956,95 @@ GetChunkSize(const double ncall)
       });
   }
 
+  // Autotuner for the launch geometry. A cache hit is used as is. On a miss
+  // with autotuning enabled, every candidate (chunk size, team size) times
+  // vegas_kernel_kokkosF on the current grid over a prefix of the cubes,
+  // a sixteenth of them but no fewer than 2^16, so that the whole sweep
+  // costs about three passes instead of one per candidate; the fastest is
+  // stored. Team sizes are capped by team_size_max. Without a usable entry
+  // the built-in heuristic is returned. Only the CUDA backend is tuned: the
+  // grid, results and integrand are CUDA space views, so mcubes does not run
+  // under OpenMP and the candidates are GPU chunk and block sizes.
+  template <typename IntegT, int ndim, typename GeneratorType>
+  numint::mcubes_launch_config
+  tuned_launch(numint::mcubes_tuning_cache& cache,
+               Kokkos::View<IntegT*, Kokkos::CudaUVMSpace> integrand,
+               double ncall,
+               size_t ncubes,
+               int ng,
+               int npg,
+               double xjac,
+               double dxg,
+               ViewVectorDouble result_dev,
+               double xnd,
+               ViewVectorDouble xi,
+               ViewVectorDouble dx,
+               ViewVectorDouble regn)
+  {
+    using ExecSpace = Kokkos::DefaultExecutionSpace;
+    const std::string key = numint::mcubes_tuning_cache::key(
+      typeid(IntegT).name(),
+      ndim,
+      ncall,
+      ExecSpace::name(),
+      std::to_string(ExecSpace().concurrency()));
+
+    numint::mcubes_launch_config best{GetChunkSize(ncall), BLOCK_DIM_X};
+    if (cache.lookup(key, best) || !cache.autotune)
+      return best;
+
+    auto probe = KOKKOS_LAMBDA(const member_type&){};
+    const int max_team_size =
+      team_policy(1, Kokkos::AUTO)
+        .team_size_max(probe, Kokkos::ParallelForTag());
+
+    const size_t calibration_cubes =
+      std::min(ncubes, std::max(ncubes / 16, size_t{1} << 16));
+    double best_time = -1.;
+    for (int chunkSize : {1, 4, 16, 32, 128, 512, 2048, 4096}) {
+      if (static_cast<size_t>(chunkSize) > calibration_cubes)
+        break;
+      const size_t totalNumThreads = calibration_cubes / chunkSize;
+      const int LastChunk =
+        calibration_cubes - totalNumThreads * chunkSize + chunkSize;
+
+      for (int teamSize : {1, 32, 64, 128, 256, 512}) {
+        if (teamSize > max_team_size)
+          break;
+        const uint32_t nBlocks = (totalNumThreads + teamSize - 1) / teamSize;
+        Kokkos::fence();
+        auto start = std::chrono::high_resolution_clock::now();
+        vegas_kernel_kokkosF<IntegT, ndim, GeneratorType>(integrand,
+                                                          nBlocks,
+                                                          teamSize,
+                                                          ng,
+                                                          npg,
+                                                          xjac,
+                                                          dxg,
+                                                          result_dev,
+                                                          xnd,
+                                                          xi,
+                                                          dx,
+                                                          regn,
+                                                          chunkSize,
+                                                          totalNumThreads,
+                                                          LastChunk,
+                                                          1,
+                                                          nullptr);
+        Kokkos::fence();
+        MilliSeconds elapsed =
+          std::chrono::high_resolution_clock::now() - start;
+        if (best_time < 0. || elapsed.count() < best_time) {
+          best_time = elapsed.count();
+          best = {chunkSize, teamSize};
+        }
+      }
+    }
+
+    cache.store(key, best);
+    return best;
+  }
+
   void
   rebin(double rc, int nd, double* r, double* xin, double* xi)
   {
@@ -984,7 +1085,10 @@ GetChunkSize(const double ncall)
         int titer,
         int itmax,
         int skip,
-        quad::Volume<double, ndim> const* vol)
+        quad::Volume<double, ndim> const* vol,
+        numint::vegas_grid* grid = nullptr,
+        bool reuse_statistics = false,
+        numint::mcubes_tuning_cache* tuning = nullptr)
   {
 
     auto t0 = std::chrono::high_resolution_clock::now();
@@ -996,7 +1100,8 @@ GetChunkSize(const double ncall)
     Kokkos::View<IntegT*, Kokkos::CudaUVMSpace> d_integrand("d_integrand", 1);
     d_integrand(0) = integrand;
 
-    int i, it, j, k, nd, ndo, ng, npg, ncubes;
+    int i, it, j, nd, ndo, ng, npg;
+    size_t k, ncubes;
     double calls, dv2g, dxg, rc, ti, tsi, wgt, xjac, xn, xnd, xo;
     double schi, si, swgt;
 
@@ -1071,18 +1176,51 @@ GetChunkSize(const double ncall)
       rebin(ndo / xnd, nd, r, xin, xi.data() + (j * (ndmx_p1)));
     }
 
+    // start from a previously adapted grid instead of the uniform one
+    size_t prior_iters = 0;
+    const size_t iters_at_start = *iters;
+    if (grid != nullptr && !grid->empty()) {
+      if (grid->ndim != ndim || grid->nbins != nd) {
+        throw std::invalid_argument(
+          "vegas grid does not match the number of dimensions or bins");
+      }
+      grid->export_to(xi.data(), ndmx_p1);
+      if (reuse_statistics) {
+        si = grid->si;
+        swgt = grid->swgt;
+        schi = grid->schi;
+        prior_iters = grid->iters;
+      }
+    }
+
     ndo = nd;
     Kokkos::deep_copy(d_dx, dx);
     Kokkos::deep_copy(d_regn, regn);
 
-    int chunkSize = GetChunkSize(ncall);
+    numint::mcubes_launch_config launch{GetChunkSize(ncall), BLOCK_DIM_X};
+    if (tuning != nullptr) {
+      deep_copy(d_xi, xi);
+      launch = tuned_launch<IntegT, ndim, GeneratorType>(*tuning,
+                                                         d_integrand,
+                                                         ncall,
+                                                         ncubes,
+                                                         ng,
+                                                         npg,
+                                                         xjac,
+                                                         dxg,
+                                                         d_result,
+                                                         xnd,
+                                                         d_xi,
+                                                         d_dx,
+                                                         d_regn);
+    }
+    int chunkSize = launch.chunk_size;
 
-    uint32_t totalNumThreads =
-      (uint32_t)((ncubes) / chunkSize);
-    uint32_t totalCubes = totalNumThreads * chunkSize; // even-split cubes
+    size_t totalNumThreads = ncubes / chunkSize;
+    size_t totalCubes = totalNumThreads * chunkSize; // even-split cubes
     int extra = ncubes - totalCubes;                   // left-over cubes
     int LastChunk = extra + chunkSize; // last chunk of last thread
-    Kernel_Params params(ncall, chunkSize, ndim);
+    Kernel_Params params(ncall, chunkSize, ndim, launch.team_size);
     
     IterDataLogger<DEBUG_MCUBES, ndim> data_collector(
       totalNumThreads, chunkSize, extra, npg, ndim);
@@ -1137,7 +1275,7 @@ GetChunkSize(const double ncall)
         schi += wgt * ti * ti;
         swgt += wgt;
         *tgral = si / swgt;
-        *chi2a = (schi - si * (*tgral)) / (it - 0.9999);
+        *chi2a = (schi - si * (*tgral)) / (it + prior_iters - 0.9999);
         if (*chi2a < 0.0)
           *chi2a = 0.0;
         *sd = sqrt(1.0 / swgt);
@@ -1229,7 +1367,7 @@ GetChunkSize(const double ncall)
       schi += wgt * ti * ti;
       swgt += wgt;
       *tgral = si / swgt;
-      *chi2a = (schi - si * (*tgral)) / (it - 0.9999);
+      *chi2a = (schi - si * (*tgral)) / (it + prior_iters - 0.9999);
 
       if (*chi2a < 0.0)
         *chi2a = 0.0;
@@ -1239,6 +1377,14 @@ GetChunkSize(const double ncall)
       *status = GetStatus(*tgral, *sd, it, epsrel, epsabs);
     } // end of iterations
 
+    if (grid != nullptr) {
+      grid->import_from(xi.data(), ndim, nd, ndmx_p1);
+      grid->si = si;
+      grid->swgt = swgt;
+      grid->schi = schi;
+      grid->iters = prior_iters + (*iters - iters_at_start);
+    }
+
     free(dt);
     free(r);
     free(xin);
@@ -1257,7 +1403,10 @@ GetChunkSize(const double ncall)
             quad::Volume<double, NDIM> const* volume,
             int totalIters = 15,
             int adjustIters = 15,
-            int skipIters = 5)
+            int skipIters = 5,
+            numint::vegas_grid* grid = nullptr,
+            bool reuse_statistics = false,
+            numint::mcubes_tuning_cache* tuning = nullptr)
   {
 
     numint::integration_result result;
@@ -1274,7 +1423,10 @@ GetChunkSize(const double ncall)
                                        totalIters,
                                        adjustIters,
                                        skipIters,
-                                       volume);
+                                       volume,
+                                       grid,
+                                       reuse_statistics,
+                                       tuning);
     return result;
   }
 
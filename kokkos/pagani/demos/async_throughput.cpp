@@ -0,0 +1,116 @@
+#include "kokkos/pagani/quad/GPUquad/Workspace.cuh"
+#include "common/integration_scheduler.hh"
+#include "common/kokkos/integrands.cuh"
+#include "common/kokkos/Volume.cuh"
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Throughput of a batch of small integrations run one after the other
+// versus through an integration_scheduler, each slot of which owns a
+// workspace on its own instance of the default execution space. The batch
+// alternates a gaussian peak and a sum of sines at two tolerances, the kind
+// of mix seen when scanning a parameter space.
+//
+//   ./kokkos_pagani_async_throughput [num integrals] [max in flight]
+
+namespace {
+  constexpr int ndim = 5;
+  using Pagani = Workspace<double, ndim, true>;
+  using MilliSeconds =
+    std::chrono::duration<double, std::chrono::milliseconds::period>;
+
+  double
+  tolerance(int job)
+  {
+    return job % 4 < 2 ? 1.e-3 : 1.e-4;
+  }
+
+  numint::integration_result
+  run_job(Pagani& workspace, int job)
+  {
+    quad::Volume<double, ndim> vol;
+    if (job % 2 == 0)
+      return workspace.integrate(F_4_5D(), tolerance(job), 1.e-20, vol);
+    return workspace.integrate(SinSum_5D(), tolerance(job), 1.e-20, vol);
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  const int num_jobs = argc > 1 ? std::atoi(argv[1]) : 32;
+  const int max_in_flight = argc > 2 ? std::atoi(argv[2]) : 4;
+
+  Kokkos::initialize();
+  {
+    std::vector<numint::integration_result> sequential(num_jobs);
+    auto t0 = std::chrono::high_resolution_clock::now();
+    {
+      Pagani workspace;
+      for (int job = 0; job < num_jobs; ++job)
+        sequential[job] = run_job(workspace, job);
+      Kokkos::fence();
+    }
+    MilliSeconds const sequential_time =
+      std::chrono::high_resolution_clock::now() - t0;
+
+    auto instances = Kokkos::Experimental::partition_space(
+      Kokkos::DefaultExecutionSpace(), std::vector<int>(max_in_flight, 1));
+    std::vector<std::unique_ptr<Pagani>> workspaces;
+    for (auto const& instance : instances)
+      workspaces.push_back(std::make_unique<Pagani>(instance));
+
+    std::mutex print_mutex;
+    int finished = 0;
+    std::vector<std::future<numint::integration_result>> results;
+    t0 = std::chrono::high_resolution_clock::now();
+    {
+      numint::integration_scheduler scheduler(max_in_flight);
+      for (int job = 0; job < num_jobs; ++job)
+        results.push_back(scheduler.submit(
+          [&workspaces, job](size_t slot) {
+            return run_job(*workspaces[slot], job);
+          },
+          [&print_mutex, &finished](numint::integration_result const&) {
+            std::lock_guard<std::mutex> lock(print_mutex);
+            ++finished;
+          }));
+      scheduler.wait();
+    }
+    MilliSeconds const scheduled_time =
+      std::chrono::high_resolution_clock::now() - t0;
+
+    std::cout << "job, integrand, epsrel, estimate, errorest, nregions\n";
+    std::cout << std::setprecision(15);
+    int mismatches = 0;
+    for (int job = 0; job < num_jobs; ++job) {
+      auto const res = results[job].get();
+      if (res.status != sequential[job].status ||
+          res.nregions != sequential[job].nregions)
+        ++mismatches;
+      std::cout << job << ", " << (job % 2 == 0 ? "F_4_5D" : "SinSum_5D")
+                << ", " << tolerance(job) << ", " << res.estimate << ", "
+                << res.errorest << ", " << res.nregions << "\n";
+    }
+
+    std::cout << "completed callbacks: " << finished << "\n";
+    std::cout << "sequential: " << sequential_time.count() << " ms, "
+              << num_jobs / (sequential_time.count() * 1.e-3)
+              << " integrals/s\n";
+    std::cout << "scheduled (" << max_in_flight
+              << " in flight): " << scheduled_time.count() << " ms, "
+              << num_jobs / (scheduled_time.count() * 1.e-3)
+              << " integrals/s\n";
+    std::cout << "speedup: " << sequential_time.count() / scheduled_time.count()
+              << ", runs differing from the sequential ones: " << mismatches
+              << "\n";
+  }
+  Kokkos::finalize();
+  return 0;
+}
@@ -0,0 +1,71 @@
+#include "kokkos/pagani/quad/GPUquad/Distributed_workspace.cuh"
+#include "common/kokkos/Volume.cuh"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+// Strong scaling of the distributed workspace: run with a varying number of
+// ranks, e.g. mpirun -np 4 ./kokkos_pagani_distributed_scaling
+
+class GENZ_4_5D {
+public:
+  KOKKOS_INLINE_FUNCTION double
+  operator()(double x, double y, double z, double w, double v)
+  {
+    double beta = .5;
+    return exp(-1.0 *
+               (pow(25, 2) * pow(x - beta, 2) + pow(25, 2) * pow(y - beta, 2) +
+                pow(25, 2) * pow(z - beta, 2) + pow(25, 2) * pow(w - beta, 2) +
+                pow(25, 2) * pow(v - beta, 2)));
+  }
+};
+
+int
+main(int argc, char** argv)
+{
+  MPI_Init(&argc, &argv);
+  Kokkos::initialize(argc, argv);
+  {
+    using MilliSeconds =
+      std::chrono::duration<double, std::chrono::milliseconds::period>;
+    constexpr int ndim = 5;
+    constexpr bool use_custom = true;
+    double constexpr epsabs = 1.0e-20;
+    double const true_value = 1.79132603674879e-06;
+    GENZ_4_5D integrand;
+    quad::Volume<double, ndim> vol;
+
+    int rank = 0, num_ranks = 1;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_ranks);
+
+    if (rank == 0)
+      std::cout << "id, ranks, epsrel, estimate, errorest, true_value, "
+                   "nregions, iters, rebalances, status, time"
+                << std::endl;
+
+    for (double epsrel = 1.e-3; epsrel >= 1.e-7; epsrel /= 5.) {
+      Distributed_workspace<double, ndim, use_custom> workspace;
+      MPI_Barrier(MPI_COMM_WORLD);
+      auto const t0 = std::chrono::high_resolution_clock::now();
+      numint::integration_result result =
+        workspace.integrate(integrand, epsrel, epsabs, vol);
+      MPI_Barrier(MPI_COMM_WORLD);
+      MilliSeconds dt = std::chrono::high_resolution_clock::now() - t0;
+
+      if (rank == 0)
+        std::cout << std::scientific << std::setprecision(15) << "f4_5D,"
+                  << num_ranks << "," << epsrel << "," << result.estimate
+                  << "," << result.errorest << "," << true_value << ","
+                  << result.nregions << "," << result.iters << ","
+                  << workspace.num_rebalances << "," << result.status << ","
+                  << dt.count() << std::endl;
+
+      if (result.status != 0)
+        break;
+    }
+  }
+  Kokkos::finalize();
+  MPI_Finalize();
+  return 0;
+}
@@ -0,0 +1,127 @@
+#include "kokkos/pagani/quad/GPUquad/Workspace.cuh"
+#include "kokkos/pagani/quad/GPUquad/Launch_policy.cuh"
+#include "common/kokkos/Volume.cuh"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+// Calibrates the Pagani launch policy of the default execution space. For
+// each ndim the team sizes of the phases are searched one phase at a time,
+// the others fixed at the best values so far, timing full integrations of a
+// gaussian peak. The winners are stored in the config file, which Workspace
+// users read with Launch_policy::load.
+//
+//   ./kokkos_pagani_tune_launch_policy [config file] [epsrel]
+
+class Gaussian_peak {
+public:
+  template <typename... Args>
+  KOKKOS_INLINE_FUNCTION double
+  operator()(Args... x)
+  {
+    const double sum = ((100. * (x - .5) * (x - .5)) + ...);
+    return exp(-sum);
+  }
+};
+
+template <int ndim>
+double
+time_integration(pagani::Launch_policy const& policy, double epsrel)
+{
+  using MilliSeconds =
+    std::chrono::duration<double, std::chrono::milliseconds::period>;
+  constexpr int num_repeats = 3;
+  quad::Volume<double, ndim> vol;
+  Gaussian_peak integrand;
+  double best = std::numeric_limits<double>::max();
+
+  for (int i = 0; i < num_repeats; ++i) {
+    Workspace<double, ndim, true> workspace(policy);
+    auto const t0 = std::chrono::high_resolution_clock::now();
+    workspace.integrate(integrand, epsrel, 1.e-20, vol);
+    Kokkos::fence();
+    MilliSeconds dt = std::chrono::high_resolution_clock::now() - t0;
+    best = std::min(best, dt.count());
+  }
+  return best;
+}
+
+template <int ndim>
+pagani::Launch_policy
+tune(double epsrel, std::vector<int> const& team_sizes)
+{
+  struct Phase {
+    const char* name;
+    int pagani::Launch_policy::*size;
+    std::vector<int> candidates;
+  };
+
+  std::vector<Phase> const phases = {
+    {"cubature", &pagani::Launch_policy::cubature, {32, 64, 128, 256}},
+    {"refine_error", &pagani::Launch_policy::refine_error, team_sizes},
+    {"filter", &pagani::Launch_policy::filter, team_sizes},
+    {"split", &pagani::Launch_policy::split, team_sizes},
+    {"reset_chunk",
+     &pagani::Launch_policy::reset_chunk,
+     {64, 256, 1024, 4096}}};
+
+  pagani::Launch_policy best;
+  double best_time = time_integration<ndim>(best, epsrel);
+
+  for (Phase const& phase : phases) {
+    for (int candidate : phase.candidates) {
+      pagani::Launch_policy policy = best;
+      policy.*phase.size = candidate;
+      const double time = time_integration<ndim>(policy, epsrel);
+      std::cout << ndim << "," << phase.name << "," << candidate << ","
+                << time << std::endl;
+      if (time < best_time) {
+        best_time = time;
+        best = policy;
+      }
+    }
+  }
+  return best;
+}
+
+template <int ndim>
+void
+tune_and_save(std::string const& filename,
+              double epsrel,
+              std::vector<int> const& team_sizes)
+{
+  pagani::Launch_policy policy = tune<ndim>(epsrel, team_sizes);
+  policy.save(filename, ndim);
+}
+
+int
+main(int argc, char** argv)
+{
+  Kokkos::initialize(argc, argv);
+  {
+    const std::string filename = argc > 1 ? argv[1] : "pagani_launch.cfg";
+    const double epsrel = argc > 2 ? std::stod(argv[2]) : 1.e-6;
+
+    // team sizes beyond what the backend accepts would be clamped to the
+    // same launch, skip them
+    const int max_team_size = Kokkos::TeamPolicy<>(1, 1).team_size_max(
+      KOKKOS_LAMBDA(const member_type&){}, Kokkos::ParallelForTag());
+    std::vector<int> team_sizes;
+    for (int size : {1, 16, 32, 64, 128, 256, 512})
+      if (size <= max_team_size)
+        team_sizes.push_back(size);
+
+    std::cout << "ndim, phase, size, time" << std::endl;
+    tune_and_save<3>(filename, epsrel, team_sizes);
+    tune_and_save<5>(filename, epsrel, team_sizes);
+    tune_and_save<8>(filename, epsrel, team_sizes);
+    std::cout << "launch policies for "
+              << Kokkos::DefaultExecutionSpace::name() << " written to "
+              << filename << std::endl;
+  }
+  Kokkos::finalize();
+  return 0;
+}
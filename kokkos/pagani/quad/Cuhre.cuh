@@ -5,7 +5,10 @@
 #include "kokkos/pagani/quad/Rule.cuh"
 #include "kokkos/pagani/quad/quad.h"
 #include "common/integration_result.hh"
+#include "common/capture.hh"
+#include <algorithm>
 #include <array>
+#include <memory>
 #include "common/kokkos/cudaMemoryUtil.h"
 
 template <typename T, int NDIM>
@@ -21,6 +24,8 @@ public:
   size_t fEvalPerRegion;
   Structures<T> constMem;
   Rule<double> rule;
+  std::shared_ptr<numint::capture_writer> capture;
+  size_t max_captured_regions = 0;
 
   // Cuhre() = default;
 
@@ -36,7 +41,9 @@ public:
     Kokkos::Profiling::popRegion();
   }
 
-  // reconsider this mechanism for generating output data
+  // copies the estimates and bounds of the first numToStore regions to the
+  // host buffers after Integrate; capture_to does not need buffers sized by
+  // the caller
   Cuhre(double* hostRegionsIntegral,
         double* hostRegionsError,
         double* hostRegions,
@@ -59,40 +66,84 @@ public:
     rule.Init(NDIM, fEvalPerRegion, key, verbose, &constMem);
   }
 
+  // writes the regions Integrate ends with to filename, at most
+  // options.regions of them; evaluations are not captured on this path
+  void
+  capture_to(const std::string& filename,
+             const numint::capture_options& options = {})
+  {
+    capture.reset();
+    capture = std::make_shared<numint::capture_writer>(filename, NDIM);
+    max_captured_regions = options.regions;
+  }
+
+  void
+  stop_capture()
+  {
+    capture.reset();
+  }
+
+  // copies count entries of src from first on to the host, so that only
+  // what is kept crosses over
+  static void
+  copy_to_host(ViewVectorDouble src, size_t first, size_t count, double* dst)
+  {
+    Kokkos::View<double*,
+                 Kokkos::HostSpace,
+                 Kokkos::MemoryTraits<Kokkos::Unmanaged>>
+      host(dst, count);
+    Kokkos::deep_copy(
+      host, Kokkos::subview(src, std::make_pair(first, first + count)));
+  }
+
   void
   GenerateSubRegionOutput(ViewVectorDouble dRegionsIntegral,
                           ViewVectorDouble dRegionsError,
                           ViewVectorDouble dRegions,
                           ViewVectorDouble dRegionsLength)
   {
-    if (output == false)
-      return;
-
-    ViewVectorDouble::HostMirror RegionsIntegral =
-      Kokkos::create_mirror_view(dRegionsIntegral);
-    ViewVectorDouble::HostMirror RegionsError =
-      Kokkos::create_mirror_view(dRegionsError);
-    ViewVectorDouble::HostMirror Regions = Kokkos::create_mirror_view(dRegions);
-    ViewVectorDouble::HostMirror RegionsLength =
-      Kokkos::create_mirror_view(dRegionsLength);
-
-    Kokkos::deep_copy(RegionsIntegral, dRegionsIntegral);
-    Kokkos::deep_copy(RegionsError, dRegionsError);
-    Kokkos::deep_copy(Regions, dRegions);
-    Kokkos::deep_copy(RegionsLength, dRegionsLength);
-
-    for (size_t regID = 0; regID < numOutputRegions; regID++) {
-      OutputRegionsIntegral[regID] = RegionsIntegral(regID);
-      OutputRegionsError[regID] = RegionsError(regID);
-      // printf("Storing at cpu side:%.15f +- %.15f\n", RegionsIntegral(regID),
-      // RegionsError(regID));
+    const size_t numRegions = dRegionsIntegral.extent(0);
+    if (output) {
+      const size_t count = std::min(numOutputRegions, numRegions);
+      copy_to_host(dRegionsIntegral, 0, count, OutputRegionsIntegral);
+      copy_to_host(dRegionsError, 0, count, OutputRegionsError);
+      for (size_t dim = 0; dim < NDIM; ++dim) {
+        copy_to_host(
+          dRegions, dim * numRegions, count, OutputRegions + dim * count);
+        copy_to_host(dRegionsLength,
+                     dim * numRegions,
+                     count,
+                     OutputRegionsLength + dim * count);
+      }
     }
 
-    for (size_t index = 0; index < numOutputRegions * NDIM; index++) {
-      OutputRegions[index] = Regions(index);
-      OutputRegionsLength[index] = RegionsLength(index);
-      // printf("Storing at cpu side:%.15f +- %.15f\n", Regions(index),
-      // RegionsLength(index));
+    if (capture) {
+      const size_t count = std::min(max_captured_regions, numRegions);
+      std::vector<double> lows(NDIM * count), highs(NDIM * count);
+      std::vector<double> estimates(count), errorests(count);
+      copy_to_host(dRegionsIntegral, 0, count, estimates.data());
+      copy_to_host(dRegionsError, 0, count, errorests.data());
+      for (size_t dim = 0; dim < NDIM; ++dim) {
+        copy_to_host(dRegions, dim * numRegions, count, &lows[dim * count]);
+        copy_to_host(
+          dRegionsLength, dim * numRegions, count, &highs[dim * count]);
+      }
+      for (size_t i = 0; i < highs.size(); ++i)
+        highs[i] += lows[i];
+
+      numint::capture_block block;
+      block.kind = numint::capture_kind::regions;
+      block.count = count;
+      block.dropped = numRegions - count;
+      for (const std::vector<double>* bounds : {&lows, &highs})
+        for (size_t dim = 0; dim < NDIM; ++dim)
+          block.columns.push_back(
+            {bounds->data() + dim * count, sizeof(double)});
+      block.columns.push_back({estimates.data(), sizeof(double)});
+      block.columns.push_back({errorests.data(), sizeof(double)});
+      capture->submit(std::move(block));
+      // the columns live on this stack frame
+      capture->flush();
     }
   }
 
@@ -0,0 +1,265 @@
+#ifndef KOKKOS_DISTRIBUTED_WORKSPACE_CUH
+#define KOKKOS_DISTRIBUTED_WORKSPACE_CUH
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "kokkos/pagani/quad/GPUquad/Workspace.cuh"
+#include "common/mpi_utils.hh"
+
+// Pagani over the ranks of an MPI communicator. Every rank owns a shard of the
+// sub-regions and runs the refinement loop of Workspace on it, with a reducer
+// that sums iteration estimates, finished estimates, region counts and the
+// statistics of the threshold classification over all ranks, so every rank
+// takes the same decisions and returns the same result. Active regions are
+// moved between ranks after filtering, before they are split, to keep the
+// shards even.
+//
+// Regions travel through host buffers and land in the memory space of the
+// execution space the workspace is bound to.
+template <typename T,
+          size_t ndim,
+          bool use_custom = false,
+          pagani::Cubature_rule rule = pagani::Cubature_rule::degree9>
+class Distributed_workspace
+  : private Workspace<T, ndim, use_custom, false, rule, quad::Mpi_reducer> {
+  using Base = Workspace<T, ndim, use_custom, false, rule, quad::Mpi_reducer>;
+  using Estimates = Region_estimates<T, ndim>;
+  using Sub_regs = Sub_regions<T, ndim>;
+  using Regs_characteristics = Region_characteristics<ndim>;
+  using memory_space = ExecSpace::memory_space;
+
+  // left coordinates and lengths, parent integral and error estimate, and
+  // sub-dividing dimension, all sent as doubles
+  static constexpr size_t record_size = 2 * ndim + 3;
+
+private:
+  void keep_share(Sub_regs& subregions);
+  void rebalance(Sub_regs& subregions,
+                 Regs_characteristics& characteristics,
+                 Estimates& parent_ests);
+
+public:
+  // shards are rebalanced once the largest exceeds the even share by more
+  // than this fraction
+  T rebalance_tolerance = .1;
+  size_t num_rebalances = 0;
+
+  explicit Distributed_workspace(MPI_Comm comm = MPI_COMM_WORLD)
+    : Base(quad::Mpi_reducer(comm))
+  {}
+
+  // every rank has to use the same settings
+  using Base::execution_space;
+  using Base::launch_policy;
+  using Base::set_launch_policy;
+  using Base::set_local_refinement_threshold;
+  using Base::set_memory_budget;
+
+  template <typename IntegT, int debug = 0>
+  numint::integration_result integrate(const IntegT& integrand,
+                                       T epsrel,
+                                       T epsabs,
+                                       quad::Volume<T, ndim> const& vol,
+                                       bool relerr_classification = true);
+};
+
+template <typename T, size_t ndim, bool use_custom, pagani::Cubature_rule rule>
+void
+Distributed_workspace<T, ndim, use_custom, rule>::keep_share(
+  Sub_regs& subregions)
+{
+  const ExecSpace& space = this->execution_space();
+  const size_t total = subregions.size;
+  const size_t num_ranks = static_cast<size_t>(this->reducer.num_ranks);
+  const size_t rank = static_cast<size_t>(this->reducer.rank);
+  const size_t first = rank * total / num_ranks;
+  const size_t share = (rank + 1) * total / num_ranks - first;
+
+  auto left = Kokkos::create_mirror_view_and_copy(
+    Kokkos::HostSpace(), subregions.flat_left_coord(space));
+  auto length = Kokkos::create_mirror_view_and_copy(
+    Kokkos::HostSpace(), subregions.flat_length(space));
+  Kokkos::View<T*, Kokkos::HostSpace> h_share_left("share_left", share * ndim);
+  Kokkos::View<T*, Kokkos::HostSpace> h_share_length("share_length",
+                                                     share * ndim);
+
+  for (size_t dim = 0; dim < ndim; ++dim) {
+    for (size_t i = 0; i < share; ++i) {
+      h_share_left(dim * share + i) = left(dim * total + first + i);
+      h_share_length(dim * share + i) = length(dim * total + first + i);
+    }
+  }
+
+  subregions.assign(
+    Kokkos::create_mirror_view_and_copy(memory_space(), h_share_left),
+    Kokkos::create_mirror_view_and_copy(memory_space(), h_share_length),
+    share);
+}
+
+template <typename T, size_t ndim, bool use_custom, pagani::Cubature_rule rule>
+void
+Distributed_workspace<T, ndim, use_custom, rule>::rebalance(
+  Sub_regs& subregions,
+  Regs_characteristics& characteristics,
+  Estimates& parent_ests)
+{
+  const quad::Mpi_reducer& reducer = this->reducer;
+  const size_t num_ranks = static_cast<size_t>(reducer.num_ranks);
+  const size_t rank = static_cast<size_t>(reducer.rank);
+  const size_t n = subregions.size;
+  const std::vector<size_t> counts = reducer.allgather(n);
+
+  size_t total = 0;
+  for (size_t count : counts)
+    total += count;
+  const size_t largest = *std::max_element(counts.begin(), counts.end());
+  const T even_share = std::ceil(static_cast<T>(total) / num_ranks);
+
+  if (total == 0 || largest <= (1. + rebalance_tolerance) * even_share)
+    return;
+
+  // counts and displacements are in records; every rank sees the same
+  // counts, so either all of them throw or none does
+  if (std::max(largest, static_cast<size_t>(even_share)) >
+      static_cast<size_t>(std::numeric_limits<int>::max()))
+    throw std::overflow_error(
+      "Distributed_workspace: shard too large for an MPI exchange");
+
+  // regions keep their position in the global list, the ranks just own
+  // different contiguous pieces of it afterwards
+  std::vector<size_t> offset(num_ranks + 1, 0);
+  std::vector<size_t> target_offset(num_ranks + 1, 0);
+  for (size_t r = 0; r < num_ranks; ++r) {
+    offset[r + 1] = offset[r] + counts[r];
+    target_offset[r + 1] = (r + 1) * total / num_ranks;
+  }
+  const size_t m = target_offset[rank + 1] - target_offset[rank];
+
+  auto overlap = [](size_t b1, size_t e1, size_t b2, size_t e2) {
+    const size_t b = std::max(b1, b2);
+    const size_t e = std::min(e1, e2);
+    return e > b ? e - b : 0;
+  };
+
+  std::vector<int> send_counts(num_ranks), send_displs(num_ranks);
+  std::vector<int> recv_counts(num_ranks), recv_displs(num_ranks);
+  for (size_t r = 0, send_at = 0, recv_at = 0; r < num_ranks; ++r) {
+    const size_t to_send = overlap(
+      offset[rank], offset[rank + 1], target_offset[r], target_offset[r + 1]);
+    const size_t to_recv = overlap(
+      offset[r], offset[r + 1], target_offset[rank], target_offset[rank + 1]);
+    send_counts[r] = static_cast<int>(to_send);
+    send_displs[r] = static_cast<int>(send_at);
+    recv_counts[r] = static_cast<int>(to_recv);
+    recv_displs[r] = static_cast<int>(recv_at);
+    send_at += to_send;
+    recv_at += to_recv;
+  }
+
+  const ExecSpace& space = this->execution_space();
+  std::vector<double> send_buf(n * record_size);
+  if (n > 0) {
+    auto left = Kokkos::create_mirror_view_and_copy(
+      Kokkos::HostSpace(), subregions.flat_left_coord(space));
+    auto length = Kokkos::create_mirror_view_and_copy(
+      Kokkos::HostSpace(), subregions.flat_length(space));
+    auto integrals = Kokkos::create_mirror_view_and_copy(
+      Kokkos::HostSpace(), parent_ests.integral_estimates);
+    auto errors = Kokkos::create_mirror_view_and_copy(
+      Kokkos::HostSpace(), parent_ests.error_estimates);
+    auto split_dims = Kokkos::create_mirror_view_and_copy(
+      Kokkos::HostSpace(), characteristics.sub_dividing_dim);
+
+    for (size_t i = 0; i < n; ++i) {
+      double* record = send_buf.data() + i * record_size;
+      for (size_t dim = 0; dim < ndim; ++dim) {
+        record[dim] = left(dim * n + i);
+        record[ndim + dim] = length(dim * n + i);
+      }
+      record[2 * ndim] = integrals(i);
+      record[2 * ndim + 1] = errors(i);
+      record[2 * ndim + 2] = static_cast<double>(split_dims(i));
+    }
+  }
+
+  MPI_Datatype region_record;
+  MPI_Type_contiguous(
+    static_cast<int>(record_size), MPI_DOUBLE, &region_record);
+  MPI_Type_commit(&region_record);
+  std::vector<double> recv_buf(m * record_size);
+  MPI_Alltoallv(send_buf.data(),
+                send_counts.data(),
+                send_displs.data(),
+                region_record,
+                recv_buf.data(),
+                recv_counts.data(),
+                recv_displs.data(),
+                region_record,
+                reducer.comm);
+  MPI_Type_free(&region_record);
+
+  Kokkos::View<T*, Kokkos::HostSpace> h_left("left", m * ndim);
+  Kokkos::View<T*, Kokkos::HostSpace> h_length("length", m * ndim);
+  Kokkos::View<T*, Kokkos::HostSpace> h_integrals("integrals", m);
+  Kokkos::View<T*, Kokkos::HostSpace> h_errors("errors", m);
+  Kokkos::View<int*, Kokkos::HostSpace> h_split_dims("split_dims", m);
+
+  for (size_t i = 0; i < m; ++i) {
+    const double* record = recv_buf.data() + i * record_size;
+    for (size_t dim = 0; dim < ndim; ++dim) {
+      h_left(dim * m + i) = record[dim];
+      h_length(dim * m + i) = record[ndim + dim];
+    }
+    h_integrals(i) = record[2 * ndim];
+    h_errors(i) = record[2 * ndim + 1];
+    h_split_dims(i) = static_cast<int>(record[2 * ndim + 2]);
+  }
+
+  subregions.assign(
+    Kokkos::create_mirror_view_and_copy(memory_space(), h_left),
+    Kokkos::create_mirror_view_and_copy(memory_space(), h_length),
+    m);
+  parent_ests.integral_estimates =
+    Kokkos::create_mirror_view_and_copy(memory_space(), h_integrals);
+  parent_ests.error_estimates =
+    Kokkos::create_mirror_view_and_copy(memory_space(), h_errors);
+  parent_ests.size = m;
+  characteristics.sub_dividing_dim =
+    Kokkos::create_mirror_view_and_copy(memory_space(), h_split_dims);
+  characteristics.size = m;
+  num_rebalances++;
+}
+
+template <typename T, size_t ndim, bool use_custom, pagani::Cubature_rule rule>
+template <typename IntegT, int debug>
+numint::integration_result
+Distributed_workspace<T, ndim, use_custom, rule>::integrate(
+  const IntegT& integrand,
+  T epsrel,
+  T epsabs,
+  quad::Volume<T, ndim> const& vol,
+  bool relerr_classification)
+{
+  Sub_regs subregions;
+  this->initial_partition(subregions);
+  keep_share(subregions);
+  num_rebalances = 0;
+
+  return this->template refine<IntegT, false, debug>(
+    integrand,
+    subregions,
+    epsrel,
+    epsabs,
+    vol,
+    relerr_classification,
+    [this](Sub_regs& regions,
+           Regs_characteristics& characteristics,
+           Estimates& parent_ests) {
+      rebalance(regions, characteristics, parent_ests);
+    });
+}
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef KOKKOS_PAGANI_LAUNCH_POLICY_CUH
+#define KOKKOS_PAGANI_LAUNCH_POLICY_CUH
+
+#include "common/kokkos/cudaMemoryUtil.h"
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace pagani {
+
+  // Launch geometry of the Pagani phases. cubature is the team size of the
+  // region sampling kernel, one team per region; refine_error, filter and
+  // split are the team sizes of the per-region bookkeeping kernels, one
+  // thread per region; reset_chunk is the chunk size of the range loop that
+  // re-activates regions on an error budget overflow. The defaults are the
+  // values Pagani was tuned with on a V100.
+  //
+  // Policies are kept in a text file with one line per backend and ndim:
+  //   backend ndim cubature refine_error filter split reset_chunk
+  // see kokkos/pagani/demos/tune_launch_policy.cpp for the calibration.
+  struct Launch_policy {
+    int cubature = 64;
+    int refine_error = 64;
+    int filter = 64;
+    int split = 64;
+    int reset_chunk = 256;
+
+    bool
+    valid() const
+    {
+      return cubature > 0 && refine_error > 0 && filter > 0 && split > 0 &&
+             reset_chunk > 0;
+    }
+
+    // replaces the defaults with the entry for (backend, ndim) if the file
+    // has one; a missing file or entry leaves the policy untouched
+    bool load(std::string const& filename,
+              size_t ndim,
+              std::string const& backend =
+                Kokkos::DefaultExecutionSpace::name());
+
+    // adds or replaces the entry for (backend, ndim), keeping the others
+    void save(std::string const& filename,
+              size_t ndim,
+              std::string const& backend =
+                Kokkos::DefaultExecutionSpace::name()) const;
+  };
+
+  namespace detail {
+    using Launch_policy_entries =
+      std::map<std::pair<std::string, size_t>, Launch_policy>;
+
+    inline Launch_policy_entries
+    read_launch_policies(std::string const& filename)
+    {
+      Launch_policy_entries entries;
+      std::ifstream in(filename);
+      std::string line;
+      while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string backend;
+        size_t ndim = 0;
+        Launch_policy policy;
+        if (fields >> backend >> ndim >> policy.cubature >>
+              policy.refine_error >> policy.filter >> policy.split >>
+              policy.reset_chunk &&
+            policy.valid())
+          entries[{backend, ndim}] = policy;
+      }
+      return entries;
+    }
+
+    template <typename Policy, typename Functor>
+    void
+    launch_region_teams(std::string const& label,
+                        size_t num_regions,
+                        int team_size,
+                        Functor const& functor,
+                        const ExecSpace& space)
+    {
+      auto probe = KOKKOS_LAMBDA(const member_type& team_member)
+      {
+        functor(team_member, 1);
+      };
+      const int max_size =
+        Policy(1, 1).team_size_max(probe, Kokkos::ParallelForTag());
+      const int size = std::max(1, std::min(team_size, max_size));
+      const size_t num_teams = (num_regions + size - 1) / size;
+      auto policy = Kokkos::Experimental::require(
+        Policy(space, num_teams, size),
+        Kokkos::Experimental::WorkItemProperty::HintLightWeight);
+
+      Kokkos::parallel_for(
+        label, policy, KOKKOS_LAMBDA(const member_type& team_member) {
+          functor(team_member, size);
+        });
+    }
+  }
+
+  // one thread per region in teams of team_size threads, clamped to what the
+  // backend accepts; functor gets the team member and the actual team size.
+  // Teams within the launch bounds the kernels were written for keep them.
+  template <typename Functor>
+  void
+  parallel_for_regions(std::string const& label,
+                       size_t num_regions,
+                       int team_size,
+                       Functor const& functor,
+                       const ExecSpace& space = ExecSpace())
+  {
+    if (num_regions == 0)
+      return;
+
+    if (team_size <= 64)
+      detail::launch_region_teams<
+        Kokkos::TeamPolicy<Kokkos::LaunchBounds<64, 18>>>(
+        label, num_regions, team_size, functor, space);
+    else
+      detail::launch_region_teams<Kokkos::TeamPolicy<>>(
+        label, num_regions, team_size, functor, space);
+  }
+}
+
+inline bool
+pagani::Launch_policy::load(std::string const& filename,
+                            size_t ndim,
+                            std::string const& backend)
+{
+  auto const entries = detail::read_launch_policies(filename);
+  auto entry = entries.find({backend, ndim});
+  if (entry == entries.end())
+    return false;
+  *this = entry->second;
+  return true;
+}
+
+inline void
+pagani::Launch_policy::save(std::string const& filename,
+                            size_t ndim,
+                            std::string const& backend) const
+{
+  auto entries = detail::read_launch_policies(filename);
+  entries[{backend, ndim}] = *this;
+
+  std::ofstream out(filename, std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error("cannot open " + filename + " for writing");
+  }
+
+  for (auto const& [key, policy] : entries)
+    out << key.first << ' ' << key.second << ' ' << policy.cubature << ' '
+        << policy.refine_error << ' ' << policy.filter << ' ' << policy.split
+        << ' ' << policy.reset_chunk << '\n';
+
+  if (!out) {
+    throw std::runtime_error("failed to write launch policies to " +
+                             filename);
+  }
+}
+
+#endif
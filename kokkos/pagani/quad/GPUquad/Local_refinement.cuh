@@ -0,0 +1,317 @@
+#ifndef KOKKOS_LOCAL_REFINEMENT_CUH
+#define KOKKOS_LOCAL_REFINEMENT_CUH
+
+#include "kokkos/pagani/quad/quad.h"
+#include "kokkos/pagani/quad/GPUquad/Sub_regions.cuh"
+#include "kokkos/pagani/quad/GPUquad/Region_estimates.cuh"
+#include "common/kokkos/cudaApply.cuh"
+#include "common/kokkos/cudaMemoryUtil.h"
+#include "common/kokkos/thrust_utils.cuh"
+#include "common/integration_result.hh"
+
+// Second phase for the tail of a run: every team takes one of the remaining
+// regions and refines it on its own, Cuhre style, with a heap of
+// sub-regions in scratch memory. A team bisects its worst sub-region until
+// the errors of its leaves fit in the region's share of the error budget or
+// the heap is full. The result has status 1 when a team ran out of heap
+// before meeting its share, the caller then goes on with global refinement.
+//
+// Like the rest of the Kokkos Pagani this runs on the CUDA backend only. The
+// kernel sticks to team policies and level 0 scratch, but the regions,
+// generators and results it touches are CudaSpace views, so it does not run
+// under OpenMP or another host backend.
+
+namespace quad {
+
+  // per-team region heap, regions stored as slot * ndim + dim
+  template <typename T,
+            size_t ndim,
+            pagani::Cubature_rule rule = pagani::Cubature_rule::degree9>
+  struct Local_heap {
+    KOKKOS_INLINE_FUNCTION
+    Local_heap(const member_type& team, int heap_capacity)
+      : lows(team.team_scratch(0), heap_capacity * ndim)
+      , lengths(team.team_scratch(0), heap_capacity * ndim)
+      , estimates(team.team_scratch(0), heap_capacity)
+      , errors(team.team_scratch(0), heap_capacity)
+      , fevals(team.team_scratch(0),
+               pagani::CuhreFuncEvalsPerRegion<ndim, rule>())
+      , bisectdims(team.team_scratch(0), heap_capacity)
+      , capacity(heap_capacity)
+    {}
+
+    static size_t
+    shmem_size(int heap_capacity)
+    {
+      return 2 * ScratchViewDouble::shmem_size(heap_capacity * ndim) +
+             2 * ScratchViewDouble::shmem_size(heap_capacity) +
+             ScratchViewDouble::shmem_size(
+               pagani::CuhreFuncEvalsPerRegion<ndim, rule>()) +
+             ScratchViewInt::shmem_size(heap_capacity);
+    }
+
+    ScratchViewDouble lows;
+    ScratchViewDouble lengths;
+    ScratchViewDouble estimates;
+    ScratchViewDouble errors;
+    ScratchViewDouble fevals;
+    ScratchViewInt bisectdims;
+    int capacity;
+  };
+
+  // largest heap that fits in level 0 scratch, at most max_capacity regions
+  template <typename T,
+            size_t ndim,
+            pagani::Cubature_rule rule = pagani::Cubature_rule::degree9>
+  int
+  local_heap_capacity(int max_capacity = 512)
+  {
+    const size_t scratch_bytes = team_policy::scratch_size_max(0);
+    int capacity = max_capacity;
+    while (capacity > 2 &&
+           Local_heap<T, ndim, rule>::shmem_size(capacity) > scratch_bytes)
+      capacity /= 2;
+    return capacity;
+  }
+
+  // team-collective evaluation of the cubature rule on heap slot
+  template <typename IntegT,
+            typename T,
+            size_t ndim,
+            pagani::Cubature_rule rule = pagani::Cubature_rule::degree9>
+  KOKKOS_INLINE_FUNCTION void
+  team_sample_region(IntegT* d_integrand,
+                     const Structures<T>& constMem,
+                     const T* generators,
+                     const T* global_lows,
+                     const T* global_highs,
+                     Local_heap<T, ndim, rule>& heap,
+                     int slot,
+                     const member_type& team)
+  {
+    constexpr int feval = pagani::CuhreFuncEvalsPerRegion<ndim, rule>();
+    T jacobian = 1.;
+    T vol = 1.;
+    for (size_t dim = 0; dim < ndim; ++dim) {
+      jacobian *= global_highs[dim] - global_lows[dim];
+      vol *= heap.lengths(slot * ndim + dim);
+    }
+
+    Kokkos::parallel_for(
+      Kokkos::TeamThreadRange(team, feval), [&](const int pIndex) {
+        gpu::cudaArray<T, ndim> x;
+        for (size_t dim = 0; dim < ndim; ++dim) {
+          const T generator = generators[feval * dim + pIndex];
+          const T low = heap.lows(slot * ndim + dim);
+          const T high = low + heap.lengths(slot * ndim + dim);
+          x[dim] = global_lows[dim] +
+                   ((.5 + generator) * low + (.5 - generator) * high) *
+                     (global_highs[dim] - global_lows[dim]);
+        }
+        heap.fevals(pIndex) = gpu::apply(*d_integrand, x) * jacobian;
+      });
+    team.team_barrier();
+
+    T sum[NRULES];
+    for (int rul = 0; rul < NRULES; ++rul) {
+      Kokkos::parallel_reduce(
+        Kokkos::TeamThreadRange(team, feval),
+        [&](const int pIndex, T& lsum) {
+          const int gIndex = constMem.gpuGenPermGIndex(pIndex);
+          lsum += heap.fevals(pIndex) * constMem.cRuleWt(gIndex * NRULES + rul);
+        },
+        sum[rul]);
+    }
+
+    Kokkos::single(Kokkos::PerTeam(team), [&]() {
+      // fourth differences pick the axis of the next bisection
+      const T g_ratio = constMem.gpuG(2 * ndim) / constMem.gpuG(1 * ndim);
+      const T ratio = g_ratio * g_ratio;
+      const T base = heap.fevals(0) * 2 * (1 - ratio);
+      constexpr int offset = 2 * ndim;
+      int bisectdim = 0;
+      T max_range = 0.;
+      for (size_t dim = 0; dim < ndim; ++dim) {
+        if (heap.lengths(slot * ndim + dim) > max_range) {
+          max_range = heap.lengths(slot * ndim + dim);
+          bisectdim = dim;
+        }
+      }
+
+      T maxdiff = 0.;
+      for (size_t dim = 0; dim < ndim; ++dim) {
+        const int fp = 1 + 2 * dim;
+        const int fm = fp + 1;
+        const T fourthdiff =
+          fabs(base + ratio * (heap.fevals(fp) + heap.fevals(fm)) -
+               (heap.fevals(fp + offset) + heap.fevals(fm + offset)));
+        if (fourthdiff > maxdiff) {
+          maxdiff = fourthdiff;
+          bisectdim = dim;
+        }
+      }
+
+      heap.bisectdims(slot) = bisectdim;
+      heap.estimates(slot) = vol * sum[0];
+      if constexpr (pagani::uses_degree7<ndim, rule>()) {
+        heap.errors(slot) = vol * fabs(sum[1]);
+        return;
+      }
+
+      T errs[NRULES];
+      for (int rul = 1; rul < NRULES - 1; ++rul) {
+        T maxerr = 0.;
+        constexpr int NSETS = 9;
+        for (int s = 0; s < NSETS; ++s) {
+          maxerr = fmax(maxerr,
+                        fabs(sum[rul + 1] +
+                             constMem.GPUScale(s * NRULES + rul) * sum[rul]) *
+                          constMem.GPUNorm(s * NRULES + rul));
+        }
+        errs[rul] = maxerr;
+      }
+
+      const T errcoeff[3] = {5., 1., 5.};
+      heap.errors(slot) =
+        vol * ((errcoeff[0] * errs[1] <= errs[2] &&
+                errcoeff[0] * errs[2] <= errs[3]) ?
+                 errcoeff[1] * errs[1] :
+                 errcoeff[2] * fmax(fmax(errs[1], errs[2]), errs[3]));
+    });
+    team.team_barrier();
+  }
+
+  template <typename IntegT,
+            typename T,
+            size_t ndim,
+            pagani::Cubature_rule rule = pagani::Cubature_rule::degree9>
+  numint::integration_result
+  team_local_refinement(IntegT* d_integrand,
+                        const Structures<T>& constMem,
+                        ViewVectorDouble generators,
+                        ViewVectorDouble global_lows,
+                        ViewVectorDouble global_highs,
+                        const Sub_regions<T, ndim>& subregions,
+                        T budget_per_region,
+                        const ExecSpace& space = ExecSpace(),
+                        int max_capacity = 512)
+  {
+    const size_t num_regions = subregions.size;
+    numint::integration_result res;
+    if (num_regions == 0)
+      return res;
+
+    Region_estimates<T, ndim> estimates(num_regions, space);
+    ViewVectorInt leaves = quad::cuda_malloc<int>(num_regions, space);
+    ViewVectorInt unconverged = quad::cuda_malloc<int>(num_regions, space);
+    const int capacity = local_heap_capacity<T, ndim, rule>(max_capacity);
+    pagani::Region_pages<T, ndim> regions = subregions.coords;
+    ViewVectorDouble integrals = estimates.integral_estimates;
+    ViewVectorDouble errors = estimates.error_estimates;
+
+    team_policy policy(space, num_regions, Kokkos::AUTO);
+    Kokkos::parallel_for(
+      "Local_refinement",
+      policy.set_scratch_size(
+        0, Kokkos::PerTeam(Local_heap<T, ndim, rule>::shmem_size(capacity))),
+      KOKKOS_LAMBDA(const member_type& team) {
+        const int region = team.league_rank();
+        Local_heap<T, ndim, rule> heap(team, capacity);
+
+        Kokkos::parallel_for(
+          Kokkos::TeamThreadRange(team, static_cast<int>(ndim)),
+          [&](const int dim) {
+            heap.lows(dim) = regions.left(region, dim);
+            heap.lengths(dim) = regions.length(region, dim);
+          });
+        team.team_barrier();
+
+        team_sample_region<IntegT, T, ndim, rule>(d_integrand,
+                                                  constMem,
+                                                  generators.data(),
+                                                  global_lows.data(),
+                                                  global_highs.data(),
+                                                  heap,
+                                                  0,
+                                                  team);
+        int size = 1;
+
+        while (true) {
+          int worst = -1;
+          Kokkos::single(
+            Kokkos::PerTeam(team),
+            [&](int& next) {
+              T errorest = 0.;
+              T max_err = -1.;
+              next = -1;
+              for (int slot = 0; slot < size; ++slot) {
+                errorest += heap.errors(slot);
+                if (heap.errors(slot) > max_err) {
+                  max_err = heap.errors(slot);
+                  next = slot;
+                }
+              }
+              if (errorest <= budget_per_region || size == capacity)
+                next = -1;
+            },
+            worst);
+
+          if (worst < 0)
+            break;
+
+          // the worst region keeps its lower half, the upper half is appended
+          Kokkos::single(Kokkos::PerTeam(team), [&]() {
+            const int dim = heap.bisectdims(worst);
+            for (size_t d = 0; d < ndim; ++d) {
+              heap.lows(size * ndim + d) = heap.lows(worst * ndim + d);
+              heap.lengths(size * ndim + d) = heap.lengths(worst * ndim + d);
+            }
+            const T half = .5 * heap.lengths(worst * ndim + dim);
+            heap.lengths(worst * ndim + dim) = half;
+            heap.lengths(size * ndim + dim) = half;
+            heap.lows(size * ndim + dim) += half;
+          });
+          team.team_barrier();
+
+          team_sample_region<IntegT, T, ndim, rule>(d_integrand,
+                                                    constMem,
+                                                    generators.data(),
+                                                    global_lows.data(),
+                                                    global_highs.data(),
+                                                    heap,
+                                                    worst,
+                                                    team);
+          team_sample_region<IntegT, T, ndim, rule>(d_integrand,
+                                                    constMem,
+                                                    generators.data(),
+                                                    global_lows.data(),
+                                                    global_highs.data(),
+                                                    heap,
+                                                    size,
+                                                    team);
+          ++size;
+        }
+
+        Kokkos::single(Kokkos::PerTeam(team), [&]() {
+          T estimate = 0.;
+          T errorest = 0.;
+          for (int slot = 0; slot < size; ++slot) {
+            estimate += heap.estimates(slot);
+            errorest += heap.errors(slot);
+          }
+          integrals(region) = estimate;
+          errors(region) = errorest;
+          leaves(region) = size;
+          unconverged(region) = errorest > budget_per_region ? 1 : 0;
+        });
+      });
+
+    res.estimate = reduction<T>(integrals, num_regions, space);
+    res.errorest = reduction<T>(errors, num_regions, space);
+    res.nregions = reduction<int>(leaves, num_regions, space);
+    res.status = reduction<int>(unconverged, num_regions, space) == 0 ? 0 : 1;
+    return res;
+  }
+}
+
+#endif
@@ -20,8 +20,12 @@
 #include <stdlib.h>
 #include <fstream>
 #include <string>
+#include <type_traits>
 
-template <typename T, size_t ndim, bool use_custom = false>
+template <typename T,
+          size_t ndim,
+          bool use_custom = false,
+          pagani::Cubature_rule rule = pagani::Cubature_rule::degree9>
 class Cubature_rules {
 public:
   // integrator requires constMem structure and generators array (those two can
@@ -69,11 +73,12 @@ public:
     };
 
     print_header();
-    constexpr size_t fEvalPerRegion = pagani::CuhreFuncEvalsPerRegion<ndim>();
-    quad::Rule<T> rule;
-    const int key = 0;
+    constexpr size_t fEvalPerRegion =
+      pagani::CuhreFuncEvalsPerRegion<ndim, rule>();
+    quad::Rule<T> rule_tables;
+    const int key = pagani::uses_degree7<ndim, rule>() ? 7 : 0;
     const int verbose = 0;
-    rule.Init(ndim, fEvalPerRegion, key, verbose, &constMem);
+    rule_tables.Init(ndim, fEvalPerRegion, key, verbose, &constMem);
     generators = quad::cuda_malloc<T>(ndim * fEvalPerRegion);
 
     quad::ComputeGenerators<T, ndim>(generators, fEvalPerRegion, constMem);
@@ -85,7 +90,9 @@ public:
   }
 
   void
-  set_device_volume(T const* lows = nullptr, T const* highs = nullptr)
+  set_device_volume(T const* lows = nullptr,
+                    T const* highs = nullptr,
+                    const ExecSpace& space = ExecSpace())
   {
 
     auto _lows = Kokkos::create_mirror_view(integ_space_lows);
@@ -93,8 +100,8 @@ public:
 
     if (lows == nullptr && highs == nullptr) {
       std::fill_n(_highs.data(), ndim, 1.);
-      Kokkos::deep_copy(integ_space_highs, _highs);
-      Kokkos::deep_copy(integ_space_lows, _lows);
+      Kokkos::deep_copy(space, integ_space_highs, _highs);
+      Kokkos::deep_copy(space, integ_space_lows, _lows);
 
     } else {
 
@@ -103,9 +110,11 @@ public:
         _highs[dim] = highs[dim];
       }
 
-      Kokkos::deep_copy(integ_space_highs, _highs);
-      Kokkos::deep_copy(integ_space_lows, _lows);
+      Kokkos::deep_copy(space, integ_space_highs, _highs);
+      Kokkos::deep_copy(space, integ_space_lows, _lows);
     }
+    // the mirrors go out of scope here
+    space.fence();
   }
 
   ~Cubature_rules() {}
@@ -127,7 +136,8 @@ public:
     auto h_generators = Kokkos::create_mirror_view(d_generators);
     Kokkos::deep_copy(h_generators, d_generators);
 
-    for (int i = 0; i < ndim * pagani::CuhreFuncEvalsPerRegion<ndim>(); ++i) {
+    for (int i = 0; i < ndim * pagani::CuhreFuncEvalsPerRegion<ndim, rule>();
+         ++i) {
       rgenerators.outfile << i << "," << std::scientific << h_generators[i]
                           << std::endl;
     }
@@ -143,7 +153,8 @@ public:
     if constexpr (debug >= 2) {
       
 
-      constexpr size_t num_fevals = pagani::CuhreFuncEvalsPerRegion<ndim>();
+      constexpr size_t num_fevals =
+        pagani::CuhreFuncEvalsPerRegion<ndim, rule>();
       const size_t num_regions = estimates.size;
 
       auto ests = Kokkos::create_mirror_view(estimates.integral_estimates);
@@ -218,45 +229,66 @@ public:
     const Sub_regs& subregions,
     const Reg_estimates& subregion_estimates,
     const Regs_characteristics& region_characteristics,
-    bool compute_error = false)
+    bool compute_error = false,
+    int team_size = BLOCK_SIZE,
+    const ExecSpace& space = ExecSpace())
   {
     size_t num_regions = subregions.size;
     quad::Func_Evals<ndim> dfevals;
 
     if constexpr (debug >= 2) {
-      constexpr size_t num_fevals = pagani::CuhreFuncEvalsPerRegion<ndim>();
+      constexpr size_t num_fevals =
+        pagani::CuhreFuncEvalsPerRegion<ndim, rule>();
       dfevals.fevals_list =
         quad::cuda_malloc<quad::Feval<ndim>>(num_regions * num_fevals);
     }
 
     quad::set_device_array<int>(
-      region_characteristics.active_regions.data(), num_regions, 1.);
-
-    constexpr size_t block_size = BLOCK_SIZE;
-    T epsrel = 1.e-3, epsabs = 1.e-12;
+      region_characteristics.active_regions.data(), num_regions, 1, space);
+
+    // the team size is a template parameter of the sampling kernel, so the
+    // requested one is rounded up to the nearest instantiated size; the
+    // fourth differences need the first 4 * ndim + 1 points in one pass
+    auto phase1 = [&](auto block_size) {
+      quad::INTEGRATE_GPU_PHASE1<IntegT,
+                                 T,
+                                 ndim,
+                                 decltype(block_size)::value,
+                                 debug,
+                                 rule>(
+        d_integrand,
+        subregions.coords,
+        num_regions,
+        subregion_estimates.integral_estimates.data(),
+        subregion_estimates.error_estimates.data(),
+        region_characteristics.sub_dividing_dim.data(),
+        constMem,
+        integ_space_lows.data(),
+        integ_space_highs.data(),
+        generators.data(),
+        dfevals,
+        space);
+    };
 
-    quad::INTEGRATE_GPU_PHASE1<IntegT, T, ndim, block_size, debug>(
-      d_integrand,
-      subregions.dLeftCoord.data(),
-      subregions.dLength.data(),
-      num_regions,
-      subregion_estimates.integral_estimates.data(),
-      subregion_estimates.error_estimates.data(),
-      region_characteristics.sub_dividing_dim.data(),
-      constMem,
-      integ_space_lows.data(),
-      integ_space_highs.data(),
-      generators.data(),
-      dfevals);
+    const int size = std::max(team_size, static_cast<int>(4 * ndim + 1));
+    if (size <= 32)
+      phase1(std::integral_constant<int, 32>());
+    else if (size <= 64)
+      phase1(std::integral_constant<int, 64>());
+    else if (size <= 128)
+      phase1(std::integral_constant<int, 128>());
+    else
+      phase1(std::integral_constant<int, 256>());
 
     print_verbose<debug>(generators, dfevals, subregion_estimates);
     numint::integration_result res;
     res.estimate = reduction<T, use_custom>(
-      subregion_estimates.integral_estimates, num_regions);
-    res.errorest = compute_error ?
-                     reduction<T, use_custom>(
-                       subregion_estimates.error_estimates, num_regions) :
-                     std::numeric_limits<T>::infinity();
+      subregion_estimates.integral_estimates, num_regions, space);
+    res.errorest =
+      compute_error ?
+        reduction<T, use_custom>(
+          subregion_estimates.error_estimates, num_regions, space) :
+        std::numeric_limits<T>::infinity();
     return res;
   }
 
@@ -264,11 +296,11 @@ public:
   void
   Setup_cubature_integration_rules()
   {
-    size_t fEvalPerRegion = pagani::CuhreFuncEvalsPerRegion<dim>();
-    quad::Rule<T> rule;
-    const int key = 0;
+    size_t fEvalPerRegion = pagani::CuhreFuncEvalsPerRegion<dim, rule>();
+    quad::Rule<T> rule_tables;
+    const int key = pagani::uses_degree7<dim, rule>() ? 7 : 0;
     const int verbose = 0;
-    rule.Init(dim, fEvalPerRegion, key, verbose, &constMem);
+    rule_tables.Init(dim, fEvalPerRegion, key, verbose, &constMem);
     generators = quad::cuda_malloc<T>(sizeof(T) * dim * fEvalPerRegion);
 
     size_t block_size = 64;
@@ -287,15 +319,18 @@ template <typename T, size_t ndim, bool use_custom = false>
 numint::integration_result
 compute_finished_estimates(const Region_estimates<T, ndim>& estimates,
                            const Region_characteristics<ndim>& classifiers,
-                           const numint::integration_result& iter)
+                           const numint::integration_result& iter,
+                           const ExecSpace& space = ExecSpace())
 {
   numint::integration_result finished;
   finished.estimate =
-    iter.estimate - dot_product<int, T, use_custom>(
-                      classifiers.active_regions, estimates.integral_estimates);
+    iter.estimate -
+    dot_product<int, T, use_custom>(
+      classifiers.active_regions, estimates.integral_estimates, space);
   finished.errorest =
-    iter.errorest - dot_product<int, T, use_custom>(classifiers.active_regions,
-                                                    estimates.error_estimates);
+    iter.errorest -
+    dot_product<int, T, use_custom>(
+      classifiers.active_regions, estimates.error_estimates, space);
   return finished;
 }
 
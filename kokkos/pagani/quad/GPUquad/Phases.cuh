@@ -3,6 +3,7 @@
 
 #include "kokkos/pagani/quad/GPUquad/Sample.cuh"
 #include "kokkos/pagani/quad/GPUquad/Func_Eval.cuh"
+#include "kokkos/pagani/quad/GPUquad/Launch_policy.cuh"
 #include "kokkos/pagani/quad/quad.h"
 #include "common/kokkos/Volume.cuh"
 
@@ -146,19 +147,15 @@ namespace quad {
               int* activeRegions,
               size_t currIterRegions,
               T epsrel,
-              int heuristicID)
+              int heuristicID,
+              int team_size = 64,
+              const ExecSpace& space = ExecSpace())
   {
-    size_t numThreads = 64;
-    size_t numBlocks =
-      currIterRegions / numThreads + ((currIterRegions % numThreads) ? 1 : 0);
-
-    Kokkos::TeamPolicy<Kokkos::LaunchBounds<64, 18>> team_policy1(numBlocks,
-                                                                  numThreads);
-    auto team_policy = Kokkos::Experimental::require(
-      team_policy1, Kokkos::Experimental::WorkItemProperty::HintLightWeight);
-
-    Kokkos::parallel_for(
-      "RefineError", team_policy, KOKKOS_LAMBDA(const member_type team_member) {
+    pagani::parallel_for_regions(
+      "RefineError",
+      currIterRegions,
+      team_size,
+      KOKKOS_LAMBDA(const member_type& team_member, int numThreads) {
         int threadIdx = team_member.team_rank();
         int blockIdx = team_member.league_rank();
 
@@ -199,7 +196,8 @@ namespace quad {
             selfErr < MaxErr(selfRes, epsrel, /*epsabs*/ 1e-200);
           activeRegions[tid] = !(/*polished ||*/ PassRatioTest);
         }
-      });
+      },
+      space);
   }
 
   KOKKOS_INLINE_FUNCTION void
@@ -234,12 +232,15 @@ namespace quad {
     }
   }
 
-  template <typename IntegT, typename T, int NDIM, int blockDim, int debug>
+  template <typename IntegT,
+            typename T,
+            int NDIM,
+            int blockDim,
+            int debug,
+            pagani::Cubature_rule rule = pagani::Cubature_rule::degree9>
   KOKKOS_INLINE_FUNCTION void
   INIT_REGION_POOL(IntegT* d_integrand,
-                   T* dRegions,
-                   T* dRegionsLength,
-                   size_t numRegions,
+                   pagani::Region_pages<T, NDIM> regions,
                    const Structures<T>& constMem,
                    T* lows,
                    T* highs,
@@ -253,26 +254,28 @@ namespace quad {
                          Kokkos::MemoryTraits<Kokkos::Unmanaged>>
       ScratchViewRegion;
 
-    SampleRegionBlock<IntegT, T, NDIM, blockDim, debug>(d_integrand,
-                                                        constMem,
-                                                        sRegionPool,
-                                                        dRegions,
-                                                        dRegionsLength,
-                                                        numRegions,
-                                                        lows,
-                                                        highs,
-                                                        generators,
-                                                        fevals,
-                                                        team_member);
+    SampleRegionBlock<IntegT, T, NDIM, blockDim, debug, rule>(d_integrand,
+                                                              constMem,
+                                                              sRegionPool,
+                                                              regions,
+                                                              lows,
+                                                              highs,
+                                                              generators,
+                                                              fevals,
+                                                              team_member);
     team_member.team_barrier();
   }
 
-  template <typename IntegT, typename T, int NDIM, int blockDim, int debug = 0>
+  template <typename IntegT,
+            typename T,
+            int NDIM,
+            int blockDim,
+            int debug = 0,
+            pagani::Cubature_rule rule = pagani::Cubature_rule::degree9>
   void
   INTEGRATE_GPU_PHASE1(
     IntegT* d_integrand,
-    T* dRegions,
-    T* dRegionsLength,
+    pagani::Region_pages<T, NDIM> regions,
     size_t numRegions,
     T* dRegionsIntegral,
     T* dRegionsError,
@@ -282,7 +285,8 @@ namespace quad {
     T* lows,
     T* highs,
     T* generators,
-    quad::Func_Evals<NDIM> fevals)
+    quad::Func_Evals<NDIM> fevals,
+    const ExecSpace& space = ExecSpace())
   {
 
     uint32_t nBlocks = numRegions;
@@ -292,9 +296,8 @@ namespace quad {
                          Kokkos::MemoryTraits<Kokkos::Unmanaged>>
       ScratchViewRegion;
 
-    Kokkos::TeamPolicy<> mainKernelPolicy(nBlocks,
-                                                                      nThreads);
-   
+    Kokkos::TeamPolicy<> mainKernelPolicy(space, nBlocks, nThreads);
+
     int shMemBytes =
       ScratchViewRegion::shmem_size(1) +
       ScratchViewDouble::shmem_size(nThreads);  // for sdata
@@ -305,17 +308,16 @@ namespace quad {
       KOKKOS_LAMBDA(const member_type team_member) {
 
         ScratchViewRegion sRegionPool(team_member.team_scratch(0), 1);
-        INIT_REGION_POOL<IntegT, T, NDIM, blockDim, debug>(d_integrand,
-                                                           dRegions,
-                                                           dRegionsLength,
-                                                           numRegions,
-                                                           constMem,
-                                                           lows,
-                                                           highs,
-                                                           generators,
-                                                           sRegionPool.data(),
-                                                           fevals,
-                                                           team_member);
+        INIT_REGION_POOL<IntegT, T, NDIM, blockDim, debug, rule>(
+          d_integrand,
+          regions,
+          constMem,
+          lows,
+          highs,
+          generators,
+          sRegionPool.data(),
+          fevals,
+          team_member);
 
         team_member.team_barrier();
 
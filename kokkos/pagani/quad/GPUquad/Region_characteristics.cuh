@@ -9,7 +9,11 @@
 template <size_t ndim>
 class Region_characteristics {
 public:
-  Region_characteristics(size_t num_regions) { device_init(num_regions); }
+  Region_characteristics(size_t num_regions,
+                         const ExecSpace& space = ExecSpace())
+  {
+    device_init(num_regions, space);
+  }
 
   Region_characteristics(const Region_characteristics<ndim>& other)
   {
@@ -19,10 +23,10 @@ public:
   }
 
   void
-  device_init(size_t num_regions)
+  device_init(size_t num_regions, const ExecSpace& space = ExecSpace())
   {
-    active_regions = quad::cuda_malloc<int>(num_regions);
-    sub_dividing_dim = quad::cuda_malloc<int>(num_regions);
+    active_regions = quad::cuda_malloc<int>(num_regions, space);
+    sub_dividing_dim = quad::cuda_malloc<int>(num_regions, space);
     size = num_regions;
   }
 
@@ -9,7 +9,10 @@ class Region_estimates {
 public:
   Region_estimates() {}
 
-  Region_estimates(size_t num_regions) { device_init(num_regions); }
+  Region_estimates(size_t num_regions, const ExecSpace& space = ExecSpace())
+  {
+    device_init(num_regions, space);
+  }
 
   Region_estimates(const Region_estimates<T, ndim>& other)
   {
@@ -19,18 +22,18 @@ public:
   }
 
   void
-  device_init(size_t num_regions)
+  device_init(size_t num_regions, const ExecSpace& space = ExecSpace())
   {
-    integral_estimates = quad::cuda_malloc<T>(num_regions);
-    error_estimates = quad::cuda_malloc<T>(num_regions);
+    integral_estimates = quad::cuda_malloc<T>(num_regions, space);
+    error_estimates = quad::cuda_malloc<T>(num_regions, space);
     size = num_regions;
   }
 
   void
-  reallocate(size_t num_regions)
+  reallocate(size_t num_regions, const ExecSpace& space = ExecSpace())
   {
-    integral_estimates = quad::cuda_malloc<T>(num_regions);
-    error_estimates = quad::cuda_malloc<T>(num_regions);
+    integral_estimates = quad::cuda_malloc<T>(num_regions, space);
+    error_estimates = quad::cuda_malloc<T>(num_regions, space);
     size = num_regions;
   }
 
@@ -236,6 +236,123 @@ namespace quad {
       }
     }
 
+    // Fully symmetric degree 7 rule for the high dimensional case, exact for
+    // every monomial of degree 7 and for x^8. The point count grows as
+    // NDIM^3 instead of 2^NDIM: the centre, two sets {u1}, {u2} on the axes,
+    // the pairs {l, l} and the triples {l, l, l} with l = sqrt(3/5) on
+    // [-1, 1]. The first null rule is the difference to the degree 5 rule
+    // on the centre, the axes and the pairs, the others drop to the rules of
+    // degree 5 on the triples, 3 on {u2} and 1 on the centre. Only valid
+    // for NDIM >= 5, see pagani::uses_degree7.
+    void
+    Rule7Generate()
+    {
+      const T n = NDIM;
+      const T v = .6;
+      const T m[5] = {1., 1. / 3, 1. / 5, 1. / 7, 1. / 9};
+
+      const T w_triples = 1. / (216 * v * v * v);
+      const T w_pairs =
+        (1. / 9 - 8 * (n - 2) * w_triples * v * v) / (4 * v * v);
+
+      // what the pairs and triples leave of the 1D moments, matched by a two
+      // point Gauss rule in x^2 over the axis points
+      T rest[5];
+      for (int k = 1; k <= 4; ++k)
+        rest[k] = m[k] - (4 * (n - 1) * w_pairs +
+                          4 * (n - 1) * (n - 2) * w_triples) *
+                           pow(v, k);
+      const T det = rest[2] * rest[2] - rest[1] * rest[3];
+      const T alpha = (rest[1] * rest[4] - rest[2] * rest[3]) / det;
+      const T beta = (rest[3] * rest[3] - rest[2] * rest[4]) / det;
+      const T disc = sqrt(alpha * alpha - 4 * beta);
+      const T u1 = (-alpha - disc) / 2;
+      const T u2 = (-alpha + disc) / 2;
+      const T b_u2 = (rest[2] - u1 * rest[1]) / (u2 - u1);
+      const T a_u1 = rest[1] - b_u2;
+
+      const T counts[5] = {1.,
+                           2 * n,
+                           2 * n,
+                           2 * n * (n - 1),
+                           4 * n * (n - 1) * (n - 2) / 3};
+      auto centre_weight = [&](T* w) {
+        w[0] = 1.;
+        for (int set = 1; set < 5; ++set)
+          w[0] -= counts[set] * w[set];
+      };
+
+      // embedded degree 5 rules on the pairs or on the triples
+      auto degree5 = [&](T* w, T w3, T w4) {
+        const T c = 4 * (n - 1) * w3 + 4 * (n - 1) * (n - 2) * w4;
+        const T s1 = m[1] - c * v;
+        const T s2 = m[2] - c * v * v;
+        const T b = (s2 - u1 * s1) / (u2 * (u2 - u1));
+        w[1] = (s1 - b * u2) / (2 * u1);
+        w[2] = b / 2;
+        w[3] = w3;
+        w[4] = w4;
+        centre_weight(w);
+      };
+
+      T r7[5] = {0., a_u1 / (2 * u1), b_u2 / (2 * u2), w_pairs, w_triples};
+      centre_weight(r7);
+      T r5[5], r5_triples[5];
+      degree5(r5, 1. / (36 * v * v), 0.);
+      degree5(r5_triples, 0., 1. / (72 * (n - 2) * v * v));
+      T r3[5] = {0., 0., 1. / (6 * u2), 0., 0.};
+      centre_weight(r3);
+      const T r1[5] = {1., 0., 0., 0., 0.};
+
+      CPURuleWt = HostVectorDouble("CPURuleWt", NSETS * NRULES);
+      for (int set = 0; set < NSETS; ++set) {
+        CPURuleWt(set * NRULES) = r7[set];
+        CPURuleWt(set * NRULES + 1) = r7[set] - r5[set];
+        CPURuleWt(set * NRULES + 2) = r7[set] - r5_triples[set];
+        CPURuleWt(set * NRULES + 3) = r7[set] - r3[set];
+        CPURuleWt(set * NRULES + 4) = r7[set] - r1[set];
+      }
+
+      CPUGeneratorCount = HostVectorSize_t("CPUGeneratorCount", NSETS);
+      cpuGenCount = HostVectorInt("cpuGenCount", NSETS);
+      indxCnt = HostVectorInt("indxCnt", NSETS);
+      const int nonzeros[5] = {0, 1, 1, 2, 3};
+      for (int set = 0; set < NSETS; ++set) {
+        CPUGeneratorCount(set) = counts[set];
+        cpuGenCount(set) = counts[set];
+        indxCnt(set) = nonzeros[set];
+      }
+
+      // generators live on [-1/2, 1/2]
+      cpuG = HostVectorDouble("cpuG", NDIM * NSETS);
+      for (int i = 0; i < NDIM * NSETS; ++i) {
+        cpuG(i) = 0.0;
+      }
+      cpuG(NDIM) = sqrt(u1) / 2;
+      cpuG(NDIM * 2) = sqrt(u2) / 2;
+      cpuG(NDIM * 3) = sqrt(v) / 2;
+      cpuG(NDIM * 3 + 1) = sqrt(v) / 2;
+      cpuG(NDIM * 4) = sqrt(v) / 2;
+      cpuG(NDIM * 4 + 1) = sqrt(v) / 2;
+      cpuG(NDIM * 4 + 2) = sqrt(v) / 2;
+
+      CPUScale = HostVectorDouble("CPUScale", NSETS * NRULES);
+      CPUNorm = HostVectorDouble("CPUNorm", NSETS * NRULES);
+      for (int idx = 0; idx < NSETS; ++idx) {
+        for (int r = 1; r < NRULES - 1; ++r) {
+          const T w_r = CPURuleWt(idx * NRULES + r);
+          T scale = (w_r == 0) ? 100 : -CPURuleWt(idx * NRULES + r + 1) / w_r;
+          T sum = 0;
+          for (int x = 0; x < NSETS; ++x) {
+            sum += counts[x] * fabs(CPURuleWt(x * NRULES + r + 1) +
+                                    scale * CPURuleWt(x * NRULES + r));
+          }
+          CPUScale(idx * NRULES + r) = scale;
+          CPUNorm(idx * NRULES + r) = 1 / sum;
+        }
+      }
+    }
+
   public:
     inline int
     GET_FEVAL()
@@ -308,8 +425,9 @@ namespace quad {
       else
         RULE = 9;
 
-      // temporary
-      RULE = 9;
+      // temporary, only the symmetric degree 7 rule can be asked for, and
+      // only from 5 dimensions on (pagani::uses_degree7)
+      RULE = key == 7 && ndim >= 5 ? 7 : 9;
 
       if (RULE == 13)
         NSETS = 14;
@@ -318,18 +436,27 @@ namespace quad {
       else if (RULE == 9)
         NSETS = 9;
       else if (RULE == 7)
-        NSETS = 6;
-
-      FEVAL = (1 + 2 * ndim + 2 * ndim + 2 * ndim + 2 * ndim +
-               2 * ndim * (ndim - 1) + 4 * ndim * (ndim - 1) +
-               4 * ndim * (ndim - 1) * (ndim - 2) / 3 + (1 << ndim));
-
-      PERMUTATIONS_POS_ARRAY_SIZE =
-        (1 + 1 * 1 + 2 * ndim * 1 + 2 * ndim * 1 + 2 * ndim * 1 + 2 * ndim * 1 +
-         2 * ndim * (ndim - 1) * 2 + 4 * ndim * (ndim - 1) * 2 +
-         4 * ndim * (ndim - 1) * (ndim - 2) * 3 / 3 + ndim * (1 << ndim));
-      // NRULES = 5;
-      Rule9Generate();
+        NSETS = 5;
+
+      if (RULE == 7) {
+        FEVAL = 1 + 4 * ndim + 2 * ndim * (ndim - 1) +
+                4 * ndim * (ndim - 1) * (ndim - 2) / 3;
+        PERMUTATIONS_POS_ARRAY_SIZE = 1 + 4 * ndim + 4 * ndim * (ndim - 1) +
+                                      4 * ndim * (ndim - 1) * (ndim - 2);
+        Rule7Generate();
+      } else {
+        FEVAL = (1 + 2 * ndim + 2 * ndim + 2 * ndim + 2 * ndim +
+                 2 * ndim * (ndim - 1) + 4 * ndim * (ndim - 1) +
+                 4 * ndim * (ndim - 1) * (ndim - 2) / 3 + (1 << ndim));
+
+        PERMUTATIONS_POS_ARRAY_SIZE =
+          (1 + 1 * 1 + 2 * ndim * 1 + 2 * ndim * 1 + 2 * ndim * 1 +
+           2 * ndim * 1 + 2 * ndim * (ndim - 1) * 2 +
+           4 * ndim * (ndim - 1) * 2 +
+           4 * ndim * (ndim - 1) * (ndim - 2) * 3 / 3 + ndim * (1 << ndim));
+        // NRULES = 5;
+        Rule9Generate();
+      }
       cpuGenPermVarCount = HostVectorInt("cpuGenPermVarCount", fEval);
       cpuGenPermVarStart = HostVectorInt("cpuGenPermVarStart", fEval + 1);
       cpuGenPermGIndex = HostVectorInt("cpuGenPermGIndex", (fEval /*+ 1*/));
@@ -7,6 +7,7 @@
 #include "common/kokkos/cudaApply.cuh"
 #include "common/kokkos/cudaMemoryUtil.h"
 #include "kokkos/pagani/quad/GPUquad/Func_Eval.cuh"
+#include "kokkos/pagani/quad/GPUquad/Sub_regions.cuh"
 #include <cmath>
 
 namespace quad {
@@ -42,7 +43,11 @@ namespace quad {
     return sum;
   }
 
-  template <typename IntegT, typename T, int NDIM, int debug = 0>
+  template <typename IntegT,
+            typename T,
+            int NDIM,
+            int debug = 0,
+            pagani::Cubature_rule rule = pagani::Cubature_rule::degree9>
   KOKKOS_INLINE_FUNCTION void
   computePermutation(IntegT* d_integrand,
                      int pIndex,
@@ -61,10 +66,11 @@ namespace quad {
     const int threadIdx = team_member.team_rank();
     gpu::cudaArray<T, NDIM> x;
     int blockIdx = team_member.league_rank();
+    constexpr size_t FEVAL = pagani::CuhreFuncEvalsPerRegion<NDIM, rule>();
 
     for (int dim = 0; dim < NDIM; ++dim) {
       const T generator =
-        (generators[pagani::CuhreFuncEvalsPerRegion<NDIM>() * dim + pIndex]);
+        (generators[FEVAL * dim + pIndex]);
       x[dim] = global_lows[dim] + ((.5 + generator) * rlows[dim]+ (.5 - generator) * rhighs[dim]) * ranges[dim];
                                       
     }
@@ -76,10 +82,10 @@ namespace quad {
     if constexpr (debug >= 2) {
       const int blockIdx = team_member.league_rank();
       // assert(fevals != nullptr);
-      fevals[blockIdx * pagani::CuhreFuncEvalsPerRegion<NDIM>() + pIndex].store(
+      fevals[blockIdx * FEVAL + pIndex].store(
         x, global_lows, ranges, rlows, rhighs);
-      fevals[blockIdx * pagani::CuhreFuncEvalsPerRegion<NDIM>() + pIndex].store(
-        gpu::apply(*d_integrand, x), pIndex);
+      fevals[blockIdx * FEVAL + pIndex].store(gpu::apply(*d_integrand, x),
+                                              pIndex);
     }
 
     for (int rul = 0; rul < NRULES; ++rul) {
@@ -88,14 +94,17 @@ namespace quad {
   }
 
   // BLOCK SIZE has to be atleast 4*DIM+1 for the first IF
-  template <typename IntegT, typename T, int NDIM, int blockdim, int debug = 0>
+  template <typename IntegT,
+            typename T,
+            int NDIM,
+            int blockdim,
+            int debug = 0,
+            pagani::Cubature_rule rule = pagani::Cubature_rule::degree9>
   KOKKOS_INLINE_FUNCTION void
   SampleRegionBlock(IntegT* d_integrand,
                     const Structures<T>& constMem,
                     Region<NDIM>* sRegionPool,
-                    T* dRegions,
-                    T* dRegionsLength,
-                    int numRegions,
+                    pagani::Region_pages<T, NDIM> regions,
                     T* global_lows,
                     T* global_highs,
                     T* generators,
@@ -114,9 +123,9 @@ namespace quad {
     int  maxDim;
 
     for (int dim = 0; dim < NDIM; ++dim) {
-        const double lower = dRegions[dim * numRegions + blockIdx];
+        const double lower = regions.left(blockIdx, dim);
         rlows[dim] = lower;
-        rhighs[dim] = lower + dRegionsLength[dim * numRegions + blockIdx];
+        rhighs[dim] = lower + regions.length(blockIdx, dim);
         vol *= rhighs[dim] - rlows[dim];
         
         ranges[dim] = global_highs[dim] - global_lows[dim];
@@ -142,21 +151,21 @@ namespace quad {
     // values for the permutation used to compute
     // fourth dimension
     int pIndex = perm * blockdim + threadIdx;
-    constexpr int FEVAL = pagani::CuhreFuncEvalsPerRegion<NDIM>();
+    constexpr int FEVAL = pagani::CuhreFuncEvalsPerRegion<NDIM, rule>();
     if (pIndex < FEVAL) {
-      computePermutation<IntegT, T, NDIM, debug>(d_integrand,
-                                                 pIndex,
-                                                 rlows,
-                                                 rhighs,
-                                                 global_lows,
-                                                 sum,
-                                                 constMem,
-                                                 ranges,
-                                                 jacobian,
-                                                 generators,
-                                                 sdata.data(),
-                                                 fevals,
-                                                 team_member);
+      computePermutation<IntegT, T, NDIM, debug, rule>(d_integrand,
+                                                       pIndex,
+                                                       rlows,
+                                                       rhighs,
+                                                       global_lows,
+                                                       sum,
+                                                       constMem,
+                                                       ranges,
+                                                       jacobian,
+                                                       generators,
+                                                       sdata.data(),
+                                                       fevals,
+                                                       team_member);
     }
 
     team_member.team_barrier();
@@ -189,38 +198,38 @@ namespace quad {
     team_member.team_barrier();
     for (perm = 1; perm < FEVAL / blockdim; ++perm) {
       int pIndex = perm * blockdim + threadIdx;
-      computePermutation<IntegT, T, NDIM, debug>(d_integrand,
-                                                 pIndex,
-                                                 rlows,
-                                                 rhighs,
-                                                 global_lows,
-                                                 sum,
-                                                 constMem,
-                                                 ranges,
-                                                 jacobian,
-                                                 generators,
-                                                 sdata.data(),
-                                                 fevals,
-                                                 team_member);
+      computePermutation<IntegT, T, NDIM, debug, rule>(d_integrand,
+                                                       pIndex,
+                                                       rlows,
+                                                       rhighs,
+                                                       global_lows,
+                                                       sum,
+                                                       constMem,
+                                                       ranges,
+                                                       jacobian,
+                                                       generators,
+                                                       sdata.data(),
+                                                       fevals,
+                                                       team_member);
     }
 
     // Balance permutations
     pIndex = perm * blockdim + threadIdx;
     if (pIndex < FEVAL) {
       int pIndex = perm * blockdim + threadIdx;
-      computePermutation<IntegT, T, NDIM, debug>(d_integrand,
-                                                 pIndex,
-                                                 rlows,
-                                                 rhighs,
-                                                 global_lows,
-                                                 sum,
-                                                 constMem,
-                                                 ranges,
-                                                 jacobian,
-                                                 generators,
-                                                 sdata.data(),
-                                                 fevals,
-                                                 team_member);
+      computePermutation<IntegT, T, NDIM, debug, rule>(d_integrand,
+                                                       pIndex,
+                                                       rlows,
+                                                       rhighs,
+                                                       global_lows,
+                                                       sum,
+                                                       constMem,
+                                                       ranges,
+                                                       jacobian,
+                                                       generators,
+                                                       sdata.data(),
+                                                       fevals,
+                                                       team_member);
     }
 
     team_member.team_barrier();
@@ -232,6 +241,13 @@ namespace quad {
 
       Result* r = &region->result; // ptr to shared Mem
 
+      if constexpr (pagani::uses_degree7<NDIM, rule>()) {
+        // difference to the embedded degree 5 rule
+        r->avg = vol * sum[0];
+        r->err = vol * fabs(sum[1]);
+        return;
+      }
+
       for (int rul = 1; rul < NRULES - 1; ++rul) {
         T maxerr = 0.;
 
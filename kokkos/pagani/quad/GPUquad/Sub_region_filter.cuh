@@ -5,7 +5,9 @@
 #include "common/kokkos/cudaMemoryUtil.h"
 #include "kokkos/pagani/quad/GPUquad/Region_characteristics.cuh"
 #include "kokkos/pagani/quad/GPUquad/Region_estimates.cuh"
+#include "kokkos/pagani/quad/GPUquad/Launch_policy.cuh"
 #include "common/kokkos/util.cuh"
+#include "common/kokkos/stream_compaction.cuh"
 
 template <typename T, size_t ndim, bool use_custom = false>
 class Sub_regions_filter {
@@ -14,106 +16,79 @@ public:
   using Region_char = Region_characteristics<ndim>;
   using Region_ests = Region_estimates<T, ndim>;
 
-  Sub_regions_filter(const size_t num_regions)
+  Sub_regions_filter(const size_t num_regions,
+                     int team_size = 64,
+                     const ExecSpace& space = ExecSpace())
+    : team_size(team_size), space(space), compaction(space)
   {
-    scanned_array = quad::cuda_malloc<int>(num_regions);
+    active_ids = quad::cuda_malloc<int>(num_regions, space);
   }
 
   size_t
   get_num_active_regions(ViewVectorInt active_regions, const size_t num_regions)
   {
-    exclusive_prefix_scan(active_regions, scanned_array);
-    int last_element = -1;
-    int num_active = 0;
-    int lastScanned = 0.;
-
-    ReturnLastIndexValues(
-      active_regions, scanned_array, last_element, lastScanned);
-    num_active = static_cast<size_t>(lastScanned);
-
-    if (last_element == 1) {
-      num_active++;
-    }
-
-    return static_cast<size_t>(num_active);
-  }
-
-  void
-  ReturnLastIndexValues(ViewVectorInt listA,
-                        ViewVectorInt listB,
-                        int& lastA,
-                        int& lastB)
-  {
-    int sizeA = listA.extent(0);
-    int sizeB = listB.extent(0);
-
-    ViewVectorInt A_sub(listA, std::make_pair(sizeA - 1, sizeA));
-    ViewVectorInt B_sub(listB, std::make_pair(sizeB - 1, sizeB));
-
-    ViewVectorInt::HostMirror hostA_sub = Kokkos::create_mirror_view(A_sub);
-    ViewVectorInt::HostMirror hostB_sub = Kokkos::create_mirror_view(B_sub);
-
-    deep_copy(hostA_sub, A_sub);
-    deep_copy(hostB_sub, B_sub);
-
-    lastA = hostA_sub(0);
-    lastB = hostB_sub(0);
+    return compaction.count_flagged(
+      "CountActiveRegions",
+      num_regions,
+      KOKKOS_LAMBDA(const size_t reg) { return active_regions(reg) == 1; });
   }
 
+  // Moves the active regions to the front of the pages, keeping their order.
+  // active_ids lists them in their new order, so the region going to slot i
+  // comes from slot active_ids(i) >= i. The slots are processed in batches
+  // through the compaction buffer, gathered then written back; a batch only
+  // overwrites slots whose regions were read by earlier batches or by itself.
   void
-  alignRegions(ViewVectorDouble dRegions,
-               ViewVectorDouble dRegionsLength,
-               ViewVectorInt activeRegions,
-               ViewVectorDouble dRegionsIntegral,
-               ViewVectorDouble dRegionsError,
-               ViewVectorDouble dRegionsParentIntegral,
-               ViewVectorDouble dRegionsParentError,
-               ViewVectorInt subDividingDimension,
-               ViewVectorInt scannedArray,
-               ViewVectorDouble newActiveRegions,
-               ViewVectorDouble newActiveRegionsLength,
-               ViewVectorInt newActiveRegionsBisectDim,
-               size_t numRegions,
-               size_t newNumRegions,
-               size_t numOfDivisionOnDimension)
+  compact_regions(Regions& sub_regions, size_t newNumRegions)
   {
-    size_t numThreads = 64;
-    size_t numBlocks =
-      numRegions / numThreads + ((numRegions % numThreads) ? 1 : 0);
-
-    Kokkos::TeamPolicy<Kokkos::LaunchBounds<64, 18>> team_policy1(numBlocks,
-                                                                  numThreads);
-    auto team_policy = Kokkos::Experimental::require(
-      team_policy1, Kokkos::Experimental::WorkItemProperty::HintLightWeight);
-
-    Kokkos::parallel_for(
-      "AlignRegions",
-      team_policy,
-      KOKKOS_LAMBDA(const member_type team_member) {
-        int threadIdx = team_member.team_rank();
-        int blockIdx = team_member.league_rank();
-
-        size_t tid = blockIdx * numThreads + threadIdx;
-
-        if (tid < numRegions && activeRegions(tid) == 1.) {
-          size_t interval_index = (size_t)scannedArray(tid);
-
-          for (size_t i = 0; i < ndim; ++i) {
-            newActiveRegions(i * newNumRegions + interval_index) =
-              dRegions(i * numRegions + tid);
-            newActiveRegionsLength(i * newNumRegions + interval_index) =
-              dRegionsLength(i * numRegions + tid);
+    const size_t num_pages = pagani::num_region_pages(sub_regions.size);
+    const size_t batch_size = pagani::region_page_size *
+                              pagani::num_compaction_pages(num_pages);
+    ViewVectorDouble buffer =
+      sub_regions.get_compaction_buffer(batch_size, space);
+    pagani::Region_pages<T, ndim> regions = sub_regions.coords;
+    ViewVectorInt ids = active_ids;
+
+    for (size_t first = 0; first < newNumRegions; first += batch_size) {
+      const size_t count = std::min(batch_size, newNumRegions - first);
+
+      pagani::parallel_for_regions(
+        "GatherActiveRegions",
+        count,
+        team_size,
+        KOKKOS_LAMBDA(const member_type& team_member, int numThreads) {
+          const size_t slot =
+            team_member.league_rank() * numThreads + team_member.team_rank();
+          if (slot < count) {
+            const size_t reg = ids(first + slot);
+            for (size_t dim = 0; dim < ndim; ++dim) {
+              buffer(dim * batch_size + slot) = regions.left(reg, dim);
+              buffer((ndim + dim) * batch_size + slot) =
+                regions.length(reg, dim);
+            }
           }
-
-          dRegionsParentIntegral(interval_index) = dRegionsIntegral(tid);
-          dRegionsParentError(interval_index) = dRegionsError(tid);
-
-          for (size_t i = 0; i < numOfDivisionOnDimension; ++i) {
-            newActiveRegionsBisectDim(i * newNumRegions + interval_index) =
-              subDividingDimension(tid);
+        },
+        space);
+
+      pagani::parallel_for_regions(
+        "ScatterActiveRegions",
+        count,
+        team_size,
+        KOKKOS_LAMBDA(const member_type& team_member, int numThreads) {
+          const size_t slot =
+            team_member.league_rank() * numThreads + team_member.team_rank();
+          if (slot < count) {
+            for (size_t dim = 0; dim < ndim; ++dim) {
+              regions.left(first + slot, dim) =
+                buffer(dim * batch_size + slot);
+              regions.length(first + slot, dim) =
+                buffer((ndim + dim) * batch_size + slot);
+            }
           }
-        }
-      });
+        },
+        space);
+    }
+    sub_regions.release_pages(newNumRegions);
   }
 
   // filter out finished regions
@@ -123,47 +98,56 @@ public:
          const Region_ests& region_ests,
          Region_ests& parent_ests)
   {
-
     const size_t current_num_regions = sub_regions.size;
-    const size_t num_active_regions = get_num_active_regions(
-      region_characteristics.active_regions, current_num_regions);
+    if (current_num_regions == 0)
+      return 0;
+
+    // a filter kept across iterations only reallocates when the regions
+    // outgrow its ids
+    if (active_ids.extent(0) < current_num_regions)
+      active_ids = quad::cuda_malloc<int>(current_num_regions, space);
+
+    // the outputs are sized for the worst case and trimmed once the count is
+    // known, so flags, offsets and the parents' scalars take a single pass
+    ViewVectorDouble parent_integrals =
+      quad::cuda_malloc<T>(current_num_regions, space);
+    ViewVectorDouble parent_errors =
+      quad::cuda_malloc<T>(current_num_regions, space);
+    ViewVectorInt bisect_dims =
+      quad::cuda_malloc<int>(current_num_regions, space);
+    ViewVectorInt active_regions = region_characteristics.active_regions;
+    ViewVectorDouble integrals = region_ests.integral_estimates;
+    ViewVectorDouble errors = region_ests.error_estimates;
+    ViewVectorInt sub_dividing_dim = region_characteristics.sub_dividing_dim;
+    ViewVectorInt ids = active_ids;
+
+    const size_t num_active_regions = compaction.compact(
+      "FilterRegions",
+      current_num_regions,
+      KOKKOS_LAMBDA(const size_t reg) { return active_regions(reg) == 1; },
+      KOKKOS_LAMBDA(const size_t reg, const size_t slot) {
+        parent_integrals(slot) = integrals(reg);
+        parent_errors(slot) = errors(reg);
+        bisect_dims(slot) = sub_dividing_dim(reg);
+        ids(slot) = static_cast<int>(reg);
+      });
 
     if (num_active_regions == 0) {
       return 0;
     }
 
-    // I dont' create Regions filtered_regions, because upon destruction it
-    // would deallocate and for performance reasons, I don't want a deep_copy to
-    // occur here
-    ViewVectorDouble filtered_leftCoord =
-      quad::cuda_malloc<T>(num_active_regions * ndim);
-    ViewVectorDouble filtered_length =
-      quad::cuda_malloc<T>(num_active_regions * ndim);
-    ViewVectorInt filtered_sub_dividing_dim =
-      quad::cuda_malloc<int>(num_active_regions);
-
-    parent_ests.reallocate(num_active_regions);
-    const int numOfDivisionOnDimension = 1;
-
-    alignRegions(sub_regions.dLeftCoord,
-                 sub_regions.dLength,
-                 region_characteristics.active_regions,
-                 region_ests.integral_estimates,
-                 region_ests.error_estimates,
-                 parent_ests.integral_estimates,
-                 parent_ests.error_estimates,
-                 region_characteristics.sub_dividing_dim,
-                 scanned_array,
-                 filtered_leftCoord,
-                 filtered_length,
-                 filtered_sub_dividing_dim,
-                 current_num_regions,
-                 num_active_regions,
-                 numOfDivisionOnDimension);
-
-    sub_regions.dLeftCoord = filtered_leftCoord;
-    sub_regions.dLength = filtered_length;
-    region_characteristics.sub_dividing_dim = filtered_sub_dividing_dim;
+    const auto active = std::make_pair(size_t{0}, num_active_regions);
+    parent_ests.integral_estimates = Kokkos::subview(parent_integrals, active);
+    parent_ests.error_estimates = Kokkos::subview(parent_errors, active);
+    parent_ests.size = num_active_regions;
+
+    // the coordinates are compacted in place, all of them are active
+    // regions when nothing was filtered out
+    if (num_active_regions < current_num_regions)
+      compact_regions(sub_regions, num_active_regions);
+
+    region_characteristics.sub_dividing_dim =
+      Kokkos::subview(bisect_dims, active);
     sub_regions.size = num_active_regions;
     region_characteristics.size = num_active_regions;
     return num_active_regions;
@@ -171,7 +155,11 @@ public:
 
   ~Sub_regions_filter() {}
 
-  ViewVectorInt scanned_array;
+  // positions of the active regions after the last filter
+  ViewVectorInt active_ids;
+  int team_size;
+  ExecSpace space;
+  quad::Stream_compaction compaction;
 };
 
 #endif
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "kokkos/pagani/quad/GPUquad/Sub_regions.cuh"
 #include "kokkos/pagani/quad/GPUquad/Region_characteristics.cuh"
+#include "kokkos/pagani/quad/GPUquad/Launch_policy.cuh"
 #include "common/kokkos/cudaMemoryUtil.h"
 
 template <typename T, size_t ndim>
@@ -10,8 +11,18 @@ class Sub_region_splitter {
 
 public:
   size_t num_regions;
-  Sub_region_splitter(size_t size) : num_regions(size) {}
-
+  int team_size;
+  ExecSpace space;
+  Sub_region_splitter(size_t size,
+                      int team_size = 64,
+                      const ExecSpace& space = ExecSpace())
+    : num_regions(size), team_size(team_size), space(space)
+  {}
+
+  // Each region is halved along its sub-dividing dimension in place and the
+  // second halves are appended after the current regions, so child i of
+  // region r ends up at i * num_regions + r. Only the pages for the new
+  // halves are added, the existing ones are not copied.
   void
   split(Sub_regions<T, ndim>& sub_regions,
         const Region_characteristics<ndim>& classifiers)
@@ -20,81 +31,43 @@ public:
       return;
 
     size_t children_per_region = 2;
-
-    ViewVectorDouble children_left_coord(
-      "children_left", num_regions * ndim * children_per_region);
-    ViewVectorDouble children_length("children_length",
-                                     num_regions * ndim * children_per_region);
-
-    divideIntervalsGPU(children_left_coord.data(),
-                       children_length.data(),
-                       sub_regions.dLeftCoord.data(),
-                       sub_regions.dLength.data(),
+    sub_regions.reserve(num_regions * children_per_region, space);
+    divideIntervalsGPU(sub_regions.coords,
                        classifiers.sub_dividing_dim.data(),
-                       num_regions,
-                       children_per_region);
-
-    // is the old sub_regions.dLeftCoord getting free?
-    // is the old sub_regions.dLength getting free?
-
+                       num_regions);
     sub_regions.size = num_regions * children_per_region;
-    sub_regions.dLeftCoord = children_left_coord;
-    sub_regions.dLength = children_length;
   }
 
   void
-  divideIntervalsGPU(T* genRegions,
-                     T* genRegionsLength,
-                     T* activeRegions,
-                     T* activeRegionsLength,
+  divideIntervalsGPU(pagani::Region_pages<T, ndim> regions,
                      int* activeRegionsBisectDim,
-                     size_t numActiveRegions,
-                     int numOfDivisionOnDimension)
+                     size_t numActiveRegions)
   {
-    size_t numThreads = 64;
-    size_t numBlocks =
-      numActiveRegions / numThreads + ((numActiveRegions % numThreads) ? 1 : 0);
-    Kokkos::TeamPolicy<Kokkos::LaunchBounds<64, 18>> team_policy1(numBlocks,
-                                                                  numThreads);
-    auto team_policy = Kokkos::Experimental::require(
-      team_policy1, Kokkos::Experimental::WorkItemProperty::HintLightWeight);
-
-    Kokkos::parallel_for(
+    pagani::parallel_for_regions(
       "DivideIntervalsGPU",
-      team_policy,
-      KOKKOS_LAMBDA(const member_type team_member) {
+      numActiveRegions,
+      team_size,
+      KOKKOS_LAMBDA(const member_type& team_member, int numThreads) {
         int threadIdx = team_member.team_rank();
         int blockIdx = team_member.league_rank();
         size_t tid = blockIdx * numThreads + threadIdx;
 
         if (tid < numActiveRegions) {
+          const int bisectdim = activeRegionsBisectDim[tid];
+          const size_t sibling = numActiveRegions + tid;
 
-          int bisectdim = activeRegionsBisectDim[tid];
-          size_t data_size = numActiveRegions * numOfDivisionOnDimension;
-
-          for (int i = 0; i < numOfDivisionOnDimension; ++i) {
-            for (size_t dim = 0; dim < ndim; ++dim) {
-              genRegions[i * numActiveRegions + dim * data_size + tid] =
-                activeRegions[dim * numActiveRegions + tid];
-              genRegionsLength[i * numActiveRegions + dim * data_size + tid] =
-                activeRegionsLength[dim * numActiveRegions + tid];
-            }
+          for (size_t dim = 0; dim < ndim; ++dim) {
+            regions.left(sibling, dim) = regions.left(tid, dim);
+            regions.length(sibling, dim) = regions.length(tid, dim);
           }
 
-          for (int i = 0; i < numOfDivisionOnDimension; ++i) {
-
-            double interval_length =
-              activeRegionsLength[bisectdim * numActiveRegions + tid] /
-              numOfDivisionOnDimension;
-
-            genRegions[bisectdim * data_size + i * numActiveRegions + tid] =
-              activeRegions[bisectdim * numActiveRegions + tid] +
-              i * interval_length;
-            genRegionsLength[i * numActiveRegions + bisectdim * data_size +
-                             tid] = interval_length;
-          }
+          const double interval_length = regions.length(tid, bisectdim) / 2;
+          regions.length(tid, bisectdim) = interval_length;
+          regions.length(sibling, bisectdim) = interval_length;
+          regions.left(sibling, bisectdim) += interval_length;
         }
-      });
+      },
+      space);
   }
 };
-#endif
\ No newline at end of file
+#endif
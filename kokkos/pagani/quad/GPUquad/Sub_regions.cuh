@@ -2,9 +2,68 @@
 #define KOKKOS_SUB_REGIONS_CUH
 
 #include <iostream>
+#include <vector>
 #include "common/kokkos/cudaMemoryUtil.h"
 #include "common/kokkos/Volume.cuh"
 
+namespace pagani {
+
+  // Region coordinates are stored in fixed-size pages of region_page_size
+  // regions. A page holds the left coordinates of its regions dimension by
+  // dimension, followed by their lengths, so each page is a small SoA block.
+  constexpr size_t region_page_bits = 12;
+  constexpr size_t region_page_size = size_t{1} << region_page_bits;
+
+  inline size_t
+  num_region_pages(size_t num_regions)
+  {
+    return (num_regions + region_page_size - 1) / region_page_size;
+  }
+
+  // filtering compacts the pages through a buffer of an eighth of them
+  inline size_t
+  num_compaction_pages(size_t num_pages)
+  {
+    return num_pages == 0 ? 0 : (num_pages + 7) / 8;
+  }
+
+  // doubles held by the coordinates of num_regions regions, including the
+  // compaction buffer
+  inline size_t
+  region_storage_doubles(size_t num_regions, size_t ndim)
+  {
+    const size_t num_pages = num_region_pages(num_regions);
+    return 2 * ndim * region_page_size *
+           (num_pages + num_compaction_pages(num_pages));
+  }
+
+  template <typename T>
+  struct Region_page {
+    T* data = nullptr;
+  };
+
+  // device side handle of the page table, cheap to capture in kernels
+  template <typename T, size_t ndim>
+  struct Region_pages {
+    KOKKOS_INLINE_FUNCTION T&
+    left(size_t region, size_t dim) const
+    {
+      return table(region >> region_page_bits)
+        .data[dim * region_page_size + (region & (region_page_size - 1))];
+    }
+
+    KOKKOS_INLINE_FUNCTION T&
+    length(size_t region, size_t dim) const
+    {
+      return table(region >> region_page_bits)
+        .data[(ndim + dim) * region_page_size +
+              (region & (region_page_size - 1))];
+    }
+
+    Kokkos::View<Region_page<T>*, Kokkos::CudaSpace> table;
+  };
+}
+
 template <typename T, size_t ndim>
 struct Sub_regions {
 
@@ -22,53 +81,167 @@ struct Sub_regions {
   Sub_regions(const Sub_regions<T, ndim>& other)
   {
     device_init(other.size);
-    dLeftCoord = other.dLeftCoord;
-    dLength = other.dLength;
-    // Kokkos::deep_copy(dLeftCoord, other.dLeftCoord);
-    // Kokkos::deep_copy(dLength, other.dLength);
+    copy_pages(other.pages, pages);
+    Kokkos::fence();
+  }
+
+  Sub_regions(Sub_regions<T, ndim>&&) = default;
+
+  // deep, like the copy constructor; the snapshot is not copied
+  Sub_regions&
+  operator=(const Sub_regions<T, ndim>& other)
+  {
+    if (this == &other)
+      return *this;
+    device_init(other.size);
+    copy_pages(other.pages, pages);
+    Kokkos::fence();
+    return *this;
   }
 
+  Sub_regions& operator=(Sub_regions<T, ndim>&&) = default;
+
+  // only the first split_axes axes are divided, the others span [0, 1]
   void
-  create_uniform_split(size_t numOfDivisionPerRegionPerDimension)
+  create_uniform_split(size_t numOfDivisionPerRegionPerDimension,
+                       size_t split_axes = ndim,
+                       const ExecSpace& space = ExecSpace())
   {
     size_t num_starting_regions =
-      pow((double)numOfDivisionPerRegionPerDimension, (double)ndim);
+      pow((double)numOfDivisionPerRegionPerDimension, (double)split_axes);
     double starting_axis_length =
       1. / (double)numOfDivisionPerRegionPerDimension;
-    device_init(num_starting_regions);
+    device_init(num_starting_regions, space);
+    pagani::Region_pages<T, ndim> regions = coords;
     Kokkos::parallel_for(
       "GenerateInitialRegions",
-      Kokkos::RangePolicy<>(0, num_starting_regions),
-      [=, *this] __host__ __device__(const int reg) {
+      Kokkos::RangePolicy<ExecSpace>(space, 0, num_starting_regions),
+      KOKKOS_LAMBDA(const int reg) {
         for (int dim = 0; dim < (int)ndim; ++dim) {
+          if (dim >= (int)split_axes) {
+            regions.left(reg, dim) = 0.;
+            regions.length(reg, dim) = 1.;
+            continue;
+          }
           size_t _id =
             (int)(reg / pow((double)numOfDivisionPerRegionPerDimension, dim)) %
             numOfDivisionPerRegionPerDimension;
-          dLeftCoord[num_starting_regions * dim + reg] =
-            static_cast<double>(_id) *
-            static_cast<double>(starting_axis_length);
-          dLength[num_starting_regions * dim + reg] = starting_axis_length;
+          regions.left(reg, dim) = static_cast<double>(_id) *
+                                   static_cast<double>(starting_axis_length);
+          regions.length(reg, dim) = starting_axis_length;
         }
       });
     size = num_starting_regions;
   }
 
   void
-  device_init(size_t const numRegions)
+  device_init(size_t const numRegions, const ExecSpace& space = ExecSpace())
   {
+    release_pages(0);
+    reserve(numRegions, space);
     size = numRegions;
-    dLeftCoord = quad::cuda_malloc<T>(numRegions * ndim);
-    dLength = quad::cuda_malloc<T>(numRegions * ndim);
   }
 
+  // makes room for num_regions regions, reusing released pages before
+  // allocating new ones; the regions already stored stay in place
   void
-  print_bounds()
+  reserve(size_t num_regions, const ExecSpace& space = ExecSpace())
+  {
+    const size_t num_pages = pagani::num_region_pages(num_regions);
+    if (num_pages <= pages.size())
+      return;
+
+    while (pages.size() < num_pages) {
+      if (free_pages.empty()) {
+        pages.push_back(
+          quad::cuda_malloc<T>(2 * ndim * pagani::region_page_size, space));
+      } else {
+        pages.push_back(free_pages.back());
+        free_pages.pop_back();
+      }
+    }
+    update_page_table(space);
+  }
+
+  // keeps the pages covering the first num_regions regions, the others go
+  // back to the pool
+  void
+  release_pages(size_t num_regions)
+  {
+    const size_t num_pages = pagani::num_region_pages(num_regions);
+    while (pages.size() > num_pages) {
+      free_pages.push_back(pages.back());
+      pages.pop_back();
+    }
+  }
+
+  // returns the pooled pages to the device
+  void
+  trim()
+  {
+    free_pages.clear();
+    compaction_buffer = ViewVectorDouble();
+  }
+
+  size_t
+  capacity() const
+  {
+    return pages.size() * pagani::region_page_size;
+  }
+
+  // device buffer holding num_regions regions in the compaction layout,
+  // grown on demand and kept between filters
+  ViewVectorDouble
+  get_compaction_buffer(size_t num_regions,
+                        const ExecSpace& space = ExecSpace())
+  {
+    if (compaction_buffer.extent(0) < 2 * ndim * num_regions)
+      compaction_buffer = quad::cuda_malloc<T>(2 * ndim * num_regions, space);
+    return compaction_buffer;
+  }
+
+  // coordinates in the flat layout with stride size, left coordinates of
+  // region i in dimension dim at dim * size + i
+  ViewVectorDouble
+  flat_left_coord(const ExecSpace& space = ExecSpace()) const
+  {
+    return flatten(true, space);
+  }
+
+  ViewVectorDouble
+  flat_length(const ExecSpace& space = ExecSpace()) const
   {
-    auto LeftCoord = Kokkos::create_mirror_view(dLeftCoord);
-    auto Length = Kokkos::create_mirror_view(dLength);
+    return flatten(false, space);
+  }
+
+  // replaces the regions by num_regions regions in the flat layout
+  void
+  assign(ViewVectorDouble left,
+         ViewVectorDouble length,
+         size_t num_regions,
+         const ExecSpace& space = ExecSpace())
+  {
+    device_init(num_regions, space);
+    pagani::Region_pages<T, ndim> regions = coords;
+    Kokkos::parallel_for(
+      "AssignRegions",
+      Kokkos::RangePolicy<ExecSpace>(space, 0, num_regions),
+      KOKKOS_LAMBDA(const size_t reg) {
+        for (size_t dim = 0; dim < ndim; ++dim) {
+          regions.left(reg, dim) = left(dim * num_regions + reg);
+          regions.length(reg, dim) = length(dim * num_regions + reg);
+        }
+      });
+    space.fence();
+  }
 
-    Kokkos::deep_copy(dLeftCoord, LeftCoord);
-    Kokkos::deep_copy(dLength, Length);
+  void
+  print_bounds()
+  {
+    auto LeftCoord = Kokkos::create_mirror_view_and_copy(Kokkos::HostSpace(),
+                                                         flat_left_coord());
+    auto Length =
+      Kokkos::create_mirror_view_and_copy(Kokkos::HostSpace(), flat_length());
 
     for (size_t i = 0; i < size; i++) {
       for (size_t dim = 0; dim < ndim; dim++) {
@@ -98,13 +271,8 @@ struct Sub_regions {
   T
   compute_total_volume()
   {
-
-    printf("about to compute_total_volume\n");
-    auto LeftCoord = Kokkos::create_mirror_view(dLeftCoord);
-    auto Length = Kokkos::create_mirror_view(dLength);
-
-    Kokkos::deep_copy(LeftCoord, dLeftCoord);
-    Kokkos::deep_copy(Length, dLength);
+    auto Length =
+      Kokkos::create_mirror_view_and_copy(Kokkos::HostSpace(), flat_length());
 
     T total_vol = 0.;
     for (size_t regID = 0; regID < size; regID++) {
@@ -115,78 +283,108 @@ struct Sub_regions {
   }
 
   void
-  uniform_split(size_t numOfDivisionPerRegionPerDimension)
+  uniform_split(size_t numOfDivisionPerRegionPerDimension,
+                size_t split_axes = ndim,
+                const ExecSpace& space = ExecSpace())
   {
-    size_t num_starting_regions =
-      pow((T)numOfDivisionPerRegionPerDimension, (T)ndim);
-    T starting_axis_length = 1. / (T)numOfDivisionPerRegionPerDimension;
-
-    device_init(num_starting_regions);
-
-    create_uniform_split(numOfDivisionPerRegionPerDimension);
-    size = num_starting_regions;
+    create_uniform_split(numOfDivisionPerRegionPerDimension, split_axes, space);
   }
 
   quad::Volume<T, ndim>
   extract_region(size_t const regionID)
   {
-    auto LeftCoord = Kokkos::create_mirror_view(dLeftCoord);
-    auto Length = Kokkos::create_mirror_view(dLength);
+    ViewVectorDouble bounds = quad::cuda_malloc<T>(2 * ndim);
+    pagani::Region_pages<T, ndim> regions = coords;
+    Kokkos::parallel_for(
+      "ExtractRegion",
+      Kokkos::RangePolicy<>(0, ndim),
+      KOKKOS_LAMBDA(const size_t dim) {
+        bounds(dim) = regions.left(regionID, dim);
+        bounds(ndim + dim) = regions.length(regionID, dim);
+      });
+    auto host_bounds =
+      Kokkos::create_mirror_view_and_copy(Kokkos::HostSpace(), bounds);
 
     quad::Volume<T, ndim> regionID_bounds;
     for (size_t dim = 0; dim < ndim; dim++) {
-      size_t region_index = size * dim + regionID;
-      regionID_bounds.lows[dim] = LeftCoord[region_index];
-      regionID_bounds.highs[dim] =
-        LeftCoord[region_index] + Length[region_index];
+      regionID_bounds.lows[dim] = host_bounds(dim);
+      regionID_bounds.highs[dim] = host_bounds(dim) + host_bounds(ndim + dim);
     }
     return regionID_bounds;
   }
 
-  /*void
-  set_ptr_to_estimates(Region_estimates<T, ndim>* estimates)
-  {
-    assert(estimates != nullptr && estimates->size == this->size);
-    region_estimates = estimates;
-  }
-
-  void
-  set_ptr_to_characteristics(Region_characteristics<ndim>* charactrs)
-  {
-    assert(charactrs != nullptr && charactrs->size == this->size);
-    characteristics = charactrs;
-  }
-*/
   void
   take_snapshot()
   {
     snapshot_size = size;
-    snapshot_dLeftCoord = quad::cuda_malloc<T>(size * ndim);
-    snapshot_dLength = quad::cuda_malloc<T>(size * ndim);
-    quad::cuda_memcpy_device_to_device<T>(
-      snapshot_dLeftCoord, dLeftCoord, size * ndim);
-    quad::cuda_memcpy_device_to_device<T>(
-      snapshot_dLength, dLength, size * ndim);
+    snapshot_pages.clear();
+    for (size_t page = 0; page < pages.size(); ++page)
+      snapshot_pages.push_back(
+        quad::cuda_malloc<T>(2 * ndim * pagani::region_page_size));
+    copy_pages(pages, snapshot_pages);
   }
 
+  // copies the snapshot back, which stays valid for further loads
   void
   load_snapshot()
   {
-    dLeftCoord = snapshot_dLeftCoord;
-    dLength = snapshot_dLength;
-    size = snapshot_size;
+    device_init(snapshot_size);
+    copy_pages(snapshot_pages, pages);
+    Kokkos::fence();
   }
 
   // device side variables
-  ViewVectorDouble dLeftCoord;
-  ViewVectorDouble dLength;
+  pagani::Region_pages<T, ndim> coords;
 
-  ViewVectorDouble snapshot_dLeftCoord;
-  ViewVectorDouble snapshot_dLength;
+  std::vector<ViewVectorDouble> pages;
+  std::vector<ViewVectorDouble> free_pages;
+  std::vector<ViewVectorDouble> snapshot_pages;
+  ViewVectorDouble compaction_buffer;
 
   size_t size = 0;
-  size_t host_data_size = 0;
   size_t snapshot_size = 0;
+
+  void
+  update_page_table(const ExecSpace& space)
+  {
+    Kokkos::View<pagani::Region_page<T>*, Kokkos::CudaSpace> table(
+      Kokkos::view_alloc(space, "region_pages"), pages.size());
+    auto host_table = Kokkos::create_mirror_view(table);
+    for (size_t page = 0; page < pages.size(); ++page)
+      host_table(page).data = pages[page].data();
+    Kokkos::deep_copy(space, table, host_table);
+    space.fence();
+    coords.table = table;
+  }
+
+  static void
+  copy_pages(std::vector<ViewVectorDouble> const& from,
+             std::vector<ViewVectorDouble> const& to)
+  {
+    for (size_t page = 0; page < from.size() && page < to.size(); ++page)
+      Kokkos::deep_copy(to[page], from[page]);
+  }
+
+  ViewVectorDouble
+  flatten(bool left_coord, const ExecSpace& space) const
+  {
+    const size_t num_regions = size;
+    ViewVectorDouble flat = quad::cuda_malloc<T>(num_regions * ndim, space);
+    if (num_regions == 0)
+      return flat;
+
+    pagani::Region_pages<T, ndim> regions = coords;
+    Kokkos::parallel_for(
+      "FlattenRegions",
+      Kokkos::RangePolicy<ExecSpace>(space, 0, num_regions),
+      KOKKOS_LAMBDA(const size_t reg) {
+        for (size_t dim = 0; dim < ndim; ++dim)
+          flat(dim * num_regions + reg) =
+            left_coord ? regions.left(reg, dim) : regions.length(reg, dim);
+      });
+    space.fence();
+    return flat;
+  }
 };
 
-#endif
\ No newline at end of file
+#endif
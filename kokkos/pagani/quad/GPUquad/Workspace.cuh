@@ -9,7 +9,10 @@
 #include "kokkos/pagani/quad/GPUquad/Sub_region_splitter.cuh"
 #include "kokkos/pagani/quad/GPUquad/Sub_region_filter.cuh"
 #include "kokkos/pagani/quad/GPUquad/heuristic_classifier.cuh"
+#include "kokkos/pagani/quad/GPUquad/Local_refinement.cuh"
+#include "kokkos/pagani/quad/GPUquad/Launch_policy.cuh"
 #include "common/integration_result.hh"
+#include "common/integration_scheduler.hh"
 #include "common/kokkos/Volume.cuh"
 #include "common/kokkos/cudaMemoryUtil.h"
 
@@ -21,14 +24,19 @@ output_iter_data()
     return;
 }
 
-template <typename T, size_t ndim, bool use_custom = false, bool collect_mult_runs = false>
+template <typename T,
+          size_t ndim,
+          bool use_custom = false,
+          bool collect_mult_runs = false,
+          pagani::Cubature_rule rule = pagani::Cubature_rule::degree9,
+          typename Reducer = Local_reducer>
 class Workspace {
   using Estimates = Region_estimates<T, ndim>;
   using Sub_regs = Sub_regions<T, ndim>;
   using Regs_characteristics = Region_characteristics<ndim>;
   using Filter = Sub_regions_filter<T, ndim, use_custom>;
   using Splitter = Sub_region_splitter<T, ndim>;
-  using Classifier = Heuristic_classifier<T, ndim, use_custom>;
+  using Classifier = Heuristic_classifier<T, ndim, use_custom, Reducer>;
   std::ofstream outiters;
 
 private:
@@ -43,12 +51,108 @@ private:
                           numint::integration_result& finished,
                           const numint::integration_result& iter,
                           const numint::integration_result& cummulative);
+  template <typename IntegT>
+  bool refine_locally(IntegT* d_integrand,
+                      const Sub_regs& subregions,
+                      size_t peak_num_regions,
+                      size_t num_active_regions,
+                      T active_estimate,
+                      T epsrel,
+                      T epsabs,
+                      numint::integration_result& cummulative,
+                      bool& enabled);
+
+  // the degree 7 rule starts with the leading axes halved, as many as keep
+  // the first iteration within about 2^23 evaluations
+  static constexpr size_t
+  degree7_split_axes()
+  {
+    constexpr size_t feval = pagani::CuhreFuncEvalsPerRegion<ndim, rule>();
+    size_t axes = 0;
+    while (axes < ndim && (size_t{2} << axes) * feval <= (size_t{1} << 23))
+      ++axes;
+    return axes;
+  }
 
-  Cubature_rules<T, ndim, use_custom> rules;
+  Cubature_rules<T, ndim, use_custom, rule> rules;
+  pagani::Launch_policy launch;
+  // every kernel, reduction and read-back of the workspace is queued on
+  // space, so workspaces bound to different instances run concurrently
+  ExecSpace space;
+  // device memory the classifier may plan with, 0 for the whole device
+  size_t memory_budget = 0;
+  // active regions below which the remaining ones are refined per team; 0,
+  // the default, disables the local phase
+  size_t local_refinement_threshold = 0;
+
+protected:
+  // the identity for a single workspace; over MPI it sums every estimate,
+  // error estimate and region count of the loop over the ranks
+  Reducer reducer;
+
+  explicit Workspace(const Reducer& reducer) : reducer(reducer) {}
+
+  void initial_partition(Sub_regs& subregions) const;
+
+  struct no_hook {
+    void
+    operator()(Sub_regs&, Regs_characteristics&, Estimates&) const
+    {}
+  };
+
+  // the main loop of integrate; after_filter gets the active regions with
+  // their sub-dividing dimensions and parent estimates before they are split
+  template <typename IntegT, bool predict_split, int debug, typename Hook>
+  numint::integration_result refine(const IntegT& integrand,
+                                    Sub_regs& subregions,
+                                    T epsrel,
+                                    T epsabs,
+                                    quad::Volume<T, ndim> const& vol,
+                                    bool relerr_classification,
+                                    Hook after_filter);
 
 public:
   Workspace() = default;
   Workspace(T* lows, T* highs) : Cubature_rules<T, ndim>(lows, highs) {}
+  explicit Workspace(const pagani::Launch_policy& launch) : launch(launch) {}
+  explicit Workspace(const ExecSpace& space,
+                     size_t memory_budget = 0,
+                     const pagani::Launch_policy& launch = {})
+    : launch(launch), space(space), memory_budget(memory_budget)
+  {}
+
+  const ExecSpace&
+  execution_space() const
+  {
+    return space;
+  }
+
+  void
+  set_memory_budget(size_t bytes)
+  {
+    memory_budget = bytes;
+  }
+
+  void
+  set_launch_policy(const pagani::Launch_policy& policy)
+  {
+    launch = policy;
+  }
+
+  const pagani::Launch_policy&
+  launch_policy() const
+  {
+    return launch;
+  }
+
+  void
+  set_local_refinement_threshold(size_t num_regions)
+  {
+    local_refinement_threshold = num_regions;
+  }
+
+  // subregions are read on the workspace's instance, regions generated on
+  // another one have to be fenced first
   template <typename IntegT,
             bool predict_split = false,
             bool collect_iters = false,
@@ -70,25 +174,50 @@ public:
                                        T epsabs,
                                        quad::Volume<T, ndim> const& vol,
                                        bool relerr_classification = true);
+
+  // Starts the integration on a host thread and returns at once. The
+  // integrand and volume are copied, the workspace is not: it has to stay
+  // alive and untouched until the future is ready. To overlap integrations
+  // on a GPU give each one a workspace on its own execution space instance.
+  template <typename IntegT>
+  std::future<numint::integration_result>
+  integrate_async(const IntegT& integrand,
+                  T epsrel,
+                  T epsabs,
+                  quad::Volume<T, ndim> const& vol,
+                  bool relerr_classification = true)
+  {
+    return numint::integrate_async(
+      *this, integrand, epsrel, epsabs, vol, relerr_classification);
+  }
 };
 
-template <typename T, size_t ndim, bool use_custom, bool collect_mult_runs>
+template <typename T,
+          size_t ndim,
+          bool use_custom,
+          bool collect_mult_runs,
+          pagani::Cubature_rule rule,
+          typename Reducer>
 bool
-Workspace<T, ndim, use_custom, collect_mult_runs>::heuristic_classify(
-  Classifier& classifier,
-  Region_characteristics<ndim>& characteristics,
-  const Estimates& estimates,
-  numint::integration_result& finished,
-  const numint::integration_result& iter,
-  const numint::integration_result& cummulative)
+Workspace<T, ndim, use_custom, collect_mult_runs, rule, Reducer>::
+  heuristic_classify(
+    Classifier& classifier,
+    Region_characteristics<ndim>& characteristics,
+    const Estimates& estimates,
+    numint::integration_result& finished,
+    const numint::integration_result& iter,
+    const numint::integration_result& cummulative)
 {
 
+  // memory is limited by the largest shard
+  const size_t largest_shard = reducer.max(characteristics.size);
   const T ratio = static_cast<T>(classifier.device_mem_required_for_full_split(
-                    characteristics.size)) /
-                  static_cast<T>(free_device_mem(characteristics.size, ndim));
+                    largest_shard)) /
+                  static_cast<T>(
+                    free_device_mem(largest_shard, ndim, memory_budget));
   const bool classification_necessary = ratio > 1.;
 
-  if (!classifier.classification_criteria_met(characteristics.size)) {
+  if (!classifier.classification_criteria_met(largest_shard)) {
     const bool must_terminate = classification_necessary;
     return must_terminate;
   }
@@ -105,9 +234,11 @@ Workspace<T, ndim, use_custom, collect_mult_runs>::heuristic_classify(
 
   if (hs_classify_success) {
     characteristics.active_regions = hs_results.active_flags;
-    finished.estimate = iter.estimate - dot_product<int, T, use_custom>(
-                                          characteristics.active_regions,
-                                          estimates.integral_estimates);
+    finished.estimate =
+      iter.estimate - reducer.sum(dot_product<int, T, use_custom>(
+                        characteristics.active_regions,
+                        estimates.integral_estimates,
+                        space));
     finished.errorest = hs_results.finished_errorest;
   }
 
@@ -117,14 +248,83 @@ Workspace<T, ndim, use_custom, collect_mult_runs>::heuristic_classify(
   return must_terminate;
 }
 
-template <typename T, size_t ndim, bool use_custom, bool collect_mult_runs>
+template <typename T,
+          size_t ndim,
+          bool use_custom,
+          bool collect_mult_runs,
+          pagani::Cubature_rule rule,
+          typename Reducer>
+template <typename IntegT>
+bool
+Workspace<T, ndim, use_custom, collect_mult_runs, rule, Reducer>::
+  refine_locally(
+    IntegT* d_integrand,
+    const Sub_regs& subregions,
+    size_t peak_num_regions,
+    size_t num_active_regions,
+    T active_estimate,
+    T epsrel,
+    T epsabs,
+    numint::integration_result& cummulative,
+    bool& enabled)
+{
+  // only once the active set has shrunk to a size that cannot keep the
+  // global pipeline busy
+  if (!enabled || peak_num_regions <= local_refinement_threshold ||
+      num_active_regions > local_refinement_threshold ||
+      num_active_regions == 0)
+    return false;
+
+  const T budget =
+    std::max(epsrel * std::abs(cummulative.estimate + active_estimate),
+             epsabs) -
+    cummulative.errorest;
+  if (budget <= 0.)
+    return false;
+
+  numint::integration_result local =
+    quad::team_local_refinement<IntegT, T, ndim, rule>(
+      d_integrand,
+      rules.constMem,
+      rules.generators,
+      rules.integ_space_lows,
+      rules.integ_space_highs,
+      subregions,
+      budget / static_cast<T>(num_active_regions),
+      space);
+  // a team filled its heap first: the regions stay with the global loop,
+  // which also finishes the run, on every rank
+  if (reducer.any(subregions.size > 0 && local.status != 0)) {
+    enabled = false;
+    return false;
+  }
+
+  cummulative.estimate += reducer.sum(local.estimate);
+  cummulative.errorest += reducer.sum(local.errorest);
+  cummulative.nregions += reducer.sum(local.nregions);
+  cummulative.status = accuracy_reached(epsrel,
+                                        epsabs,
+                                        std::abs(cummulative.estimate),
+                                        cummulative.errorest) ?
+                         0 :
+                         1;
+  return true;
+}
+
+template <typename T,
+          size_t ndim,
+          bool use_custom,
+          bool collect_mult_runs,
+          pagani::Cubature_rule rule,
+          typename Reducer>
 void
-Workspace<T, ndim, use_custom, collect_mult_runs>::fix_error_budget_overflow(
-  Region_characteristics<ndim>& characteristics,
-  const numint::integration_result& cummulative_finished,
-  const numint::integration_result& iter,
-  numint::integration_result& iter_finished,
-  const T epsrel)
+Workspace<T, ndim, use_custom, collect_mult_runs, rule, Reducer>::
+  fix_error_budget_overflow(
+    Region_characteristics<ndim>& characteristics,
+    const numint::integration_result& cummulative_finished,
+    const numint::integration_result& iter,
+    numint::integration_result& iter_finished,
+    const T epsrel)
 {
 
   T leaves_estimate = cummulative_finished.estimate + iter.estimate;
@@ -132,21 +332,26 @@ Workspace<T, ndim, use_custom, collect_mult_runs>::fix_error_budget_overflow(
     cummulative_finished.errorest + iter_finished.errorest;
 
   if (leaves_finished_errorest > abs(leaves_estimate) * epsrel) {
-    size_t num_threads = 256;
-    size_t num_blocks = characteristics.size / num_threads +
-                        (characteristics.size % num_threads == 0 ? 0 : 1);
-
-    quad::set_array_to_value<int>(
-      characteristics.active_regions.data(), characteristics.size, 1);
+    ViewVectorInt active_regions = characteristics.active_regions;
+    Kokkos::parallel_for(
+      "ReactivateRegions",
+      Kokkos::RangePolicy<ExecSpace>(space, 0, characteristics.size)
+        .set_chunk_size(launch.reset_chunk),
+      KOKKOS_LAMBDA(const size_t i) { active_regions(i) = 1; });
     iter_finished.errorest = 0.;
     iter_finished.estimate = 0.;
   }
 }
 
-template <typename T, size_t ndim, bool use_custom, bool collect_mult_runs>
+template <typename T,
+          size_t ndim,
+          bool use_custom,
+          bool collect_mult_runs,
+          pagani::Cubature_rule rule,
+          typename Reducer>
 template <typename IntegT, bool predict_split, bool collect_iters, int debug>
 numint::integration_result
-Workspace<T, ndim, use_custom, collect_mult_runs>::integrate(const IntegT& integrand,
+Workspace<T, ndim, use_custom, collect_mult_runs, rule, Reducer>::integrate(const IntegT& integrand,
                                           Sub_regions<T, ndim>& subregions,
                                           T epsrel,
                                           T epsabs,
@@ -159,21 +364,24 @@ Workspace<T, ndim, use_custom, collect_mult_runs>::integrate(const IntegT& integ
     std::chrono::duration<T, std::chrono::milliseconds::period>;
 
   CustomTimer timer;
-  rules.set_device_volume(vol.lows, vol.highs);
+  rules.set_device_volume(vol.lows, vol.highs, space);
   Estimates prev_iter_estimates;
   numint::integration_result cummulative;
   Recorder<debug, collect_mult_runs> iter_recorder("kokkos_pagani_iters.csv");
   Recorder<debug, collect_mult_runs> time_breakdown("kokkos_pagani_time_breakdown.csv");
 
-  Classifier classifier(epsrel, epsabs);
+  Classifier classifier(epsrel, epsabs, reducer, space, memory_budget);
   cummulative.status = 1;
   bool compute_relerr_error_reduction = false;
   IntegT* d_integrand = quad::make_gpu_integrand<IntegT>(integrand);
-  
+  size_t peak_num_regions = 0;
+  bool local_phase = local_refinement_threshold != 0;
+  Filter filter(subregions.size, launch.filter, space);
+
   for (size_t it = 0; it < 700 && subregions.size > 0; it++) {
     size_t num_regions = subregions.size;
-    Regs_characteristics characteristics(subregions.size);
-    Estimates estimates(subregions.size);
+    Regs_characteristics characteristics(subregions.size, space);
+    Estimates estimates(subregions.size, space);
 
     if constexpr (debug > 0) {
       timer = std::chrono::high_resolution_clock::now();
@@ -186,7 +394,9 @@ Workspace<T, ndim, use_custom, collect_mult_runs>::integrate(const IntegT& integ
         subregions,
         estimates,
         characteristics,
-        compute_relerr_error_reduction);
+        compute_relerr_error_reduction,
+        launch.cubature,
+        space);
 
     if constexpr (debug > 0) {
       MilliSeconds dt = std::chrono::high_resolution_clock::now() - timer;
@@ -210,10 +420,13 @@ Workspace<T, ndim, use_custom, collect_mult_runs>::integrate(const IntegT& integ
                                                     prev_iter_estimates,
                                                     characteristics,
                                                     epsrel,
-                                                    relerr_classification);
+                                                    relerr_classification,
+                                                    launch.refine_error,
+                                                    space);
 
     iter.errorest =
-      reduction<T, use_custom>(estimates.error_estimates, subregions.size);
+      reduction<T, use_custom>(
+        estimates.error_estimates, subregions.size, space);
 
     if constexpr (debug > 0) {
       MilliSeconds dt = std::chrono::high_resolution_clock::now() - timer;
@@ -257,7 +470,7 @@ Workspace<T, ndim, use_custom, collect_mult_runs>::integrate(const IntegT& integ
     classifier.store_estimate(cummulative.estimate + iter.estimate);
     numint::integration_result finished =
       compute_finished_estimates<T, ndim, use_custom>(
-        estimates, characteristics, iter);
+        estimates, characteristics, iter, space);
 
     if constexpr (debug > 0) {
       MilliSeconds dt = std::chrono::high_resolution_clock::now() - timer;
@@ -315,8 +528,7 @@ Workspace<T, ndim, use_custom, collect_mult_runs>::integrate(const IntegT& integ
       timer = std::chrono::high_resolution_clock::now();
     }
 
-    Filter filter_obj(subregions.size);
-    size_t num_active_regions = filter_obj.filter(
+    size_t num_active_regions = filter.filter(
       subregions, characteristics, estimates, prev_iter_estimates);
 
     cummulative.nregions += num_regions - num_active_regions;
@@ -330,7 +542,21 @@ Workspace<T, ndim, use_custom, collect_mult_runs>::integrate(const IntegT& integ
       timer = std::chrono::high_resolution_clock::now();
     }
 
-    Splitter splitter(subregions.size);
+    peak_num_regions = std::max(peak_num_regions, num_regions);
+    if (refine_locally(d_integrand,
+                       subregions,
+                       peak_num_regions,
+                       subregions.size,
+                       iter.estimate - finished.estimate,
+                       epsrel,
+                       epsabs,
+                       cummulative,
+                       local_phase)) {
+      Kokkos::kokkos_free(d_integrand);
+      return cummulative;
+    }
+
+    Splitter splitter(subregions.size, launch.split, space);
     splitter.split(subregions, characteristics);
 
     if constexpr (debug > 0) {
@@ -345,61 +571,86 @@ Workspace<T, ndim, use_custom, collect_mult_runs>::integrate(const IntegT& integ
   return cummulative;
 }
 
-template <typename T, size_t ndim, bool use_custom, bool collect_mult_runs>
-template <typename IntegT, bool predict_split, bool collect_iters, int debug>
-numint::integration_result
-Workspace<T, ndim, use_custom, collect_mult_runs>::integrate(const IntegT& integrand,
-                                          T epsrel,
-                                          T epsabs,
-                                          quad::Volume<T, ndim> const& vol,
-                                          bool relerr_classification)
+template <typename T,
+          size_t ndim,
+          bool use_custom,
+          bool collect_mult_runs,
+          pagani::Cubature_rule rule,
+          typename Reducer>
+void
+Workspace<T, ndim, use_custom, collect_mult_runs, rule, Reducer>::
+  initial_partition(Sub_regs& subregions) const
 {
-  using MilliSeconds =
-    std::chrono::duration<T, std::chrono::milliseconds::period>;
-  rules.set_device_volume(vol.lows, vol.highs);
-  Estimates prev_iter_estimates;
-  numint::integration_result cummulative;
-  Recorder<debug, collect_mult_runs> iter_recorder("cuda_iters.csv");
-
   size_t partitions_per_axis = 2;
-  if (ndim < 5)
+  size_t split_axes = ndim;
+  if constexpr (pagani::uses_degree7<ndim, rule>())
+    split_axes = degree7_split_axes();
+  else if (ndim < 5)
     partitions_per_axis = 4;
   else if (ndim <= 10)
     partitions_per_axis = 2;
   else
     partitions_per_axis = 1;
 
-  Sub_regions<T, ndim> subregions(partitions_per_axis);
+  subregions.uniform_split(partitions_per_axis, split_axes, space);
+}
+
+template <typename T,
+          size_t ndim,
+          bool use_custom,
+          bool collect_mult_runs,
+          pagani::Cubature_rule rule,
+          typename Reducer>
+template <typename IntegT, bool predict_split, int debug, typename Hook>
+numint::integration_result
+Workspace<T, ndim, use_custom, collect_mult_runs, rule, Reducer>::refine(
+  const IntegT& integrand,
+  Sub_regs& subregions,
+  T epsrel,
+  T epsabs,
+  quad::Volume<T, ndim> const& vol,
+  bool relerr_classification,
+  Hook after_filter)
+{
+  rules.set_device_volume(vol.lows, vol.highs, space);
+  Estimates prev_iter_estimates;
+  numint::integration_result cummulative;
+  Recorder<debug, collect_mult_runs> iter_recorder("cuda_iters.csv");
+  const bool root = reducer.rank == 0;
 
-  Classifier classifier(epsrel, epsabs);
+  Classifier classifier(epsrel, epsabs, reducer, space, memory_budget);
   cummulative.status = 1;
   bool compute_relerr_error_reduction = false;
 
   IntegT* d_integrand = quad::make_gpu_integrand<IntegT>(integrand);
+  size_t peak_num_regions = 0;
+  bool local_phase = local_refinement_threshold != 0;
+  size_t total_regions = reducer.sum(subregions.size);
+  Filter filter(subregions.size, launch.filter, space);
 
   if constexpr (debug > 0) {
-    iter_recorder.outfile << "it, estimate, errorest, nregions" << std::endl;
+    if (root)
+      iter_recorder.outfile << "it, estimate, errorest, nregions" << std::endl;
   }
 
-  for (size_t it = 0; it < 700 && subregions.size > 0; it++) {
-    size_t num_regions = subregions.size;
-    Regs_characteristics characteristics(subregions.size);
-    Estimates estimates(subregions.size);
+  for (size_t it = 0; it < 700 && total_regions > 0; it++) {
+    Regs_characteristics characteristics(subregions.size, space);
+    Estimates estimates(subregions.size, space);
 
-    auto const t0 = std::chrono::high_resolution_clock::now();
-    numint::integration_result iter =
+    numint::integration_result local_iter =
       rules.template apply_cubature_integration_rules<IntegT, debug>(
         d_integrand,
         it,
         subregions,
         estimates,
         characteristics,
-        compute_relerr_error_reduction);
-    MilliSeconds dt = std::chrono::high_resolution_clock::now() - t0;
+        compute_relerr_error_reduction,
+        launch.cubature,
+        space);
 
     if constexpr (predict_split) {
       relerr_classification =
-        subregions.size <= 15000000 && it < 15 && cummulative.nregions == 0 ?
+        total_regions <= 15000000 && it < 15 && cummulative.nregions == 0 ?
           false :
           true;
     }
@@ -408,14 +659,24 @@ Workspace<T, ndim, use_custom, collect_mult_runs>::integrate(const IntegT& integ
                                                     prev_iter_estimates,
                                                     characteristics,
                                                     epsrel,
-                                                    relerr_classification);
-    iter.errorest =
-      reduction<T, use_custom>(estimates.error_estimates, subregions.size);
+                                                    relerr_classification,
+                                                    launch.refine_error,
+                                                    space);
+    local_iter.errorest =
+      reduction<T, use_custom>(
+        estimates.error_estimates, subregions.size, space);
 
-    if constexpr (debug > 0)
-      iter_recorder.outfile << it << "," << cummulative.estimate + iter.estimate
-                            << "," << cummulative.errorest + iter.errorest
-                            << "," << subregions.size << std::endl;
+    numint::integration_result iter = local_iter;
+    iter.estimate = reducer.sum(local_iter.estimate);
+    iter.errorest = reducer.sum(local_iter.errorest);
+
+    if constexpr (debug > 0) {
+      if (root)
+        iter_recorder.outfile << it << ","
+                              << cummulative.estimate + iter.estimate << ","
+                              << cummulative.errorest + iter.errorest << ","
+                              << total_regions << std::endl;
+    }
 
     if constexpr (predict_split) {
       if (cummulative.nregions == 0 && it == 15) {
@@ -430,7 +691,7 @@ Workspace<T, ndim, use_custom, collect_mult_runs>::integrate(const IntegT& integ
       cummulative.estimate += iter.estimate;
       cummulative.errorest += iter.errorest;
       cummulative.status = 0;
-      cummulative.nregions += subregions.size;
+      cummulative.nregions += total_regions;
       Kokkos::kokkos_free(d_integrand);
       return cummulative;
     }
@@ -438,7 +699,9 @@ Workspace<T, ndim, use_custom, collect_mult_runs>::integrate(const IntegT& integ
     classifier.store_estimate(cummulative.estimate + iter.estimate);
     numint::integration_result finished =
       compute_finished_estimates<T, ndim, use_custom>(
-        estimates, characteristics, iter);
+        estimates, characteristics, local_iter, space);
+    finished.estimate = reducer.sum(finished.estimate);
+    finished.errorest = reducer.sum(finished.errorest);
     fix_error_budget_overflow(
       characteristics, cummulative, iter, finished, epsrel);
     if (heuristic_classify(classifier,
@@ -449,25 +712,69 @@ Workspace<T, ndim, use_custom, collect_mult_runs>::integrate(const IntegT& integ
                            cummulative) == true) {
       cummulative.estimate += iter.estimate;
       cummulative.errorest += iter.errorest;
-      cummulative.nregions += subregions.size;
+      cummulative.nregions += total_regions;
       Kokkos::kokkos_free(d_integrand);
       return cummulative;
     }
 
     cummulative.estimate += finished.estimate;
     cummulative.errorest += finished.errorest;
-    Filter filter_obj(subregions.size);
-    size_t num_active_regions = filter_obj.filter(
+    size_t num_active_regions = filter.filter(
       subregions, characteristics, estimates, prev_iter_estimates);
-    cummulative.nregions += num_regions - num_active_regions;
     subregions.size = num_active_regions;
-    Splitter splitter(subregions.size);
+    characteristics.size = num_active_regions;
+    prev_iter_estimates.size = num_active_regions;
+
+    const size_t total_active_regions = reducer.sum(num_active_regions);
+    cummulative.nregions += total_regions - total_active_regions;
+    peak_num_regions = std::max(peak_num_regions, total_regions);
+    after_filter(subregions, characteristics, prev_iter_estimates);
+
+    if (refine_locally(d_integrand,
+                       subregions,
+                       peak_num_regions,
+                       total_active_regions,
+                       iter.estimate - finished.estimate,
+                       epsrel,
+                       epsabs,
+                       cummulative,
+                       local_phase)) {
+      Kokkos::kokkos_free(d_integrand);
+      return cummulative;
+    }
+    Splitter splitter(subregions.size, launch.split, space);
     splitter.split(subregions, characteristics);
+    total_regions = 2 * total_active_regions;
     cummulative.iters++;
   }
-  cummulative.nregions += subregions.size;
+  cummulative.nregions += total_regions;
   Kokkos::kokkos_free(d_integrand);
   return cummulative;
 }
 
+template <typename T,
+          size_t ndim,
+          bool use_custom,
+          bool collect_mult_runs,
+          pagani::Cubature_rule rule,
+          typename Reducer>
+template <typename IntegT, bool predict_split, bool collect_iters, int debug>
+numint::integration_result
+Workspace<T, ndim, use_custom, collect_mult_runs, rule, Reducer>::integrate(const IntegT& integrand,
+                                          T epsrel,
+                                          T epsabs,
+                                          quad::Volume<T, ndim> const& vol,
+                                          bool relerr_classification)
+{
+  Sub_regions<T, ndim> subregions;
+  initial_partition(subregions);
+  return refine<IntegT, predict_split, debug>(integrand,
+                                              subregions,
+                                              epsrel,
+                                              epsabs,
+                                              vol,
+                                              relerr_classification,
+                                              no_hook{});
+}
+
 #endif
@@ -5,6 +5,7 @@
 #include "common/kokkos/cudaMemoryUtil.h"
 #include "common/kokkos/thrust_utils.cuh"
 
+#include <limits>
 #include <string>
 
 template <typename T>
@@ -61,10 +62,13 @@ void
 device_set_true_for_larger_than(const T* arr,
                                 const T val,
                                 const size_t size,
-                                int* output_flags)
+                                int* output_flags,
+                                const ExecSpace& space = ExecSpace())
 {
   Kokkos::parallel_for(
-    "Loop1", size, KOKKOS_LAMBDA(const int& i) {
+    "Loop1",
+    Kokkos::RangePolicy<ExecSpace>(space, 0, size),
+    KOKKOS_LAMBDA(const int& i) {
       if (i < size) {
         output_flags[i] = arr[i] > val;
       }
@@ -76,9 +80,10 @@ void
 set_true_for_larger_than(const T* arr,
                          const T val,
                          const size_t size,
-                         int* output_flags)
+                         int* output_flags,
+                         const ExecSpace& space = ExecSpace())
 {
-  device_set_true_for_larger_than<T>(arr, val, size, output_flags);
+  device_set_true_for_larger_than<T>(arr, val, size, output_flags, space);
 }
 
 size_t
@@ -100,24 +105,20 @@ num_ints_needed(size_t num_regions)
 size_t
 num_doubles_needed(size_t num_regions, size_t ndim)
 { // move to pagani utils, has nothing to do with classifying
-  const size_t newActiveRegions = num_regions * ndim;
-  const size_t newActiveRegionsLength = num_regions * ndim;
+  // the coordinates are split and filtered in their pages, which only grow
+  // to hold the children
+  const size_t regionPages =
+    pagani::region_storage_doubles(2 * num_regions, ndim);
   const size_t parentExpansionEstimate = num_regions;
   const size_t parentExpansionErrorest = num_regions;
-  const size_t genRegions = num_regions * ndim * 2;
-  const size_t genRegionsLength = num_regions * ndim * 2;
 
-  const size_t regions = 2 * num_regions * ndim;
-  const size_t regionsLength = 2 * num_regions * ndim;
   const size_t regionsIntegral = 2 * num_regions;
   const size_t regionsError = 2 * num_regions;
   const size_t parentsIntegral = num_regions;
   const size_t parentsError = num_regions;
 
   return parentsError + parentsIntegral + regionsError + regionsIntegral +
-         regionsLength + regions + genRegionsLength + genRegions +
-         parentExpansionErrorest + parentExpansionEstimate +
-         newActiveRegionsLength + newActiveRegions;
+         regionPages + parentExpansionErrorest + parentExpansionEstimate;
 }
 
 size_t
@@ -127,10 +128,13 @@ device_mem_required_for_full_split(size_t num_regions, size_t ndim)
          4 * num_ints_needed(num_regions);
 }
 
+// memory_budget is the share of the device a workspace may use, 0 for all
+// of it
 size_t
-free_device_mem(size_t num_regions, size_t ndim)
+free_device_mem(size_t num_regions, size_t ndim, size_t memory_budget = 0)
 {
-  size_t total_physmem = total_device_mem();
+  size_t total_physmem =
+    memory_budget > 0 ? memory_budget : total_device_mem();
   size_t mem_occupied = device_mem_required_for_full_split(num_regions, ndim);
 
   // the 1 is so we don't divide by zero at any point when using this
@@ -139,7 +143,43 @@ free_device_mem(size_t num_regions, size_t ndim)
   return free_mem;
 }
 
-template <typename T, size_t ndim, bool use_custom = false>
+// reductions of classification statistics for a single workspace; a
+// distributed workspace substitutes a reducer over all of its ranks
+struct Local_reducer {
+  template <typename T>
+  T
+  sum(T val) const
+  {
+    return val;
+  }
+
+  template <typename T>
+  T
+  min(T val) const
+  {
+    return val;
+  }
+
+  template <typename T>
+  T
+  max(T val) const
+  {
+    return val;
+  }
+
+  bool
+  any(bool val) const
+  {
+    return val;
+  }
+
+  int rank = 0;
+};
+
+template <typename T,
+          size_t ndim,
+          bool use_custom = false,
+          typename Reducer = Local_reducer>
 class Heuristic_classifier {
 
   T epsrel = 0.;
@@ -150,13 +190,25 @@ class Heuristic_classifier {
   const size_t min_iters_for_convergence = 1;
   T max_percent_error_budget = .25;
   T max_active_regions_percentage = .5;
+  Reducer reducer;
+  ExecSpace space;
+  size_t memory_budget = 0;
 
   friend class Classification_res<T>;
 
 public:
   Heuristic_classifier() = default;
 
-  Heuristic_classifier(T rel_tol, T abs_tol) : epsrel(rel_tol), epsabs(abs_tol)
+  Heuristic_classifier(T rel_tol,
+                       T abs_tol,
+                       Reducer red = Reducer(),
+                       const ExecSpace& space = ExecSpace(),
+                       size_t memory_budget = 0)
+    : epsrel(rel_tol)
+    , epsabs(abs_tol)
+    , reducer(red)
+    , space(space)
+    , memory_budget(memory_budget)
   {
     required_digits = ceil(log10(1 / epsrel));
   }
@@ -222,24 +274,7 @@ public:
   size_t
   num_doubles_needed(const size_t num_regions) const
   { // move to pagani utils, has nothing to do with classifying
-    const size_t newActiveRegions = num_regions * ndim;
-    const size_t newActiveRegionsLength = num_regions * ndim;
-    const size_t parentExpansionEstimate = num_regions;
-    const size_t parentExpansionErrorest = num_regions;
-    const size_t genRegions = num_regions * ndim * 2;
-    const size_t genRegionsLength = num_regions * ndim * 2;
-
-    const size_t regions = 2 * num_regions * ndim;
-    const size_t regionsLength = 2 * num_regions * ndim;
-    const size_t regionsIntegral = 2 * num_regions;
-    const size_t regionsError = 2 * num_regions;
-    const size_t parentsIntegral = num_regions;
-    const size_t parentsError = num_regions;
-
-    return parentsError + parentsIntegral + regionsError + regionsIntegral +
-           regionsLength + regions + genRegionsLength + genRegions +
-           parentExpansionErrorest + parentExpansionEstimate +
-           newActiveRegionsLength + newActiveRegions;
+    return ::num_doubles_needed(num_regions, ndim);
   }
 
   size_t
@@ -261,7 +296,7 @@ public:
   bool
   enough_mem_for_next_split(const size_t num_regions)
   {
-    return free_device_mem(num_regions, ndim) >
+    return free_device_mem(num_regions, ndim, memory_budget) >
            device_mem_required_for_full_split(num_regions);
   }
 
@@ -283,11 +318,15 @@ public:
       return static_cast<T>(x) / static_cast<T>(y);
     };
 
-    set_true_for_larger_than<T>(
-      errorests.data(), res.threshold, num_regions, res.active_flags.data());
-    res.num_active = static_cast<size_t>(
-      reduction<int, use_custom>(res.active_flags, num_regions));
-    res.percent_mem_active = int_division(res.num_active, num_regions);
+    set_true_for_larger_than<T>(errorests.data(),
+                                res.threshold,
+                                num_regions,
+                                res.active_flags.data(),
+                                space);
+    res.num_active = reducer.sum(static_cast<size_t>(
+      reduction<int, use_custom>(res.active_flags, num_regions, space)));
+    res.percent_mem_active =
+      int_division(res.num_active, reducer.sum(num_regions));
     res.pass_mem = res.percent_mem_active <= max_active_regions_percentage;
   }
 
@@ -304,7 +343,8 @@ public:
 
     const T extra_f_errorest =
       active_errorest -
-      dot_product<int, T, use_custom>(active_flags, error_estimates) -
+      reducer.sum(dot_product<int, T, use_custom>(
+        active_flags, error_estimates, space)) -
       iter_finished_errorest;
     const T error_budget = target_error - total_f_errorest;
     res.pass_errorest_budget =
@@ -335,7 +375,7 @@ public:
   classification_criteria_met(const size_t num_regions) const
   {
     T ratio = static_cast<T>(device_mem_required_for_full_split(num_regions)) /
-              static_cast<T>(free_device_mem(num_regions, ndim));
+              static_cast<T>(free_device_mem(num_regions, ndim, memory_budget));
 
     if (ratio > 1.) {
       return true;
@@ -354,14 +394,25 @@ public:
            const T iter_finished_errorest,
            const T total_finished_errorest)
   {
-    Classification_res<T> thres_search =
-      (device_array_min_max<T, use_custom>(errorests));
+    // a rank left without regions contributes the identities of min and max
+    Classification_res<T> thres_search;
+    if (num_regions == 0) {
+      thres_search.threshold_range.low = std::numeric_limits<T>::max();
+      thres_search.threshold_range.high = std::numeric_limits<T>::lowest();
+    } else {
+      thres_search = device_array_min_max<T, use_custom>(errorests, space);
+    }
     thres_search.data_allocated = true;
+    thres_search.threshold_range.low =
+      reducer.min(thres_search.threshold_range.low);
+    thres_search.threshold_range.high =
+      reducer.max(thres_search.threshold_range.high);
+    const size_t total_num_regions = reducer.sum(num_regions);
 
     const T min_errorest = thres_search.threshold_range.low;
     const T max_errorest = thres_search.threshold_range.high;
-    thres_search.threshold = iter_errorest / num_regions;
-    thres_search.active_flags = quad::cuda_malloc<int>(num_regions);
+    thres_search.threshold = iter_errorest / total_num_regions;
+    thres_search.active_flags = quad::cuda_malloc<int>(num_regions, space);
     const T target_error = abs(estimates_from_last_iters[2]) * epsrel;
 
     const size_t max_num_thresholds_attempts = 20;
@@ -408,7 +459,7 @@ public:
         num_thres_increases = 0;
         thres_search.threshold_range.low = min_errorest;
         thres_search.threshold_range.high = max_errorest;
-        thres_search.threshold = iter_errorest / num_regions;
+        thres_search.threshold = iter_errorest / total_num_regions;
       } else if (exhausted_attempts && max_percent_error_budget >= .7 &&
                  max_active_regions_percentage <= .7) {
         max_active_regions_percentage += .1;
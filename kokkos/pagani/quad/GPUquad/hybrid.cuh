@@ -15,7 +15,9 @@ two_level_errorest_and_relerr_classify(
   const Region_estimates<T, ndim>& prev_iter_two_level_estimates,
   const Region_characteristics<ndim>& reg_classifiers,
   T epsrel,
-  bool relerr_classification = true)
+  bool relerr_classification = true,
+  int team_size = 64,
+  const ExecSpace& space = ExecSpace())
 {
   size_t num_regions = current_iter_raw_estimates.size;
   bool forbid_relerr_classification = !relerr_classification;
@@ -23,8 +25,8 @@ two_level_errorest_and_relerr_classify(
     return;
   }
 
-  ViewVectorDouble new_two_level_errorestimates("two-level-errorests",
-                                                num_regions);
+  ViewVectorDouble new_two_level_errorestimates(
+    Kokkos::view_alloc(space, "two-level-errorests"), num_regions);
 
   quad::RefineError<T>(current_iter_raw_estimates.integral_estimates.data(),
                        current_iter_raw_estimates.error_estimates.data(),
@@ -34,7 +36,9 @@ two_level_errorest_and_relerr_classify(
                        reg_classifiers.active_regions.data(),
                        num_regions,
                        epsrel,
-                       forbid_relerr_classification);
+                       forbid_relerr_classification,
+                       team_size,
+                       space);
 
   current_iter_raw_estimates.error_estimates = new_two_level_errorestimates;
 }
@@ -73,10 +73,28 @@ MaxErr(double avg, double epsrel, double epsabs)
 }
 
 namespace pagani {
-  template <size_t ndim>
+  // degree 9 rule of Cuhre, or the fully symmetric degree 7 rule without the
+  // 2^ndim vertex points, meant for 10 to 20 dimensions
+  enum class Cubature_rule { degree9 = 9, degree7 = 7 };
+
+  // The degree 7 generators only exist from 5 dimensions on: below, one
+  // axis set is not real (u1 < 0 in 3D, a division by 0 in 2D) or lies
+  // outside the region (u2 > 1 in 3D and 4D). Those dimensions keep the
+  // degree 9 rule, which is cheap there anyway.
+  template <size_t ndim, Cubature_rule rule>
+  KOKKOS_INLINE_FUNCTION constexpr bool
+  uses_degree7()
+  {
+    return rule == Cubature_rule::degree7 && ndim >= 5;
+  }
+
+  template <size_t ndim, Cubature_rule rule = Cubature_rule::degree9>
   KOKKOS_INLINE_FUNCTION constexpr size_t
   CuhreFuncEvalsPerRegion()
   {
+    if constexpr (uses_degree7<ndim, rule>())
+      return 1 + 4 * ndim + 2 * ndim * (ndim - 1) +
+             4 * ndim * (ndim - 1) * (ndim - 2) / 3;
     return (1 + 2 * ndim + 2 * ndim + 2 * ndim + 2 * ndim +
             2 * ndim * (ndim - 1) + 4 * ndim * (ndim - 1) +
             4 * ndim * (ndim - 1) * (ndim - 2) / 3 + (1 << ndim));
@@ -1,5 +1,7 @@
 #include "kokkos/pagani/quad/Cuhre.cuh"
 #include "catch.hpp"
+#include "common/capture.hh"
+#include <cstdio>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -152,3 +154,34 @@ TEST_CASE("Constant Zero Value Function")
   CHECK(nonZeroErrFound == false);
   CHECK(totalErrorEst <= 0.00000000000001);
 }
+
+TEST_CASE("Captured regions are bounded by the capture options")
+{
+  constexpr int ndim = 2;
+  const std::string filename = "kokkos_cuhre_capture.bin";
+  PTest integrand;
+  size_t maxIters = 1;
+  int heuristicID = 0;
+  double epsrel = 1.0e-3;
+  double epsabs = 1.0e-12;
+  numint::capture_options options;
+  options.regions = 4;
+
+  Cuhre<double, ndim> cuhre;
+  cuhre.capture_to(filename, options);
+  cuhre.Integrate<PTest>(integrand, epsrel, epsabs, heuristicID, maxIters);
+  cuhre.stop_capture();
+
+  numint::capture_data data = numint::read_capture(filename);
+  CHECK(data.ndim == ndim);
+  CHECK(data.region_estimate.size() == 4);
+  CHECK(data.dropped_regions == 12);
+  for (size_t reg = 0; reg < data.region_estimate.size(); ++reg) {
+    double volume = 1.;
+    for (int dim = 0; dim < ndim; ++dim)
+      volume *= data.region_highs[dim][reg] - data.region_lows[dim][reg];
+    CHECK(volume == Approx(1. / 16));
+    CHECK(data.region_estimate[reg] == Approx(15.37 / 16));
+  }
+  std::remove(filename.c_str());
+}
@@ -0,0 +1,98 @@
+#include "kokkos/qmc/qmc.h"
+#include "common/kokkos/Volume.cuh"
+#include "common/kokkos/integrands.cuh"
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+// Runs the QMC integrator on a few of the benchmark integrands with every
+// rule and periodization, printing the true relative error next to the
+// estimated one.
+//
+//   ./kokkos_qmc_integrals [epsrel] [randomizations]
+
+namespace {
+  using MilliSeconds =
+    std::chrono::duration<double, std::chrono::milliseconds::period>;
+
+  const char*
+  name(numint::qmc_rule rule)
+  {
+    return rule == numint::qmc_rule::sobol ? "sobol" : "lattice";
+  }
+
+  const char*
+  name(numint::qmc_periodization periodization)
+  {
+    switch (periodization) {
+      case numint::qmc_periodization::baker:
+        return "baker";
+      case numint::qmc_periodization::polynomial:
+        return "polynomial";
+      default:
+        return "none";
+    }
+  }
+
+  template <typename IntegT, int ndim>
+  void
+  run(std::string const& id,
+      IntegT integrand,
+      double true_value,
+      double epsrel,
+      unsigned randomizations)
+  {
+    quad::Volume<double, ndim> vol;
+    for (auto rule : {numint::qmc_rule::lattice, numint::qmc_rule::sobol}) {
+      for (auto periodization : {numint::qmc_periodization::none,
+                                 numint::qmc_periodization::baker,
+                                 numint::qmc_periodization::polynomial}) {
+        numint::qmc_options options;
+        options.rule = rule;
+        options.periodization = periodization;
+        options.randomizations = randomizations;
+        auto const t0 = std::chrono::high_resolution_clock::now();
+        auto const res = kokkos_qmc::integrate<IntegT, ndim>(
+          integrand, epsrel, 1.e-20, vol, options);
+        MilliSeconds const dt = std::chrono::high_resolution_clock::now() - t0;
+        std::cout << id << ", " << name(rule) << ", " << name(periodization)
+                  << ", " << res.estimate << ", " << res.errorest << ", "
+                  << std::abs((res.estimate - true_value) / true_value) << ", "
+                  << res.neval << ", " << res.status << ", " << dt.count()
+                  << "\n";
+      }
+    }
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  const double epsrel = argc > 1 ? std::atof(argv[1]) : 1.e-3;
+  const unsigned randomizations = argc > 2 ? std::atoi(argv[2]) : 16;
+
+  // the integral of sin(x_1 + ... + x_6) over the unit cube is the imaginary
+  // part of ((e^i - 1) / i)^6
+  const std::complex<double> i(0., 1.);
+  const std::complex<double> factor = (std::exp(i) - 1.) / i;
+  const double sinsum_true_value = std::imag(std::pow(factor, 6));
+
+  Kokkos::initialize();
+  {
+    std::cout << std::setprecision(15);
+    std::cout << "id, rule, periodization, estimate, errorest, true relerr, "
+                 "neval, status, time (ms)\n";
+    run<SinSum_6D, 6>(
+      "SinSum_6D", SinSum_6D(), sinsum_true_value, epsrel, randomizations);
+    run<F_3_8D, 8>(
+      "F_3_8D", F_3_8D(), 2.2751965817917756076e-10, epsrel, randomizations);
+    run<F_1_8D, 8>(
+      "F_1_8D", F_1_8D(), 3.439557952183252e-05, epsrel, randomizations);
+  }
+  Kokkos::finalize();
+  return 0;
+}
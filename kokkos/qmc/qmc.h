@@ -0,0 +1,77 @@
+#ifndef KOKKOS_QMC_H
+#define KOKKOS_QMC_H
+
+#include <Kokkos_Core.hpp>
+#include "common/kokkos/Volume.cuh"
+#include "common/integration_result.hh"
+#include "common/qmc.hh"
+
+// Kokkos backend of the randomized QMC integrator of common/qmc.hh. Every
+// doubling of the point set is one array reduction over the new points,
+// each thread summing its points for all the randomizations.
+
+namespace kokkos_qmc {
+
+  template <typename IntegT, int ndim>
+  struct Randomized_sums {
+    using value_type = double[];
+
+    KOKKOS_INLINE_FUNCTION void
+    operator()(const int64_t i, value_type sums) const
+    {
+      IntegT f = integrand;
+      double x[ndim];
+      for (unsigned r = 0; r < value_count; ++r) {
+        const double weight = sequence.point(i, r, x);
+        sums[r] += weight * numint::qmc_call<ndim>(f, x);
+      }
+    }
+
+    KOKKOS_INLINE_FUNCTION void
+    init(value_type sums) const
+    {
+      for (unsigned r = 0; r < value_count; ++r)
+        sums[r] = 0.;
+    }
+
+    KOKKOS_INLINE_FUNCTION void
+    join(value_type dst, const value_type src) const
+    {
+      for (unsigned r = 0; r < value_count; ++r)
+        dst[r] += src[r];
+    }
+
+    unsigned value_count;
+    IntegT integrand;
+    numint::qmc_sequence<ndim> sequence;
+  };
+
+  template <typename IntegT, int ndim>
+  numint::integration_result
+  integrate(IntegT integrand,
+            double epsrel,
+            double epsabs,
+            quad::Volume<double, ndim> const& vol,
+            numint::qmc_options const& options = {})
+  {
+    const Randomized_sums<IntegT, ndim> functor{
+      options.randomizations,
+      integrand,
+      numint::make_qmc_sequence<ndim>(options, vol.lows, vol.highs)};
+    Kokkos::View<double*, Kokkos::HostSpace> level_sums(
+      "qmc_level_sums", options.randomizations);
+
+    auto accumulate = [&](uint64_t first, uint64_t last, double* sums) {
+      Kokkos::parallel_reduce(
+        "kokkos_qmc::integrate",
+        Kokkos::RangePolicy<Kokkos::IndexType<int64_t>>(first, last),
+        functor,
+        level_sums);
+      for (unsigned r = 0; r < options.randomizations; ++r)
+        sums[r] += level_sums(r);
+    };
+    return numint::qmc_iterate(epsrel, epsabs, options, accumulate);
+  }
+}
+
+#endif
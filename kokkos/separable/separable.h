@@ -0,0 +1,161 @@
+#ifndef KOKKOS_SEPARABLE_H
+#define KOKKOS_SEPARABLE_H
+
+#include <Kokkos_Core.hpp>
+#include "common/integration_result.hh"
+#include "common/kokkos/Volume.cuh"
+#include "common/separable.hh"
+#include "kokkos/gauss_kronrod/batched_qag.h"
+#include "kokkos/pagani/quad/GPUquad/Workspace.cuh"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Kokkos backend of the separable integrands of common/separable.hh. All
+// the 1D factors go through one Batched_qag launch per round, whatever
+// their number; factors of two or more dimensions each run a Pagani
+// workspace of their own dimension.
+
+namespace kokkos_separable {
+
+  namespace detail {
+    // the 1D factors of IntegT as a Batched_qag family, integral i being
+    // the factor of group groups[i]
+    template <typename IntegT>
+    struct Factor_family {
+      using Traits = numint::separable_traits<IntegT>;
+      static constexpr int num_groups = numint::num_separable_groups<IntegT>;
+
+      KOKKOS_INLINE_FUNCTION double
+      operator()(size_t i, double x) const
+      {
+        return evaluate(
+          groups[i], x, std::make_integer_sequence<int, num_groups>());
+      }
+
+      template <int... g>
+      KOKKOS_INLINE_FUNCTION double
+      evaluate(int group, double x, std::integer_sequence<int, g...>) const
+      {
+        double value = 0.;
+        (void)((group == g && (value = evaluate_factor<g>(x), true)) || ...);
+        return value;
+      }
+
+      template <int g>
+      KOKKOS_INLINE_FUNCTION double
+      evaluate_factor(double x) const
+      {
+        if constexpr (numint::separable_group_size<IntegT, g> == 1) {
+          auto f = Traits::template factor<g>(integrand);
+          return f(x);
+        } else {
+          return 0.;
+        }
+      }
+
+      IntegT integrand;
+      int groups[num_groups];
+    };
+
+    template <typename IntegT, int g, int ndim>
+    void
+    integrate_group(IntegT const& integrand,
+                    quad::Volume<double, ndim> const& vol,
+                    numint::separable_tolerance const& tolerance,
+                    numint::integration_result& result)
+    {
+      constexpr int group_ndim = numint::separable_group_size<IntegT, g>;
+      if constexpr (group_ndim > 1) {
+        constexpr int offset = numint::separable_offset<IntegT>(g);
+        const quad::Volume<double, group_ndim> group_vol(vol.lows + offset,
+                                                         vol.highs + offset);
+        auto const factor =
+          numint::separable_traits<IntegT>::template factor<g>(integrand);
+        Workspace<double, group_ndim> pagani;
+        result = pagani.integrate(
+          factor, tolerance.epsrel, tolerance.epsabs, group_vol);
+      }
+    }
+
+    template <typename IntegT, int ndim, int... g>
+    void
+    integrate_groups(IntegT const& integrand,
+                     quad::Volume<double, ndim> const& vol,
+                     std::vector<numint::separable_tolerance> const& tolerances,
+                     std::vector<numint::integration_result>& results,
+                     std::integer_sequence<int, g...>)
+    {
+      (integrate_group<IntegT, g>(integrand, vol, tolerances[g], results[g]),
+       ...);
+    }
+  }
+
+  template <typename IntegT, int ndim>
+  numint::integration_result
+  integrate(IntegT const& integrand,
+            double epsrel,
+            double epsabs,
+            quad::Volume<double, ndim> const& vol,
+            int max_rounds = 4)
+  {
+    using Traits = numint::separable_traits<IntegT>;
+    static_assert(Traits::value, "the integrand is not declared separable");
+    static_assert(numint::separable_ndim<IntegT>() == ndim,
+                  "the groups do not cover the dimensions of the integrand");
+    constexpr int num_groups = numint::num_separable_groups<IntegT>;
+
+    detail::Factor_family<IntegT> family{integrand, {}};
+    std::vector<int> batched;
+    std::vector<double> lows, highs;
+    std::vector<double> volumes(num_groups, 1.);
+    for (int g = 0, offset = 0; g < num_groups; ++g) {
+      const int group_ndim = numint::separable_groups<IntegT>[g];
+      for (int d = offset; d < offset + group_ndim; ++d)
+        volumes[g] *= vol.highs[d] - vol.lows[d];
+      if (group_ndim == 1) {
+        family.groups[batched.size()] = g;
+        batched.push_back(g);
+        lows.push_back(vol.lows[offset]);
+        highs.push_back(vol.highs[offset]);
+      }
+      offset += group_ndim;
+    }
+
+    const gauss_kronrod::Batched_qag<> qag;
+    auto evaluate =
+      [&](std::vector<numint::separable_tolerance> const& tolerances) {
+        std::vector<numint::integration_result> results(num_groups);
+        if (!batched.empty()) {
+          // one tolerance for the batch, the tightest asked for
+          double batch_epsrel = std::numeric_limits<double>::max();
+          double batch_epsabs = std::numeric_limits<double>::max();
+          for (int g : batched) {
+            batch_epsrel = std::min(batch_epsrel, tolerances[g].epsrel);
+            batch_epsabs = std::min(batch_epsabs, tolerances[g].epsabs);
+          }
+          auto const batch =
+            qag.integrate(family, lows, highs, batch_epsrel, batch_epsabs);
+          for (size_t i = 0; i < batched.size(); ++i)
+            results[batched[i]] = batch[i];
+        }
+        detail::integrate_groups(integrand,
+                                 vol,
+                                 tolerances,
+                                 results,
+                                 std::make_integer_sequence<int, num_groups>());
+        return results;
+      };
+    return numint::separable_iterate(Traits::kind,
+                                     numint::separable_errors::bound,
+                                     volumes,
+                                     epsrel,
+                                     epsabs,
+                                     evaluate,
+                                     max_rounds);
+  }
+}
+
+#endif
@@ -156,13 +156,15 @@ namespace cuda_mcubes {
     return val;
   }
 
+  // decodes the 64-bit cube index ms into its 1-based per-axis intervals
   __inline__ void
-  get_indx(uint32_t ms, uint32_t* da, int ND, int NINTV)
+  get_indx(size_t ms, uint32_t* da, int ND, int NINTV)
   {
     // called like :    get_indx(m * chunkSize, &kg[1], ndim, ng);
-    uint32_t dp[Internal_Vegas_Params::get_MXDIM()];
-    uint32_t j, t0, t1;
-    uint32_t m = ms;
+    size_t dp[Internal_Vegas_Params::get_MXDIM()];
+    size_t t0, t1;
+    int j;
+    size_t m = ms;
     dp[0] = 1;
     dp[1] = NINTV;
 
@@ -181,7 +183,7 @@ namespace cuda_mcubes {
   void
   Test_get_indx(int ndim,
                 int ng,
-                uint32_t totalNumThreads,
+                size_t totalNumThreads,
                 int chunkSize,
                 int it,
                 std::ofstream& interval_myfile)
@@ -191,7 +193,7 @@ namespace cuda_mcubes {
     if (it == 1)
       interval_myfile << "m, kg[1], kg[2], kg[3], it\n";
 
-    for (uint32_t m = 0; m < totalNumThreads; m++) {
+    for (size_t m = 0; m < totalNumThreads; m++) {
       uint32_t kg[mxdim_p1];
       get_indx(m, &kg[1], ndim, ng);
 
@@ -216,7 +218,7 @@ namespace cuda_mcubes {
                        double& wgt,
                        int npg,
                        int sampleID,
-                       uint32_t cube_id,
+                       size_t cube_id,
                        double* randoms = nullptr)
   {
     constexpr int ndmx = Internal_Vegas_Params::get_NDMX();
@@ -276,7 +278,7 @@ namespace cuda_mcubes {
                       double* d,
                       double& fb,
                       double& f2b,
-                      uint32_t cube_id)
+                      size_t cube_id)
   {
     constexpr int mxdim_p1 = Internal_Vegas_Params::get_MXDIM_p1();
 
@@ -360,7 +362,7 @@ namespace cuda_mcubes {
     for (int t = 0; t < chunkSize; t++) {
       double fb = 0.,
              f2b = 0.0; // init to zero for each interval processed by thread
-      uint32_t cube_id = cube_id_offset + t;
+      size_t cube_id = cube_id_offset + t;
 
       // can't use if(is_same<GeneratorType, Custom_generator>) in device code
       // can't do if statement checking whether typename GeneratorType ==
@@ -419,21 +421,22 @@ namespace cuda_mcubes {
                double* d,
                double* dx,
                double* regn,
-               int ncubes,
+               size_t ncubes,
                int iter,
                double sc,
                double sci,
                double ing,
                int chunkSize,
-               uint32_t totalNumThreads,
+               size_t totalNumThreads,
                int LastChunk,
                unsigned int seed_init,
                sycl::nd_item<1> item_ct1,
                double* shared)
   {
     constexpr int mxdim_p1 = Internal_Vegas_Params::get_MXDIM_p1();
-    uint32_t m = item_ct1.get_group(0) * item_ct1.get_local_range().get(0) +
-                 item_ct1.get_local_id(0);
+    const size_t m =
+      item_ct1.get_group(0) * item_ct1.get_local_range().get(0) +
+      item_ct1.get_local_id(0);
     uint32_t tx = item_ct1.get_local_id(0);
     double wgt;
     uint32_t kg[mxdim_p1];
@@ -443,10 +446,7 @@ namespace cuda_mcubes {
 
     if (m < totalNumThreads) {
 
-      size_t cube_id_offset =
-        (item_ct1.get_group(0) * item_ct1.get_local_range().get(0) +
-         item_ct1.get_local_id(0)) *
-        chunkSize;
+      size_t cube_id_offset = m * chunkSize;
 
       if (m == totalNumThreads - 1)
         chunkSize = LastChunk;
@@ -517,13 +517,13 @@ namespace cuda_mcubes {
                 double* d,
                 double* dx,
                 double* regn,
-                int ncubes,
+                size_t ncubes,
                 int iter,
                 double sc,
                 double sci,
                 double ing, // not needed?
                 int chunkSize,
-                uint32_t totalNumThreads,
+                size_t totalNumThreads,
                 int LastChunk,
                 unsigned int seed_init,
                 sycl::nd_item<1> item_ct1,
@@ -534,13 +534,11 @@ namespace cuda_mcubes {
     constexpr int ndmx_p1 = Internal_Vegas_Params::get_NDMX_p1();
     constexpr int mxdim_p1 = Internal_Vegas_Params::get_MXDIM_p1();
 
-    uint32_t m = item_ct1.get_group(0) * item_ct1.get_local_range().get(0) +
-                 item_ct1.get_local_id(0);
+    const size_t m =
+      item_ct1.get_group(0) * item_ct1.get_local_range().get(0) +
+      item_ct1.get_local_id(0);
     int tx = item_ct1.get_local_id(0);
-    size_t cube_id_offset =
-      (item_ct1.get_group(0) * item_ct1.get_local_range().get(0) +
-       item_ct1.get_local_id(0)) *
-      chunkSize;
+    size_t cube_id_offset = m * chunkSize;
 
     double fb, f2b, wgt, xn, xo, rc, f, f2, ran00;
     uint32_t kg[mxdim_p1];
@@ -831,9 +829,9 @@ namespace cuda_mcubes {
     q_ct1.memset(ia_dev, 0, sizeof(int) * (mxdim_p1)).wait();
 
     int chunkSize = GetChunkSize(ncall);
-    uint32_t totalNumThreads = (uint32_t)((ncubes) / chunkSize);
+    size_t totalNumThreads = (size_t)((ncubes) / chunkSize);
 
-    uint32_t totalCubes = totalNumThreads * chunkSize; // even-split cubes
+    size_t totalCubes = totalNumThreads * chunkSize; // even-split cubes
     int extra = ncubes - totalCubes;                   // left-over cubes
     int LastChunk = extra + chunkSize; // last chunk of last thread
 
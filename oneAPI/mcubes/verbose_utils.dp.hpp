@@ -26,7 +26,7 @@ public:
   double* randoms = nullptr;
   double* funcevals = nullptr;
 
-  IterDataLogger(uint32_t totalNumThreads,
+  IterDataLogger(size_t totalNumThreads,
                  int chunkSize,
                  int extra,
                  int npg,
@@ -113,7 +113,7 @@ public:
   }
 
   void
-  PrintRandomNums(int it, int ncubes, int npg, int ndim)
+  PrintRandomNums(int it, size_t ncubes, int npg, int ndim)
   {
 
     size_t nums_per_cube = npg * ndim;
@@ -123,7 +123,7 @@ public:
       return;
     else {
 
-      for (int cube = 0; cube < ncubes; cube++)
+      for (size_t cube = 0; cube < ncubes; cube++)
         for (int sample = 1; sample <= npg; sample++)
           for (int dim = 1; dim <= ndim; dim++) {
 
@@ -139,7 +139,7 @@ public:
   }
 
   void
-  PrintFuncEvals(int it, int ncubes, int npg, int ndim)
+  PrintFuncEvals(int it, size_t ncubes, int npg, int ndim)
   {
 
     size_t nums_per_cube = npg * ndim;
@@ -151,7 +151,7 @@ public:
 
       std::cout << "expecting total random numbers:" << ncubes * npg * ndim
                 << "\n";
-      for (int cube = 0; cube < ncubes; cube++)
+      for (size_t cube = 0; cube < ncubes; cube++)
         for (int sample = 1; sample <= npg; sample++) {
 
           size_t nums_evals_per_chunk = npg;
@@ -166,14 +166,14 @@ public:
   void
   PrintIntervals(int ndim,
                  int ng,
-                 uint32_t totalNumThreads,
+                 size_t totalNumThreads,
                  int chunkSize,
                  int it)
   {
     /*constexpr int mxdim_p1 = Internal_Vegas_Params::get_MXDIM_p1();
     if(it == 1)
         interval_myfile<<"m, kg[1], kg[2], kg[3], it\n";
-    for(uint32_t m = 0; m < totalNumThreads; m++){
+    for(size_t m = 0; m < totalNumThreads; m++){
         uint32_t kg[mxdim_p1];
         get_indx(m , &kg[1], ndim, ng);
         interval_myfile<<m<<",";
@@ -5,27 +5,23 @@
 #include <dpct/dpct.hpp>
 #include "oneAPI/pagani/quad/GPUquad/Sub_regions.dp.hpp"
 #include "common/oneAPI/cudaMemoryUtil.h"
+#include "common/oneAPI/stream_compaction.dp.hpp"
 #include "oneAPI/pagani/quad/GPUquad/heuristic_classifier.dp.hpp"
 #include <numeric>
 
+// the scalars of the active regions move during the compaction pass, the
+// coordinates afterwards since their layout depends on the number of regions
 template <typename T, int NDIM>
 void
-alignRegions(T* dRegions,
-             T* dRegionsLength,
-             double* activeRegions,
-             T* dRegionsIntegral,
-             T* dRegionsError,
-             T* dRegionsParentIntegral,
-             T* dRegionsParentError,
-             int* subDividingDimension,
-             double* scannedArray,
-             T* newActiveRegions,
-             T* newActiveRegionsLength,
-             int* newActiveRegionsBisectDim,
-             size_t numRegions,
-             size_t newNumRegions,
-             int numOfDivisionOnDimension,
-             sycl::nd_item<3> item_ct1)
+alignCoordinates(T* dRegions,
+                 T* dRegionsLength,
+                 double* activeRegions,
+                 double* scannedArray,
+                 T* newActiveRegions,
+                 T* newActiveRegionsLength,
+                 size_t numRegions,
+                 size_t newNumRegions,
+                 sycl::nd_item<3> item_ct1)
 {
 
   size_t tid = item_ct1.get_group(2) * item_ct1.get_local_range().get(2) +
@@ -40,14 +36,6 @@ alignRegions(T* dRegions,
       newActiveRegionsLength[i * newNumRegions + interval_index] =
         dRegionsLength[i * numRegions + tid];
     }
-
-    dRegionsParentIntegral[interval_index] = dRegionsIntegral[tid];
-    dRegionsParentError[interval_index] = dRegionsError[tid];
-
-    for (int i = 0; i < numOfDivisionOnDimension; ++i) {
-      newActiveRegionsBisectDim[i * newNumRegions + interval_index] =
-        subDividingDimension[tid];
-    }
   }
 }
 
@@ -58,30 +46,32 @@ public:
   using Region_char = Region_characteristics<ndim>;
   using Region_ests = Region_estimates<ndim>;
 
-  Sub_regions_filter(const size_t num_regions)
+  Sub_regions_filter() = default;
+
+  Sub_regions_filter(const size_t num_regions) { reserve(num_regions); }
+
+  // grows the scan array when needed, never shrinks it: a Workspace keeps
+  // one filter, and its host allocated count, for all its iterations
+  void
+  reserve(const size_t num_regions)
   {
+    if (num_regions <= capacity)
+      return;
+    auto q_ct1 = sycl::queue(sycl::gpu_selector());
+    sycl::free(scanned_array, q_ct1);
     scanned_array = quad::cuda_malloc<double>(num_regions);
+    capacity = num_regions;
   }
 
   size_t
   get_num_active_regions(double* active_regions, const size_t num_regions)
   {
-    auto q_ct1 = sycl::queue(sycl::gpu_selector());
-    exclusive_scan<double, use_custom>(
-      active_regions, num_regions, scanned_array);
-
-    double last_element;
-    double num_active = 0;
-
-    q_ct1.memcpy(
-      &last_element, active_regions + num_regions - 1, sizeof(double));
-
-    q_ct1.memcpy(&num_active, scanned_array + num_regions - 1, sizeof(double))
-      .wait();
-
-    if (last_element == 1.)
-      num_active += 1;
-    return static_cast<size_t>(num_active);
+    reserve(num_regions);
+    double* positions = scanned_array;
+    return compaction.compact(
+      num_regions,
+      [=](size_t reg) { return active_regions[reg] == 1.; },
+      [=](size_t reg, size_t slot) { positions[reg] = slot; });
   }
 
   // filter out finished regions
@@ -93,10 +83,41 @@ public:
   {
     auto q_ct1 = sycl::queue(sycl::gpu_selector());
     const size_t current_num_regions = sub_regions->size;
-    const size_t num_active_regions = get_num_active_regions(
-      region_characteristics->active_regions, current_num_regions);
+    if (current_num_regions == 0) {
+      return 0;
+    }
+
+    // parents and bisection dimensions are written during the compaction
+    // pass, before the number of active regions is known, so they are sized
+    // for the worst case
+    reserve(current_num_regions);
+    int* filtered_sub_dividing_dim =
+      quad::cuda_malloc<int>(current_num_regions);
+    parent_ests->reallocate(current_num_regions);
+
+    auto dLeftCoord = sub_regions->dLeftCoord;
+    auto dLength = sub_regions->dLength;
+    auto active_regions = region_characteristics->active_regions;
+    auto integral_estimates = region_ests->integral_estimates;
+    auto error_estimates = region_ests->error_estimates;
+    auto parent_integral_ests = parent_ests->integral_estimates;
+    auto parent_error_ests = parent_ests->error_estimates;
+    auto sub_dividing_dim = region_characteristics->sub_dividing_dim;
+    auto positions = scanned_array;
+
+    const size_t num_active_regions = compaction.compact(
+      current_num_regions,
+      [=](size_t reg) { return active_regions[reg] == 1.; },
+      [=](size_t reg, size_t slot) {
+        positions[reg] = slot;
+        parent_integral_ests[slot] = integral_estimates[reg];
+        parent_error_ests[slot] = error_estimates[reg];
+        filtered_sub_dividing_dim[slot] = sub_dividing_dim[reg];
+      });
+    parent_ests->size = num_active_regions;
 
     if (num_active_regions == 0) {
+      sycl::free(filtered_sub_dividing_dim, q_ct1);
       return 0;
     }
 
@@ -107,21 +128,8 @@ public:
       quad::cuda_malloc<double>(num_active_regions * ndim);
     double* filtered_length =
       quad::cuda_malloc<double>(num_active_regions * ndim);
-    int* filtered_sub_dividing_dim = quad::cuda_malloc<int>(num_active_regions);
-
-    parent_ests->reallocate(num_active_regions);
-    const int numOfDivisionOnDimension = 1;
     const size_t num_blocks = compute_num_blocks(current_num_regions);
 
-    auto dLeftCoord = sub_regions->dLeftCoord;
-    auto dLength = sub_regions->dLength;
-    auto active_regions = region_characteristics->active_regions;
-    auto integral_estimates = region_ests->integral_estimates;
-    auto error_estimates = region_ests->error_estimates;
-    auto parent_integral_ests = parent_ests->integral_estimates;
-    auto parent_error_ests = parent_ests->error_estimates;
-    auto sub_dividing_dim = region_characteristics->sub_dividing_dim;
-
     q_ct1
       .submit([&](sycl::handler& cgh) {
         auto scanned_array_ct8 = scanned_array;
@@ -130,22 +138,15 @@ public:
                                           sycl::range(1, 1, BLOCK_SIZE),
                                         sycl::range(1, 1, BLOCK_SIZE)),
                          [=](sycl::nd_item<3> item_ct1) {
-                           alignRegions<double, static_cast<int>(ndim)>(
+                           alignCoordinates<double, static_cast<int>(ndim)>(
                              dLeftCoord,
                              dLength,
                              active_regions,
-                             integral_estimates,
-                             error_estimates,
-                             parent_integral_ests,
-                             parent_error_ests,
-                             sub_dividing_dim,
                              scanned_array_ct8,
                              filtered_leftCoord,
                              filtered_length,
-                             filtered_sub_dividing_dim,
                              current_num_regions,
                              num_active_regions,
-                             numOfDivisionOnDimension,
                              item_ct1);
                          });
       })
@@ -178,6 +179,8 @@ public:
   }
 
   double* scanned_array = nullptr;
+  size_t capacity = 0;
+  quad::Stream_compaction compaction;
 };
 
 #endif
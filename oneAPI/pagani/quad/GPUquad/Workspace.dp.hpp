@@ -48,6 +48,8 @@ private:
                           const numint::integration_result& cummulative);
 
   Cubature_rules<ndim> rules;
+  // kept between iterations, see Sub_regions_filter::reserve
+  Filter filter;
 
 public:
   Workspace() = default;
@@ -325,8 +327,7 @@ Workspace<ndim, use_custom, collect_mult_runs>::integrate(const IntegT& integran
         << "heuristic_classify," << dt.count() << std::endl;
     }
 
-    Filter filter_obj(subregions.size);
-    size_t num_active_regions = filter_obj.filter(
+    size_t num_active_regions = filter.filter(
       &subregions, &characteristics, &estimates, &prev_iter_estimates);
     cummulative.nregions += num_regions - num_active_regions;
     subregions.size = num_active_regions;
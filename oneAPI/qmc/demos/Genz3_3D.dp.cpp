@@ -0,0 +1,51 @@
+#include <CL/sycl.hpp>
+#include "oneAPI/qmc/qmc.dp.hpp"
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+class GENZ_3_3D {
+public:
+  SYCL_EXTERNAL double
+  operator()(double x, double y, double z)
+  {
+    return sycl::pown(1 + 3 * x + 2 * y + z, -4);
+  }
+};
+
+// tightens epsrel until the QMC integrator runs out of points, with the
+// lattice and Sobol rules, both with the baker's transform
+int
+main()
+{
+  constexpr int ndim = 3;
+  const double true_value = 0.010846560846560846561;
+  quad::Volume<double, ndim> volume;
+  GENZ_3_3D integrand;
+
+  std::cout << std::setprecision(15);
+  std::cout << "rule, epsrel, estimate, errorest, true relerr, neval, status, "
+               "time (ms)\n";
+  for (auto rule : {numint::qmc_rule::lattice, numint::qmc_rule::sobol}) {
+    numint::qmc_options options;
+    options.rule = rule;
+    options.periodization = numint::qmc_periodization::baker;
+    for (double epsrel = 1.e-3; epsrel >= 1.e-9; epsrel /= 5.) {
+      auto const t0 = std::chrono::high_resolution_clock::now();
+      auto const res = oneapi_qmc::integrate<GENZ_3_3D, ndim>(
+        integrand, epsrel, 1.e-20, volume, options);
+      std::chrono::duration<double, std::milli> const dt =
+        std::chrono::high_resolution_clock::now() - t0;
+      std::cout << (rule == numint::qmc_rule::sobol ? "sobol" : "lattice")
+                << ", " << epsrel << ", " << res.estimate << ", "
+                << res.errorest << ", "
+                << std::abs((res.estimate - true_value) / true_value) << ", "
+                << res.neval << ", " << res.status << ", " << dt.count()
+                << "\n";
+      if (res.status != 0)
+        break;
+    }
+  }
+  return 0;
+}
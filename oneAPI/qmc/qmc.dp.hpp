@@ -0,0 +1,68 @@
+#ifndef ONEAPI_QMC_DP_HPP
+#define ONEAPI_QMC_DP_HPP
+
+#include <CL/sycl.hpp>
+#include "common/oneAPI/Volume.dp.hpp"
+#include "common/integration_result.hh"
+#include "common/qmc.hh"
+#include <algorithm>
+#include <new>
+
+// SYCL backend of the randomized QMC integrator of common/qmc.hh. Every
+// doubling of the point set is one kernel over the new points with a span
+// reduction holding one sum per randomization; the sums live in host USM.
+
+namespace oneapi_qmc {
+
+  template <typename IntegT, int ndim>
+  numint::integration_result
+  integrate(IntegT integrand,
+            double epsrel,
+            double epsabs,
+            quad::Volume<double, ndim> const& vol,
+            numint::qmc_options const& options = {})
+  {
+    auto q = sycl::queue(sycl::gpu_selector());
+    const numint::qmc_sequence<ndim> sequence =
+      numint::make_qmc_sequence<ndim>(options, vol.lows, vol.highs);
+    const unsigned num_random = options.randomizations;
+    double* level_sums = sycl::malloc_host<double>(num_random, q);
+    if (level_sums == nullptr)
+      throw std::bad_alloc();
+
+    auto accumulate = [&](uint64_t first, uint64_t last, double* sums) {
+      std::fill(level_sums, level_sums + num_random, 0.);
+      auto sample = [=](sycl::id<1> id, auto& partial) {
+        IntegT f = integrand;
+        double x[ndim];
+        const uint64_t i = first + id[0];
+        for (unsigned r = 0; r < num_random; ++r) {
+          const double weight = sequence.point(i, r, x);
+          partial[r] += weight * numint::qmc_call<ndim>(f, x);
+        }
+      };
+      q.submit([&](sycl::handler& cgh) {
+         cgh.parallel_for(
+           sycl::range<1>(last - first),
+           sycl::reduction(sycl::span<double>(level_sums, num_random),
+                           sycl::plus<double>()),
+           sample);
+       }).wait();
+      for (unsigned r = 0; r < num_random; ++r)
+        sums[r] += level_sums[r];
+    };
+
+    try {
+      const numint::integration_result res =
+        numint::qmc_iterate(epsrel, epsabs, options, accumulate);
+      sycl::free(level_sums, q);
+      return res;
+    }
+    catch (...) {
+      sycl::free(level_sums, q);
+      throw;
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,234 @@
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+#include "common/integration_cache.hh"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <initializer_list>
+#include <string>
+
+namespace {
+  // stands in for the quad::Volume of any back-end, only the bounds are read
+  template <size_t ndim>
+  struct Box {
+    double lows[ndim];
+    double highs[ndim];
+
+    Box()
+    {
+      std::fill(lows, lows + ndim, 0.);
+      std::fill(highs, highs + ndim, 1.);
+    }
+
+    Box(std::initializer_list<double> l, std::initializer_list<double> h)
+    {
+      std::copy(l.begin(), l.end(), lows);
+      std::copy(h.begin(), h.end(), highs);
+    }
+  };
+
+  std::string
+  scratch_file(std::string const& name)
+  {
+    const std::string filename = "integration_cache_" + name + ".bin";
+    std::remove(filename.c_str());
+    return filename;
+  }
+
+  numint::integration_result
+  converged(double estimate, double errorest)
+  {
+    numint::integration_result res;
+    res.estimate = estimate;
+    res.errorest = errorest;
+    res.status = 0;
+    res.nregions = 7;
+    return res;
+  }
+}
+
+TEST_CASE("Keys cover the integrand, algorithm and bounds")
+{
+  Box<2> unit;
+  Box<2> wide({0., 0.}, {2., 1.});
+  numint::integration_key key("gauss", "pagani", unit);
+  CHECK(key.hash() == numint::integration_key("gauss", "pagani", unit).hash());
+  CHECK(key.hash() != numint::integration_key("gauss", "pagani", wide).hash());
+  CHECK(key.hash() != numint::integration_key("gauss", "cuhre", unit).hash());
+  CHECK(key.hash() !=
+        numint::integration_key("gauss", "pagani", unit).add(2.).hash());
+  // the strings are length prefixed
+  CHECK(numint::integration_key("ab", "c").bytes() !=
+        numint::integration_key("a", "bc").bytes());
+}
+
+TEST_CASE("Converged results answer looser requests")
+{
+  const std::string filename = scratch_file("lookup");
+  Box<3> vol;
+  numint::integration_key key("gauss", "pagani", vol);
+  int runs = 0;
+  auto run = [&](numint::vegas_grid*) {
+    ++runs;
+    return converged(1., 1.e-6);
+  };
+
+  numint::integration_cache cache(filename);
+  auto res = cache.integrate(key, 1.e-6, 1.e-20, run);
+  CHECK(runs == 1);
+  CHECK(res.estimate == 1.);
+
+  SECTION("Same or looser tolerance is a hit")
+  {
+    cache.integrate(key, 1.e-6, 1.e-20, run);
+    cache.integrate(key, 1.e-3, 1.e-20, run);
+    CHECK(runs == 1);
+    CHECK(cache.size() == 1);
+  }
+
+  SECTION("Tighter tolerance runs again")
+  {
+    cache.integrate(key, 1.e-8, 1.e-20, run);
+    CHECK(runs == 2);
+    CHECK(cache.size() == 2);
+  }
+
+  SECTION("Other problems do not match")
+  {
+    numint::integration_key other("gauss", "pagani", vol);
+    other.add(0.5);
+    cache.integrate(other, 1.e-3, 1.e-20, run);
+    CHECK(runs == 2);
+  }
+
+  SECTION("Failed runs only answer the same request")
+  {
+    numint::integration_key hard("peak", "pagani", vol);
+    auto failing = [&](numint::vegas_grid*) {
+      ++runs;
+      numint::integration_result res;
+      res.estimate = 2.;
+      res.errorest = 1.e-2;
+      res.status = 1;
+      return res;
+    };
+    cache.integrate(hard, 1.e-4, 1.e-20, failing);
+    res = cache.integrate(hard, 1.e-4, 1.e-20, failing);
+    CHECK(runs == 2);
+    CHECK(res.status == 1);
+    cache.integrate(hard, 1.e-5, 1.e-20, failing);
+    CHECK(runs == 3);
+  }
+  std::remove(filename.c_str());
+}
+
+TEST_CASE("Results persist and are shared between caches")
+{
+  const std::string filename = scratch_file("shared");
+  numint::integration_key key("sinsum", "cuhre");
+  {
+    numint::integration_cache writer(filename);
+    numint::cache_entry entry;
+    entry.epsrel = 1.e-5;
+    entry.result = converged(3., 1.e-6);
+    writer.store(key, entry);
+  }
+
+  numint::integration_cache first(filename);
+  numint::integration_cache second(filename);
+  numint::cache_entry found;
+  REQUIRE(first.lookup(key, 1.e-5, 0., found));
+  CHECK(found.result.estimate == 3.);
+  CHECK(found.result.nregions == 7);
+
+  numint::cache_entry entry;
+  entry.epsrel = 1.e-7;
+  entry.result = converged(3.1, 1.e-9);
+  first.store(key, entry);
+  REQUIRE(second.lookup(key, 1.e-7, 0., found));
+  CHECK(found.result.estimate == 3.1);
+  CHECK(second.size() == 2);
+  std::remove(filename.c_str());
+}
+
+TEST_CASE("Torn records are skipped and cut off")
+{
+  const std::string filename = scratch_file("torn");
+  numint::integration_key key("gauss", "pagani");
+  numint::cache_entry entry;
+  entry.epsrel = 1.e-3;
+  entry.result = converged(1., 1.e-4);
+  {
+    numint::integration_cache cache(filename);
+    cache.store(key, entry);
+  }
+  {
+    std::ofstream out(filename, std::ios::app | std::ios::binary);
+    out << "half a record";
+  }
+
+  numint::integration_cache cache(filename);
+  CHECK(cache.size() == 1);
+  entry.epsrel = 1.e-5;
+  entry.result = converged(1., 1.e-6);
+  cache.store(key, entry);
+  numint::integration_cache reopened(filename);
+  CHECK(reopened.size() == 2);
+  numint::cache_entry found;
+  CHECK(reopened.lookup(key, 1.e-5, 0., found));
+  std::remove(filename.c_str());
+}
+
+TEST_CASE("Looser results warm start VEGAS with their grid")
+{
+  const std::string filename = scratch_file("warm");
+  numint::integration_key key("gauss", "mcubes ncall=1e6");
+  numint::integration_cache cache(filename);
+
+  cache.integrate(key, 1.e-2, 0., [](numint::vegas_grid* grid) {
+    CHECK(grid->empty());
+    grid->resize(2, 4);
+    for (int dim = 0; dim < 2; ++dim)
+      for (int bin = 0; bin < 4; ++bin)
+        (*grid)(dim, bin) = (bin + 1) / 4.;
+    grid->iters = 10;
+    return converged(1., 1.e-3);
+  });
+
+  bool warm = false;
+  cache.integrate(key, 1.e-4, 0., [&](numint::vegas_grid* grid) {
+    warm = !grid->empty() && grid->nbins == 4 && grid->iters == 10 &&
+           (*grid)(1, 2) == .75;
+    return converged(1., 1.e-5);
+  });
+  CHECK(warm);
+  std::remove(filename.c_str());
+}
+
+TEST_CASE("Files of another format are refused")
+{
+  const std::string filename = scratch_file("foreign");
+  {
+    std::ofstream out(filename);
+    out << "0 1 2 3 4 5 6 7 8 9\n";
+  }
+  CHECK_THROWS_AS(numint::integration_cache(filename), std::runtime_error);
+  std::remove(filename.c_str());
+}
+
+TEST_CASE("cubacpp results convert")
+{
+  struct {
+    double value = 2.;
+    double error = 1.e-3;
+    long long neval = 100;
+    int nregions = 3;
+    int status = 0;
+  } cuba;
+  auto const res = numint::from_cubacpp(cuba);
+  CHECK(res.estimate == 2.);
+  CHECK(res.errorest == 1.e-3);
+  CHECK(res.neval == 100);
+  CHECK(res.nregions == 3);
+  CHECK(res.status == 0);
+}
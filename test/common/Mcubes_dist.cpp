@@ -0,0 +1,79 @@
+#define CATCH_CONFIG_RUNNER
+#include "catch2/catch.hpp"
+
+#include "cuda/mcubes/mcubesDist.hh"
+#include "common/mpi_utils.hh"
+#include <cmath>
+
+class GENZ_4_5D {
+public:
+  double
+  operator()(double x, double y, double z, double w, double v)
+  {
+    double beta = .5;
+    return exp(-1.0 *
+               (pow(25, 2) * pow(x - beta, 2) + pow(25, 2) * pow(y - beta, 2) +
+                pow(25, 2) * pow(z - beta, 2) + pow(25, 2) * pow(w - beta, 2) +
+                pow(25, 2) * pow(v - beta, 2)));
+  }
+};
+
+TEST_CASE("Distributed VEGAS does not depend on the number of ranks")
+{
+  constexpr int ndim = 5;
+  double constexpr epsrel = 1.e-3;
+  double constexpr epsabs = 1.e-20;
+  double const true_value = 1.79132603674879e-06;
+  unsigned long const ncall = 1.e5;
+  int const itmx = 10;
+  int const num_streams = 8;
+  quad::Volume<double, ndim> vol;
+  GENZ_4_5D integrand;
+  quad::Mpi_reducer reducer;
+
+  numint::integration_result const res = dist_mcubes_integrate<GENZ_4_5D, ndim>(
+    integrand, epsrel, epsabs, ncall, &vol, itmx, num_streams);
+
+  CHECK(reducer.min(res.estimate) == reducer.max(res.estimate));
+  CHECK(reducer.min(res.errorest) == reducer.max(res.errorest));
+  CHECK(reducer.min(res.chi_sq) == reducer.max(res.chi_sq));
+  CHECK(std::abs(res.estimate - true_value) <= 5. * res.errorest);
+
+  numint::integration_result const single =
+    dist_mcubes_integrate<GENZ_4_5D, ndim>(integrand,
+                                           epsrel,
+                                           epsabs,
+                                           ncall,
+                                           &vol,
+                                           itmx,
+                                           num_streams,
+                                           1,
+                                           MPI_COMM_SELF);
+  CHECK(single.estimate == res.estimate);
+  CHECK(single.errorest == res.errorest);
+  CHECK(single.chi_sq == res.chi_sq);
+}
+
+TEST_CASE("The stream count changes the samples")
+{
+  constexpr int ndim = 5;
+  quad::Volume<double, ndim> vol;
+  GENZ_4_5D integrand;
+
+  numint::integration_result const four =
+    dist_mcubes_integrate<GENZ_4_5D, ndim>(
+      integrand, 1.e-3, 1.e-20, 1.e5, &vol, 3, 4);
+  numint::integration_result const eight =
+    dist_mcubes_integrate<GENZ_4_5D, ndim>(
+      integrand, 1.e-3, 1.e-20, 1.e5, &vol, 3, 8);
+  CHECK(four.estimate != eight.estimate);
+}
+
+int
+main(int argc, char* argv[])
+{
+  MPI_Init(&argc, &argv);
+  const int result = Catch::Session().run(argc, argv);
+  MPI_Finalize();
+  return result;
+}
@@ -0,0 +1,125 @@
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+#include "common/mcubes_tuning.hh"
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace {
+  std::string
+  scratch_file(std::string const& name)
+  {
+    const std::string filename = "mcubes_tuning_" + name + ".txt";
+    std::remove(filename.c_str());
+    return filename;
+  }
+}
+
+TEST_CASE("Keys bucket ncall by decade")
+{
+  using numint::mcubes_tuning_cache;
+  const std::string key =
+    mcubes_tuning_cache::key("fun", 6, 2.e6, "Cuda", "V100");
+  CHECK(key == "fun 6 6 Cuda V100");
+  CHECK(mcubes_tuning_cache::key("fun", 6, 9.9e6, "Cuda", "V100") == key);
+  CHECK(mcubes_tuning_cache::key("fun", 6, 1.e7, "Cuda", "V100") != key);
+  CHECK(mcubes_tuning_cache::key("fun", 5, 2.e6, "Cuda", "V100") != key);
+  CHECK(mcubes_tuning_cache::key("fun", 6, 2.e6, "Cuda", "A100") != key);
+}
+
+TEST_CASE("Lookup finds stored entries only")
+{
+  numint::mcubes_tuning_cache cache(scratch_file("lookup"));
+  CHECK(cache.size() == 0);
+
+  const std::string key =
+    numint::mcubes_tuning_cache::key("fun", 3, 1.e5, "Cuda", "V100");
+  numint::mcubes_launch_config config;
+  CHECK_FALSE(cache.lookup(key, config));
+  CHECK_FALSE(config.valid());
+
+  cache.store(key, {32, 128});
+  REQUIRE(cache.lookup(key, config));
+  CHECK(config.chunk_size == 32);
+  CHECK(config.team_size == 128);
+
+  const std::string other =
+    numint::mcubes_tuning_cache::key("fun", 3, 1.e6, "Cuda", "V100");
+  CHECK_FALSE(cache.lookup(other, config));
+
+  // storing again replaces the entry
+  cache.store(key, {4, 256});
+  REQUIRE(cache.lookup(key, config));
+  CHECK(config.chunk_size == 4);
+  CHECK(config.team_size == 256);
+  CHECK(cache.size() == 1);
+}
+
+TEST_CASE("Entries persist across instances")
+{
+  const std::string filename = scratch_file("persist");
+  const std::string first =
+    numint::mcubes_tuning_cache::key("f", 8, 1.e8, "Cuda", "V100");
+  const std::string second =
+    numint::mcubes_tuning_cache::key("g", 2, 5.e4, "OpenMP", "host");
+  {
+    numint::mcubes_tuning_cache cache(filename);
+    cache.store(first, {2048, 64});
+    cache.store(second, {1, 32});
+  }
+
+  numint::mcubes_tuning_cache reloaded(filename, false);
+  CHECK_FALSE(reloaded.autotune);
+  CHECK(reloaded.size() == 2);
+
+  numint::mcubes_launch_config config;
+  REQUIRE(reloaded.lookup(first, config));
+  CHECK(config.chunk_size == 2048);
+  CHECK(config.team_size == 64);
+  REQUIRE(reloaded.lookup(second, config));
+  CHECK(config.chunk_size == 1);
+  CHECK(config.team_size == 32);
+  std::remove(filename.c_str());
+}
+
+TEST_CASE("Corrupt and stale lines are skipped")
+{
+  const std::string filename = scratch_file("corrupt");
+  {
+    std::ofstream out(filename);
+    out << "f 8 8 Cuda V100 2048 64\n"
+        << "garbage\n"
+        << "g 2 4 Cuda V100 not numbers\n"
+        << "h 3 5 Cuda V100 0 128\n"
+        << "k 3 5 Cuda V100 16 -1\n"
+        << "m 4 6 Cuda V100 32\n"
+        << "\n"
+        << "n 5 7 Cuda V100 128 256 trailing\n";
+  }
+
+  numint::mcubes_tuning_cache cache(filename);
+  CHECK(cache.size() == 2);
+
+  numint::mcubes_launch_config config;
+  CHECK(cache.lookup("f 8 8 Cuda V100", config));
+  CHECK(config.chunk_size == 2048);
+  CHECK(cache.lookup("n 5 7 Cuda V100", config));
+  CHECK(config.team_size == 256);
+  CHECK_FALSE(cache.lookup("h 3 5 Cuda V100", config));
+  CHECK_FALSE(cache.lookup("k 3 5 Cuda V100", config));
+  CHECK_FALSE(cache.lookup("m 4 6 Cuda V100", config));
+
+  // the next store rewrites the file without the bad lines
+  cache.store("p 1 3 Cuda V100", {4, 32});
+  numint::mcubes_tuning_cache rewritten(filename);
+  CHECK(rewritten.size() == 3);
+  std::remove(filename.c_str());
+}
+
+TEST_CASE("An unwritable cache file throws on store")
+{
+  numint::mcubes_tuning_cache cache("no_such_dir/mcubes_tuning.txt");
+  CHECK(cache.size() == 0);
+  CHECK_THROWS_AS(cache.store("f 1 1 Cuda V100", {1, 1}),
+                  std::runtime_error);
+}
@@ -0,0 +1,104 @@
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+#include "common/qmc.hh"
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <stdexcept>
+
+namespace {
+  // the host backend only reads the bounds of the volume
+  template <size_t ndim>
+  struct Box {
+    double lows[ndim];
+    double highs[ndim];
+
+    Box()
+    {
+      std::fill(lows, lows + ndim, 0.);
+      std::fill(highs, highs + ndim, 1.);
+    }
+
+    Box(std::initializer_list<double> l, std::initializer_list<double> h)
+    {
+      std::copy(l.begin(), l.end(), lows);
+      std::copy(h.begin(), h.end(), highs);
+    }
+  };
+
+  class Exp_product_3D {
+  public:
+    double
+    operator()(double x, double y, double z)
+    {
+      return exp(x) * y * y * z;
+    }
+
+    static double
+    true_value()
+    {
+      return (std::exp(1.) - 1.) / 6.;
+    }
+  };
+}
+
+TEST_CASE("Host QMC converges on smooth integrands")
+{
+  Box<3> vol;
+  for (auto rule : {numint::qmc_rule::lattice, numint::qmc_rule::sobol}) {
+    for (auto periodization : {numint::qmc_periodization::none,
+                               numint::qmc_periodization::baker,
+                               numint::qmc_periodization::polynomial}) {
+      numint::qmc_options options;
+      options.rule = rule;
+      options.periodization = periodization;
+      const auto res = numint::qmc_integrate<3>(
+        Exp_product_3D(), 1.e-6, 1.e-12, vol, options, 4);
+      CHECK(res.status == 0);
+      CHECK(res.neval % options.randomizations == 0);
+      CHECK(std::abs(res.estimate - Exp_product_3D::true_value()) <
+            5. * res.errorest + 1.e-12);
+    }
+  }
+}
+
+TEST_CASE("Host QMC maps the points to the volume")
+{
+  // the integral over [1, 2] x [0, 2] x [0, 1]
+  Box<3> vol({1., 0., 0.}, {2., 2., 1.});
+  const double true_value = (std::exp(2.) - std::exp(1.)) * 8. / 3. / 2.;
+  const auto res = numint::qmc_integrate<3>(
+    Exp_product_3D(), 1.e-6, 1.e-12, vol, numint::qmc_options(), 4);
+  CHECK(res.status == 0);
+  CHECK(std::abs(res.estimate - true_value) < 5. * res.errorest + 1.e-10);
+}
+
+TEST_CASE("Host QMC does not depend on the number of threads")
+{
+  Box<3> vol;
+  numint::qmc_options options;
+  options.periodization = numint::qmc_periodization::baker;
+  options.max_log2_points = 14;
+
+  const auto one_thread =
+    numint::qmc_integrate<3>(Exp_product_3D(), 1.e-12, 0., vol, options, 1);
+  const auto threads =
+    numint::qmc_integrate<3>(Exp_product_3D(), 1.e-12, 0., vol, options, 7);
+
+  CHECK(one_thread.status == 1);
+  CHECK(one_thread.iters == options.max_log2_points -
+                              options.min_log2_points + 1);
+  CHECK(one_thread.neval == threads.neval);
+  CHECK(one_thread.estimate == threads.estimate);
+  CHECK(one_thread.errorest == threads.errorest);
+}
+
+TEST_CASE("Host QMC rejects a single randomization")
+{
+  Box<3> vol;
+  numint::qmc_options options;
+  options.randomizations = 1;
+  CHECK_THROWS_AS(
+    numint::qmc_integrate<3>(Exp_product_3D(), 1.e-3, 0., vol, options, 2),
+    std::invalid_argument);
+}
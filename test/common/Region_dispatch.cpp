@@ -0,0 +1,116 @@
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+#include "common/region_dispatch.hh"
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+  // counts how many times every region was processed
+  std::vector<int>
+  visits(numint::region_schedule schedule,
+         size_t n,
+         size_t num_workers,
+         const double* predicted = nullptr)
+  {
+    std::vector<std::atomic<int>> counts(n);
+    numint::region_dispatcher dispatcher(num_workers);
+    dispatcher.run(
+      n, [&](size_t region) { ++counts[region]; }, schedule, predicted);
+    return std::vector<int>(counts.begin(), counts.end());
+  }
+}
+
+TEST_CASE("Every region is processed once")
+{
+  const std::vector<double> predicted{3., 1., 4., 1., 5., 9., 2., 6., 5., 3.};
+  for (auto schedule : {numint::region_schedule::static_blocks,
+                        numint::region_schedule::self_scheduled,
+                        numint::region_schedule::cost_ordered}) {
+    for (size_t n : {size_t{1}, size_t{3}, size_t{10}, size_t{1000}}) {
+      for (size_t num_workers : {size_t{1}, size_t{4}, size_t{16}}) {
+        const std::vector<int> counts =
+          visits(schedule,
+                 n,
+                 num_workers,
+                 n == predicted.size() ? predicted.data() : nullptr);
+        CHECK(counts == std::vector<int>(n, 1));
+      }
+    }
+  }
+}
+
+TEST_CASE("Guided chunks shrink with the work left")
+{
+  CHECK(numint::guided_chunk(1000, 4) == 125);
+  CHECK(numint::guided_chunk(100, 4) == 12);
+  CHECK(numint::guided_chunk(5, 4) == 1);
+  CHECK(numint::guided_chunk(5, 4, 8) == 5);
+}
+
+TEST_CASE("Expensive regions are ordered first")
+{
+  const std::vector<double> costs{2., 7., 1., 7., 3.};
+  CHECK(numint::cost_order(costs.data(), costs.size()) ==
+        std::vector<size_t>{1, 3, 4, 0, 2});
+
+  SECTION("A single worker follows the predicted order")
+  {
+    std::vector<size_t> processed;
+    numint::region_dispatcher dispatcher(1);
+    dispatcher.run(
+      costs.size(),
+      [&](size_t region) { processed.push_back(region); },
+      numint::region_schedule::cost_ordered,
+      costs.data());
+    CHECK(processed == std::vector<size_t>{1, 3, 4, 0, 2});
+  }
+}
+
+TEST_CASE("Measured costs are written per region")
+{
+  const size_t n = 64;
+  std::vector<double> measured(n, -1.);
+  numint::region_dispatcher dispatcher(4);
+  dispatcher.run(
+    n,
+    [](size_t region) {
+      volatile double sum = 0.;
+      for (size_t i = 0; i < 1000 * region; ++i)
+        sum += i;
+    },
+    numint::region_schedule::self_scheduled,
+    nullptr,
+    measured.data());
+  for (double cost : measured)
+    CHECK(cost >= 0.);
+}
+
+TEST_CASE("Exceptions reach the caller")
+{
+  std::atomic<size_t> processed{0};
+  auto work = [&](size_t region) {
+    if (region == 17)
+      throw std::runtime_error("region 17");
+    ++processed;
+  };
+
+  SECTION("A single worker stops at the failing region")
+  {
+    numint::region_dispatcher dispatcher(1);
+    CHECK_THROWS_WITH(dispatcher.run(100, work), "region 17");
+    CHECK(processed == 17);
+  }
+
+  SECTION("Every worker stops after its current region")
+  {
+    // with static blocks of 25, the first worker fails after regions 0 to
+    // 16 and the others finish at most the region they are processing
+    numint::region_dispatcher dispatcher(4);
+    CHECK_THROWS_WITH(
+      dispatcher.run(100, work, numint::region_schedule::static_blocks),
+      "region 17");
+    CHECK(processed >= 17);
+    CHECK(processed < 100);
+  }
+}
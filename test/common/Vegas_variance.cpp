@@ -0,0 +1,130 @@
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+#include "common/vegas_variance.hh"
+#include <cmath>
+#include <random>
+
+namespace {
+  double
+  variance_with(numint::vegas_reduced_sums const& sums, double b)
+  {
+    return sums.ff - 2. * b * sums.fc + b * b * sums.cc;
+  }
+}
+
+TEST_CASE("A correlated control uses b = cov / var")
+{
+  numint::vegas_reduced_sums sums;
+  sums.f = 2.;
+  sums.ff = 1.;
+  sums.c = 1.1;
+  sums.cc = .5;
+  sums.fc = .4;
+  const double control_integral = 1.;
+
+  double estimate = 0., variance = 0.;
+  numint::apply_control_variate(sums, control_integral, estimate, variance);
+
+  const double b = sums.fc / sums.cc;
+  CHECK(b == Approx(.8));
+  CHECK((sums.f - estimate) / (sums.c - control_integral) == Approx(b));
+  CHECK(estimate == Approx(1.92));
+  CHECK(variance == Approx(sums.ff - sums.fc * sums.fc / sums.cc));
+  CHECK(variance < sums.ff);
+
+  // no other coefficient does better
+  CHECK(variance == Approx(variance_with(sums, b)));
+  CHECK(variance < variance_with(sums, .9 * b));
+  CHECK(variance < variance_with(sums, 1.1 * b));
+}
+
+TEST_CASE("An anti-correlated control reduces the variance too")
+{
+  numint::vegas_reduced_sums sums;
+  sums.f = 1.;
+  sums.ff = 2.;
+  sums.c = .9;
+  sums.cc = 1.;
+  sums.fc = -1.;
+
+  double estimate = 0., variance = 0.;
+  numint::apply_control_variate(sums, 1., estimate, variance);
+  CHECK(estimate == Approx(1. - (-1.) * (.9 - 1.)));
+  CHECK(variance == Approx(1.));
+}
+
+TEST_CASE("Useless controls leave the estimate alone")
+{
+  numint::vegas_reduced_sums sums;
+  sums.f = 3.;
+  sums.ff = .25;
+  sums.c = 2.;
+  double estimate = 0., variance = 0.;
+
+  SECTION("constant control")
+  {
+    sums.cc = 0.;
+    numint::apply_control_variate(sums, 1., estimate, variance);
+    CHECK(estimate == 3.);
+    CHECK(variance == .25);
+  }
+
+  SECTION("uncorrelated control")
+  {
+    sums.cc = 1.;
+    sums.fc = 0.;
+    numint::apply_control_variate(sums, 1., estimate, variance);
+    CHECK(estimate == 3.);
+    CHECK(variance == .25);
+  }
+}
+
+TEST_CASE("A perfect control keeps a positive variance")
+{
+  numint::vegas_reduced_sums sums;
+  sums.f = 1.5;
+  sums.ff = 4.;
+  sums.c = .75;
+  sums.cc = 1.;
+  sums.fc = 2.;
+
+  double estimate = 0., variance = 0.;
+  numint::apply_control_variate(sums, .5, estimate, variance);
+  CHECK(estimate == Approx(1.));
+  CHECK(variance > 0.);
+  CHECK(variance == Approx(4.e-30));
+}
+
+TEST_CASE("Sampled sums recover the integral of a correlated integrand")
+{
+  // f = g + h / 10 on [0, 1] with g(u) = u, h(u) = sin(7 u)^2
+  const size_t n = 100000;
+  std::mt19937_64 gen(7);
+  std::uniform_real_distribution<double> uniform;
+  double sf = 0., sff = 0., sc = 0., scc = 0., sfc = 0.;
+  for (size_t i = 0; i < n; ++i) {
+    const double u = uniform(gen);
+    const double g = u;
+    const double f = g + .1 * std::sin(7. * u) * std::sin(7. * u);
+    sf += f;
+    sff += f * f;
+    sc += g;
+    scc += g * g;
+    sfc += f * g;
+  }
+
+  // the mean and the variance of the mean, as the kernels report them
+  numint::vegas_reduced_sums sums;
+  sums.f = sf / n;
+  sums.c = sc / n;
+  sums.ff = (sff / n - sums.f * sums.f) / (n - 1);
+  sums.cc = (scc / n - sums.c * sums.c) / (n - 1);
+  sums.fc = (sfc / n - sums.f * sums.c) / (n - 1);
+
+  double estimate = 0., variance = 0.;
+  numint::apply_control_variate(sums, .5, estimate, variance);
+
+  const double exact = .5 + .1 * (.5 - std::sin(14.) / 28.);
+  CHECK(variance < .05 * sums.ff);
+  CHECK(std::abs(estimate - exact) < 4. * std::sqrt(variance));
+}
@@ -3,11 +3,13 @@
 #include "common/cuda/Interp2D.cuh"
 #include "common/cuda/cudaMemoryUtil.h"
 
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <vector>
 
 __global__ void
 gEvaluate(quad::Interp2D f, double x, double y, double* result)
@@ -175,3 +177,66 @@ TEST_CASE("Interp2D exact at knots")
 {
   test_interpolation_at_knots();
 }
+
+template <typename Interp>
+__global__ void
+gEvaluate_points(Interp f,
+                 const double* x,
+                 const double* y,
+                 size_t n,
+                 double* result)
+{
+  const size_t i = blockIdx.x * blockDim.x + threadIdx.x;
+  if (i < n)
+    result[i] = f(x[i], y[i]);
+}
+
+template <typename Layout>
+std::vector<double>
+evaluate_with_layout(std::vector<double> const& xs,
+                     std::vector<double> const& ys,
+                     std::vector<double> const& zs,
+                     std::vector<double> const& x,
+                     std::vector<double> const& y)
+{
+  quad::basic_Interp2D<Layout> f(xs, ys, zs);
+  const size_t n = x.size();
+  double* points = quad::cuda_malloc_managed<double>(3 * n);
+  std::copy(x.begin(), x.end(), points);
+  std::copy(y.begin(), y.end(), points + n);
+  gEvaluate_points<<<(n + 127) / 128, 128>>>(
+    f, points, points + n, n, points + 2 * n);
+  cudaDeviceSynchronize();
+  std::vector<double> result(points + 2 * n, points + 3 * n);
+  cudaFree(points);
+  return result;
+}
+
+TEST_CASE("Storage layouts give the same values")
+{
+  // uneven spacing, extents that are not multiples of the tiles
+  std::vector<double> xs, ys, zs;
+  for (int i = 0; i < 37; ++i)
+    xs.push_back(i + .01 * i * i);
+  for (int j = 0; j < 21; ++j)
+    ys.push_back(-5. + .5 * j + .02 * j * j);
+  for (double y : ys)
+    for (double x : xs)
+      zs.push_back(std::sin(.3 * x) * std::cos(.7 * y) + .01 * x * y);
+
+  std::vector<double> x, y;
+  for (int k = 0; k < 1000; ++k) {
+    const double u = ((k * 37) % 1000) / 1e3, v = ((k * 91) % 1000) / 1e3;
+    x.push_back(xs.front() + (xs.back() - xs.front()) * u);
+    y.push_back(ys.front() + (ys.back() - ys.front()) * v);
+  }
+
+  const std::vector<double> row_major =
+    evaluate_with_layout<numint::row_major_layout>(xs, ys, zs, x, y);
+  CHECK(evaluate_with_layout<numint::tiled_layout<>>(xs, ys, zs, x, y) ==
+        row_major);
+  CHECK(evaluate_with_layout<numint::morton_layout<>>(xs, ys, zs, x, y) ==
+        row_major);
+  CHECK(evaluate_with_layout<numint::packed_cell_layout>(xs, ys, zs, x, y) ==
+        row_major);
+}
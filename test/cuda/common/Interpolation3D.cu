@@ -3,11 +3,13 @@
 #include "common/cuda/Interp3D.cuh"
 #include "common/cuda/cudaMemoryUtil.h"
 
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <vector>
 
 __global__ void
 gEvaluate(quad::Interp3D f, double x, double y, double z, double* result)
@@ -273,4 +275,65 @@ TEST_CASE("exact solution on linear function")
 TEST_CASE("approximate solution on quadratic function")
 {
   test_on_quadratic_func();
-}
\ No newline at end of file
+}
+template <typename Interp>
+__global__ void
+gEvaluate_points(Interp f, const double* points, size_t n, double* result)
+{
+  const size_t i = blockIdx.x * blockDim.x + threadIdx.x;
+  if (i < n)
+    result[i] = f(points[i], points[n + i], points[2 * n + i]);
+}
+
+template <typename Layout>
+std::vector<double>
+evaluate_with_layout(std::vector<double> const& xs,
+                     std::vector<double> const& ys,
+                     std::vector<double> const& zs,
+                     std::vector<double> const& vs,
+                     std::vector<double> const& points)
+{
+  quad::basic_Interp3D<Layout> f(xs, ys, zs, vs);
+  const size_t n = points.size() / 3;
+  double* buffer = quad::cuda_malloc_managed<double>(4 * n);
+  std::copy(points.begin(), points.end(), buffer);
+  gEvaluate_points<<<(n + 127) / 128, 128>>>(f, buffer, n, buffer + 3 * n);
+  cudaDeviceSynchronize();
+  std::vector<double> result(buffer + 3 * n, buffer + 4 * n);
+  cudaFree(buffer);
+  return result;
+}
+
+TEST_CASE("Storage layouts give the same values")
+{
+  std::vector<double> xs, ys, zs, vs;
+  for (int i = 0; i < 11; ++i)
+    xs.push_back(i + .1 * i * i);
+  for (int j = 0; j < 7; ++j)
+    ys.push_back(.5 * j);
+  for (int k = 0; k < 13; ++k)
+    zs.push_back(-1. + .2 * k + .01 * k * k);
+  for (double z : zs)
+    for (double y : ys)
+      for (double x : xs)
+        vs.push_back(std::sin(.3 * x + y) * std::exp(-.1 * z * z));
+
+  // all the x, then all the y, then all the z
+  constexpr int n = 1000;
+  std::vector<double> points(3 * n);
+  for (int k = 0; k < n; ++k) {
+    points[k] = xs.front() + (xs.back() - xs.front()) * ((k * 37) % n) / n;
+    points[n + k] = ys.front() + (ys.back() - ys.front()) * ((k * 91) % n) / n;
+    points[2 * n + k] =
+      zs.front() + (zs.back() - zs.front()) * ((k * 53) % n) / n;
+  }
+
+  const std::vector<double> row_major =
+    evaluate_with_layout<numint::row_major_layout>(xs, ys, zs, vs, points);
+  CHECK(evaluate_with_layout<numint::tiled_layout<2>>(xs, ys, zs, vs, points) ==
+        row_major);
+  CHECK(evaluate_with_layout<numint::morton_layout<3>>(
+          xs, ys, zs, vs, points) == row_major);
+  CHECK(evaluate_with_layout<numint::packed_cell_layout>(
+          xs, ys, zs, vs, points) == row_major);
+}
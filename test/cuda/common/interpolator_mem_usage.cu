@@ -1,5 +1,6 @@
 #define CATCH_CONFIG_MAIN
 #include "catch2/catch.hpp"
+#include <memory>
 #include <numeric>
 #include <vector>
 #include "common/cuda/Interp1D.cuh"
@@ -106,3 +107,44 @@ TEST_CASE("No memory Leak")
 
   cudaFree(results);
 }
+
+TEST_CASE("Copies share the tables")
+{
+  double* results = quad::cuda_malloc<double>(1000);
+  constexpr size_t s = 100000;
+  std::vector<double> xs_1D(s);
+  std::vector<double> ys_1D(s);
+  std::iota(xs_1D.begin(), xs_1D.end(), 1.);
+  std::iota(ys_1D.begin(), ys_1D.end(), 2.);
+
+  constexpr std::size_t nx = 3;
+  constexpr std::size_t ny = 2;
+  std::array<double, nx> xs_2D = {1., 2., 3.};
+  std::array<double, ny> ys_2D = {4., 5.};
+  auto zs_2D = create_values<nx, ny>(xs_2D, ys_2D);
+
+  using IntegT = Test_object<s, nx, ny>;
+  auto original =
+    std::make_unique<IntegT>(xs_1D.data(), ys_1D.data(), xs_2D, ys_2D, zs_2D);
+
+  // a family of parameter variations takes no device memory of its own
+  size_t const mem_before_copies = quad::get_free_mem();
+  std::vector<IntegT> family(100, *original);
+  CHECK(quad::get_free_mem() == mem_before_copies);
+
+  // and outlives the object it was copied from
+  original.reset();
+  IntegT* device_obj = quad::cuda_copy_to_managed(family.back());
+  Evaluate_test_obj<IntegT><<<1, 1>>>(device_obj, results);
+  cudaDeviceSynchronize();
+  double host_results[1000];
+  cudaMemcpy(
+    host_results, results, sizeof(host_results), cudaMemcpyDeviceToHost);
+  CHECK(host_results[0] == Approx(2.5 * (3 * 2.6 * 4.1 + 2 * 2.6 + 4 * 4.1)));
+  device_obj->~IntegT();
+  cudaFree(device_obj);
+
+  family.clear();
+  CHECK(quad::get_free_mem() >= mem_before_copies);
+  cudaFree(results);
+}
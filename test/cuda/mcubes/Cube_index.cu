@@ -0,0 +1,89 @@
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+#include "cuda/mcubes/vegasT.cuh"
+#include "common/cuda/cudaMemoryUtil.h"
+#include <cstdint>
+#include <vector>
+
+namespace {
+  constexpr int ndim = 8;
+  constexpr int ng = 20; // 20^8 = 2.56e10 cubes
+
+  // reference decoding, the most significant axis first
+  std::vector<uint32_t>
+  decode(size_t index)
+  {
+    std::vector<uint32_t> intervals(ndim);
+    for (int j = ndim - 1; j >= 0; --j) {
+      intervals[j] = 1 + static_cast<uint32_t>(index % ng);
+      index /= ng;
+    }
+    return intervals;
+  }
+
+  std::vector<size_t>
+  large_indices()
+  {
+    size_t num_cubes = 1;
+    for (int j = 0; j < ndim; ++j)
+      num_cubes *= ng;
+    const size_t two_31 = size_t{1} << 31;
+    const size_t two_32 = size_t{1} << 32;
+    return {two_31 - 1,
+            two_31,
+            two_31 + 1,
+            two_32 - 1,
+            two_32,
+            two_32 + 12345,
+            3 * two_32 + 7,
+            num_cubes / 2 + 3,
+            num_cubes - 1};
+  }
+
+  __global__ void
+  decode_on_device(const size_t* indices, size_t n, uint32_t* intervals)
+  {
+    const size_t i = blockIdx.x * blockDim.x + threadIdx.x;
+    if (i < n)
+      cuda_mcubes::get_indx(indices[i], &intervals[i * ndim], ndim, ng);
+  }
+}
+
+TEST_CASE("Cube indices above 2^31 decode on the host")
+{
+  for (size_t index : large_indices()) {
+    uint32_t intervals[ndim];
+    cuda_mcubes::get_indx(index, intervals, ndim, ng);
+    const std::vector<uint32_t> expected = decode(index);
+    for (int j = 0; j < ndim; ++j)
+      CHECK(intervals[j] == expected[j]);
+  }
+
+  // the last cube is the last interval of every axis
+  uint32_t last[ndim];
+  cuda_mcubes::get_indx(large_indices().back(), last, ndim, ng);
+  for (int j = 0; j < ndim; ++j)
+    CHECK(last[j] == static_cast<uint32_t>(ng));
+}
+
+TEST_CASE("Cube indices above 2^31 decode on the device")
+{
+  const std::vector<size_t> indices = large_indices();
+  const size_t n = indices.size();
+  size_t* d_indices = quad::cuda_malloc<size_t>(n);
+  uint32_t* d_intervals = quad::cuda_malloc<uint32_t>(n * ndim);
+  quad::cuda_memcpy_to_device<size_t>(d_indices, indices.data(), n);
+
+  decode_on_device<<<1, 32>>>(d_indices, n, d_intervals);
+  cudaDeviceSynchronize();
+
+  std::vector<uint32_t> intervals(n * ndim);
+  quad::cuda_memcpy_to_host<uint32_t>(intervals.data(), d_intervals, n * ndim);
+  for (size_t i = 0; i < n; ++i) {
+    const std::vector<uint32_t> expected = decode(indices[i]);
+    for (int j = 0; j < ndim; ++j)
+      CHECK(intervals[i * ndim + j] == expected[j]);
+  }
+  cudaFree(d_indices);
+  cudaFree(d_intervals);
+}
@@ -0,0 +1,113 @@
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+#include "cuda/mcubes/vegasT.cuh"
+#include "common/cuda/Volume.cuh"
+#include <cmath>
+
+class Corner_NaN {
+public:
+  __device__ __host__ double
+  operator()(double x, double y)
+  {
+    return x > .5 && y > .5 ? NAN : 1.;
+  }
+};
+
+TEST_CASE("VEGAS stops at the first non-finite value")
+{
+  constexpr int ndim = 2;
+  quad::Volume<double, ndim> vol;
+  Corner_NaN integrand;
+  numint::nonfinite_report report;
+
+  auto const result =
+    cuda_mcubes::integrate<Corner_NaN, ndim>(integrand,
+                                             1.e-3,
+                                             1.e-12,
+                                             1.e5,
+                                             &vol,
+                                             15,
+                                             15,
+                                             5,
+                                             nullptr,
+                                             false,
+                                             numint::nonfinite_policy::fail,
+                                             &report);
+  CHECK(result.status == numint::nonfinite_status);
+  CHECK(std::isnan(result.estimate));
+  CHECK(std::isnan(result.errorest));
+  CHECK(result.iters == 0);
+
+  // about a quarter of the first iteration's samples
+  CHECK(report.count > 0);
+  REQUIRE(!report.points.empty());
+  CHECK(report.points.size() <= report.count);
+  for (auto const& p : report.points) {
+    CHECK(std::isnan(p.value));
+    REQUIRE(p.x.size() == ndim);
+    for (int dim = 0; dim < ndim; ++dim) {
+      CHECK(p.x[dim] > .5);
+      CHECK(p.region_lows[dim] <= p.x[dim]);
+      CHECK(p.x[dim] <= p.region_highs[dim]);
+    }
+  }
+}
+
+TEST_CASE("VEGAS counts non-finite values as zero")
+{
+  constexpr int ndim = 2;
+  quad::Volume<double, ndim> vol;
+  Corner_NaN integrand;
+  numint::nonfinite_report report;
+
+  auto const result =
+    cuda_mcubes::integrate<Corner_NaN, ndim>(integrand,
+                                             1.e-3,
+                                             1.e-12,
+                                             1.e5,
+                                             &vol,
+                                             15,
+                                             15,
+                                             5,
+                                             nullptr,
+                                             false,
+                                             numint::nonfinite_policy::zero,
+                                             &report);
+  CHECK(result.status != numint::nonfinite_status);
+  CHECK(std::isfinite(result.estimate));
+  CHECK(result.estimate == Approx(.75).epsilon(1.e-2));
+  CHECK(report.count > 0);
+}
+
+TEST_CASE("By default VEGAS lets non-finite values reach the estimate")
+{
+  constexpr int ndim = 2;
+  quad::Volume<double, ndim> vol;
+  Corner_NaN integrand;
+
+  auto const result = cuda_mcubes::integrate<Corner_NaN, ndim>(
+    integrand, 1.e-3, 1.e-12, 1.e5, &vol);
+  CHECK(std::isnan(result.estimate));
+  CHECK(result.status == 1);
+  CHECK(result.status != numint::nonfinite_status);
+
+  // the same, with the values counted
+  numint::nonfinite_report report;
+  auto const policy = numint::nonfinite_policy::propagate;
+  auto const propagated =
+    cuda_mcubes::integrate<Corner_NaN, ndim>(integrand,
+                                             1.e-3,
+                                             1.e-12,
+                                             1.e5,
+                                             &vol,
+                                             15,
+                                             15,
+                                             5,
+                                             nullptr,
+                                             false,
+                                             policy,
+                                             &report);
+  CHECK(std::isnan(propagated.estimate));
+  CHECK(propagated.status == 1);
+  CHECK(report.count > 0);
+}
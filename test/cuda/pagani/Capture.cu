@@ -0,0 +1,141 @@
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+#include "cuda/pagani/quad/GPUquad/Workspace.cuh"
+#include "common/capture.hh"
+#include "common/cuda/Volume.cuh"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <tuple>
+#include <vector>
+
+class Product_3D {
+public:
+  __device__ __host__ double
+  operator()(double x, double y, double z)
+  {
+    return x * y * y * exp(z);
+  }
+};
+
+namespace {
+  std::string
+  scratch_file(std::string const& name)
+  {
+    const std::string filename = "pagani_capture_" + name + ".bin";
+    std::remove(filename.c_str());
+    return filename;
+  }
+}
+
+TEST_CASE("Final regions partition the volume")
+{
+  constexpr int ndim = 3;
+  const std::string filename = scratch_file("regions");
+  quad::Volume<double, ndim> vol({0., 0., 0.}, {1., 2., 1.});
+  Workspace<double, ndim> pagani;
+  numint::capture_options options;
+  options.regions = 1 << 18;
+  pagani.capture_to(filename, options);
+  auto const res =
+    pagani.integrate<Product_3D>(Product_3D(), 1.e-6, 1.e-12, vol);
+  pagani.stop_capture();
+  REQUIRE(res.status == 0);
+
+  const numint::capture_data data = numint::read_capture(filename);
+  REQUIRE(data.ndim == ndim);
+  CHECK(data.dropped_regions == 0);
+  CHECK(data.region_estimate.size() == res.nregions);
+
+  double volume = 0., estimate = 0.;
+  for (size_t r = 0; r < data.region_estimate.size(); ++r) {
+    double region_volume = 1.;
+    for (int dim = 0; dim < ndim; ++dim) {
+      CHECK(data.region_lows[dim][r] >= vol.lows[dim]);
+      CHECK(data.region_highs[dim][r] <= vol.highs[dim]);
+      region_volume *= data.region_highs[dim][r] - data.region_lows[dim][r];
+    }
+    volume += region_volume;
+    estimate += data.region_estimate[r];
+  }
+  CHECK(volume == Approx(2.).epsilon(1.e-12));
+  CHECK(estimate == Approx(res.estimate).epsilon(1.e-10));
+}
+
+TEST_CASE("Evaluations are sampled into bounded buffers")
+{
+  constexpr int ndim = 3;
+  const std::string filename = scratch_file("evaluations");
+  quad::Volume<double, ndim> vol;
+  Workspace<double, ndim> pagani;
+  numint::capture_options options;
+  options.evaluations = 1024;
+  options.sample_every = 16;
+  pagani.capture_to(filename, options);
+  auto const res =
+    pagani.integrate<Product_3D>(Product_3D(), 1.e-6, 1.e-12, vol);
+  pagani.stop_capture();
+  REQUIRE(res.status == 0);
+
+  const numint::capture_data data = numint::read_capture(filename);
+  REQUIRE(!data.eval_value.empty());
+  CHECK(data.eval_value.size() <= 1024 * (res.iters + 1));
+
+  Product_3D integrand;
+  for (size_t i = 0; i < data.eval_value.size(); ++i) {
+    const double x = data.eval_x[0][i];
+    const double y = data.eval_x[1][i];
+    const double z = data.eval_x[2][i];
+    CHECK(data.eval_value[i] == Approx(integrand(x, y, z)));
+  }
+}
+
+TEST_CASE("The sample does not change from one run to the next")
+{
+  constexpr int ndim = 3;
+  quad::Volume<double, ndim> vol;
+  Workspace<double, ndim> pagani;
+  numint::capture_options options;
+  options.evaluations = 1 << 20;
+  options.sample_every = 16;
+
+  // slots are taken in whatever order the blocks run
+  auto sampled = [&](std::string const& name) {
+    pagani.capture_to(scratch_file(name), options);
+    pagani.integrate<Product_3D>(Product_3D(), 1.e-6, 1.e-12, vol);
+    pagani.stop_capture();
+    const numint::capture_data data =
+      numint::read_capture("pagani_capture_" + name + ".bin");
+    CHECK(data.dropped_evaluations == 0);
+    std::vector<std::tuple<uint32_t, uint64_t, uint32_t>> keys;
+    for (size_t i = 0; i < data.eval_value.size(); ++i)
+      keys.emplace_back(
+        data.eval_iteration[i], data.eval_region[i], data.eval_point[i]);
+    std::sort(keys.begin(), keys.end());
+    return keys;
+  };
+
+  const auto first = sampled("first");
+  REQUIRE(!first.empty());
+  CHECK(sampled("second") == first);
+}
+
+TEST_CASE("Small evaluations can be filtered out")
+{
+  constexpr int ndim = 3;
+  const std::string filename = scratch_file("filtered");
+  quad::Volume<double, ndim> vol;
+  Workspace<double, ndim> pagani;
+  numint::capture_options options;
+  options.sample_every = 1;
+  options.min_abs_value = 1.;
+  pagani.capture_to(filename, options);
+  pagani.integrate<Product_3D>(Product_3D(), 1.e-3, 1.e-12, vol);
+  pagani.stop_capture();
+
+  const numint::capture_data data = numint::read_capture(filename);
+  REQUIRE(!data.eval_value.empty());
+  for (double value : data.eval_value)
+    CHECK(std::abs(value) >= 1.);
+}
@@ -0,0 +1,99 @@
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+#include "cuda/pagani/quad/GPUquad/Workspace.cuh"
+#include "common/cuda/Volume.cuh"
+#include "common/cuda/integrands.cuh"
+#include "common/integration_result.hh"
+#include <chrono>
+#include <future>
+
+// linear, so the first iteration converges, but every evaluation spins long
+// enough for the cubature kernel to dominate a run
+class Busy_5D {
+public:
+  __device__ __host__ double
+  operator()(double x, double y, double z, double w, double v)
+  {
+    double spin = 0.;
+    for (int i = 0; i < spins; ++i)
+      spin += cos(spin + x * i);
+    return x + y + z + w + v + 1.e-300 * spin;
+  }
+
+  int spins = 1 << 18;
+};
+
+template <typename F>
+double
+seconds(F run)
+{
+  auto const t0 = std::chrono::steady_clock::now();
+  run();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+    .count();
+}
+
+TEST_CASE("Workspaces on separate streams give the sequential results")
+{
+  constexpr int ndim = 5;
+  constexpr double epsrel = 1.e-5;
+  constexpr double epsabs = 1.e-20;
+  quad::Volume<double, ndim> vol;
+  F_4_5D gaussian;
+  SinSum_5D sinsum;
+
+  Workspace<double, ndim> reference;
+  auto const expected_gaussian =
+    reference.integrate(gaussian, epsrel, epsabs, vol);
+  auto const expected_sinsum = reference.integrate(sinsum, epsrel, epsabs, vol);
+
+  Workspace<double, ndim> first;
+  Workspace<double, ndim> second;
+  auto gaussian_run = std::async(std::launch::async, [&]() {
+    return first.integrate(gaussian, epsrel, epsabs, vol);
+  });
+  auto sinsum_run = std::async(std::launch::async, [&]() {
+    return second.integrate(sinsum, epsrel, epsabs, vol);
+  });
+  auto const res_gaussian = gaussian_run.get();
+  auto const res_sinsum = sinsum_run.get();
+
+  CHECK(res_gaussian.status == expected_gaussian.status);
+  CHECK(res_gaussian.nregions == expected_gaussian.nregions);
+  CHECK(res_gaussian.estimate == Approx(expected_gaussian.estimate));
+  CHECK(res_sinsum.status == expected_sinsum.status);
+  CHECK(res_sinsum.nregions == expected_sinsum.nregions);
+  CHECK(res_sinsum.estimate == Approx(expected_sinsum.estimate));
+}
+
+TEST_CASE("Workspaces on separate streams overlap on the device")
+{
+  constexpr int ndim = 5;
+  constexpr double epsrel = 1.e-3;
+  constexpr double epsabs = 1.e-20;
+  quad::Volume<double, ndim> vol;
+  Busy_5D integrand;
+
+  // 32 initial regions, one block each, leave most of the device idle
+  Workspace<double, ndim> first;
+  Workspace<double, ndim> second;
+  first.integrate(integrand, epsrel, epsabs, vol);
+
+  const double sequential = seconds([&]() {
+    first.integrate(integrand, epsrel, epsabs, vol);
+    second.integrate(integrand, epsrel, epsabs, vol);
+  });
+  const double concurrent = seconds([&]() {
+    auto first_run = std::async(std::launch::async, [&]() {
+      return first.integrate(integrand, epsrel, epsabs, vol);
+    });
+    auto second_run = std::async(std::launch::async, [&]() {
+      return second.integrate(integrand, epsrel, epsabs, vol);
+    });
+    CHECK(first_run.get().status == 0);
+    CHECK(second_run.get().status == 0);
+  });
+
+  // perfect overlap halves the time
+  CHECK(concurrent < .8 * sequential);
+}
@@ -35,3 +35,78 @@ TEST_CASE("Return NAN")
     pagani.integrate<NaN_Integral>(integrand, epsrel, epsabs, vol);
   CHECK(std::isnan(result.estimate) == true);
 };
+
+class Corner_NaN {
+public:
+  __device__ double
+  operator()(double x, double y)
+  {
+    return x > .5 && y > .5 ? NAN : 1.;
+  }
+};
+
+TEST_CASE("Stop at the first non-finite value")
+{
+  constexpr int ndim = 2;
+  quad::Volume<double, ndim> vol;
+  Workspace<double, ndim> pagani;
+  Corner_NaN integrand;
+
+  auto const result =
+    pagani.integrate<Corner_NaN>(integrand, 1.e-3, 1.e-12, vol);
+  CHECK(result.status == numint::nonfinite_status);
+  CHECK(std::isnan(result.estimate));
+  CHECK(result.iters == 0);
+
+  auto const report = pagani.nonfinite_report();
+  CHECK(report.count > 0);
+  REQUIRE(!report.points.empty());
+  CHECK(report.points.size() <= report.count);
+  for (auto const& p : report.points) {
+    CHECK(std::isnan(p.value));
+    for (int dim = 0; dim < ndim; ++dim) {
+      CHECK(p.x[dim] > .5);
+      CHECK(p.region_lows[dim] <= p.x[dim]);
+      CHECK(p.x[dim] <= p.region_highs[dim]);
+    }
+  }
+}
+
+TEST_CASE("Non-finite values counted as zero")
+{
+  constexpr int ndim = 2;
+  quad::Volume<double, ndim> vol;
+  Workspace<double, ndim> pagani;
+  pagani.set_nonfinite_policy(numint::nonfinite_policy::zero);
+  Corner_NaN integrand;
+
+  auto const result =
+    pagani.integrate<Corner_NaN>(integrand, 1.e-3, 1.e-12, vol);
+  CHECK(result.status != numint::nonfinite_status);
+  CHECK(result.estimate == Approx(.75).epsilon(1.e-2));
+  CHECK(pagani.nonfinite_report().count > 0);
+}
+
+TEST_CASE("Regions with non-finite values excluded")
+{
+  constexpr int ndim = 2;
+  quad::Volume<double, ndim> vol;
+  Workspace<double, ndim> pagani;
+  pagani.set_nonfinite_policy(numint::nonfinite_policy::exclude);
+  Corner_NaN integrand;
+
+  auto const result =
+    pagani.integrate<Corner_NaN>(integrand, 1.e-3, 1.e-12, vol);
+  // the first split has 4 x 4 regions, the 4 in the corner are dropped
+  // and the others integrate 1 exactly
+  CHECK(result.status == 0);
+  CHECK(result.estimate == Approx(.75).epsilon(1.e-10));
+  CHECK(result.errorest <= 1.e-3 * .75);
+
+  auto const report = pagani.nonfinite_report();
+  constexpr size_t fevals = pagani::CuhreFuncEvalsPerRegion<ndim>();
+  CHECK(report.count == 4 * fevals);
+  for (auto const& p : report.points)
+    for (int dim = 0; dim < ndim; ++dim)
+      CHECK(p.region_lows[dim] >= .5);
+}
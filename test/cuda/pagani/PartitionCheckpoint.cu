@@ -0,0 +1,173 @@
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+#include "cuda/pagani/quad/GPUquad/Workspace.cuh"
+#include "cuda/pagani/quad/GPUquad/Partition_checkpoint.cuh"
+#include "common/cuda/cudaMemoryUtil.h"
+#include "common/cuda/Volume.cuh"
+#include "common/cuda/integrands.cuh"
+#include "common/integration_result.hh"
+#include <cmath>
+#include <vector>
+
+TEST_CASE("Partition survives a round trip through a file")
+{
+  constexpr int ndim = 3;
+  Sub_regions<double, ndim> regions(4);
+  const size_t n = regions.size;
+  Region_estimates<double, ndim> parents(n / 2);
+
+  std::vector<double> ests(n / 2);
+  for (size_t i = 0; i < n / 2; ++i)
+    ests[i] = static_cast<double>(i);
+  quad::cuda_memcpy_to_device<double>(
+    parents.integral_estimates, ests.data(), n / 2);
+  quad::cuda_memcpy_to_device<double>(
+    parents.error_estimates, ests.data(), n / 2);
+
+  Partition_checkpoint<double, ndim> saved;
+  saved.capture(regions, parents, 3);
+  saved.save("cuda_pagani_partition.bin");
+
+  Partition_checkpoint<double, ndim> loaded("cuda_pagani_partition.bin");
+  CHECK(loaded.size == n);
+  CHECK(loaded.num_parents == n / 2);
+  CHECK(loaded.iterations == 3);
+
+  Sub_regions<double, ndim> restored;
+  Region_estimates<double, ndim> restored_parents;
+  loaded.restore(restored, restored_parents);
+  CHECK(restored.size == n);
+  CHECK(restored_parents.size == n / 2);
+
+  std::vector<double> orig(n * ndim), copy(n * ndim);
+  quad::cuda_memcpy_to_host<double>(orig.data(), regions.dLeftCoord, n * ndim);
+  quad::cuda_memcpy_to_host<double>(
+    copy.data(), restored.dLeftCoord, n * ndim);
+  CHECK(orig == copy);
+
+  quad::cuda_memcpy_to_host<double>(orig.data(), regions.dLength, n * ndim);
+  quad::cuda_memcpy_to_host<double>(copy.data(), restored.dLength, n * ndim);
+  CHECK(orig == copy);
+
+  std::vector<double> restored_ests(n / 2);
+  quad::cuda_memcpy_to_host<double>(
+    restored_ests.data(), restored_parents.integral_estimates, n / 2);
+  CHECK(restored_ests == ests);
+}
+
+TEST_CASE("Loading a partition of another dimension fails")
+{
+  Sub_regions<double, 2> regions(4);
+  Region_estimates<double, 2> parents;
+  Partition_checkpoint<double, 2> saved;
+  saved.capture(regions, parents, 0);
+  saved.save("cuda_pagani_partition_2D.bin");
+
+  Partition_checkpoint<double, 3> loaded;
+  CHECK_THROWS(loaded.load("cuda_pagani_partition_2D.bin"));
+  CHECK(loaded.empty());
+}
+
+TEST_CASE("Warm-start skips refinement of a nearby integrand")
+{
+  constexpr int ndim = 5;
+  constexpr double epsrel = 1.e-5;
+  constexpr double epsabs = 1.e-40;
+  quad::Volume<double, ndim> vol;
+  Workspace<double, ndim> workspace;
+
+  F_4_5D_alt integrand;
+  integrand.sharpness = 15.;
+  integrand.peak_loc = .5;
+  Partition_checkpoint<double, ndim> checkpoint;
+  numint::integration_result first =
+    workspace.integrate(integrand, checkpoint, epsrel, epsabs, vol);
+  REQUIRE(first.status == 0);
+  REQUIRE(!checkpoint.empty());
+  checkpoint.save("cuda_pagani_partition_5D.bin");
+
+  integrand.peak_loc = .51;
+  integrand.set_true_value();
+
+  Partition_checkpoint<double, ndim> empty;
+  numint::integration_result cold =
+    workspace.integrate(integrand, empty, epsrel, epsabs, vol);
+
+  Partition_checkpoint<double, ndim> loaded("cuda_pagani_partition_5D.bin");
+  numint::integration_result warm =
+    workspace.integrate(integrand, loaded, epsrel, epsabs, vol);
+
+  CHECK(cold.status == 0);
+  CHECK(warm.status == 0);
+  CHECK(warm.iters < cold.iters);
+  CHECK(std::abs(warm.estimate - integrand.true_value) <=
+        epsrel * std::abs(integrand.true_value));
+}
+
+TEST_CASE("Checkpoint is refreshed at its interval only")
+{
+  constexpr int ndim = 5;
+  constexpr double epsrel = 1.e-5;
+  constexpr double epsabs = 1.e-40;
+  quad::Volume<double, ndim> vol;
+  Workspace<double, ndim> workspace;
+
+  F_4_5D_alt integrand;
+  integrand.sharpness = 15.;
+  integrand.peak_loc = .5;
+
+  Partition_checkpoint<double, ndim> every;
+  every.set_interval(1);
+  workspace.integrate(integrand, every, epsrel, epsabs, vol);
+
+  Partition_checkpoint<double, ndim> sparse;
+  sparse.set_interval(3);
+  workspace.integrate(integrand, sparse, epsrel, epsabs, vol);
+
+  REQUIRE(!every.empty());
+  REQUIRE(!sparse.empty());
+  CHECK((sparse.iterations - 1) % 3 == 0);
+  CHECK(sparse.iterations <= every.iterations);
+  CHECK(every.iterations - sparse.iterations < 3);
+}
+
+TEST_CASE("Clearing a checkpoint resets its interval")
+{
+  constexpr int ndim = 3;
+  Sub_regions<double, ndim> regions(4);
+  Region_estimates<double, ndim> parents;
+
+  Partition_checkpoint<double, ndim> checkpoint;
+  checkpoint.set_interval(3);
+  checkpoint.capture(regions, parents, 0);
+  CHECK(checkpoint.interval == 3);
+
+  checkpoint.clear();
+  CHECK(checkpoint.empty());
+  CHECK(checkpoint.interval ==
+        Partition_checkpoint<double, ndim>::default_interval);
+}
+
+TEST_CASE("Only the overload taking regions counts the final iteration")
+{
+  constexpr int ndim = 5;
+  constexpr double epsrel = 1.e-5;
+  constexpr double epsabs = 1.e-40;
+  quad::Volume<double, ndim> vol;
+  Workspace<double, ndim> workspace;
+
+  F_4_5D_alt integrand;
+  integrand.sharpness = 15.;
+  integrand.peak_loc = .5;
+
+  numint::integration_result from_volume =
+    workspace.integrate(integrand, epsrel, epsabs, vol);
+  // the split the overload above starts from in 5D
+  Sub_regions<double, ndim> regions(2);
+  numint::integration_result from_regions =
+    workspace.integrate(integrand, regions, epsrel, epsabs, vol);
+
+  REQUIRE(from_volume.status == 0);
+  REQUIRE(from_regions.status == 0);
+  CHECK(from_regions.iters == from_volume.iters + 1);
+}
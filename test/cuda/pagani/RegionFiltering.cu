@@ -14,6 +14,7 @@
 #include <iomanip>
 #include <iostream>
 #include <numeric>
+#include <vector>
 
 #include "cuda/pagani/quad/GPUquad/PaganiUtils.cuh"
 #include "cuda/pagani/quad/GPUquad/Workspace.cuh"
@@ -492,3 +493,88 @@ TEST_CASE("filter: first and last regions are inactive")
   CHECK(!regions_same(
     LeftCoord, original_LeftCoord, num_active - 1, n - 1, ndim, num_active, n));
 }
+
+// filters a partition of partitions^ndim regions, every third and every
+// seventh but one active, and checks it against the output of the scan
+// based filter: the active regions in order, with their estimates moved to
+// the parents and positions that are the exclusive scan of the flags
+template <size_t ndim>
+void
+check_filter_output(Sub_regions_filter<double, ndim>& filter,
+                    size_t partitions)
+{
+  Sub_regions<double, ndim> regions(partitions);
+  const size_t n = regions.size;
+  Region_characteristics<ndim> characteristics(n);
+  Region_estimates<double, ndim> estimates(n);
+  Region_estimates<double, ndim> parents;
+
+  std::vector<double> active(n), integrals(n), errors(n);
+  std::vector<int> dims(n);
+  std::vector<size_t> kept;
+  for (size_t i = 0; i < n; ++i) {
+    active[i] = i % 3 == 0 || i % 7 == 1 ? 1. : 0.;
+    integrals[i] = static_cast<double>(i);
+    errors[i] = .5 * i;
+    dims[i] = static_cast<int>(i % ndim);
+    if (active[i] == 1.)
+      kept.push_back(i);
+  }
+
+  std::vector<double> left(n * ndim), length(n * ndim);
+  quad::cuda_memcpy_to_host<double>(left.data(), regions.dLeftCoord, n * ndim);
+  quad::cuda_memcpy_to_host<double>(length.data(), regions.dLength, n * ndim);
+  quad::cuda_memcpy_to_device<double>(
+    characteristics.active_regions, active.data(), n);
+  quad::cuda_memcpy_to_device<int>(
+    characteristics.sub_dividing_dim, dims.data(), n);
+  quad::cuda_memcpy_to_device<double>(
+    estimates.integral_estimates, integrals.data(), n);
+  quad::cuda_memcpy_to_device<double>(
+    estimates.error_estimates, errors.data(), n);
+
+  const size_t m = filter.filter(regions, characteristics, estimates, parents);
+  REQUIRE(m == kept.size());
+  REQUIRE(regions.size == m);
+  REQUIRE(parents.size == m);
+
+  std::vector<double> new_left(m * ndim), new_length(m * ndim);
+  std::vector<double> parent_integrals(m), parent_errors(m), positions(n);
+  std::vector<int> new_dims(m);
+  quad::cuda_memcpy_to_host<double>(
+    new_left.data(), regions.dLeftCoord, m * ndim);
+  quad::cuda_memcpy_to_host<double>(
+    new_length.data(), regions.dLength, m * ndim);
+  quad::cuda_memcpy_to_host<double>(
+    parent_integrals.data(), parents.integral_estimates, m);
+  quad::cuda_memcpy_to_host<double>(
+    parent_errors.data(), parents.error_estimates, m);
+  quad::cuda_memcpy_to_host<int>(
+    new_dims.data(), characteristics.sub_dividing_dim, m);
+  quad::cuda_memcpy_to_host<double>(
+    positions.data(), filter.scanned_array, n);
+
+  size_t mismatches = 0;
+  for (size_t slot = 0; slot < m; ++slot) {
+    const size_t i = kept[slot];
+    mismatches += positions[i] != slot;
+    mismatches += parent_integrals[slot] != integrals[i];
+    mismatches += parent_errors[slot] != errors[i];
+    mismatches += new_dims[slot] != dims[i];
+    for (size_t dim = 0; dim < ndim; ++dim) {
+      mismatches += new_left[dim * m + slot] != left[dim * n + i];
+      mismatches += new_length[dim * m + slot] != length[dim * n + i];
+    }
+  }
+  CHECK(mismatches == 0);
+}
+
+TEST_CASE("A filter reused across iterations matches the scan based one")
+{
+  constexpr size_t ndim = 2;
+  Sub_regions_filter<double, ndim> filter;
+  check_filter_output(filter, 8);
+  // more tiles than the first call, the state must grow
+  check_filter_output(filter, 400);
+  check_filter_output(filter, 3);
+}
@@ -10,6 +10,7 @@
 #include <iostream>
 #include <numeric>
 #include <array>
+#include <vector>
 
 double
 compute_jacobian(double* left_coord, double* length, size_t size)
@@ -93,4 +94,60 @@ TEST_CASE("Split 10D space in unit-hypercube")
     CHECK(sub_regions.Length[i] < 1.);
     CHECK(sub_regions.Length[i] > 0.);
   }
-}
\ No newline at end of file
+}
+namespace {
+  template <size_t ndim>
+  std::vector<double>
+  device_coords(Sub_regions<double, ndim> const& regions, bool left)
+  {
+    std::vector<double> coords(regions.size * ndim);
+    const double* src = left ? regions.dLeftCoord : regions.dLength;
+    quad::cuda_memcpy_to_host<double>(coords.data(), src, coords.size());
+    return coords;
+  }
+}
+
+TEST_CASE("A snapshot can be loaded more than once")
+{
+  constexpr size_t ndim = 3;
+  Sub_regions<double, ndim> sub_regions(4);
+  const std::vector<double> left = device_coords(sub_regions, true);
+  const std::vector<double> length = device_coords(sub_regions, false);
+  sub_regions.take_snapshot();
+
+  for (int load = 0; load < 2; ++load) {
+    std::vector<double> garbage(sub_regions.size * ndim, -1.);
+    quad::cuda_memcpy_to_device<double>(
+      sub_regions.dLeftCoord, garbage.data(), garbage.size());
+    quad::cuda_memcpy_to_device<double>(
+      sub_regions.dLength, garbage.data(), garbage.size());
+
+    sub_regions.load_snapshot();
+    CHECK(sub_regions.dLeftCoord != sub_regions.snapshot_dLeftCoord);
+    CHECK(sub_regions.dLength != sub_regions.snapshot_dLength);
+    CHECK(device_coords(sub_regions, true) == left);
+    CHECK(device_coords(sub_regions, false) == length);
+  }
+}
+
+TEST_CASE("Copies of sub-regions own their coordinates")
+{
+  constexpr size_t ndim = 3;
+  Sub_regions<double, ndim> sub_regions(3);
+  const std::vector<double> left = device_coords(sub_regions, true);
+
+  Sub_regions<double, ndim> constructed(sub_regions);
+  Sub_regions<double, ndim> assigned(2);
+  assigned = sub_regions;
+  REQUIRE(assigned.size == sub_regions.size);
+  CHECK(assigned.dLeftCoord != sub_regions.dLeftCoord);
+
+  std::vector<double> garbage(sub_regions.size * ndim, -1.);
+  quad::cuda_memcpy_to_device<double>(
+    sub_regions.dLeftCoord, garbage.data(), garbage.size());
+
+  CHECK(device_coords(constructed, true) == left);
+  CHECK(device_coords(assigned, true) == left);
+  CHECK(device_coords(constructed, false) ==
+        device_coords(sub_regions, false));
+}
@@ -0,0 +1,78 @@
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+#include "cuda/pagani/quad/GPUquad/Vector_workspace.cuh"
+#include "cuda/pagani/quad/GPUquad/Workspace.cuh"
+#include "common/cuda/cudaArray.cuh"
+#include "common/cuda/Volume.cuh"
+#include "common/integration_result.hh"
+#include <cmath>
+
+__device__ __host__ double
+gaussian(double x, double y, double z)
+{
+  return exp(-10. * ((x - .5) * (x - .5) + (y - .5) * (y - .5) +
+                     (z - .5) * (z - .5)));
+}
+
+// a gaussian, its first moment along x and a constant
+class Gaussian_moments {
+public:
+  __device__ __host__ gpu::cudaArray<double, 3>
+  operator()(double x, double y, double z)
+  {
+    const double g = gaussian(x, y, z);
+    return {{g, x * g, 2.}};
+  }
+};
+
+template <int comp>
+class Gaussian_moment {
+public:
+  __device__ __host__ double
+  operator()(double x, double y, double z)
+  {
+    return Gaussian_moments()(x, y, z)[comp];
+  }
+};
+
+TEST_CASE("All components converge on one partition")
+{
+  constexpr int ndim = 3;
+  constexpr double epsrel = 1.e-6;
+  constexpr double epsabs = 1.e-20;
+  quad::Volume<double, ndim> vol;
+  Vector_workspace<double, ndim, 3> workspace;
+
+  numint::integration_results<3> res =
+    workspace.integrate(Gaussian_moments(), epsrel, epsabs, vol);
+
+  CHECK(res.status == 0);
+  for (int comp = 0; comp < 3; ++comp) {
+    CHECK(res.errorest[comp] <= epsrel * std::abs(res.estimate[comp]));
+  }
+  CHECK(res.estimate[2] == Approx(2.).epsilon(1.e-12));
+  // the gaussian is symmetric around .5
+  CHECK(res.estimate[1] == Approx(.5 * res.estimate[0]).epsilon(epsrel));
+}
+
+TEST_CASE("Components match scalar integrations")
+{
+  constexpr int ndim = 3;
+  constexpr double epsrel = 1.e-5;
+  constexpr double epsabs = 1.e-20;
+  quad::Volume<double, ndim> vol;
+  Vector_workspace<double, ndim, 3> vector_workspace;
+  Workspace<double, ndim> workspace;
+
+  numint::integration_results<3> res =
+    vector_workspace.integrate(Gaussian_moments(), epsrel, epsabs, vol);
+  numint::integration_result first =
+    workspace.integrate(Gaussian_moment<0>(), epsrel, epsabs, vol);
+  numint::integration_result second =
+    workspace.integrate(Gaussian_moment<1>(), epsrel, epsabs, vol);
+
+  CHECK(res.estimate[0] == Approx(first.estimate).epsilon(2 * epsrel));
+  CHECK(res.estimate[1] == Approx(second.estimate).epsilon(2 * epsrel));
+  CHECK(res.component(1).estimate == res.estimate[1]);
+  CHECK(res.component(1).status == res.status);
+}
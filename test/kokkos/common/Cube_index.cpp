@@ -0,0 +1,78 @@
+#include "catch2/catch.hpp"
+#include "kokkos/mcubes/mcubes.h"
+#include <cstdint>
+#include <vector>
+
+namespace {
+  constexpr int ndim = 8;
+  constexpr int ng = 20; // 20^8 = 2.56e10 cubes
+
+  // reference decoding, the most significant axis first
+  std::vector<uint32_t>
+  decode(size_t index)
+  {
+    std::vector<uint32_t> intervals(ndim);
+    for (int j = ndim - 1; j >= 0; --j) {
+      intervals[j] = 1 + static_cast<uint32_t>(index % ng);
+      index /= ng;
+    }
+    return intervals;
+  }
+
+  std::vector<size_t>
+  large_indices()
+  {
+    size_t num_cubes = 1;
+    for (int j = 0; j < ndim; ++j)
+      num_cubes *= ng;
+    const size_t two_31 = size_t{1} << 31;
+    const size_t two_32 = size_t{1} << 32;
+    return {two_31 - 1,
+            two_31,
+            two_31 + 1,
+            two_32 - 1,
+            two_32,
+            two_32 + 12345,
+            3 * two_32 + 7,
+            num_cubes / 2 + 3,
+            num_cubes - 1};
+  }
+}
+
+TEST_CASE("Cube indices above 2^31 decode on the host")
+{
+  for (size_t index : large_indices()) {
+    uint32_t intervals[ndim];
+    kokkos_mcubes::get_indx(index, intervals, ndim, ng);
+    const std::vector<uint32_t> expected = decode(index);
+    for (int j = 0; j < ndim; ++j)
+      CHECK(intervals[j] == expected[j]);
+  }
+}
+
+TEST_CASE("Cube indices above 2^31 decode on the device")
+{
+  const std::vector<size_t> indices = large_indices();
+  const size_t n = indices.size();
+  ViewVectorSize_t d_indices("indices", n);
+  Kokkos::View<uint32_t*, Kokkos::CudaSpace> d_intervals("intervals",
+                                                         n * ndim);
+  auto h_indices = Kokkos::create_mirror_view(d_indices);
+  for (size_t i = 0; i < n; ++i)
+    h_indices(i) = indices[i];
+  Kokkos::deep_copy(d_indices, h_indices);
+
+  Kokkos::parallel_for(
+    "DecodeCubes", Kokkos::RangePolicy<>(0, n), KOKKOS_LAMBDA(const size_t i) {
+      kokkos_mcubes::get_indx(
+        d_indices(i), d_intervals.data() + i * ndim, ndim, ng);
+    });
+
+  auto intervals =
+    Kokkos::create_mirror_view_and_copy(Kokkos::HostSpace(), d_intervals);
+  for (size_t i = 0; i < n; ++i) {
+    const std::vector<uint32_t> expected = decode(indices[i]);
+    for (int j = 0; j < ndim; ++j)
+      CHECK(intervals(i * ndim + j) == expected[j]);
+  }
+}
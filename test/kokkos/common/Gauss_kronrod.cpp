@@ -0,0 +1,134 @@
+#include "catch2/catch.hpp"
+#include "kokkos/gauss_kronrod/batched_qag.h"
+#include <cmath>
+#include <vector>
+
+// f_i(x) = exp(-a_i x), a family with one parameter per integral
+class Exponential_family {
+public:
+  KOKKOS_INLINE_FUNCTION double
+  operator()(size_t i, double x) const
+  {
+    return exp(-(1. + .01 * i) * x);
+  }
+};
+
+// narrow peak at 0.3 that a single rule application cannot resolve
+class Peak_family {
+public:
+  KOKKOS_INLINE_FUNCTION double
+  operator()(size_t i, double x) const
+  {
+    const double width = 1.e-2 / (1. + i % 4);
+    return 1. / (width * width + (x - .3) * (x - .3));
+  }
+};
+
+double
+exponential_integral(size_t i, double low, double high)
+{
+  const double a = 1. + .01 * i;
+  return (exp(-a * low) - exp(-a * high)) / a;
+}
+
+double
+peak_integral(size_t i, double low, double high)
+{
+  const double width = 1.e-2 / (1. + i % 4);
+  return (atan((high - .3) / width) - atan((low - .3) / width)) / width;
+}
+
+TEST_CASE("Smooth integrands converge on a single interval")
+{
+  const size_t num_integrals = 1000;
+  std::vector<double> lows(num_integrals), highs(num_integrals);
+  for (size_t i = 0; i < num_integrals; ++i) {
+    lows[i] = -.5 + .001 * i;
+    highs[i] = lows[i] + 1.;
+  }
+
+  gauss_kronrod::Batched_qag<> qag;
+  auto const results =
+    qag.integrate(Exponential_family{}, lows, highs, 1.e-10, 1.e-14);
+  REQUIRE(results.size() == num_integrals);
+
+  for (size_t i = 0; i < num_integrals; ++i) {
+    const double exact = exponential_integral(i, lows[i], highs[i]);
+    CHECK(results[i].status == 0);
+    CHECK(results[i].nregions == 1);
+    CHECK(results[i].neval == 21);
+    CHECK(results[i].estimate == Approx(exact).epsilon(1.e-12));
+  }
+}
+
+TEST_CASE("Peaked integrands are subdivided")
+{
+  const size_t num_integrals = 256;
+  const double epsrel = 1.e-9;
+  std::vector<double> lows(num_integrals, 0.), highs(num_integrals, 1.);
+
+  gauss_kronrod::Batched_qag<gauss_kronrod::Rule::gk21> qag21(128);
+  gauss_kronrod::Batched_qag<gauss_kronrod::Rule::gk15> qag15(256);
+  auto const results21 =
+    qag21.integrate(Peak_family{}, lows, highs, epsrel, 1.e-20);
+  auto const results15 =
+    qag15.integrate(Peak_family{}, lows, highs, epsrel, 1.e-20);
+
+  for (size_t i = 0; i < num_integrals; ++i) {
+    const double exact = peak_integral(i, 0., 1.);
+    CHECK(results21[i].status == 0);
+    CHECK(results21[i].nregions > 1);
+    CHECK(results21[i].nregions == results21[i].iters + 1);
+    CHECK(results21[i].errorest <= epsrel * exact);
+    CHECK(results21[i].estimate == Approx(exact).epsilon(epsrel));
+
+    CHECK(results15[i].status == 0);
+    CHECK(results15[i].estimate ==
+          Approx(results21[i].estimate).epsilon(epsrel));
+  }
+}
+
+TEST_CASE("Exhausting the interval limit is reported")
+{
+  std::vector<double> lows(16, 0.), highs(16, 1.);
+  gauss_kronrod::Batched_qag<> qag(2);
+  auto const results = qag.integrate(Peak_family{}, lows, highs, 1.e-12, 0.);
+
+  for (auto const& result : results) {
+    CHECK(result.status == 1);
+    CHECK(result.nregions == 2);
+    CHECK(result.neval == 3 * 21);
+  }
+}
+
+TEST_CASE("Device views of bounds and results")
+{
+  const size_t num_integrals = 100;
+  using Bounds = gauss_kronrod::Batched_qag<>::Bounds;
+  using memory_space = gauss_kronrod::Batched_qag<>::memory_space;
+  Kokkos::View<double*, memory_space> lows("lows", num_integrals);
+  Kokkos::View<double*, memory_space> highs("highs", num_integrals);
+  Kokkos::deep_copy(lows, 0.);
+  Kokkos::deep_copy(highs, 2.);
+  gauss_kronrod::Batched_qag<>::Results results("results", num_integrals);
+
+  gauss_kronrod::Batched_qag<> qag;
+  qag.integrate(
+    Exponential_family{}, Bounds(lows), Bounds(highs), 1.e-10, 0., results);
+  Kokkos::fence();
+
+  auto host_results =
+    Kokkos::create_mirror_view_and_copy(Kokkos::HostSpace(), results);
+  for (size_t i = 0; i < num_integrals; ++i)
+    CHECK(host_results(i).estimate ==
+          Approx(exponential_integral(i, 0., 2.)).epsilon(1.e-10));
+
+  Kokkos::View<double*, memory_space> too_short("too_short", 1);
+  CHECK_THROWS_AS(qag.integrate(Exponential_family{},
+                                Bounds(lows),
+                                Bounds(too_short),
+                                1.e-10,
+                                0.,
+                                results),
+                  std::invalid_argument);
+}
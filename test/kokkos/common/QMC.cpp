@@ -0,0 +1,119 @@
+#include "catch2/catch.hpp"
+#include "common/kokkos/Volume.cuh"
+#include "common/qmc.hh"
+#include "kokkos/qmc/qmc.h"
+#include <cmath>
+#include <set>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+  class Exp_product_3D {
+  public:
+    KOKKOS_INLINE_FUNCTION double
+    operator()(double x, double y, double z)
+    {
+      return exp(x) * y * y * z;
+    }
+
+    static double
+    true_value()
+    {
+      return (std::exp(1.) - 1.) / 6.;
+    }
+  };
+
+  // the 2^m cells point i of the first 2^m falls in along each of the
+  // first two dimensions, with cells_0 * cells_1 = 2^m
+  std::set<std::pair<int, int>>
+  occupied_cells(numint::qmc_rule rule, int m, int log2_cells_0)
+  {
+    numint::qmc_options options;
+    options.rule = rule;
+    const double lows[2] = {0., 0.};
+    const double highs[2] = {1., 1.};
+    const auto sequence = numint::make_qmc_sequence<2>(options, lows, highs);
+    std::set<std::pair<int, int>> cells;
+    for (uint64_t i = 0; i < (uint64_t{1} << m); ++i) {
+      double x[2];
+      sequence.point(i, 3, x);
+      cells.emplace(static_cast<int>(x[0] * (1 << log2_cells_0)),
+                    static_cast<int>(x[1] * (1 << (m - log2_cells_0))));
+    }
+    return cells;
+  }
+}
+
+TEST_CASE("Shifted point sets keep their structure")
+{
+  SECTION("Sobol points are (0, m, 2)-nets")
+  {
+    for (int log2_cells_0 = 0; log2_cells_0 <= 8; ++log2_cells_0)
+      CHECK(occupied_cells(numint::qmc_rule::sobol, 8, log2_cells_0).size() ==
+            256);
+  }
+
+  SECTION("Lattice projections are equispaced")
+  {
+    CHECK(occupied_cells(numint::qmc_rule::lattice, 8, 8).size() == 256);
+    CHECK(occupied_cells(numint::qmc_rule::lattice, 8, 0).size() == 256);
+  }
+}
+
+TEST_CASE("Smooth integrands converge")
+{
+  quad::Volume<double, 3> vol;
+  for (auto rule : {numint::qmc_rule::lattice, numint::qmc_rule::sobol}) {
+    for (auto periodization : {numint::qmc_periodization::none,
+                               numint::qmc_periodization::baker,
+                               numint::qmc_periodization::polynomial}) {
+      numint::qmc_options options;
+      options.rule = rule;
+      options.periodization = periodization;
+      const auto res = numint::qmc_integrate<3>(
+        Exp_product_3D(), 1.e-6, 1.e-12, vol, options);
+      CHECK(res.status == 0);
+      CHECK(res.neval % options.randomizations == 0);
+      CHECK(std::abs(res.estimate - Exp_product_3D::true_value()) <
+            5. * res.errorest + 1.e-12);
+    }
+  }
+}
+
+TEST_CASE("Results do not depend on the backend or the threads")
+{
+  quad::Volume<double, 3> vol;
+  numint::qmc_options options;
+  options.periodization = numint::qmc_periodization::baker;
+  options.max_log2_points = 14;
+
+  const auto one_thread = numint::qmc_integrate<3>(
+    Exp_product_3D(), 1.e-12, 0., vol, options, 1);
+  const auto threads = numint::qmc_integrate<3>(
+    Exp_product_3D(), 1.e-12, 0., vol, options, 8);
+  const auto kokkos = kokkos_qmc::integrate<Exp_product_3D, 3>(
+    Exp_product_3D(), 1.e-12, 0., vol, options);
+
+  CHECK(one_thread.estimate == threads.estimate);
+  CHECK(one_thread.errorest == threads.errorest);
+  CHECK(kokkos.neval == one_thread.neval);
+  CHECK(kokkos.estimate == Approx(one_thread.estimate).epsilon(1.e-12));
+  CHECK(kokkos.errorest == Approx(one_thread.errorest).epsilon(1.e-6));
+}
+
+TEST_CASE("Unusable options are rejected")
+{
+  quad::Volume<double, 3> vol;
+  numint::qmc_options options;
+  options.randomizations = 1;
+  CHECK_THROWS_AS(
+    numint::qmc_integrate<3>(Exp_product_3D(), 1.e-3, 0., vol, options),
+    std::invalid_argument);
+
+  options = numint::qmc_options();
+  options.rule = numint::qmc_rule::sobol;
+  const double lows[17] = {};
+  const double highs[17] = {};
+  CHECK_THROWS_AS(numint::make_qmc_sequence<17>(options, lows, highs),
+                  std::invalid_argument);
+}
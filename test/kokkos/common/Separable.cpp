@@ -0,0 +1,225 @@
+#include "catch2/catch.hpp"
+#include "common/kokkos/Volume.cuh"
+#include "common/separable.hh"
+#include "kokkos/separable/separable.h"
+#include <cmath>
+#include <vector>
+
+namespace {
+  class Exponential {
+  public:
+    KOKKOS_INLINE_FUNCTION double
+    operator()(double x)
+    {
+      return exp(-rate * x);
+    }
+
+    double rate;
+  };
+
+  // exp(-x_0) exp(-2 x_1) ... exp(-6 x_5)
+  class Exp_product_6D {
+  public:
+    KOKKOS_INLINE_FUNCTION double
+    operator()(double x, double y, double z, double k, double m, double n)
+    {
+      return exp(-(x + 2. * y + 3. * z + 4. * k + 5. * m + 6. * n));
+    }
+
+    static double
+    true_value()
+    {
+      double value = 1.;
+      for (int a = 1; a <= 6; ++a)
+        value *= (1. - std::exp(-a)) / a;
+      return value;
+    }
+  };
+
+  class Cos_sum_2D {
+  public:
+    KOKKOS_INLINE_FUNCTION double
+    operator()(double y, double z)
+    {
+      return cos(y + z);
+    }
+  };
+
+  // a 1D, a 2D and a 1D factor
+  class Mixed_product_4D {
+  public:
+    KOKKOS_INLINE_FUNCTION double
+    operator()(double x, double y, double z, double w)
+    {
+      return exp(-x) * cos(y + z) * exp(-3. * w);
+    }
+
+    static double
+    true_value()
+    {
+      return (1. - std::exp(-1.)) * (2. * std::cos(1.) - std::cos(2.) - 1.) *
+             (1. - std::exp(-3.)) / 3.;
+    }
+  };
+
+  // the same groups as a sum
+  class Mixed_sum_4D {
+  public:
+    KOKKOS_INLINE_FUNCTION double
+    operator()(double x, double y, double z, double w)
+    {
+      return exp(-x) + cos(y + z) + exp(-3. * w);
+    }
+
+    static double
+    true_value()
+    {
+      return (1. - std::exp(-1.)) + (2. * std::cos(1.) - std::cos(2.) - 1.) +
+             (1. - std::exp(-3.)) / 3.;
+    }
+  };
+}
+
+template <>
+struct numint::separable_traits<Exp_product_6D> {
+  static constexpr bool value = true;
+  static constexpr separable_kind kind = separable_kind::product;
+  using groups = uniform_separable_groups<1, 6>;
+
+  template <int g>
+  KOKKOS_INLINE_FUNCTION static Exponential
+  factor(Exp_product_6D const&)
+  {
+    return Exponential{g + 1.};
+  }
+};
+
+template <typename IntegT>
+struct Mixed_traits {
+  static constexpr bool value = true;
+  using groups = std::integer_sequence<int, 1, 2, 1>;
+
+  template <int g>
+  KOKKOS_INLINE_FUNCTION static auto
+  factor(IntegT const&)
+  {
+    if constexpr (g == 1)
+      return Cos_sum_2D();
+    else
+      return Exponential{g == 0 ? 1. : 3.};
+  }
+};
+
+template <>
+struct numint::separable_traits<Mixed_product_4D>
+  : Mixed_traits<Mixed_product_4D> {
+  static constexpr separable_kind kind = separable_kind::product;
+};
+
+template <>
+struct numint::separable_traits<Mixed_sum_4D> : Mixed_traits<Mixed_sum_4D> {
+  static constexpr separable_kind kind = separable_kind::sum;
+};
+
+TEST_CASE("Factor errors combine into the error of the whole")
+{
+  std::vector<numint::integration_result> factors(3);
+  const double estimates[3] = {2., -.5, 4.};
+  const double errors[3] = {.02, .001, .01};
+  for (int g = 0; g < 3; ++g) {
+    factors[g].estimate = estimates[g];
+    factors[g].errorest = errors[g];
+    factors[g].status = 0;
+    factors[g].neval = 10;
+  }
+  const std::vector<double> volumes = {1., 2., .5};
+
+  SECTION("Products")
+  {
+    auto const bound = numint::combine_separable(
+      numint::separable_kind::product,
+      numint::separable_errors::bound,
+      factors,
+      volumes);
+    CHECK(bound.estimate == -4.);
+    CHECK(bound.errorest == Approx(2.02 * .501 * 4.01 - 4.));
+    CHECK(bound.neval == 30);
+    CHECK(bound.status == 0);
+
+    auto const statistical = numint::combine_separable(
+      numint::separable_kind::product,
+      numint::separable_errors::statistical,
+      factors,
+      volumes);
+    CHECK(statistical.errorest ==
+          Approx(std::hypot(.02 * 2., std::hypot(.001 * 8., .01 * 1.))));
+  }
+
+  SECTION("Sums weigh each term by the volume of the others")
+  {
+    auto const bound =
+      numint::combine_separable(numint::separable_kind::sum,
+                                numint::separable_errors::bound,
+                                factors,
+                                volumes);
+    CHECK(bound.estimate == Approx(2. * 1. - .5 * .5 + 4. * 2.));
+    CHECK(bound.errorest == Approx(.02 * 1. + .001 * .5 + .01 * 2.));
+  }
+
+  SECTION("A failed factor fails the whole")
+  {
+    factors[1].status = 1;
+    CHECK(numint::combine_separable(numint::separable_kind::sum,
+                                    numint::separable_errors::bound,
+                                    factors,
+                                    volumes)
+            .status == 1);
+  }
+}
+
+TEST_CASE("Separable integrands converge factor by factor")
+{
+  SECTION("Fully separable product")
+  {
+    quad::Volume<double, 6> vol;
+    auto const res = kokkos_separable::integrate<Exp_product_6D, 6>(
+      Exp_product_6D(), 1.e-10, 1.e-20, vol);
+    CHECK(res.status == 0);
+    CHECK(res.errorest <= 1.e-10 * std::abs(res.estimate));
+    CHECK(res.estimate == Approx(Exp_product_6D::true_value()).epsilon(1.e-9));
+  }
+
+  SECTION("Groups of one and two dimensions")
+  {
+    const double lows[4] = {0., 0., 0., 0.};
+    const double highs[4] = {1., 1., 1., 1.};
+    quad::Volume<double, 4> vol(lows, highs);
+    auto const product = kokkos_separable::integrate<Mixed_product_4D, 4>(
+      Mixed_product_4D(), 1.e-6, 1.e-20, vol);
+    CHECK(product.status == 0);
+    CHECK(product.estimate ==
+          Approx(Mixed_product_4D::true_value()).epsilon(1.e-6));
+
+    auto const sum = kokkos_separable::integrate<Mixed_sum_4D, 4>(
+      Mixed_sum_4D(), 1.e-6, 1.e-20, vol);
+    CHECK(sum.status == 0);
+    CHECK(sum.estimate == Approx(Mixed_sum_4D::true_value()).epsilon(1.e-6));
+  }
+
+  SECTION("Sums over a box that is not the unit cube")
+  {
+    const double lows[4] = {0., -1., 0., 1.};
+    const double highs[4] = {2., 1., .5, 2.};
+    quad::Volume<double, 4> vol(lows, highs);
+    auto const sum = kokkos_separable::integrate<Mixed_sum_4D, 4>(
+      Mixed_sum_4D(), 1.e-6, 1.e-20, vol);
+    // every term times the volume of the other groups
+    const double exp_term = (1. - std::exp(-2.)) * 1.;
+    const double cos_term =
+      (-std::cos(1.5) + std::cos(-.5) + std::cos(1.) - std::cos(-1.)) * 2.;
+    const double exp3_term = (std::exp(-3.) - std::exp(-6.)) / 3. * 2.;
+    CHECK(sum.status == 0);
+    CHECK(sum.estimate ==
+          Approx(exp_term + cos_term + exp3_term).epsilon(1.e-6));
+  }
+}
@@ -0,0 +1,142 @@
+#include "catch2/catch.hpp"
+#include "common/kokkos/Interp2D.h"
+#include "common/shared_table.hh"
+#include <array>
+#include <thread>
+#include <vector>
+
+namespace {
+  // host memory that counts what it hands out
+  struct counted_memory {
+    static int allocations;
+    static int releases;
+
+    template <typename T>
+    static T*
+    allocate(const T* values, size_t n)
+    {
+      ++allocations;
+      return numint::host_table_memory::allocate(values, n);
+    }
+
+    template <typename T>
+    static void
+    release(T* data)
+    {
+      ++releases;
+      numint::host_table_memory::release(data);
+    }
+  };
+
+  int counted_memory::allocations = 0;
+  int counted_memory::releases = 0;
+
+  struct Tabulated {
+    numint::shared_table<double> xs;
+    numint::shared_table<double> zs;
+  };
+
+  Tabulated
+  make_tabulated(std::vector<double> const& xs, std::vector<double> const& zs)
+  {
+    return {numint::make_shared_table<counted_memory>(xs.data(), xs.size()),
+            numint::make_shared_table<counted_memory>(zs.data(), zs.size())};
+  }
+}
+
+TEST_CASE("Copies share the values and release them once")
+{
+  counted_memory::allocations = counted_memory::releases = 0;
+  const std::vector<double> xs = {1., 2., 3.};
+  const std::vector<double> zs = {4., 5., 6.};
+  {
+    const Tabulated original = make_tabulated(xs, zs);
+    CHECK(counted_memory::allocations == 2);
+    CHECK(original.xs.size() == 3);
+    CHECK(original.zs[2] == 6.);
+
+    std::vector<Tabulated> family(100, original);
+    CHECK(counted_memory::allocations == 2);
+    CHECK(original.xs.use_count() == 101);
+    for (Tabulated const& member : family) {
+      CHECK(member.xs.data() == original.xs.data());
+      CHECK(member.zs.data() == original.zs.data());
+    }
+
+    family.clear();
+    CHECK(original.zs.use_count() == 1);
+    CHECK(counted_memory::releases == 0);
+  }
+  CHECK(counted_memory::releases == 2);
+}
+
+TEST_CASE("Assignment releases the table it replaces")
+{
+  counted_memory::allocations = counted_memory::releases = 0;
+  const std::vector<double> a = {1., 2.};
+  const std::vector<double> b = {3., 4., 5.};
+  auto first = numint::make_shared_table<counted_memory>(a.data(), a.size());
+  auto second = numint::make_shared_table<counted_memory>(b.data(), b.size());
+
+  first = second;
+  CHECK(counted_memory::releases == 1);
+  CHECK(first.data() == second.data());
+  CHECK(second.use_count() == 2);
+
+  second = std::move(first);
+  CHECK(first.data() == nullptr);
+  CHECK(first.use_count() == 0);
+  CHECK(second.use_count() == 1);
+  CHECK(second[1] == 4.);
+}
+
+TEST_CASE("Empty tables allocate nothing")
+{
+  counted_memory::allocations = 0;
+  auto const empty = numint::make_shared_table<counted_memory>(
+    static_cast<const double*>(nullptr), 0);
+  numint::shared_table<double> const copy = empty;
+  CHECK(counted_memory::allocations == 0);
+  CHECK(copy.size() == 0);
+  CHECK(copy.use_count() == 0);
+}
+
+TEST_CASE("Threads copying the same table keep the count")
+{
+  counted_memory::allocations = counted_memory::releases = 0;
+  const std::vector<double> values(1000, 1.);
+  {
+    auto const table =
+      numint::make_shared_table<counted_memory>(values.data(), values.size());
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t)
+      threads.emplace_back([&table] {
+        for (int k = 0; k < 10000; ++k) {
+          numint::shared_table<double> copy = table;
+          numint::shared_table<double> other;
+          other = copy;
+        }
+      });
+    for (std::thread& thread : threads)
+      thread.join();
+    CHECK(table.use_count() == 1);
+    CHECK(counted_memory::releases == 0);
+  }
+  CHECK(counted_memory::releases == 1);
+}
+
+TEST_CASE("Interp2D copies share the views")
+{
+  std::array<double, 3> xs = {1., 2., 3.};
+  std::array<double, 2> ys = {4., 5.};
+  std::array<double, 6> zs = {1., 2., 3., 4., 5., 6.};
+  quad::Interp2D const original(xs, ys, zs);
+  quad::Interp2D const copy = original;
+  CHECK(copy.interpT.data() == original.interpT.data());
+  CHECK(copy.interpC.data() == original.interpC.data());
+  CHECK(original.interpT.use_count() == 2);
+
+  quad::Interp2D const wrapped(
+    original.interpC, original.interpR, original.interpT);
+  CHECK(wrapped.interpT.data() == original.interpT.data());
+}
@@ -0,0 +1,66 @@
+#include "catch2/catch.hpp"
+#include "common/kokkos/stream_compaction.cuh"
+#include "common/kokkos/cudaMemoryUtil.h"
+#include <vector>
+
+// compacts the indices whose value is a multiple of stride, returns them in
+// their new positions
+std::vector<int>
+compact_multiples(quad::Stream_compaction& compaction,
+                  size_t n,
+                  int stride,
+                  size_t& count)
+{
+  ViewVectorInt values = quad::cuda_malloc<int>(n);
+  ViewVectorInt compacted = quad::cuda_malloc<int>(n);
+  Kokkos::parallel_for(
+    "FillValues",
+    Kokkos::RangePolicy<>(0, n),
+    KOKKOS_LAMBDA(const size_t i) { values(i) = static_cast<int>(i); });
+  Kokkos::deep_copy(compacted, -1);
+
+  count = compaction.compact(
+    "CompactMultiples",
+    n,
+    KOKKOS_LAMBDA(const size_t i) { return values(i) % stride == 0; },
+    KOKKOS_LAMBDA(const size_t i, const size_t slot) {
+      compacted(slot) = values(i);
+    });
+
+  auto host = Kokkos::create_mirror_view_and_copy(Kokkos::HostSpace(),
+                                                  compacted);
+  return std::vector<int>(host.data(), host.data() + n);
+}
+
+TEST_CASE("Compaction keeps the order of the flagged indices")
+{
+  quad::Stream_compaction compaction;
+  // one tile, a few tiles and many tiles, reusing the look-back state
+  for (size_t n : {size_t{1}, size_t{1000}, size_t{5000}, size_t{1} << 20}) {
+    for (int stride : {1, 3, 7}) {
+      size_t count = 0;
+      auto const compacted = compact_multiples(compaction, n, stride, count);
+      CHECK(count == (n + stride - 1) / stride);
+      bool ordered = true;
+      for (size_t slot = 0; slot < count; ++slot)
+        ordered = ordered && compacted[slot] == static_cast<int>(slot) * stride;
+      CHECK(ordered);
+      if (count < n)
+        CHECK(compacted[count] == -1);
+    }
+  }
+}
+
+TEST_CASE("Counting only")
+{
+  quad::Stream_compaction compaction;
+  const size_t n = 10000;
+  CHECK(compaction.count_flagged(
+          "CountNone", n, KOKKOS_LAMBDA(const size_t) { return false; }) ==
+        0);
+  CHECK(compaction.count_flagged(
+          "CountAll", n, KOKKOS_LAMBDA(const size_t) { return true; }) == n);
+  CHECK(compaction.count_flagged(
+          "CountEmpty", 0, KOKKOS_LAMBDA(const size_t) { return true; }) ==
+        0);
+}
@@ -0,0 +1,123 @@
+#include "catch2/catch.hpp"
+#include "kokkos/pagani/quad/GPUquad/Workspace.cuh"
+#include "common/integration_scheduler.hh"
+#include "common/kokkos/integrands.cuh"
+#include "common/integration_result.hh"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Scheduler caps the number of jobs in flight")
+{
+  constexpr size_t max_in_flight = 3;
+  constexpr int num_jobs = 24;
+  std::atomic<int> running{0};
+  std::atomic<int> peak{0};
+  std::atomic<int> callbacks{0};
+  std::atomic<bool> bad_slot{false};
+  std::vector<std::future<int>> results;
+
+  {
+    numint::integration_scheduler scheduler(max_in_flight);
+    CHECK(scheduler.max_in_flight() == max_in_flight);
+    for (int job = 0; job < num_jobs; ++job)
+      results.push_back(scheduler.submit(
+        [&, job](size_t slot) {
+          // Catch assertions are not thread safe, record and check later
+          if (slot >= max_in_flight)
+            bad_slot = true;
+          const int now = ++running;
+          int seen = peak.load();
+          while (now > seen && !peak.compare_exchange_weak(seen, now))
+            ;
+          std::this_thread::sleep_for(std::chrono::milliseconds(2));
+          --running;
+          return job * job;
+        },
+        [&](int) { ++callbacks; }));
+    scheduler.wait();
+    CHECK(callbacks == num_jobs);
+  }
+
+  CHECK_FALSE(bad_slot);
+  CHECK(peak <= static_cast<int>(max_in_flight));
+  CHECK(peak > 1);
+  for (int job = 0; job < num_jobs; ++job)
+    CHECK(results[job].get() == job * job);
+}
+
+TEST_CASE("Exceptions thrown by a job reach its future")
+{
+  numint::integration_scheduler scheduler(2);
+  auto failing = scheduler.submit([](size_t) -> int {
+    throw std::runtime_error("failed integration");
+  });
+  auto fine = scheduler.submit([](size_t) { return 1; });
+  CHECK_THROWS_AS(failing.get(), std::runtime_error);
+  CHECK(fine.get() == 1);
+}
+
+TEST_CASE("Asynchronous integrations match the blocking ones")
+{
+  constexpr int ndim = 5;
+  constexpr bool use_custom = true;
+  constexpr double epsrel = 1.e-4;
+  constexpr double epsabs = 1.e-20;
+  using Pagani = Workspace<double, ndim, use_custom>;
+  quad::Volume<double, ndim> vol;
+  F_4_5D gaussian;
+  SinSum_5D sinsum;
+
+  Pagani reference;
+  auto const expected_gaussian =
+    reference.integrate(gaussian, epsrel, epsabs, vol);
+  auto const expected_sinsum = reference.integrate(sinsum, epsrel, epsabs, vol);
+
+  SECTION("Workspace::integrate_async")
+  {
+    Pagani workspace;
+    auto run = workspace.integrate_async(gaussian, epsrel, epsabs, vol);
+    auto const res = run.get();
+    CHECK(res.status == expected_gaussian.status);
+    CHECK(res.nregions == expected_gaussian.nregions);
+    CHECK(res.estimate == Approx(expected_gaussian.estimate));
+  }
+
+  SECTION("Scheduled on one workspace per slot")
+  {
+    constexpr size_t max_in_flight = 2;
+    constexpr int num_jobs = 6;
+    auto instances = Kokkos::Experimental::partition_space(
+      Kokkos::DefaultExecutionSpace(), 1, 1);
+    std::vector<std::unique_ptr<Pagani>> workspaces;
+    for (auto const& instance : instances)
+      workspaces.push_back(std::make_unique<Pagani>(instance));
+
+    std::atomic<int> completed{0};
+    std::vector<std::future<numint::integration_result>> results;
+    numint::integration_scheduler scheduler(max_in_flight);
+    for (int job = 0; job < num_jobs; ++job)
+      results.push_back(scheduler.submit(
+        [&, job](size_t slot) {
+          if (job % 2 == 0)
+            return workspaces[slot]->integrate(gaussian, epsrel, epsabs, vol);
+          return workspaces[slot]->integrate(sinsum, epsrel, epsabs, vol);
+        },
+        [&](numint::integration_result const&) { ++completed; }));
+
+    for (int job = 0; job < num_jobs; ++job) {
+      auto const res = results[job].get();
+      auto const& expected = job % 2 == 0 ? expected_gaussian : expected_sinsum;
+      CHECK(res.status == expected.status);
+      CHECK(res.nregions == expected.nregions);
+      CHECK(res.estimate == Approx(expected.estimate));
+    }
+    scheduler.wait();
+    CHECK(completed == num_jobs);
+  }
+}
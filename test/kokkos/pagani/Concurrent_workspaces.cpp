@@ -0,0 +1,132 @@
+#include "catch2/catch.hpp"
+#include "kokkos/pagani/quad/GPUquad/Workspace.cuh"
+#include "common/kokkos/integrands.cuh"
+#include "common/integration_result.hh"
+#include <chrono>
+#include <future>
+
+// linear, so the first iteration converges, but every evaluation spins long
+// enough for the cubature kernel to dominate a run
+class Busy_5D {
+public:
+  KOKKOS_INLINE_FUNCTION double
+  operator()(double x, double y, double z, double w, double v)
+  {
+    double spin = 0.;
+    for (int i = 0; i < spins; ++i)
+      spin += cos(spin + x * i);
+    return x + y + z + w + v + 1.e-300 * spin;
+  }
+
+  int spins = 1 << 18;
+};
+
+template <typename F>
+double
+seconds(F run)
+{
+  auto const t0 = std::chrono::steady_clock::now();
+  run();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+    .count();
+}
+
+TEST_CASE("Memory budget replaces the device size")
+{
+  constexpr size_t ndim = 5;
+  const size_t num_regions = 1000;
+  const size_t budget = size_t{1} << 24;
+  CHECK(free_device_mem(num_regions, ndim, budget) ==
+        budget - device_mem_required_for_full_split(num_regions, ndim));
+  CHECK(free_device_mem(num_regions, ndim, 1) == 1);
+  CHECK(free_device_mem(num_regions, ndim) ==
+        free_device_mem(num_regions, ndim, total_device_mem()));
+}
+
+TEST_CASE("Workspaces on separate instances give the sequential results")
+{
+  constexpr int ndim = 5;
+  constexpr bool use_custom = true;
+  constexpr double epsrel = 1.e-5;
+  constexpr double epsabs = 1.e-20;
+  quad::Volume<double, ndim> vol;
+  F_4_5D gaussian;
+  SinSum_5D sinsum;
+
+  Workspace<double, ndim, use_custom> reference;
+  auto const expected_gaussian =
+    reference.integrate(gaussian, epsrel, epsabs, vol);
+  auto const expected_sinsum = reference.integrate(sinsum, epsrel, epsabs, vol);
+
+  auto instances = Kokkos::Experimental::partition_space(
+    Kokkos::DefaultExecutionSpace(), 1, 1);
+  Workspace<double, ndim, use_custom> first(instances[0]);
+  Workspace<double, ndim, use_custom> second(instances[1]);
+
+  auto gaussian_run = std::async(std::launch::async, [&]() {
+    return first.integrate(gaussian, epsrel, epsabs, vol);
+  });
+  auto sinsum_run = std::async(std::launch::async, [&]() {
+    return second.integrate(sinsum, epsrel, epsabs, vol);
+  });
+  auto const res_gaussian = gaussian_run.get();
+  auto const res_sinsum = sinsum_run.get();
+
+  CHECK(res_gaussian.status == expected_gaussian.status);
+  CHECK(res_gaussian.nregions == expected_gaussian.nregions);
+  CHECK(res_gaussian.estimate == Approx(expected_gaussian.estimate));
+  CHECK(res_sinsum.status == expected_sinsum.status);
+  CHECK(res_sinsum.nregions == expected_sinsum.nregions);
+  CHECK(res_sinsum.estimate == Approx(expected_sinsum.estimate));
+}
+
+TEST_CASE("Workspaces on separate instances overlap on the device")
+{
+  constexpr int ndim = 5;
+  constexpr double epsrel = 1.e-3;
+  constexpr double epsabs = 1.e-20;
+  quad::Volume<double, ndim> vol;
+  Busy_5D integrand;
+
+  // 32 initial regions, one team each, leave most of the device idle
+  auto instances = Kokkos::Experimental::partition_space(
+    Kokkos::DefaultExecutionSpace(), 1, 1);
+  Workspace<double, ndim> first(instances[0]);
+  Workspace<double, ndim> second(instances[1]);
+  first.integrate(integrand, epsrel, epsabs, vol);
+
+  const double sequential = seconds([&]() {
+    first.integrate(integrand, epsrel, epsabs, vol);
+    second.integrate(integrand, epsrel, epsabs, vol);
+  });
+  const double concurrent = seconds([&]() {
+    auto first_run = std::async(std::launch::async, [&]() {
+      return first.integrate(integrand, epsrel, epsabs, vol);
+    });
+    auto second_run = std::async(std::launch::async, [&]() {
+      return second.integrate(integrand, epsrel, epsabs, vol);
+    });
+    CHECK(first_run.get().status == 0);
+    CHECK(second_run.get().status == 0);
+  });
+
+  // perfect overlap halves the time
+  CHECK(concurrent < .8 * sequential);
+}
+
+TEST_CASE("A small memory budget stops the refinement early")
+{
+  constexpr int ndim = 5;
+  constexpr bool use_custom = true;
+  quad::Volume<double, ndim> vol;
+  F_4_5D integrand;
+
+  Workspace<double, ndim, use_custom> unlimited;
+  auto const full = unlimited.integrate(integrand, 1.e-7, 1.e-20, vol);
+
+  Workspace<double, ndim, use_custom> limited(Kokkos::DefaultExecutionSpace(),
+                                              size_t{64} << 20);
+  auto const res = limited.integrate(integrand, 1.e-7, 1.e-20, vol);
+  CHECK(res.nregions <= full.nregions);
+  CHECK(res.estimate == Approx(full.estimate).epsilon(1.e-3));
+}
@@ -0,0 +1,128 @@
+#include "catch2/catch.hpp"
+#include "kokkos/pagani/quad/GPUquad/Workspace.cuh"
+#include "common/kokkos/integrands.cuh"
+#include "common/integration_result.hh"
+#include <cmath>
+
+struct Gauss10D {
+
+  KOKKOS_INLINE_FUNCTION double
+  operator()(double a,
+             double b,
+             double c,
+             double d,
+             double e,
+             double f,
+             double g,
+             double h,
+             double i,
+             double j)
+  {
+    const double sum = (a - .5) * (a - .5) + (b - .5) * (b - .5) +
+                       (c - .5) * (c - .5) + (d - .5) * (d - .5) +
+                       (e - .5) * (e - .5) + (f - .5) * (f - .5) +
+                       (g - .5) * (g - .5) + (h - .5) * (h - .5) +
+                       (i - .5) * (i - .5) + (j - .5) * (j - .5);
+    return exp(-sum);
+  }
+};
+
+TEST_CASE("Degree 7 rule uses fewer points per region")
+{
+  using pagani::Cubature_rule;
+  CHECK(pagani::CuhreFuncEvalsPerRegion<10, Cubature_rule::degree7>() == 1181);
+  CHECK(pagani::CuhreFuncEvalsPerRegion<20, Cubature_rule::degree7>() == 9961);
+  CHECK(pagani::CuhreFuncEvalsPerRegion<12, Cubature_rule::degree7>() * 3 <
+        pagani::CuhreFuncEvalsPerRegion<12>());
+}
+
+// every generator maps into the region and every weight is finite
+template <size_t ndim>
+void
+check_rule_tables()
+{
+  using pagani::Cubature_rule;
+  constexpr size_t feval =
+    pagani::CuhreFuncEvalsPerRegion<ndim, Cubature_rule::degree7>();
+  Cubature_rules<double, ndim, true, Cubature_rule::degree7> rules;
+
+  auto generators = Kokkos::create_mirror_view(rules.generators);
+  Kokkos::deep_copy(generators, rules.generators);
+  REQUIRE(generators.extent(0) >= ndim * feval);
+  for (size_t i = 0; i < ndim * feval; ++i) {
+    CHECK(std::isfinite(generators(i)));
+    CHECK(std::abs(generators(i)) <= .5);
+  }
+
+  auto weights = Kokkos::create_mirror_view(rules.constMem.cRuleWt);
+  Kokkos::deep_copy(weights, rules.constMem.cRuleWt);
+  for (size_t i = 0; i < weights.extent(0); ++i)
+    CHECK(std::isfinite(weights(i)));
+}
+
+TEST_CASE("Degree 7 rule tables are valid in every dimension")
+{
+  using pagani::Cubature_rule;
+  // below 5 dimensions the degree 9 rule stands in
+  CHECK(pagani::CuhreFuncEvalsPerRegion<3, Cubature_rule::degree7>() ==
+        pagani::CuhreFuncEvalsPerRegion<3>());
+  CHECK(!pagani::uses_degree7<4, Cubature_rule::degree7>());
+  CHECK(pagani::uses_degree7<5, Cubature_rule::degree7>());
+
+  check_rule_tables<2>();
+  check_rule_tables<3>();
+  check_rule_tables<4>();
+  check_rule_tables<5>();
+  check_rule_tables<8>();
+}
+
+TEST_CASE("Degree 7 workspaces integrate in low dimensions")
+{
+  constexpr bool use_custom = true;
+  using pagani::Cubature_rule;
+  {
+    quad::Volume<double, 3> vol;
+    SinSum_3D integrand;
+    Workspace<double, 3, use_custom, false, Cubature_rule::degree7> workspace;
+    auto const res = workspace.integrate(integrand, 1.e-6, 1.e-40, vol);
+    CHECK(res.status == 0);
+    CHECK(res.estimate == Approx(0.8793549306454007).epsilon(1.e-6));
+  }
+  {
+    quad::Volume<double, 4> vol;
+    Addition_4D integrand;
+    Workspace<double, 4, use_custom, false, Cubature_rule::degree7> workspace;
+    auto const res = workspace.integrate(integrand, 1.e-6, 1.e-40, vol);
+    CHECK(res.status == 0);
+    CHECK(res.estimate == Approx(2.).epsilon(1.e-12));
+  }
+}
+
+TEST_CASE("Degree 7 rule integrates a linear integrand exactly")
+{
+  constexpr int ndim = 8;
+  constexpr bool use_custom = true;
+  quad::Volume<double, ndim> vol;
+  Addition_8D integrand;
+  Workspace<double, ndim, use_custom, false, pagani::Cubature_rule::degree7>
+    workspace;
+  auto const res = workspace.integrate(integrand, 1.e-6, 1.e-40, vol);
+  CHECK(res.status == 0);
+  CHECK(res.estimate == Approx(4.).epsilon(1.e-12));
+}
+
+TEST_CASE("Degree 7 rule converges on a 10D gaussian")
+{
+  constexpr int ndim = 10;
+  constexpr bool use_custom = true;
+  double constexpr epsrel = 1.e-5;
+  double const true_value = 0.4466380126635374;
+  quad::Volume<double, ndim> vol;
+  Gauss10D integrand;
+  Workspace<double, ndim, use_custom, false, pagani::Cubature_rule::degree7>
+    workspace;
+  auto const res = workspace.integrate(integrand, epsrel, 1.e-40, vol);
+  CHECK(res.status == 0);
+  CHECK(fabs(res.estimate - true_value) <= res.errorest);
+  CHECK(fabs(res.estimate - true_value) / true_value <= epsrel);
+}
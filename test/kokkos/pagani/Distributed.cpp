@@ -0,0 +1,155 @@
+#define CATCH_CONFIG_RUNNER
+#include "catch2/catch.hpp"
+
+#include <cmath>
+#include <vector>
+
+#include "kokkos/pagani/quad/GPUquad/Distributed_workspace.cuh"
+#include "kokkos/pagani/quad/GPUquad/Workspace.cuh"
+#include "common/integration_result.hh"
+#include "common/kokkos/Volume.cuh"
+#include "common/mpi_utils.hh"
+
+class GENZ_4_5D {
+public:
+  KOKKOS_INLINE_FUNCTION double
+  operator()(double x, double y, double z, double w, double v)
+  {
+    double beta = .5;
+    return exp(-1.0 *
+               (pow(25, 2) * pow(x - beta, 2) + pow(25, 2) * pow(y - beta, 2) +
+                pow(25, 2) * pow(z - beta, 2) + pow(25, 2) * pow(w - beta, 2) +
+                pow(25, 2) * pow(v - beta, 2)));
+  }
+};
+
+TEST_CASE("Reducer combines the values of all ranks")
+{
+  quad::Mpi_reducer reducer;
+  const int num_ranks = reducer.num_ranks;
+  CHECK(reducer.sum(1) == num_ranks);
+  CHECK(reducer.min(reducer.rank) == 0);
+  CHECK(reducer.max(reducer.rank) == num_ranks - 1);
+  CHECK(reducer.any(reducer.rank == 0));
+
+  std::vector<int> ranks = reducer.allgather(reducer.rank);
+  for (int r = 0; r < num_ranks; ++r)
+    CHECK(ranks[r] == r);
+}
+
+TEST_CASE("A rank without regions does not skew the classification")
+{
+  constexpr int ndim = 5;
+  constexpr bool use_custom = true;
+  quad::Mpi_reducer reducer;
+  if (reducer.num_ranks < 2)
+    return;
+
+  // rank 0 is empty, the others hold the same error estimates
+  const size_t per_rank = 1000;
+  std::vector<double> local(per_rank);
+  for (size_t i = 0; i < per_rank; ++i)
+    local[i] = 1.e-6 * static_cast<double>((i * 37) % per_rank + 1);
+  const size_t num_regions = reducer.rank == 0 ? 0 : per_rank;
+
+  std::vector<double> all;
+  for (int r = 1; r < reducer.num_ranks; ++r)
+    all.insert(all.end(), local.begin(), local.end());
+  double all_errorest = 0.;
+  for (double e : all)
+    all_errorest += e;
+
+  auto to_device = [](std::vector<double> const& values) {
+    ViewVectorDouble d_values = quad::cuda_malloc<double>(values.size());
+    auto h_values = Kokkos::create_mirror_view(d_values);
+    for (size_t i = 0; i < values.size(); ++i)
+      h_values(i) = values[i];
+    Kokkos::deep_copy(d_values, h_values);
+    return d_values;
+  };
+
+  const double epsrel = 1.e-3;
+  Heuristic_classifier<double, ndim, use_custom, quad::Mpi_reducer>
+    distributed(epsrel, 1.e-20, reducer);
+  distributed.store_estimate(1.);
+  ViewVectorDouble errorests =
+    to_device(reducer.rank == 0 ? std::vector<double>{} : local);
+  ViewVectorInt flags = quad::cuda_malloc<int>(num_regions);
+  Classification_res<double> res = distributed.classify(
+    flags, errorests, num_regions, all_errorest, 0., 0.);
+
+  Heuristic_classifier<double, ndim, use_custom> single(epsrel, 1.e-20);
+  single.store_estimate(1.);
+  ViewVectorDouble all_errorests = to_device(all);
+  ViewVectorInt all_flags = quad::cuda_malloc<int>(all.size());
+  Classification_res<double> single_res = single.classify(
+    all_flags, all_errorests, all.size(), all_errorest, 0., 0.);
+
+  CHECK(std::isfinite(res.threshold));
+  CHECK(res.threshold == Approx(single_res.threshold));
+  CHECK(res.num_active == single_res.num_active);
+  CHECK(res.finished_errorest == Approx(single_res.finished_errorest));
+  CHECK(reducer.min(res.threshold) == reducer.max(res.threshold));
+}
+
+TEST_CASE("All ranks return the same converged result")
+{
+  constexpr int ndim = 5;
+  constexpr bool use_custom = true;
+  double constexpr epsrel = 1.e-5;
+  double constexpr epsabs = 1.e-20;
+  double const true_value = 1.79132603674879e-06;
+  GENZ_4_5D integrand;
+  quad::Volume<double, ndim> vol;
+  quad::Mpi_reducer reducer;
+
+  Distributed_workspace<double, ndim, use_custom> distributed;
+  numint::integration_result res =
+    distributed.integrate(integrand, epsrel, epsabs, vol);
+
+  CHECK(res.status == 0);
+  CHECK(std::abs(res.estimate - true_value) <= epsrel * true_value);
+  CHECK(reducer.min(res.estimate) == reducer.max(res.estimate));
+  CHECK(reducer.min(res.nregions) == reducer.max(res.nregions));
+
+  Workspace<double, ndim, use_custom> single;
+  numint::integration_result single_res =
+    single.integrate(integrand, epsrel, epsabs, vol);
+  CHECK(res.estimate == Approx(single_res.estimate).epsilon(epsrel));
+}
+
+TEST_CASE("The local phase finishes a distributed run on every rank")
+{
+  constexpr int ndim = 5;
+  constexpr bool use_custom = true;
+  double constexpr epsrel = 1.e-5;
+  double constexpr epsabs = 1.e-20;
+  double const true_value = 1.79132603674879e-06;
+  GENZ_4_5D integrand;
+  quad::Volume<double, ndim> vol;
+  quad::Mpi_reducer reducer;
+
+  Distributed_workspace<double, ndim, use_custom> distributed;
+  distributed.set_local_refinement_threshold(4096);
+  numint::integration_result res =
+    distributed.integrate(integrand, epsrel, epsabs, vol);
+
+  CHECK(res.status == 0);
+  CHECK(std::abs(res.estimate - true_value) <= epsrel * true_value);
+  CHECK(reducer.min(res.estimate) == reducer.max(res.estimate));
+  CHECK(reducer.min(res.iters) == reducer.max(res.iters));
+}
+
+int
+main(int argc, char* argv[])
+{
+  int result = 0;
+  MPI_Init(&argc, &argv);
+  Kokkos::initialize();
+  {
+    result = Catch::Session().run(argc, argv);
+  }
+  Kokkos::finalize();
+  MPI_Finalize();
+  return result;
+}
@@ -0,0 +1,59 @@
+#include "catch2/catch.hpp"
+#include "kokkos/pagani/quad/GPUquad/Workspace.cuh"
+#include "kokkos/pagani/quad/GPUquad/Launch_policy.cuh"
+#include "common/kokkos/integrands.cuh"
+#include "common/integration_result.hh"
+#include <cstdio>
+
+TEST_CASE("Launch policies are stored per backend and ndim")
+{
+  const std::string filename = "pagani_launch_policy_test.cfg";
+  std::remove(filename.c_str());
+
+  pagani::Launch_policy policy;
+  CHECK(policy.load(filename, 5) == false);
+  CHECK(policy.cubature == 64);
+
+  pagani::Launch_policy tuned;
+  tuned.cubature = 128;
+  tuned.filter = 256;
+  tuned.save(filename, 5);
+  tuned.cubature = 32;
+  tuned.save(filename, 5, "OpenMP");
+
+  REQUIRE(policy.load(filename, 5));
+  CHECK(policy.cubature == 128);
+  CHECK(policy.filter == 256);
+  CHECK(policy.split == 64);
+
+  REQUIRE(policy.load(filename, 5, "OpenMP"));
+  CHECK(policy.cubature == 32);
+  CHECK(policy.load(filename, 8) == false);
+  std::remove(filename.c_str());
+}
+
+TEST_CASE("Launch policy does not change the result")
+{
+  constexpr int ndim = 5;
+  constexpr bool use_custom = true;
+  quad::Volume<double, ndim> vol;
+  F_4_5D integrand;
+
+  Workspace<double, ndim, use_custom> reference;
+  auto const expected = reference.integrate(integrand, 1.e-5, 1.e-20, vol);
+
+  pagani::Launch_policy policy;
+  policy.cubature = 256;
+  policy.refine_error = 32;
+  policy.filter = 128;
+  policy.split = 16;
+  policy.reset_chunk = 1;
+  Workspace<double, ndim, use_custom> workspace(policy);
+  auto const res = workspace.integrate(integrand, 1.e-5, 1.e-20, vol);
+
+  // the cubature team size changes the summation order of the rules, the
+  // other phases are per region
+  CHECK(res.status == expected.status);
+  CHECK(res.estimate == Approx(expected.estimate).epsilon(1.e-8));
+  CHECK(res.errorest == Approx(expected.errorest).epsilon(1.e-4));
+}
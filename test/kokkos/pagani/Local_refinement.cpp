@@ -0,0 +1,110 @@
+#include "catch2/catch.hpp"
+#include "kokkos/pagani/quad/GPUquad/Workspace.cuh"
+#include "kokkos/pagani/quad/GPUquad/Local_refinement.cuh"
+#include "common/kokkos/integrands.cuh"
+#include "common/integration_result.hh"
+
+struct Fun6 {
+
+  KOKKOS_INLINE_FUNCTION double
+  operator()(double u, double v, double w, double x, double y, double z)
+  {
+    return (12.0 / (7.0 - 6 * log(2.0) * log(2.0) + log(64.0))) *
+           (u * v + (pow(w, y) * x * y) / (1 + u) + z * z);
+  }
+};
+
+TEST_CASE("Local refinement of a linear integrand keeps every region whole")
+{
+  constexpr int ndim = 3;
+  Addition_3D integrand;
+  Addition_3D* d_integrand = quad::make_gpu_integrand<Addition_3D>(integrand);
+  Cubature_rules<double, ndim> rules;
+  Sub_regions<double, ndim> subregions(4);
+
+  numint::integration_result res =
+    quad::team_local_refinement<Addition_3D, double, ndim>(
+      d_integrand,
+      rules.constMem,
+      rules.generators,
+      rules.integ_space_lows,
+      rules.integ_space_highs,
+      subregions,
+      1.e-3);
+  CHECK(res.estimate == Approx(1.5).epsilon(1.e-12));
+  CHECK(res.nregions == subregions.size);
+  Kokkos::kokkos_free(d_integrand);
+}
+
+TEST_CASE("Local refinement meets the per-region budget")
+{
+  constexpr int ndim = 3;
+  SinSum_3D integrand;
+  SinSum_3D* d_integrand = quad::make_gpu_integrand<SinSum_3D>(integrand);
+  Cubature_rules<double, ndim> rules;
+  Sub_regions<double, ndim> subregions(2);
+  const double true_value = 0.8793549306454007;
+  const double budget = 1.e-11;
+
+  numint::integration_result res =
+    quad::team_local_refinement<SinSum_3D, double, ndim>(
+      d_integrand,
+      rules.constMem,
+      rules.generators,
+      rules.integ_space_lows,
+      rules.integ_space_highs,
+      subregions,
+      budget);
+  CHECK(res.nregions > subregions.size);
+  CHECK(res.errorest <= budget * subregions.size);
+  CHECK(res.estimate == Approx(true_value).epsilon(1.e-10));
+  Kokkos::kokkos_free(d_integrand);
+}
+
+TEST_CASE("A team that fills its heap reports it")
+{
+  constexpr int ndim = 3;
+  SinSum_3D integrand;
+  SinSum_3D* d_integrand = quad::make_gpu_integrand<SinSum_3D>(integrand);
+  Cubature_rules<double, ndim> rules;
+  Sub_regions<double, ndim> subregions(2);
+  constexpr int max_capacity = 8;
+
+  numint::integration_result res =
+    quad::team_local_refinement<SinSum_3D, double, ndim>(
+      d_integrand,
+      rules.constMem,
+      rules.generators,
+      rules.integ_space_lows,
+      rules.integ_space_highs,
+      subregions,
+      1.e-30,
+      ExecSpace(),
+      max_capacity);
+  CHECK(res.status == 1);
+  CHECK(res.nregions == max_capacity * subregions.size);
+  Kokkos::kokkos_free(d_integrand);
+}
+
+TEST_CASE("Local phase agrees with the global pipeline")
+{
+  constexpr int ndim = 6;
+  constexpr bool use_custom = true;
+  double constexpr epsrel = 1.e-5;
+  double constexpr epsabs = 1.e-40;
+  quad::Volume<double, ndim> vol;
+  Fun6 integrand;
+
+  // the local phase is opt-in
+  Workspace<double, ndim, use_custom> global;
+  auto const global_res = global.integrate(integrand, epsrel, epsabs, vol);
+
+  Workspace<double, ndim, use_custom> local;
+  local.set_local_refinement_threshold(2048);
+  auto const local_res = local.integrate(integrand, epsrel, epsabs, vol);
+
+  CHECK(global_res.status == 0);
+  CHECK(local_res.status == 0);
+  CHECK(std::abs(local_res.estimate - 1.) <= epsrel);
+  CHECK(std::abs(local_res.estimate - global_res.estimate) <= 2 * epsrel);
+}
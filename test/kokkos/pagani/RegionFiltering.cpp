@@ -150,11 +150,12 @@ TEST_CASE("filter: all regions are active")
     Kokkos::create_mirror_view(classifications.sub_dividing_dim);
   auto host_active_regions =
     Kokkos::create_mirror_view(classifications.active_regions);
-  auto original_LeftCoord = Kokkos::create_mirror_view(coordinates.dLeftCoord);
-  auto original_Length = Kokkos::create_mirror_view(coordinates.dLength);
+  auto original_LeftCoord =
+    Kokkos::create_mirror_view(coordinates.flat_left_coord());
+  auto original_Length = Kokkos::create_mirror_view(coordinates.flat_length());
 
-  Kokkos::deep_copy(original_LeftCoord, coordinates.dLeftCoord);
-  Kokkos::deep_copy(original_Length, coordinates.dLength);
+  Kokkos::deep_copy(original_LeftCoord, coordinates.flat_left_coord());
+  Kokkos::deep_copy(original_Length, coordinates.flat_length());
 
   // set region variabels to fit test scenario
   for (size_t i = 0; i < n; ++i) {
@@ -188,11 +189,11 @@ TEST_CASE("filter: all regions are active")
 
   auto new_subdiv_dim =
     Kokkos::create_mirror_view(classifications.sub_dividing_dim);
-  auto LeftCoord = Kokkos::create_mirror_view(coordinates.dLeftCoord);
-  auto Length = Kokkos::create_mirror_view(coordinates.dLength);
+  auto LeftCoord = Kokkos::create_mirror_view(coordinates.flat_left_coord());
+  auto Length = Kokkos::create_mirror_view(coordinates.flat_length());
 
-  Kokkos::deep_copy(LeftCoord, coordinates.dLeftCoord);
-  Kokkos::deep_copy(Length, coordinates.dLength);
+  Kokkos::deep_copy(LeftCoord, coordinates.flat_left_coord());
+  Kokkos::deep_copy(Length, coordinates.flat_length());
   Kokkos::deep_copy(filtered_integrals, parents.integral_estimates);
   Kokkos::deep_copy(filtered_errors, parents.error_estimates);
   Kokkos::deep_copy(new_subdiv_dim, classifications.sub_dividing_dim);
@@ -247,11 +248,12 @@ TEST_CASE("filter: region 15 is inactive")
     Kokkos::create_mirror_view(classifications.sub_dividing_dim);
   auto host_active_regions =
     Kokkos::create_mirror_view(classifications.active_regions);
-  auto original_LeftCoord = Kokkos::create_mirror_view(coordinates.dLeftCoord);
-  auto original_Length = Kokkos::create_mirror_view(coordinates.dLength);
+  auto original_LeftCoord =
+    Kokkos::create_mirror_view(coordinates.flat_left_coord());
+  auto original_Length = Kokkos::create_mirror_view(coordinates.flat_length());
 
-  Kokkos::deep_copy(original_LeftCoord, coordinates.dLeftCoord);
-  Kokkos::deep_copy(original_Length, coordinates.dLength);
+  Kokkos::deep_copy(original_LeftCoord, coordinates.flat_left_coord());
+  Kokkos::deep_copy(original_Length, coordinates.flat_length());
 
   for (size_t i = 0; i < n; ++i) {
     integrals_mirror[i] = 1000.;
@@ -289,11 +291,11 @@ TEST_CASE("filter: region 15 is inactive")
 
   auto new_subdiv_dim =
     Kokkos::create_mirror_view(classifications.sub_dividing_dim);
-  auto LeftCoord = Kokkos::create_mirror_view(coordinates.dLeftCoord);
-  auto Length = Kokkos::create_mirror_view(coordinates.dLength);
+  auto LeftCoord = Kokkos::create_mirror_view(coordinates.flat_left_coord());
+  auto Length = Kokkos::create_mirror_view(coordinates.flat_length());
 
-  Kokkos::deep_copy(LeftCoord, coordinates.dLeftCoord);
-  Kokkos::deep_copy(Length, coordinates.dLength);
+  Kokkos::deep_copy(LeftCoord, coordinates.flat_left_coord());
+  Kokkos::deep_copy(Length, coordinates.flat_length());
   Kokkos::deep_copy(filtered_integrals, parents.integral_estimates);
   Kokkos::deep_copy(filtered_errors, parents.error_estimates);
   Kokkos::deep_copy(new_subdiv_dim, classifications.sub_dividing_dim);
@@ -346,11 +348,12 @@ TEST_CASE("filter: first and last regions are inactive")
     Kokkos::create_mirror_view(classifications.sub_dividing_dim);
   auto host_active_regions =
     Kokkos::create_mirror_view(classifications.active_regions);
-  auto original_LeftCoord = Kokkos::create_mirror_view(coordinates.dLeftCoord);
-  auto original_Length = Kokkos::create_mirror_view(coordinates.dLength);
+  auto original_LeftCoord =
+    Kokkos::create_mirror_view(coordinates.flat_left_coord());
+  auto original_Length = Kokkos::create_mirror_view(coordinates.flat_length());
 
-  Kokkos::deep_copy(original_LeftCoord, coordinates.dLeftCoord);
-  Kokkos::deep_copy(original_Length, coordinates.dLength);
+  Kokkos::deep_copy(original_LeftCoord, coordinates.flat_left_coord());
+  Kokkos::deep_copy(original_Length, coordinates.flat_length());
 
   for (size_t i = 0; i < n; ++i) {
     integrals_mirror[i] = 1000.;
@@ -394,11 +397,11 @@ TEST_CASE("filter: first and last regions are inactive")
 
   auto new_subdiv_dim =
     Kokkos::create_mirror_view(classifications.sub_dividing_dim);
-  auto LeftCoord = Kokkos::create_mirror_view(coordinates.dLeftCoord);
-  auto Length = Kokkos::create_mirror_view(coordinates.dLength);
+  auto LeftCoord = Kokkos::create_mirror_view(coordinates.flat_left_coord());
+  auto Length = Kokkos::create_mirror_view(coordinates.flat_length());
 
-  Kokkos::deep_copy(LeftCoord, coordinates.dLeftCoord);
-  Kokkos::deep_copy(Length, coordinates.dLength);
+  Kokkos::deep_copy(LeftCoord, coordinates.flat_left_coord());
+  Kokkos::deep_copy(Length, coordinates.flat_length());
   Kokkos::deep_copy(filtered_integrals, parents.integral_estimates);
   Kokkos::deep_copy(filtered_errors, parents.error_estimates);
   Kokkos::deep_copy(new_subdiv_dim, classifications.sub_dividing_dim);
@@ -48,11 +48,11 @@ TEST_CASE("Split all regions at dim 1")
 
   auto sub_div_dim =
     Kokkos::create_mirror_view(classifications.sub_dividing_dim);
-  auto orig_leftcoord = Kokkos::create_mirror_view(regions.dLeftCoord);
-  auto orig_length = Kokkos::create_mirror_view(regions.dLength);
+  auto orig_leftcoord = Kokkos::create_mirror_view(regions.flat_left_coord());
+  auto orig_length = Kokkos::create_mirror_view(regions.flat_length());
 
-  Kokkos::deep_copy(orig_leftcoord, regions.dLeftCoord);
-  Kokkos::deep_copy(orig_length, regions.dLength);
+  Kokkos::deep_copy(orig_leftcoord, regions.flat_left_coord());
+  Kokkos::deep_copy(orig_length, regions.flat_length());
 
   for (size_t i = 0; i < n; ++i) {
     sub_div_dim[i] = 1;
@@ -61,11 +61,11 @@ TEST_CASE("Split all regions at dim 1")
   Kokkos::deep_copy(classifications.sub_dividing_dim, sub_div_dim);
   splitter.split(regions, classifications);
 
-  auto new_leftcoord = Kokkos::create_mirror_view(regions.dLeftCoord);
-  auto new_length = Kokkos::create_mirror_view(regions.dLength);
+  auto new_leftcoord = Kokkos::create_mirror_view(regions.flat_left_coord());
+  auto new_length = Kokkos::create_mirror_view(regions.flat_length());
 
-  Kokkos::deep_copy(new_leftcoord, regions.dLeftCoord);
-  Kokkos::deep_copy(new_length, regions.dLength);
+  Kokkos::deep_copy(new_leftcoord, regions.flat_left_coord());
+  Kokkos::deep_copy(new_length, regions.flat_length());
 
   SECTION("Dimension zero is intact")
   {
@@ -112,11 +112,11 @@ TEST_CASE("Split first region at dim 0 the rest at dim 1")
 
   auto sub_div_dim =
     Kokkos::create_mirror_view(classifications.sub_dividing_dim);
-  auto orig_leftcoord = Kokkos::create_mirror_view(regions.dLeftCoord);
-  auto orig_length = Kokkos::create_mirror_view(regions.dLength);
+  auto orig_leftcoord = Kokkos::create_mirror_view(regions.flat_left_coord());
+  auto orig_length = Kokkos::create_mirror_view(regions.flat_length());
 
-  Kokkos::deep_copy(orig_leftcoord, regions.dLeftCoord);
-  Kokkos::deep_copy(orig_length, regions.dLength);
+  Kokkos::deep_copy(orig_leftcoord, regions.flat_left_coord());
+  Kokkos::deep_copy(orig_length, regions.flat_length());
 
   sub_div_dim[0] = 0;
   for (size_t i = 1; i < n; ++i) {
@@ -126,11 +126,11 @@ TEST_CASE("Split first region at dim 0 the rest at dim 1")
   Kokkos::deep_copy(classifications.sub_dividing_dim, sub_div_dim);
   splitter.split(regions, classifications);
 
-  auto new_leftcoord = Kokkos::create_mirror_view(regions.dLeftCoord);
-  auto new_length = Kokkos::create_mirror_view(regions.dLength);
+  auto new_leftcoord = Kokkos::create_mirror_view(regions.flat_left_coord());
+  auto new_length = Kokkos::create_mirror_view(regions.flat_length());
 
-  Kokkos::deep_copy(new_leftcoord, regions.dLeftCoord);
-  Kokkos::deep_copy(new_length, regions.dLength);
+  Kokkos::deep_copy(new_leftcoord, regions.flat_left_coord());
+  Kokkos::deep_copy(new_length, regions.flat_length());
 
   SECTION("Dimension zero is changed only for the first region")
   {
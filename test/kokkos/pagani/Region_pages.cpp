@@ -0,0 +1,205 @@
+#include "catch2/catch.hpp"
+#include "kokkos/pagani/quad/GPUquad/Sub_regions.cuh"
+#include "kokkos/pagani/quad/GPUquad/Sub_region_splitter.cuh"
+#include "kokkos/pagani/quad/GPUquad/Sub_region_filter.cuh"
+#include "kokkos/pagani/quad/GPUquad/Region_characteristics.cuh"
+#include "kokkos/pagani/quad/GPUquad/Region_estimates.cuh"
+#include "kokkos/pagani/quad/GPUquad/heuristic_classifier.cuh"
+#include <vector>
+
+template <size_t ndim>
+std::vector<double>
+host_coords(Sub_regions<double, ndim> const& regions, bool left)
+{
+  auto flat = Kokkos::create_mirror_view_and_copy(
+    Kokkos::HostSpace(),
+    left ? regions.flat_left_coord() : regions.flat_length());
+  return std::vector<double>(flat.data(), flat.data() + flat.extent(0));
+}
+
+TEST_CASE("Regions spanning several pages are split and filtered in place")
+{
+  constexpr size_t ndim = 2;
+  Sub_regions<double, ndim> regions(100);
+  const size_t n = regions.size;
+  REQUIRE(n > 2 * pagani::region_page_size);
+  CHECK(regions.pages.size() == pagani::num_region_pages(n));
+
+  const std::vector<double> left = host_coords(regions, true);
+  const std::vector<double> length = host_coords(regions, false);
+
+  Region_characteristics<ndim> classifications(n);
+  auto split_dims =
+    Kokkos::create_mirror_view(classifications.sub_dividing_dim);
+  for (size_t i = 0; i < n; ++i)
+    split_dims(i) = i % 2;
+  Kokkos::deep_copy(classifications.sub_dividing_dim, split_dims);
+
+  Sub_region_splitter<double, ndim> splitter(n);
+  splitter.split(regions, classifications);
+  REQUIRE(regions.size == 2 * n);
+  CHECK(regions.pages.size() == pagani::num_region_pages(2 * n));
+
+  const std::vector<double> split_left = host_coords(regions, true);
+  const std::vector<double> split_length = host_coords(regions, false);
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t dim = 0; dim < ndim; ++dim) {
+      const double parent_left = left[dim * n + i];
+      const double parent_length = length[dim * n + i];
+      const bool bisected = dim == i % 2;
+      const double half = bisected ? parent_length / 2 : parent_length;
+
+      CHECK(split_left[dim * 2 * n + i] == parent_left);
+      CHECK(split_length[dim * 2 * n + i] == half);
+      CHECK(split_left[dim * 2 * n + n + i] ==
+            (bisected ? parent_left + half : parent_left));
+      CHECK(split_length[dim * 2 * n + n + i] == half);
+    }
+  }
+
+  // keep every third region
+  const size_t num_split = regions.size;
+  Region_characteristics<ndim> children(num_split);
+  Region_estimates<double, ndim> estimates(num_split);
+  Region_estimates<double, ndim> parents(num_split);
+  auto active = Kokkos::create_mirror_view(children.active_regions);
+  auto errors = Kokkos::create_mirror_view(estimates.error_estimates);
+  std::vector<size_t> kept;
+  for (size_t i = 0; i < num_split; ++i) {
+    active(i) = i % 3 == 0;
+    errors(i) = static_cast<double>(i);
+    if (active(i) == 1)
+      kept.push_back(i);
+  }
+  Kokkos::deep_copy(children.active_regions, active);
+  Kokkos::deep_copy(estimates.error_estimates, errors);
+  Kokkos::deep_copy(estimates.integral_estimates, 1.);
+  Kokkos::deep_copy(children.sub_dividing_dim, 0);
+
+  const size_t total_pages = regions.pages.size();
+  Sub_regions_filter<double, ndim> filter(num_split);
+  const size_t num_active =
+    filter.filter(regions, children, estimates, parents);
+  REQUIRE(num_active == kept.size());
+  CHECK(regions.pages.size() == pagani::num_region_pages(num_active));
+  CHECK(regions.pages.size() + regions.free_pages.size() == total_pages);
+
+  const std::vector<double> filtered_left = host_coords(regions, true);
+  const std::vector<double> filtered_length = host_coords(regions, false);
+  auto parent_errors = Kokkos::create_mirror_view_and_copy(
+    Kokkos::HostSpace(), parents.error_estimates);
+  for (size_t k = 0; k < kept.size(); ++k) {
+    CHECK(parent_errors(k) == static_cast<double>(kept[k]));
+    for (size_t dim = 0; dim < ndim; ++dim) {
+      CHECK(filtered_left[dim * num_active + k] ==
+            split_left[dim * num_split + kept[k]]);
+      CHECK(filtered_length[dim * num_active + k] ==
+            split_length[dim * num_split + kept[k]]);
+    }
+  }
+
+  // the next split takes its pages from the ones the filter released
+  Sub_region_splitter<double, ndim> next_splitter(num_active);
+  next_splitter.split(regions, children);
+  CHECK(regions.size == 2 * num_active);
+  CHECK(regions.pages.size() + regions.free_pages.size() == total_pages);
+}
+
+TEST_CASE("Flat coordinates round trip through the pages")
+{
+  constexpr size_t ndim = 3;
+  const size_t n = pagani::region_page_size + 17;
+  ViewVectorDouble left = quad::cuda_malloc<double>(n * ndim);
+  ViewVectorDouble length = quad::cuda_malloc<double>(n * ndim);
+  auto h_left = Kokkos::create_mirror_view(left);
+  auto h_length = Kokkos::create_mirror_view(length);
+  for (size_t i = 0; i < n * ndim; ++i) {
+    h_left(i) = static_cast<double>(i);
+    h_length(i) = .5 * i;
+  }
+  Kokkos::deep_copy(left, h_left);
+  Kokkos::deep_copy(length, h_length);
+
+  Sub_regions<double, ndim> regions;
+  regions.assign(left, length, n);
+  CHECK(regions.size == n);
+  CHECK(regions.capacity() == 2 * pagani::region_page_size);
+
+  const std::vector<double> back = host_coords(regions, true);
+  const std::vector<double> back_length = host_coords(regions, false);
+  for (size_t i = 0; i < n * ndim; ++i) {
+    CHECK(back[i] == h_left(i));
+    CHECK(back_length[i] == h_length(i));
+  }
+
+  const quad::Volume<double, ndim> last = regions.extract_region(n - 1);
+  for (size_t dim = 0; dim < ndim; ++dim) {
+    CHECK(last.lows[dim] == h_left(dim * n + n - 1));
+    CHECK(last.highs[dim] ==
+          h_left(dim * n + n - 1) + h_length(dim * n + n - 1));
+  }
+}
+
+TEST_CASE("Split memory estimate counts pages instead of copies")
+{
+  constexpr size_t ndim = 8;
+  const size_t n = 1 << 20;
+  const size_t coords = pagani::region_storage_doubles(2 * n, ndim);
+  // children plus an eighth of them for the compaction buffer
+  CHECK(coords >= 2 * ndim * 2 * n);
+  CHECK(coords <= 2 * ndim * (2 * n + pagani::region_page_size) * 9 / 8 +
+                    2 * ndim * pagani::region_page_size);
+  // the flat layout held parents, filtered parents and children at once
+  CHECK(8 * num_doubles_needed(n, ndim) < 8 * 10 * ndim * n);
+}
+
+TEST_CASE("A snapshot can be loaded more than once")
+{
+  constexpr size_t ndim = 3;
+  Sub_regions<double, ndim> regions(20);
+  const size_t n = regions.size;
+  REQUIRE(n > pagani::region_page_size);
+  const std::vector<double> left = host_coords(regions, true);
+  const std::vector<double> length = host_coords(regions, false);
+  regions.take_snapshot();
+
+  Region_characteristics<ndim> classifications(n);
+  Kokkos::deep_copy(classifications.sub_dividing_dim, 1);
+
+  for (int load = 0; load < 2; ++load) {
+    Sub_region_splitter<double, ndim> splitter(regions.size);
+    splitter.split(regions, classifications);
+    REQUIRE(regions.size == 2 * n);
+
+    regions.load_snapshot();
+    REQUIRE(regions.size == n);
+    CHECK(host_coords(regions, true) == left);
+    CHECK(host_coords(regions, false) == length);
+  }
+
+  // the loaded regions do not share pages with the snapshot
+  for (auto const& page : regions.pages)
+    for (auto const& snapshot_page : regions.snapshot_pages)
+      CHECK(page.data() != snapshot_page.data());
+}
+
+TEST_CASE("Copy assignment copies the pages")
+{
+  constexpr size_t ndim = 2;
+  Sub_regions<double, ndim> regions(80);
+  const size_t n = regions.size;
+  const std::vector<double> left = host_coords(regions, true);
+
+  Sub_regions<double, ndim> copy(3);
+  copy = regions;
+  REQUIRE(copy.size == n);
+  CHECK(copy.pages.front().data() != regions.pages.front().data());
+
+  Region_characteristics<ndim> classifications(n);
+  Kokkos::deep_copy(classifications.sub_dividing_dim, 0);
+  Sub_region_splitter<double, ndim> splitter(n);
+  splitter.split(regions, classifications);
+
+  CHECK(copy.size == n);
+  CHECK(host_coords(copy, true) == left);
+}
@@ -16,11 +16,11 @@ TEST_CASE("New Unit-Volume 3D")
   }
 
   ViewVectorDouble::HostMirror Regions =
-    Kokkos::create_mirror_view(regions.dLeftCoord);
+    Kokkos::create_mirror_view(regions.flat_left_coord());
   ViewVectorDouble::HostMirror RegionsLength =
-    Kokkos::create_mirror_view(regions.dLength);
-  Kokkos::deep_copy(Regions, regions.dLeftCoord);
-  Kokkos::deep_copy(RegionsLength, regions.dLength);
+    Kokkos::create_mirror_view(regions.flat_length());
+  Kokkos::deep_copy(Regions, regions.flat_left_coord());
+  Kokkos::deep_copy(RegionsLength, regions.flat_length());
 
   SECTION("Region Data Properly Transferred to CPU")
   {
@@ -59,11 +59,11 @@ TEST_CASE("New Unit-Volume 5D")
   }
 
   ViewVectorDouble::HostMirror Regions =
-    Kokkos::create_mirror_view(regions.dLeftCoord);
+    Kokkos::create_mirror_view(regions.flat_left_coord());
   ViewVectorDouble::HostMirror RegionsLength =
-    Kokkos::create_mirror_view(regions.dLength);
-  Kokkos::deep_copy(Regions, regions.dLeftCoord);
-  Kokkos::deep_copy(RegionsLength, regions.dLength);
+    Kokkos::create_mirror_view(regions.flat_length());
+  Kokkos::deep_copy(Regions, regions.flat_left_coord());
+  Kokkos::deep_copy(RegionsLength, regions.flat_length());
 
   SECTION("Region Data Properly Transferred to CPU")
   {
@@ -100,11 +100,11 @@ TEST_CASE("New Unit-Volume 10D")
   }
 
   ViewVectorDouble::HostMirror Regions =
-    Kokkos::create_mirror_view(regions.dLeftCoord);
+    Kokkos::create_mirror_view(regions.flat_left_coord());
   ViewVectorDouble::HostMirror RegionsLength =
-    Kokkos::create_mirror_view(regions.dLength);
-  Kokkos::deep_copy(Regions, regions.dLeftCoord);
-  Kokkos::deep_copy(RegionsLength, regions.dLength);
+    Kokkos::create_mirror_view(regions.flat_length());
+  Kokkos::deep_copy(Regions, regions.flat_left_coord());
+  Kokkos::deep_copy(RegionsLength, regions.flat_length());
 
   SECTION("Region Data Properly Transferred to CPU")
   {